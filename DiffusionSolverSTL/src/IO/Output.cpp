@@ -36,11 +36,33 @@ void Output::write_data(const vector<double> &data) {
     }
 }
 
-// Write a matrix of data (for 2D output, e.g., temperature field)
-void Output::write_data(const vector<vector<double>> &data_matrix) {
+// Write a 2D field (one row per line, the halo holding the boundary values included, padding skipped)
+void Output::write_data(const Field2D &field) {
     if (output_file) {
-        for (const auto& row : data_matrix) {
-            write_data(row);
+        const int h = field.halo();
+        for (int j = -h; j < field.ny() + h; ++j) {
+            const double* row = field.row(j);
+            for (int i = -h; i < field.nx() + h; ++i) {
+                output_file << fixed << setprecision(6) << row[i] << "\t";
+            }
+            output_file << "\n";
+        }
+    }
+}
+
+// Write a 3D field (one xy-plane after another, separated by an empty line, halo included)
+void Output::write_data(const Field3D &field) {
+    if (output_file) {
+        const int h = field.halo();
+        for (int k = -h; k < field.nz() + h; ++k) {
+            for (int j = -h; j < field.ny() + h; ++j) {
+                const double* row = field.row(j, k);
+                for (int i = -h; i < field.nx() + h; ++i) {
+                    output_file << fixed << setprecision(6) << row[i] << "\t";
+                }
+                output_file << "\n";
+            }
+            output_file << "\n";
         }
     }
 }
\ No newline at end of file
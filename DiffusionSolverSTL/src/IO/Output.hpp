@@ -8,6 +8,7 @@
 #include <fstream>
 #include <vector>
 #include <string>
+#include "field/Field.hpp"
 
 using namespace std;
 
@@ -24,7 +25,8 @@ public:
 
     // Method to write simulation data (overloaded for vectors or scalars)
     void write_data(const vector<double>& data);
-    void write_data(const vector<vector<double>>& data_matrix);
+    void write_data(const Field2D& field);
+    void write_data(const Field3D& field);
 
     // Destructor to close the file
     ~Output() = default;
@@ -4,7 +4,6 @@
 
 #include "Convergence.hpp"
 #include <cmath>
-#include <variant>
 
 using namespace std;
 
@@ -16,13 +15,6 @@ Convergence::Convergence(double tol, int max_iter, const string& filename, Simul
       max_iterations(max_iter),
       iteration_count(0) {
 
-    // Initialize current_iteration based on the dimensionality
-    if (params.dimension == 2) {
-        current_solution = vector<vector<double>>(params.N + 2, vector<double>(params.N + 2, params.TL));
-    } else if (params.dimension == 3) {
-        current_solution = vector<vector<vector<double>>>(params.N + 2, vector<vector<double>>(params.N + 2, vector<double>(params.N + 2, params.TL)));
-    }
-
     // Open the file for logging residuals
     log_file.open(filename);
     if (!log_file) {
@@ -38,20 +30,26 @@ double Convergence::compute_residual_impl(const T& current_solution_inp, const T
     double sum = 0.0;
 
     // Check if it's 2D case
-    if constexpr (is_same_v<T, vector<vector<double>>>) {
-        for (size_t j = 0; j < current_solution_inp.size(); ++j) {
-            for (size_t i = 0; i < current_solution_inp[j].size(); ++i) {
-                double diff = current_solution_inp[j][i] - prev_solution_inp[j][i];
+    if constexpr (is_same_v<T, Field2D>) {
+        for (int j = 0; j < current_solution_inp.ny(); ++j) {
+            const double* cur = current_solution_inp.row(j);
+            const double* prev = prev_solution_inp.row(j);
+            #pragma omp simd reduction(+:sum)
+            for (int i = 0; i < current_solution_inp.nx(); ++i) {
+                double diff = cur[i] - prev[i];
                 sum += diff * diff;
             }
         }
     } 
     // Check if it's 3D case
-    else if constexpr (is_same_v<T, vector<vector<vector<double>>>>) {
-        for (int k = 0; k < current_solution_inp.size(); ++k) {
-            for (int j = 0; j < current_solution_inp[k].size(); ++j) {
-                for (int i = 0; i < current_solution_inp[k][j].size(); ++i) {
-                    double diff = current_solution_inp[k][j][i] - prev_solution_inp[k][j][i];
+    else if constexpr (is_same_v<T, Field3D>) {
+        for (int k = 0; k < current_solution_inp.nz(); ++k) {
+            for (int j = 0; j < current_solution_inp.ny(); ++j) {
+                const double* cur = current_solution_inp.row(j, k);
+                const double* prev = prev_solution_inp.row(j, k);
+                #pragma omp simd reduction(+:sum)
+                for (int i = 0; i < current_solution_inp.nx(); ++i) {
+                    double diff = cur[i] - prev[i];
                     sum += diff * diff;
                 }
             }
@@ -63,59 +61,42 @@ double Convergence::compute_residual_impl(const T& current_solution_inp, const T
 }
 
 // Method to compute the residual for 2D case (L2 norm by default)
-// 2D residual calculation
-double Convergence::compute_residual_2d(const vector<vector<double>>& current_solution_input) {
-    if (get<vector<vector<double>>>(prev_solution).empty()) {
-        prev_solution = current_solution_input;
-        return std::numeric_limits<double>::max();
-    }
-    residual = compute_residual_impl(current_solution_input,
-                                     get<vector<vector<double>>>(prev_solution));
+// 2D residual calculation between the new and the previous time level
+double Convergence::compute_residual_2d(const Field2D& current_solution_input, const Field2D& prev_solution_input) {
+    residual = compute_residual_impl(current_solution_input, prev_solution_input);
     return residual;
 }
 
 // Method to compute the residual for 3D case (L2 norm by default)
-double Convergence::compute_residual_3d(const vector<vector<vector<double>>>& current_solution_input) {
-    // Ensure we have a previous solution to compare against
-    if (get<vector<vector<vector<double>>>>(prev_solution).empty()) {
-        prev_solution = current_solution_input;
-        return numeric_limits<double>::max(); // Return a large initial residual
-    }
-    residual = compute_residual_impl(get<vector<vector<vector<double>>>>(current_solution),
-                                     get<vector<vector<vector<double>>>>(prev_solution));
+double Convergence::compute_residual_3d(const Field3D& current_solution_input, const Field3D& prev_solution_input) {
+    residual = compute_residual_impl(current_solution_input, prev_solution_input);
 
     // Calculate the L2 norm of the difference between solutions
     return residual;
 }
 
 // Method to check if convergence criteria are met for 2D case
-bool Convergence::check_convergence_2d(const vector<vector<double>>& current_solution_input) {
+bool Convergence::check_convergence_2d(const Field2D& current_solution_input, const Field2D& prev_solution_input) {
     iteration_count++;
     // Compute the current residual
-    compute_residual_2d(current_solution_input);
+    compute_residual_2d(current_solution_input, prev_solution_input);
 
     // Print current iteration and residual status
     print_status();
 
-    // Update the previous solution
-    prev_solution = current_solution_input;
-
     // Check if the residual is smaller than the tolerance or max iterations exceeded
     return (residual < tolerance || iteration_count >= max_iterations);
 }
 
 // Method to check if convergence criteria are met for 3D case
-bool Convergence::check_convergence_3d(const vector<vector<vector<double>>>& current_solution_input) {
+bool Convergence::check_convergence_3d(const Field3D& current_solution_input, const Field3D& prev_solution_input) {
     iteration_count++;
     // Compute the current residual
-    compute_residual_3d(current_solution_input);
+    compute_residual_3d(current_solution_input, prev_solution_input);
 
     // Print current iteration and residual status
     print_status();
 
-    // Update the previous solution
-    prev_solution = current_solution_input;
-
     // Check if the residual is smaller than the tolerance or max iterations exceeded
     return (residual < tolerance || iteration_count >= max_iterations);
 }
@@ -125,7 +106,6 @@ bool Convergence::check_convergence_3d(const vector<vector<vector<double>>>& cur
 void Convergence::reset() {
     residual = 0.0;
     iteration_count = 0;
-    prev_solution = {};
 }
 
 // Print convergence information
@@ -9,8 +9,8 @@
 #include <cmath>
 #include <iostream>
 #include <fstream>
-#include <variant>
 #include "simulation_parameters/SimulationParameters.hpp"
+#include "field/Field.hpp"
 
 using namespace std;
 
@@ -20,8 +20,6 @@ private:
     double residual {};
     int max_iterations {};
     int iteration_count {};
-    variant<vector<vector<double>>, vector<vector<vector<double>>>> current_solution;
-    variant<vector<vector<double>>, vector<vector<vector<double>>>> prev_solution;
     ofstream log_file;
     SimulationParameters& params;
 
@@ -33,15 +31,16 @@ public:
     // Constructor
     Convergence(double tol, int max_iter, const string& filename, SimulationParameters &params);
 
-    // Method to compute the residual for 2D case (L2 norm by default)
-    double compute_residual_2d(const vector<vector<double>>& current_solution);
+    // Method to compute the residual between two time levels for 2D case (L2 norm by default)
+    double compute_residual_2d(const Field2D& current_solution, const Field2D& prev_solution);
 
-    // Method to compute the residual for 3D case (L2 norm by default)
-    double compute_residual_3d(const vector<vector<vector<double>>>& current_solution);
+    // Method to compute the residual between two time levels for 3D case (L2 norm by default)
+    double compute_residual_3d(const Field3D& current_solution, const Field3D& prev_solution);
 
-    // Method to check if convergence criteria are met
-    bool check_convergence_2d(const vector<vector<double>>& current_solution);
-    bool check_convergence_3d(const vector<vector<vector<double>>>& current_solution);
+    // Method to check if convergence criteria are met.
+    // Both time levels are passed in by the caller, so no copy of the solution is kept here.
+    bool check_convergence_2d(const Field2D& current_solution, const Field2D& prev_solution);
+    bool check_convergence_3d(const Field3D& current_solution, const Field3D& prev_solution);
 
     // Resets the state of the Convergence class for a new computation
     void reset();
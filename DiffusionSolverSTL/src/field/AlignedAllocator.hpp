@@ -0,0 +1,49 @@
+/*
+ * File: AlignedAllocator.hpp
+ * --------------------------
+ * This header provides a minimal standard-conforming allocator that returns memory aligned
+ * to a fixed byte boundary (64 bytes by default, one cache line / one AVX-512 register).
+ * It is used by the field containers so that every row of a temperature field starts on a
+ * cache-line boundary, which allows aligned vector loads in the stencil loops.
+ */
+
+#ifndef PROJECT_02_FVM_ALIGNEDALLOCATOR_HPP
+#define PROJECT_02_FVM_ALIGNEDALLOCATOR_HPP
+
+#include <cstddef>
+#include <new>
+
+template <typename T, std::size_t Alignment = 64>
+class AlignedAllocator {
+public:
+    using value_type = T;
+
+    // Required so that std::allocator_traits can rebind the allocator to other types
+    template <typename U>
+    struct rebind {
+        using other = AlignedAllocator<U, Alignment>;
+    };
+
+    AlignedAllocator() noexcept = default;
+
+    template <typename U>
+    explicit AlignedAllocator(const AlignedAllocator<U, Alignment>&) noexcept {}
+
+    // Allocate 'n' objects of type T on an 'Alignment'-byte boundary
+    T* allocate(std::size_t n) {
+        return static_cast<T*>(::operator new(n * sizeof(T), std::align_val_t{Alignment}));
+    }
+
+    // Release memory obtained from 'allocate'
+    void deallocate(T* p, std::size_t) noexcept {
+        ::operator delete(p, std::align_val_t{Alignment});
+    }
+
+    template <typename U>
+    bool operator==(const AlignedAllocator<U, Alignment>&) const noexcept { return true; }
+
+    template <typename U>
+    bool operator!=(const AlignedAllocator<U, Alignment>&) const noexcept { return false; }
+};
+
+#endif //PROJECT_02_FVM_ALIGNEDALLOCATOR_HPP
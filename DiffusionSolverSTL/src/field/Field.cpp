@@ -0,0 +1,72 @@
+#include "Field.hpp"
+#include <algorithm>
+#include <stdexcept>
+
+// Round 'n' up to the next multiple of FIELD_PADDING
+static std::size_t padded(std::size_t n) {
+    return (n + FIELD_PADDING - 1) / FIELD_PADDING * FIELD_PADDING;
+}
+
+Field2D::Field2D(int nx, int ny, double value, int halo)
+    : size_x(nx), size_y(ny), halo_width(halo) {
+    if (nx <= 0 || ny <= 0 || halo < 0) {
+        throw std::invalid_argument("Field2D: invalid field dimensions.");
+    }
+    offset = padded(static_cast<std::size_t>(halo));
+    ld = padded(offset + static_cast<std::size_t>(nx + halo));
+    values.assign(ld * static_cast<std::size_t>(ny + 2 * halo), value);
+}
+
+void Field2D::fill(double value) {
+    std::fill(values.begin(), values.end(), value);
+}
+
+void Field2D::copy_from(const Field2D& other) {
+    if (other.size_x != size_x || other.size_y != size_y || other.halo_width != halo_width) {
+        throw std::invalid_argument("Field2D: cannot copy between fields of different shape.");
+    }
+    std::copy(other.values.begin(), other.values.end(), values.begin());
+}
+
+void Field2D::swap(Field2D& other) noexcept {
+    std::swap(size_x, other.size_x);
+    std::swap(size_y, other.size_y);
+    std::swap(halo_width, other.halo_width);
+    std::swap(offset, other.offset);
+    std::swap(ld, other.ld);
+    values.swap(other.values);
+}
+
+Field3D::Field3D(int nx, int ny, int nz, double value, int halo)
+    : size_x(nx), size_y(ny), size_z(nz), halo_width(halo) {
+    if (nx <= 0 || ny <= 0 || nz <= 0 || halo < 0) {
+        throw std::invalid_argument("Field3D: invalid field dimensions.");
+    }
+    offset = padded(static_cast<std::size_t>(halo));
+    ld = padded(offset + static_cast<std::size_t>(nx + halo));
+    plane = ld * static_cast<std::size_t>(ny + 2 * halo);
+    values.assign(plane * static_cast<std::size_t>(nz + 2 * halo), value);
+}
+
+void Field3D::fill(double value) {
+    std::fill(values.begin(), values.end(), value);
+}
+
+void Field3D::copy_from(const Field3D& other) {
+    if (other.size_x != size_x || other.size_y != size_y || other.size_z != size_z ||
+        other.halo_width != halo_width) {
+        throw std::invalid_argument("Field3D: cannot copy between fields of different shape.");
+    }
+    std::copy(other.values.begin(), other.values.end(), values.begin());
+}
+
+void Field3D::swap(Field3D& other) noexcept {
+    std::swap(size_x, other.size_x);
+    std::swap(size_y, other.size_y);
+    std::swap(size_z, other.size_z);
+    std::swap(halo_width, other.halo_width);
+    std::swap(offset, other.offset);
+    std::swap(ld, other.ld);
+    std::swap(plane, other.plane);
+    values.swap(other.values);
+}
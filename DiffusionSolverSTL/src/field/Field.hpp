@@ -0,0 +1,148 @@
+/*
+ * File: Field.hpp
+ * ---------------
+ * This file defines the 'Field2D' and 'Field3D' containers used to store scalar fields
+ * (temperature, coefficients, ...) on the structured grid.
+ *
+ * Memory layout:
+ * - All values live in ONE contiguous, 64-byte aligned buffer (no row pointers to chase).
+ * - The logical extent is nx * ny (* nz) points. Around it, 'halo' layers of ghost cells are
+ *   allocated in every direction, so stencil accesses such as T(i - 1, j) at i = 0 are valid.
+ * - Every row starts with 'offset' = halo rounded up to a multiple of 8 doubles, so the first
+ *   interior cell T(0, j) of every row (row(j)) lies on a cache-line boundary; the west halo
+ *   cells sit just before it. The leading (x) dimension is padded up to a multiple of 8
+ *   doubles as well, so the inner loops over the interior can use aligned loads.
+ *
+ * Indexing is x-fastest: T(i, j) is stored at data[(j + halo) * ld + offset + i] and
+ * T(i, j, k) at data[(k + halo) * plane + (j + halo) * ld + offset + i].
+ * Valid indices range from -halo to n + halo - 1 in each direction.
+ */
+
+#ifndef PROJECT_02_FVM_FIELD_HPP
+#define PROJECT_02_FVM_FIELD_HPP
+
+#include <cstddef>
+#include <vector>
+#include "AlignedAllocator.hpp"
+
+// Number of doubles per 64-byte cache line, used for padding the leading dimension
+constexpr std::size_t FIELD_PADDING = 8;
+
+using AlignedVector = std::vector<double, AlignedAllocator<double, 64>>;
+
+/*
+ * Class: Field2D
+ * --------------
+ * Contiguous 2D scalar field with a ghost-cell halo and a padded leading dimension.
+ */
+class Field2D {
+public:
+    Field2D() = default;
+
+    // Allocate an nx * ny field (plus halo) and fill every entry (halo included) with 'value'
+    Field2D(int nx, int ny, double value = 0.0, int halo = 1);
+
+    // Element access, (i, j) = (x index, y index)
+    double& operator()(int i, int j) { return values[index(i, j)]; }
+    const double& operator()(int i, int j) const { return values[index(i, j)]; }
+
+    // Linear offset of (i, j) inside the underlying buffer
+    [[nodiscard]] std::size_t index(int i, int j) const {
+        return static_cast<std::size_t>(j + halo_width) * ld + static_cast<std::size_t>(static_cast<std::ptrdiff_t>(offset) + i);
+    }
+
+    // Pointer to the logical element (0, j) of row j (64-byte aligned, rows are contiguous in x)
+    double* row(int j) { return values.data() + index(0, j); }
+    [[nodiscard]] const double* row(int j) const { return values.data() + index(0, j); }
+
+    // Raw access to the whole buffer (halo and padding included)
+    double* data() { return values.data(); }
+    [[nodiscard]] const double* data() const { return values.data(); }
+
+    // Fill every entry (halo included) with 'value'
+    void fill(double value);
+
+    // Copy all values from a field of the same shape (one contiguous copy)
+    void copy_from(const Field2D& other);
+
+    // Exchange the buffers of two fields in O(1)
+    void swap(Field2D& other) noexcept;
+
+    // Shape information
+    [[nodiscard]] int nx() const { return size_x; }
+    [[nodiscard]] int ny() const { return size_y; }
+    [[nodiscard]] int halo() const { return halo_width; }
+    [[nodiscard]] std::size_t stride() const { return ld; }
+    [[nodiscard]] std::size_t size() const { return values.size(); }
+    [[nodiscard]] bool empty() const { return values.empty(); }
+
+private:
+    int size_x{};           // Logical points in x-direction
+    int size_y{};           // Logical points in y-direction
+    int halo_width{};       // Ghost layers on each side
+    std::size_t offset{};   // Position of the interior cell i = 0 inside a row (multiple of FIELD_PADDING)
+    std::size_t ld{};       // Padded leading dimension (distance between rows)
+    AlignedVector values;   // Contiguous, 64-byte aligned storage
+};
+
+/*
+ * Class: Field3D
+ * --------------
+ * Contiguous 3D scalar field with a ghost-cell halo and a padded leading dimension.
+ */
+class Field3D {
+public:
+    Field3D() = default;
+
+    // Allocate an nx * ny * nz field (plus halo) and fill every entry (halo included) with 'value'
+    Field3D(int nx, int ny, int nz, double value = 0.0, int halo = 1);
+
+    // Element access, (i, j, k) = (x index, y index, z index)
+    double& operator()(int i, int j, int k) { return values[index(i, j, k)]; }
+    const double& operator()(int i, int j, int k) const { return values[index(i, j, k)]; }
+
+    // Linear offset of (i, j, k) inside the underlying buffer
+    [[nodiscard]] std::size_t index(int i, int j, int k) const {
+        return static_cast<std::size_t>(k + halo_width) * plane +
+               static_cast<std::size_t>(j + halo_width) * ld + static_cast<std::size_t>(static_cast<std::ptrdiff_t>(offset) + i);
+    }
+
+    // Pointer to the logical element (0, j, k) of the x-row (j, k) (64-byte aligned)
+    double* row(int j, int k) { return values.data() + index(0, j, k); }
+    [[nodiscard]] const double* row(int j, int k) const { return values.data() + index(0, j, k); }
+
+    // Raw access to the whole buffer (halo and padding included)
+    double* data() { return values.data(); }
+    [[nodiscard]] const double* data() const { return values.data(); }
+
+    // Fill every entry (halo included) with 'value'
+    void fill(double value);
+
+    // Copy all values from a field of the same shape (one contiguous copy)
+    void copy_from(const Field3D& other);
+
+    // Exchange the buffers of two fields in O(1)
+    void swap(Field3D& other) noexcept;
+
+    // Shape information
+    [[nodiscard]] int nx() const { return size_x; }
+    [[nodiscard]] int ny() const { return size_y; }
+    [[nodiscard]] int nz() const { return size_z; }
+    [[nodiscard]] int halo() const { return halo_width; }
+    [[nodiscard]] std::size_t stride() const { return ld; }
+    [[nodiscard]] std::size_t plane_stride() const { return plane; }
+    [[nodiscard]] std::size_t size() const { return values.size(); }
+    [[nodiscard]] bool empty() const { return values.empty(); }
+
+private:
+    int size_x{};           // Logical points in x-direction
+    int size_y{};           // Logical points in y-direction
+    int size_z{};           // Logical points in z-direction
+    int halo_width{};       // Ghost layers on each side
+    std::size_t offset{};   // Position of the interior cell i = 0 inside an x-row (multiple of FIELD_PADDING)
+    std::size_t ld{};       // Padded leading dimension (distance between x-rows)
+    std::size_t plane{};    // Distance between xy-planes
+    AlignedVector values;   // Contiguous, 64-byte aligned storage
+};
+
+#endif //PROJECT_02_FVM_FIELD_HPP
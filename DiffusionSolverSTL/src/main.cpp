@@ -10,6 +10,7 @@
 #include "simulation_parameters/SimulationParameters.hpp"
 #include "solver/SchemeType.hpp"
 #include "IO/ConfigParser.hpp"
+#include "utils/autotune.h"
 
 using namespace std;
 
@@ -39,6 +40,10 @@ int main() {
     string Linear_solver_type{};  // Linear solver type for linear algebra systems
     double Solver_tolerance{};   // Tolerance for convergence for linear algebra systems
     string Preconditioner_type{};   // Preconditioner type
+    string Preconditioner_precision{"double"};   // Storage precision of the preconditioner (optional)
+    string Triangular_solve{"LevelSchedule"};    // Schedule of the IC triangular solves (optional)
+    string Matrix_ordering{"Natural"};   // Ordering of the assembled CRS matrix (optional)
+    string Tuning_profile{};   // Per-machine kernel tuning cache (optional, empty: built-in defaults)
 
     unordered_map inputs = parser.read_config(R"(C:\Users\QCZ\CLionProjects\Project-02-FVM\DiffusionSolverSTL\config\config.txt)");
 
@@ -77,6 +82,14 @@ int main() {
             Solver_tolerance = stod(pair.second);  // Tolerance for solver convergence
         } else if (pair.first == "Preconditioner_type") {
             Preconditioner_type = pair.second;  // Preconditioner type (None, Jacobi, Incomplete Cholesky)
+        } else if (pair.first == "Preconditioner_precision") {
+            Preconditioner_precision = pair.second;  // "single": float preconditioner with iterative refinement
+        } else if (pair.first == "Triangular_solve") {
+            Triangular_solve = pair.second;  // "SyncFree": IC triangular solves without level barriers
+        } else if (pair.first == "Matrix_ordering") {
+            Matrix_ordering = pair.second;  // "RCM", "Morton", "Hilbert": solve the permuted CRS system
+        } else if (pair.first == "Tuning_profile") {
+            Tuning_profile = pair.second;  // Kernel tuning profile file (loaded, or measured and added)
         }
     }
 
@@ -86,19 +99,29 @@ int main() {
     // Output parameters read from 'config.txt' to console
     parser.output_config(inputs);
 
+    // Kernel thresholds, block size and thread count of this machine, before any solver runs
+    if (!Tuning_profile.empty() && Tuning_profile != "none") {
+        autotune_init(Tuning_profile.c_str());
+    }
+
     // Set up simulation parameters
     SimulationParameters params(L, N, TL, TH, crit, NO, ST, dl, lm, density, alpha);
 
     // Instantiate the appropriate time-stepping scheme
     std::unique_ptr<TimeStepping> timeStepScheme;
 
+    // Linear solver of the implicit schemes (set up once, reused by every time step)
+    LinearSolverSettings linear_solver{Linear_solver_type, Preconditioner_type, max_iter, Solver_tolerance,
+                                       Preconditioner_precision == "single", relax_factor,
+                                       Triangular_solve == "SyncFree", Matrix_ordering};
+
     // Select the time-stepping scheme
     if (Solver_type == "Explicit") {
         timeStepScheme = std::make_unique<ExplicitScheme>();
     } else if (Solver_type == "Implicit") {
-        timeStepScheme = std::make_unique<ImplicitScheme>();
+        timeStepScheme = std::make_unique<ImplicitScheme>(linear_solver);
     } else if (Solver_type == "CrankNicolson") {
-        timeStepScheme = std::make_unique<CrankNicolsonScheme>();
+        timeStepScheme = std::make_unique<CrankNicolsonScheme>(linear_solver);
     } else {
         cerr << "Error: Unsupported solver type ' " << Solver_type << " '." << endl;
         return -1;
@@ -94,7 +94,7 @@ std::vector<std::vector<T>> CArray2Vector(const CRSMatrix* crs_matrix, size_t ro
 
     for (size_t i = 0; i < rows; ++i) {
         for (size_t j = crs_matrix->row_ptr[i]; j < crs_matrix->row_ptr[i + 1]; ++j) {
-            result[i][crs_matrix->col_idx[j]] = static_cast<T>(crs_matrix->values[j]);
+            result[i][crs_col(crs_matrix, j)] = static_cast<T>(crs_matrix->values[j]);
         }
     }
 
@@ -127,7 +127,7 @@ std::vector<T> CArray2Vector(const CRSMatrix* crs_matrix, size_t rows, size_t co
 
     for (size_t i = 0; i < rows; ++i) {
         for (size_t j = crs_matrix->row_ptr[i]; j < crs_matrix->row_ptr[i + 1]; ++j) {
-            result[i * cols + crs_matrix->col_idx[j]] = static_cast<T>(crs_matrix->values[j]);
+            result[i * cols + crs_col(crs_matrix, j)] = static_cast<T>(crs_matrix->values[j]);
         }
     }
     return result;
@@ -13,173 +13,562 @@
  *
  * Functions:
  *  - dense_to_crs: Converts a dense matrix to a CRS matrix format.
+ *  - coo_to_crs: Builds a CRS matrix from (row, col, value) triplets, summing duplicates.
+ *  - crs_validate: Checks the CRS structure once, builds the nnz-balanced row partition and
+ *    the 32-bit copy of the column indices.
+ *  - crs_narrow_index: Drops the size_t column indices of an owned matrix (opt-in).
+ *  - crs_transpose: Computes the transpose of a CRS matrix.
  *  - free_crs_matrix: Frees memory allocated for the CRS matrix.
  */
 
 #include "CRSMatrix.h"
-#include "CPPVec2CArr.hpp"
+#include "SELLMatrix.h"
+#include "linear_algebra.h"
 #include <stdlib.h>
 #include <stdio.h>
 #include <stddef.h>
+#include <stdint.h>
+#include <string.h>
 #include <omp_llvm.h>
 
+// Empty matrix of the given shape with no arrays (so free_crs_matrix is safe on every error path)
+static void crs_init(CRSMatrix* A, size_t rows, size_t cols) {
+    A->values = NULL;
+    A->col_idx = NULL;
+    A->row_ptr = NULL;
+    A->nnz = 0;
+    A->rows = rows;
+    A->cols = cols;
+    A->row_part = NULL;
+    A->num_parts = 0;
+    A->validated = 0;
+    A->sell = NULL;
+    A->col_idx32 = NULL;
+}
+
+/*
+ * Exclusive prefix sum in place: on entry a[0..n-1] are counts, on exit a[i] is the sum of the
+ * counts before i and a[n] the total (a has n + 1 entries). Every thread sums a contiguous chunk,
+ * the chunk offsets are scanned serially (one per thread), then every thread scans its chunk.
+ */
+static void crs_prefix_sum(size_t* a, size_t n) {
+    const int max_threads = omp_get_max_threads();
+    size_t offsets_local[64];
+    size_t* offsets = (max_threads < 64) ? offsets_local : (size_t*) malloc((max_threads + 1) * sizeof(size_t));
+    if (!offsets || n < (size_t) PARALLEL_THRESHOLD) {
+        size_t sum = 0;
+        for (size_t i = 0; i < n; ++i) {
+            const size_t c = a[i];
+            a[i] = sum;
+            sum += c;
+        }
+        a[n] = sum;
+        if (offsets != offsets_local) {
+            free(offsets);
+        }
+        return;
+    }
+
+    #pragma omp parallel
+    {
+        const int t = omp_get_thread_num();
+        const int num_threads = omp_get_num_threads();
+        const size_t begin = n * (size_t) t / (size_t) num_threads;
+        const size_t end = n * (size_t) (t + 1) / (size_t) num_threads;
+
+        size_t sum = 0;
+        for (size_t i = begin; i < end; ++i) {
+            sum += a[i];
+        }
+        offsets[t + 1] = sum;
+
+        #pragma omp barrier
+        #pragma omp single
+        {
+            offsets[0] = 0;
+            for (int p = 0; p < num_threads; ++p) {
+                offsets[p + 1] += offsets[p];
+            }
+            a[n] = offsets[num_threads];
+        }
+
+        sum = offsets[t];
+        for (size_t i = begin; i < end; ++i) {
+            const size_t c = a[i];
+            a[i] = sum;
+            sum += c;
+        }
+    }
+    if (offsets != offsets_local) {
+        free(offsets);
+    }
+}
+
 /*
  * Function: dense_to_crs
  * ----------------------
- * Converts a dense matrix to Compressed Row Storage (CRS) format.
+ * Converts a dense row-major rows x cols matrix to Compressed Row Storage (CRS) format, keeping
+ * the non-zero entries (sorted columns).
+ *
+ * Two parallel passes over the rows: the non-zeros of every row are counted into row_ptr, a
+ * parallel prefix sum turns the counts into row offsets, and every row is then written at its
+ * offset. The result is validated (crs_validate).
  *
  * Parameters:
+ *   dense      - Row-major matrix (rows * cols entries)
+ *   rows, cols - Dimensions
+ *   crs_matrix - Output matrix (allocated here, free with free_crs_matrix)
  *
+ * Returns:
+ *   - 0 on success
+ *   - -1 on invalid input or memory allocation failure
  */
-
 int dense_to_crs(const double* dense, size_t rows, size_t cols, CRSMatrix* crs_matrix) {
 
     // Check the inputs validation
-    if (!dense || !crs_matrix || rows == 0 || cols ==0) {
+    if (!dense || !crs_matrix || rows == 0 || cols == 0) {
         fprintf(stderr, "Invalid input to dense_to_crs.\n");
         return -1;  // Error code for invalid input
     }
+    crs_init(crs_matrix, rows, cols);
 
-    // Step 1 Count the number of non-zero elements (nnz)
-    size_t nnz = 0;
-    #pragma omp parallel for reduction(+:nnz)
-    for (size_t i = 0; i < rows * cols; ++i) {
-        if (dense[i] != 0.0) {
-            nnz++;
+    // Step 1: Count the non-zeros of every row, then row offsets
+    crs_matrix->row_ptr = (size_t*) malloc((rows + 1) * sizeof(size_t));
+    if (!crs_matrix->row_ptr) {
+        fprintf(stderr, "Memory allocation failed in dense_to_crs.\n");
+        return -1;
+    }
+    #pragma omp parallel for schedule(static) if (rows * cols >= (size_t) DENSE_PARALLEL_THRESHOLD)
+    for (long long i = 0; i < (long long) rows; ++i) {
+        const double* row = dense + (size_t) i * cols;
+        size_t count = 0;
+        for (size_t j = 0; j < cols; ++j) {
+            count += (row[j] != 0.0);
         }
+        crs_matrix->row_ptr[i] = count;
     }
+    crs_prefix_sum(crs_matrix->row_ptr, rows);
+    crs_matrix->nnz = crs_matrix->row_ptr[rows];
 
-    // Allocate memory for CRS arrays
-    crs_matrix->values = (double*) malloc(nnz * sizeof(double));
-    crs_matrix->col_idx = (size_t*) malloc(nnz * sizeof(size_t));
-    crs_matrix->row_ptr = (size_t*) malloc((nnz + 1) * sizeof(size_t));
-    if (!crs_matrix->values || !crs_matrix->col_idx || !crs_matrix->row_ptr) {
+    // Step 2: Copy the non-zeros of every row to its offset
+    crs_matrix->values = (double*) malloc((crs_matrix->nnz + 1) * sizeof(double));
+    crs_matrix->col_idx = (size_t*) malloc((crs_matrix->nnz + 1) * sizeof(size_t));
+    if (!crs_matrix->values || !crs_matrix->col_idx) {
         fprintf(stderr, "Memory allocation failed in dense_to_crs.\n");
+        free_crs_matrix(crs_matrix);
         return -1;
     }
+    #pragma omp parallel for schedule(static) if (rows * cols >= (size_t) DENSE_PARALLEL_THRESHOLD)
+    for (long long i = 0; i < (long long) rows; ++i) {
+        const double* row = dense + (size_t) i * cols;
+        size_t k = crs_matrix->row_ptr[i];
+        for (size_t j = 0; j < cols; ++j) {
+            if (row[j] != 0.0) {
+                crs_matrix->values[k] = row[j];
+                crs_matrix->col_idx[k] = j;
+                k++;
+            }
+        }
+    }
 
-    crs_matrix->rows = rows;
-    crs_matrix->cols = cols;
+    return crs_validate(crs_matrix);
+}
 
-    // Step 2: Allocate thread-private workspaces
-    size_t* thread_row_starts = (size_t*) malloc((omp_get_max_threads() + 1) * sizeof(size_t));
-    if (!thread_row_starts) {
-        fprintf(stderr, "Memory allocation for thread-private workspaces failed.\n");
-        free_crs_matrix(crs_matrix);
-        return -1;
+// Sorts the triplet indices of one row by (column, triplet index) (insertion sort: assembled
+// rows are short and usually almost sorted)
+static void crs_sort_row(size_t* idx, size_t len, const size_t* col) {
+    for (size_t a = 1; a < len; ++a) {
+        const size_t e = idx[a];
+        const size_t c = col[e];
+        size_t b = a;
+        while (b > 0 && (col[idx[b - 1]] > c || (col[idx[b - 1]] == c && idx[b - 1] > e))) {
+            idx[b] = idx[b - 1];
+            b--;
+        }
+        idx[b] = e;
     }
-    thread_row_starts[0] = 0;
+}
 
-    // Step 3: Divide rows among threads and compute local nnz
-    int memory_error = 0;
-    #pragma omp parallel
-    {
-        int thread_id = omp_get_thread_num();
-        int num_threads = omp_get_num_threads();
+// Entry of a long row for qsort
+typedef struct {
+    size_t col;
+    size_t pos;       // Triplet index (input order of equal columns)
+} crs_entry;
 
-        size_t start_row = (rows * thread_id) / num_threads;
-        size_t end_row = (rows * (thread_id + 1)) / num_threads;
+static int crs_entry_compare(const void* a, const void* b) {
+    const crs_entry* x = (const crs_entry*) a;
+    const crs_entry* y = (const crs_entry*) b;
+    if (x->col != y->col) {
+        return (x->col < y->col) ? -1 : 1;
+    }
+    return (x->pos < y->pos) ? -1 : (x->pos > y->pos);
+}
 
-        size_t local_nnz = 0;
+// Rows longer than this are sorted with qsort instead of insertion sort
+#define CRS_SORT_INSERTION_MAX 64
 
-        // Count non-zero elements in thread's portion
-        for (size_t i = start_row; i < end_row; ++i) {
-            for (size_t j = 0; j < cols; ++j) {
-                if (dense[i * cols + j] != 0.0) {
-                    local_nnz++;
-                }
-            }
-        }
+// Sort of the triplet indices of one row by (column, triplet index); returns -1 if the scratch
+// allocation fails
+static int crs_sort_row_any(size_t* idx, size_t len, const size_t* col) {
+    if (len <= CRS_SORT_INSERTION_MAX) {
+        crs_sort_row(idx, len, col);
+        return 0;
+    }
+    crs_entry* entries = (crs_entry*) malloc(len * sizeof(crs_entry));
+    if (!entries) {
+        return -1;
+    }
+    for (size_t a = 0; a < len; ++a) {
+        entries[a].col = col[idx[a]];
+        entries[a].pos = idx[a];
+    }
+    qsort(entries, len, sizeof(crs_entry), crs_entry_compare);
+    for (size_t a = 0; a < len; ++a) {
+        idx[a] = entries[a].pos;
+    }
+    free(entries);
+    return 0;
+}
 
-        thread_row_starts[thread_id + 1] = local_nnz;
+/*
+ * Function: coo_to_crs
+ * --------------------
+ * Builds a CRS matrix from coordinate (COO) triplets (row[e], col[e], value[e]), e < nnz, as
+ * written by assembly loops: the triplets may come in any order and repeat a position, whose
+ * values are then summed (finite-volume assembly adds every face to both of its cells).
+ *
+ * O(nnz + rows) work and memory, every step parallel:
+ *  1. One shared row histogram (atomic increments), turned into row offsets with a parallel
+ *     prefix sum.
+ *  2. Every triplet index is scattered to its row through an atomic cursor per row.
+ *  3. Every row is sorted by (column, triplet index) and duplicate columns are summed in
+ *     input order: the scatter order does not matter, so the result does not depend on the
+ *     thread count or the scheduling.
+ *  4. The merged rows are counted, prefix-summed and compacted into the final arrays.
+ * The result is validated (crs_validate). Explicit zeros are kept as structural entries.
+ *
+ * Parameters:
+ *   row, col, value - Triplets (nnz entries each)
+ *   nnz             - Number of triplets (0 gives an empty matrix)
+ *   rows, cols      - Dimensions of the matrix
+ *   A               - Output matrix (allocated here, free with free_crs_matrix)
+ *
+ * Returns:
+ *   - 0 on success
+ *   - -1 on invalid input (including an index out of range) or memory allocation failure
+ */
+int coo_to_crs(const size_t* row, const size_t* col, const double* value, size_t nnz, size_t rows, size_t cols,
+               CRSMatrix* A) {
 
-        #pragma omp barrier
-        #pragma omp single
-        {
-            // Compute prefix sum of thread-local nnz counts
-            for (int t = 0; t <= num_threads; ++t) {
-                thread_row_starts[t] += thread_row_starts[t - 1];
-            }
+    if (!A || rows == 0 || cols == 0 || (nnz > 0 && (!row || !col || !value))) {
+        fprintf(stderr, "Invalid input to coo_to_crs.\n");
+        return -1;
+    }
+    crs_init(A, rows, cols);
+
+    // Indices in range
+    int out_of_range = 0;
+    #pragma omp parallel for reduction(|:out_of_range) if (nnz >= (size_t) PARALLEL_THRESHOLD)
+    for (long long e = 0; e < (long long) nnz; ++e) {
+        out_of_range |= (row[e] >= rows || col[e] >= cols);
+    }
+    if (out_of_range) {
+        fprintf(stderr, "Triplet index out of range in coo_to_crs.\n");
+        return -1;
+    }
+
+    const int parallel = (nnz >= (size_t) SPARSE_PARALLEL_THRESHOLD);
+    size_t* raw_ptr = (size_t*) calloc(rows + 1, sizeof(size_t));
+    size_t* raw_idx = (size_t*) malloc((nnz + 1) * sizeof(size_t));      // Triplet indices, then merged columns
+    double* raw_val = (double*) malloc((nnz + 1) * sizeof(double));
+    A->row_ptr = (size_t*) malloc((rows + 1) * sizeof(size_t));          // Scatter cursors, then merged lengths
+    int error = (!raw_ptr || !raw_idx || !raw_val || !A->row_ptr);
+
+    if (!error) {
+        // 1. Row lengths and row offsets
+        #pragma omp parallel for schedule(static) if (parallel)
+        for (long long e = 0; e < (long long) nnz; ++e) {
+            #pragma omp atomic
+            raw_ptr[row[e]]++;
         }
+        crs_prefix_sum(raw_ptr, rows);
 
-        // Allocate row_ptr_local with proper size
-        size_t* row_ptr_local = (size_t*) malloc((end_row - start_row + 1) * sizeof(size_t));
+        // 2. Scatter the triplet indices (any order inside a row)
+        memcpy(A->row_ptr, raw_ptr, (rows + 1) * sizeof(size_t));
+        size_t* cursor = A->row_ptr;
+        #pragma omp parallel for schedule(static) if (parallel)
+        for (long long e = 0; e < (long long) nnz; ++e) {
+            size_t dst;
+            #pragma omp atomic capture
+            dst = cursor[row[e]]++;
+            raw_idx[dst] = (size_t) e;
+        }
 
-        // Handle potential null pointer for row_ptr_local
-        if (!row_ptr_local) {
-            #pragma omp critical
-            {
-                fprintf(stderr, "Thread %d failed to allocate memory for row_ptr_local. Exiting thread.\n", omp_get_thread_num());
-                memory_error = 1;  // Signal memory allocation failure
-            }
-            #pragma omp cancel parallel   //Stop all threads in the parallel region
-        }
-        
-        // Step 4: Populate thread_local CRS arrays
-        size_t k = thread_row_starts[thread_id];
-        for (size_t i = start_row; i < end_row; ++i) {
-            size_t local_index = i - start_row;  // Compute local index
-            if (local_index >= (end_row - start_row + 1)) {
-                #pragma omp critical
-                {
-                    fprintf(stderr, "Thread %d detected out-of-bounds access in row_ptr_local.\n", omp_get_thread_num());
-                }
-                memory_error = 1;
-                #pragma omp cancel parallel   //Stop all threads in the parallel region
+        // 3. Sort every row, sum the duplicates in place and count the merged entries
+        #pragma omp parallel for schedule(dynamic, 256) reduction(|:error) if (parallel)
+        for (long long r = 0; r < (long long) rows; ++r) {
+            const size_t begin = raw_ptr[r];
+            const size_t len = raw_ptr[r + 1] - begin;
+            size_t* c = raw_idx + begin;
+            double* v = raw_val + begin;
+            if (crs_sort_row_any(c, len, col) != 0) {
+                error = 1;
+                continue;
             }
-
-            row_ptr_local[i - start_row] = k;  // Thread-local row_ptr entry
-            for (size_t j = 0; j < cols; ++j) {
-                if (dense[i * cols + j] != 0.0) {
-                    crs_matrix->values[k] = dense[i * cols +j];
-                    crs_matrix->col_idx[k] = j;
-                    k++;
+            size_t unique = 0;
+            for (size_t a = 0; a < len; ++a) {
+                const size_t e = c[a];
+                if (unique > 0 && c[unique - 1] == col[e]) {
+                    v[unique - 1] += value[e];
+                } else {
+                    c[unique] = col[e];
+                    v[unique] = value[e];
+                    unique++;
                 }
             }
+            A->row_ptr[r] = unique;
         }
+    }
 
-        // Final entry for this thread's row_ptr
-        size_t final_index = end_row - start_row;
-        if (final_index >= (end_row - start_row + 1)) {
-            #pragma omp critical
-            {
-                fprintf(stderr, "Thread %d detected out-of-bounds access in row_ptr_local final entry.\n", omp_get_thread_num());
-            }
-            memory_error = 1;
-            #pragma omp cancel parallel   //Stop all threads in the parallel region
+    if (!error) {
+        // 4. Compact the merged rows
+        crs_prefix_sum(A->row_ptr, rows);
+        A->nnz = A->row_ptr[rows];
+        A->col_idx = (size_t*) malloc((A->nnz + 1) * sizeof(size_t));
+        A->values = (double*) malloc((A->nnz + 1) * sizeof(double));
+        error = (!A->col_idx || !A->values);
+    }
+    if (!error) {
+        #pragma omp parallel for schedule(static) if (parallel)
+        for (long long r = 0; r < (long long) rows; ++r) {
+            const size_t len = A->row_ptr[r + 1] - A->row_ptr[r];
+            memcpy(A->col_idx + A->row_ptr[r], raw_idx + raw_ptr[r], len * sizeof(size_t));
+            memcpy(A->values + A->row_ptr[r], raw_val + raw_ptr[r], len * sizeof(double));
         }
+    }
 
-        row_ptr_local[end_row - start_row] = k;  // Final row_ptr entry for this thread
+    free(raw_ptr);
+    free(raw_idx);
+    free(raw_val);
+    if (error) {
+        fprintf(stderr, "Memory allocation failed in coo_to_crs.\n");
+        free_crs_matrix(A);
+        return -1;
+    }
+    return crs_validate(A);
+}
 
-        // Step 5: Aggregate results into global CRS arrays
-        #pragma omp critical
-        {
-            if (!memory_error) {
-                size_t rows_processed = end_row - start_row;
-                for (size_t r = 0; r <= rows_processed ; ++r) {
-                    crs_matrix->row_ptr[start_row + r] = row_ptr_local[r];
-                }
-            }
+// Frees the copies derived from the structure (32-bit column indices, SELL-C-sigma). Without
+// col_idx (crs_narrow_index) col_idx32 is the only index array and is kept.
+static void crs_free_copies(CRSMatrix* matrix) {
+    if (matrix->col_idx) {
+        free(matrix->col_idx32);
+        matrix->col_idx32 = NULL;
+    }
+    if (matrix->sell) {
+        free_sell_matrix(matrix->sell);
+        free(matrix->sell);
+    }
+    matrix->sell = NULL;
+}
+
+// Stores a 32-bit copy of col_idx in col_idx32 (kept at NULL if the allocation fails: the
+// kernels then use col_idx)
+static void crs_build_index32(CRSMatrix* matrix) {
+    uint32_t* col_idx32 = (uint32_t*) malloc((matrix->nnz > 0 ? matrix->nnz : 1) * sizeof(uint32_t));
+    if (!col_idx32) {
+        return;
+    }
+
+    #pragma omp parallel for simd if (matrix->nnz >= (size_t) PARALLEL_THRESHOLD)
+    for (long long j = 0; j < (long long) matrix->nnz; ++j) {
+        col_idx32[j] = (uint32_t) matrix->col_idx[j];
+    }
+
+    matrix->col_idx32 = col_idx32;
+}
 
+/*
+ * Function: crs_validate
+ * ----------------------
+ * Checks the structure of a CRS matrix ONCE, so that the kernels working on it do not need
+ * to bounds-check row_ptr and col_idx on every call, and splits the rows into contiguous
+ * parts holding roughly the same number of non-zeros (one part per OpenMP thread).
+ *
+ * Parameters:
+ *   matrix - Pointer to the CRSMatrix structure to be checked.
+ *
+ * Returns:
+ *   - 0 on success (matrix->validated is set to 1)
+ *   - -1 if the structure is invalid or memory allocation failed
+ *
+ * The copies derived from the structure are dropped, since the pattern may have changed. If
+ * cols fits in 32 bits, a 32-bit copy of col_idx is stored in col_idx32 and read by the
+ * kernels instead of col_idx (12 instead of 16 bytes per non-zero). Like row_part it is owned
+ * by the matrix; the caller's arrays are neither moved nor freed, so they may live on the
+ * stack or in a std::vector. A matrix without col_idx (see crs_narrow_index) keeps its
+ * col_idx32, which is checked instead. row_ptr stays size_t.
+ *
+ * Checks:
+ *   - row_ptr[0] == 0, row_ptr is non-decreasing and row_ptr[rows] == nnz
+ *   - every col_idx entry is smaller than cols
+ */
+int crs_validate(CRSMatrix* matrix) {
+
+    if (!matrix || !matrix->row_ptr ||
+        (matrix->nnz > 0 && (!matrix->values || (!matrix->col_idx && !matrix->col_idx32)))) {
+        fprintf(stderr, "Invalid input to crs_validate.\n");
+        return -1;
+    }
+    matrix->validated = 0;
+    crs_free_copies(matrix);
+
+    if (matrix->rows == 0 || matrix->cols == 0) {
+        fprintf(stderr, "Matrix dimensions are invalid in crs_validate.\n");
+        return -1;
+    }
+
+    // Check the row pointers
+    if (matrix->row_ptr[0] != 0 || matrix->row_ptr[matrix->rows] != matrix->nnz) {
+        fprintf(stderr, "Error: row_ptr does not span [0, nnz] in crs_validate.\n");
+        return -1;
+    }
+    for (size_t i = 0; i < matrix->rows; ++i) {
+        if (matrix->row_ptr[i] > matrix->row_ptr[i + 1]) {
+            fprintf(stderr, "Error: row_ptr is decreasing at row %zu.\n", i);
+            return -1;
         }
+    }
 
-        free(row_ptr_local);  // Ensure row_ptr_local is freed
+    // Check the column indices
+    for (size_t j = 0; j < matrix->nnz; ++j) {
+        if (crs_col(matrix, j) >= matrix->cols) {
+            fprintf(stderr, "Error: col_idx out of bounds at index %zu.\n", j);
+            return -1;
+        }
+    }
 
+    // Build the nnz-balanced row partition: part p starts at the first row whose
+    // row_ptr reaches p * nnz / num_parts
+    int num_parts = omp_get_max_threads();
+    if ((size_t) num_parts > matrix->rows) {
+        num_parts = (int) matrix->rows;
     }
 
-    if (memory_error) {
-        fprintf(stderr, "Memory allocation failed in one of the threads.\n");
-        free(thread_row_starts);
-        free_crs_matrix(crs_matrix);
+    size_t* row_part = (size_t*) malloc((num_parts + 1) * sizeof(size_t));
+    if (!row_part) {
+        fprintf(stderr, "Memory allocation failed in crs_validate.\n");
         return -1;
     }
 
-    // Step 6: Finalize global row_ptr
-    crs_matrix->row_ptr[rows] = thread_row_starts[omp_get_max_threads()];
-    free(thread_row_starts);
+    row_part[0] = 0;
+    size_t row = 0;
+    for (int p = 1; p < num_parts; ++p) {
+        size_t target = (matrix->nnz * (size_t) p) / (size_t) num_parts;
+        while (row < matrix->rows && matrix->row_ptr[row] < target) {
+            row++;
+        }
+        row_part[p] = row;
+    }
+    row_part[num_parts] = matrix->rows;
+
+    free(matrix->row_part);
+    matrix->row_part = row_part;
+    matrix->num_parts = num_parts;
+    if (matrix->col_idx && matrix->cols <= CRS_INDEX32_MAX) {
+        crs_build_index32(matrix);
+    }
+    matrix->validated = 1;
 
     return 0;
+}
+
+/*
+ * Function: crs_narrow_index
+ * --------------------------
+ * Frees the size_t column indices of a validated matrix that has the 32-bit copy, so that the
+ * matrix keeps one index array (12 instead of 20 bytes per non-zero). Only for matrices that
+ * own a malloc'd col_idx, e.g. built by dense_to_crs, coo_to_crs or stencil_to_crs. Later
+ * validations keep col_idx32; the kernels and crs_col read either width.
+ *
+ * Returns:
+ *   - 0 on success (also if col_idx32 is not set, e.g. cols does not fit in 32 bits: col_idx is kept)
+ *   - -1 if the matrix is not validated
+ */
+int crs_narrow_index(CRSMatrix* matrix) {
+    if (!matrix || !matrix->validated) {
+        fprintf(stderr, "Invalid input to crs_narrow_index.\n");
+        return -1;
+    }
+    if (matrix->col_idx32) {
+        free(matrix->col_idx);
+        matrix->col_idx = NULL;
+    }
+    return 0;
+}
+
+/*
+ * Function: crs_transpose
+ * -----------------------
+ * Computes At = A^T in CRS format (counting sort by column, O(nnz + cols)). The rows of At
+ * are sorted by column index because the rows of A are scanned in increasing order.
+ *
+ * Parameters:
+ *   A  - Validated CRS matrix
+ *   At - Output matrix (allocated here, validated, free with free_crs_matrix)
+ *
+ * Returns:
+ *   - 0 on success
+ *   - -1 on invalid input or memory allocation failure
+ */
+int crs_transpose(const CRSMatrix* A, CRSMatrix* At) {
+
+    if (!A || !At || !A->validated) {
+        fprintf(stderr, "Invalid input to crs_transpose.\n");
+        return -1;
+    }
+
+    At->values = (double*) malloc((A->nnz + 1) * sizeof(double));
+    At->col_idx = (size_t*) malloc((A->nnz + 1) * sizeof(size_t));
+    At->row_ptr = (size_t*) calloc(A->cols + 1, sizeof(size_t));
+    At->row_part = NULL;
+    At->num_parts = 0;
+    At->validated = 0;
+    At->sell = NULL;
+    At->col_idx32 = NULL;
+    if (!At->values || !At->col_idx || !At->row_ptr) {
+        fprintf(stderr, "Memory allocation failed in crs_transpose.\n");
+        free_crs_matrix(At);
+        return -1;
+    }
+    At->nnz = A->nnz;
+    At->rows = A->cols;
+    At->cols = A->rows;
+
+    // Entries per column of A, then prefix sum
+    for (size_t j = 0; j < A->nnz; ++j) {
+        At->row_ptr[crs_col(A, j) + 1]++;
+    }
+    for (size_t c = 0; c < A->cols; ++c) {
+        At->row_ptr[c + 1] += At->row_ptr[c];
+    }
+
+    // Scatter, using row_ptr[c] as insertion cursor of row c of At
+    for (size_t i = 0; i < A->rows; ++i) {
+        for (size_t j = A->row_ptr[i]; j < A->row_ptr[i + 1]; ++j) {
+            const size_t dst = At->row_ptr[crs_col(A, j)]++;
+            At->col_idx[dst] = i;
+            At->values[dst] = A->values[j];
+        }
+    }
+
+    // The cursors now point at the end of every row: shift back
+    for (size_t c = A->cols; c > 0; --c) {
+        At->row_ptr[c] = At->row_ptr[c - 1];
+    }
+    At->row_ptr[0] = 0;
 
+    return crs_validate(At);
 }
 
 /*
@@ -191,15 +580,23 @@ int dense_to_crs(const double* dense, size_t rows, size_t cols, CRSMatrix* crs_m
  *   matrix - Pointer to the CRSMatrix structure to be freed.
  *
  * This function releases the memory allocated for the values, column indices, and row
- * pointers of the CRS matrix and sets the pointers to NULL to avoid dangling references.
+ * pointers of the CRS matrix (and its row partition and SELL-C-sigma copy, if any) and sets
+ * the pointers to NULL to avoid dangling references.
  */
 void free_crs_matrix(CRSMatrix* matrix) {
     if (!matrix) return;  // Handle null pointer
+    crs_free_copies(matrix);
     if (matrix->values) free(matrix->values);
     if (matrix->col_idx) free(matrix->col_idx);
+    if (matrix->col_idx32) free(matrix->col_idx32);
     if (matrix->row_ptr) free(matrix->row_ptr);
+    if (matrix->row_part) free(matrix->row_part);
 
     matrix->row_ptr = NULL;
     matrix->col_idx = NULL;
+    matrix->col_idx32 = NULL;
     matrix->values = NULL;
+    matrix->row_part = NULL;
+    matrix->num_parts = 0;
+    matrix->validated = 0;
 }
\ No newline at end of file
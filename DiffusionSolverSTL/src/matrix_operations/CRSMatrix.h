@@ -6,25 +6,80 @@
 #ifndef PROJECT_02_FVM_CRSMATRIX_H
 #define PROJECT_02_FVM_CRSMATRIX_H
 
-#include <cstddef>  // for size_t
+#include <stddef.h>  // for size_t
+#include <stdint.h>  // for uint32_t
+
+#ifdef __cplusplus
+extern "C" {
+#endif
 
 /*
  * @struct CRSMatrix
  * Represents a sparse matrix in Compressed Row Storage (CRS) format.
+ *
+ * The structure is checked ONCE by 'crs_validate', which also stores an nnz-balanced row
+ * partition for the parallel kernels. The hot kernels (e.g. crs_mat_vec_mult) only test the
+ * 'validated' flag instead of bounds-checking every entry on every call. Any change of the
+ * sparsity pattern requires another call to 'crs_validate'.
+ *
+ * Assembly code writes the size_t column indices col_idx. If cols fits in 32 bits, crs_validate
+ * also stores a 32-bit copy in col_idx32, which the kernels read instead (12 instead of 16 bytes
+ * per non-zero); row_ptr (one entry per row) stays size_t. The owner of a malloc'd col_idx may
+ * drop it with crs_narrow_index, so that only col_idx32 is kept. The kernels take the index
+ * type as a parameter (crs_index_kernels.h, CRS_INDEX_CALL) and pick it once per call; setup
+ * code reading single entries uses crs_col.
+ *
+ * 'sell' optionally holds a SELL-C-sigma copy of the matrix (see SELLMatrix.h, crs_attach_sell)
+ * that the SpMV kernels use instead of the CRS arrays; after changing 'values' in place, call
+ * crs_refresh_sell to update it. Like row_part and col_idx32 these copies are owned by
+ * the matrix, so hand-built matrices must start with them at NULL (e.g. CRSMatrix A{}).
  */
+struct SELLMatrix;
+
 typedef struct {
     double* values;     // None_zero values
-    size_t* col_idx;    // Column indices of non-zero values
+    size_t* col_idx;    // Column indices of non-zero values (NULL after crs_narrow_index)
     size_t* row_ptr;    // Row pointers
     size_t nnz;         // Number of non-zero elements
     size_t rows;        // Number of row in the matrix
     size_t cols;        // Number of columns in the matrix
+    size_t* row_part;   // Row partition with ~equal nnz per part (num_parts + 1 entries), set by crs_validate
+    int num_parts;      // Number of parts in row_part
+    int validated;      // 1 once crs_validate succeeded, 0 otherwise
+    struct SELLMatrix* sell;  // Optional SELL-C-sigma copy used by the SpMV kernels, NULL if none
+    uint32_t* col_idx32;      // 32-bit copy of col_idx built by crs_validate, NULL if cols does not fit
 } CRSMatrix;
 
-// Function to initialize CRS from dense matrix (C function)
+// Largest cols for which crs_validate stores the 32-bit column indices
+#define CRS_INDEX32_MAX ((size_t) UINT32_MAX)
+
+// Column index of entry j in the stored width (setup code; the kernels use CRS_INDEX_CALL)
+static inline size_t crs_col(const CRSMatrix* A, size_t j) {
+    return A->col_idx32 ? (size_t) A->col_idx32[j] : A->col_idx[j];
+}
+
+// Function to initialize CRS from dense matrix (C function), validated
 int dense_to_crs(const double* dense, size_t rows, size_t cols, CRSMatrix* crs_matrix);
 
+// Build a validated CRS matrix from nnz (row, col, value) triplets in any order; repeated
+// positions are summed (parallel, O(nnz + rows))
+int coo_to_crs(const size_t* row, const size_t* col, const double* value, size_t nnz, size_t rows, size_t cols,
+               CRSMatrix* A);
+
+// Check the CRS structure once, build the nnz-balanced row partition and the 32-bit indices
+int crs_validate(CRSMatrix* matrix);
+
+// Opt-in: free the size_t column indices of an owned, validated matrix that has col_idx32
+int crs_narrow_index(CRSMatrix* matrix);
+
+// At = A^T (rows of At sorted by column index)
+int crs_transpose(const CRSMatrix* A, CRSMatrix* At);
+
 // Utility function to free the memory
 void free_crs_matrix(CRSMatrix* matrix);
 
-#endif //PROJECT_02_FVM_CRSMATRIX_H
+#ifdef __cplusplus
+}
+#endif
+
+#endif //PROJECT_02_FVM_CRSMATRIX_H
\ No newline at end of file
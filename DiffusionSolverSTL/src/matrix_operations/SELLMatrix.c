@@ -0,0 +1,521 @@
+/*
+ * File: SELLMatrix.c
+ * ------------------
+ * This file contains the SELL-C-sigma (sliced ELLPACK) sparse format: the conversion from CRS
+ * and the SIMD sparse matrix-vector kernels working on it.
+ *
+ * In CRS every row is a short reduction (5 or 7 entries for the diffusion stencil), which
+ * leaves most of a SIMD register idle and pays a horizontal sum per row. SELL-C-sigma stores
+ * SELL_C rows side by side, so one SIMD instruction advances SELL_C rows at once:
+ *  - AVX-512: one register of 8 row sums, 8-wide loads of values / columns, one gather of x.
+ *  - AVX2: two registers of 4 row sums.
+ *  - otherwise: the same loop over the lanes, vectorized by the compiler ('omp simd').
+ * The gathers use 32-bit indices when the source matrix has them (see crs_validate).
+ * Sorting the rows by length inside windows of sigma rows keeps the padding of a slice small
+ * for matrices with varying row lengths while keeping the access to x local.
+ *
+ * The intrinsic kernels are compiled when the compiler targets AVX2 / AVX-512, which the
+ * CMake option FVM_SIMD (generic, AVX2, AVX512) selects; sell_simd_kernel reports the choice.
+ *
+ * Functions:
+ *  - crs_to_sell: Converts a validated CRS matrix to SELL-C-sigma.
+ *  - crs_attach_sell: Builds a SELL-C-sigma copy owned by a CRS matrix (used by its kernels).
+ *  - crs_refresh_sell: Copies changed values of a CRS matrix into its SELL-C-sigma copy.
+ *  - sell_mat_vec_mult: y = A * x.
+ *  - sell_cg_update_direction: Fused CG direction update (see crs_cg_update_direction).
+ *  - sell_fill_ratio: Stored entries per non-zero.
+ *  - sell_simd_kernel: Instruction set the kernels were compiled for.
+ *  - free_sell_matrix: Frees the memory of a SELL-C-sigma matrix.
+ */
+
+#include "SELLMatrix.h"
+#include "linear_algebra.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <omp_llvm.h>
+
+// Intrinsic kernels for 8-lane slices; the 64-bit gathers also need a 64-bit size_t
+#if SELL_C == 8
+#if defined(__AVX512F__)
+#define SELL_AVX512 1
+#elif defined(__AVX2__)
+#define SELL_AVX2 1
+#endif
+#endif
+#if SIZE_MAX == 0xFFFFFFFFFFFFFFFF
+#define SELL_GATHER64 1
+#endif
+
+#if defined(SELL_AVX512) || defined(SELL_AVX2)
+#include <immintrin.h>
+#endif
+
+// Row length and index, sorted longest first (ties keep the original order)
+typedef struct {
+    size_t len;
+    size_t row;
+} sell_row_key;
+
+static int sell_compare_rows(const void* a, const void* b) {
+    const sell_row_key* ka = (const sell_row_key*) a;
+    const sell_row_key* kb = (const sell_row_key*) b;
+    if (ka->len != kb->len) {
+        return (ka->len > kb->len) ? -1 : 1;
+    }
+    return (ka->row > kb->row) - (ka->row < kb->row);
+}
+
+/*
+ * Copies the values of A into the lanes of S (same pattern as when S was built), column-major
+ * inside every slice; the padding keeps its zeros.
+ */
+static void sell_copy_values(const CRSMatrix* A, SELLMatrix* S) {
+    const size_t n = S->rows;
+    const size_t* row_ptr = A->row_ptr;
+
+    #pragma omp parallel for if (n >= (size_t) PARALLEL_THRESHOLD)
+    for (long long s = 0; s < (long long) S->num_slices; ++s) {
+        const size_t base = S->slice_ptr[s];
+        for (size_t lane = 0; lane < SELL_C && (size_t) s * SELL_C + lane < n; ++lane) {
+            const size_t row = S->perm[(size_t) s * SELL_C + lane];
+            for (size_t j = row_ptr[row]; j < row_ptr[row + 1]; ++j) {
+                S->values[base + (j - row_ptr[row]) * SELL_C + lane] = A->values[j];
+            }
+        }
+    }
+    S->source = A->values;
+}
+
+/*
+ * Function: crs_to_sell
+ * ---------------------
+ * Converts a validated CRS matrix to SELL-C-sigma format.
+ *
+ * Parameters:
+ *   A     - Source matrix (validated)
+ *   sigma - Sorting window in rows: 1 keeps the CRS row order, larger windows reduce the
+ *           padding of matrices with varying row lengths (SELL_DEFAULT_SIGMA is a good default)
+ *   S     - Output matrix (allocated here, free with free_sell_matrix)
+ *
+ * Returns:
+ *   - 0 on success
+ *   - -1 on invalid input or memory allocation failure
+ */
+int crs_to_sell(const CRSMatrix* A, size_t sigma, SELLMatrix* S) {
+
+    if (!A || !S || !A->validated) {
+        fprintf(stderr, "Invalid input to crs_to_sell.\n");
+        return -1;
+    }
+
+    const size_t n = A->rows;
+    S->rows = n;
+    S->cols = A->cols;
+    S->nnz = A->nnz;
+    S->num_slices = (n + SELL_C - 1) / SELL_C;
+    S->sigma = (sigma == 0) ? 1 : (sigma > n ? n : sigma);
+    S->values = NULL;
+    S->source = NULL;
+    S->col_idx = NULL;
+    S->col_idx32 = NULL;
+    S->slice_ptr = (size_t*) malloc((S->num_slices + 1) * sizeof(size_t));
+    S->perm = (size_t*) malloc(n * sizeof(size_t));
+    sell_row_key* keys = (sell_row_key*) malloc(n * sizeof(sell_row_key));
+    if (!S->slice_ptr || !S->perm || !keys) {
+        fprintf(stderr, "Memory allocation failed in crs_to_sell.\n");
+        free(keys);
+        free_sell_matrix(S);
+        return -1;
+    }
+
+    const size_t* row_ptr = A->row_ptr;
+    const long long num_slices = (long long) S->num_slices;
+
+    // Sort the rows by length inside every window of sigma rows
+    #pragma omp parallel for if (n >= (size_t) PARALLEL_THRESHOLD)
+    for (long long i = 0; i < (long long) n; ++i) {
+        keys[i].len = row_ptr[i + 1] - row_ptr[i];
+        keys[i].row = (size_t) i;
+    }
+    if (S->sigma > 1) {
+        const long long num_windows = (long long) ((n + S->sigma - 1) / S->sigma);
+        #pragma omp parallel for schedule(dynamic) if (n >= (size_t) PARALLEL_THRESHOLD)
+        for (long long w = 0; w < num_windows; ++w) {
+            const size_t start = (size_t) w * S->sigma;
+            const size_t end = (start + S->sigma < n) ? start + S->sigma : n;
+            qsort(keys + start, end - start, sizeof(sell_row_key), sell_compare_rows);
+        }
+    }
+
+    // Width of every slice = its longest row
+    S->slice_ptr[0] = 0;
+    #pragma omp parallel for if (n >= (size_t) PARALLEL_THRESHOLD)
+    for (long long s = 0; s < num_slices; ++s) {
+        size_t width = 0;
+        for (size_t r = (size_t) s * SELL_C; r < (size_t) (s + 1) * SELL_C && r < n; ++r) {
+            S->perm[r] = keys[r].row;
+            width = (keys[r].len > width) ? keys[r].len : width;
+        }
+        S->slice_ptr[s + 1] = width * SELL_C;
+    }
+    for (long long s = 0; s < num_slices; ++s) {
+        S->slice_ptr[s + 1] += S->slice_ptr[s];
+    }
+    free(keys);
+
+    const size_t stored = (S->slice_ptr[S->num_slices] > 0) ? S->slice_ptr[S->num_slices] : 1;
+    S->values = (double*) malloc(stored * sizeof(double));
+    if (A->col_idx32) {
+        S->col_idx32 = (uint32_t*) malloc(stored * sizeof(uint32_t));
+    } else {
+        S->col_idx = (size_t*) malloc(stored * sizeof(size_t));
+    }
+    if (!S->values || (!S->col_idx && !S->col_idx32)) {
+        fprintf(stderr, "Memory allocation failed in crs_to_sell.\n");
+        free_sell_matrix(S);
+        return -1;
+    }
+
+    // Scatter the columns into the lanes, column-major inside the slice, padding with column 0
+    // and value 0
+    #pragma omp parallel for if (stored >= (size_t) SPARSE_PARALLEL_THRESHOLD)
+    for (long long s = 0; s < num_slices; ++s) {
+        const size_t base = S->slice_ptr[s];
+        const size_t width = (S->slice_ptr[s + 1] - base) / SELL_C;
+        for (size_t lane = 0; lane < SELL_C; ++lane) {
+            const size_t r = (size_t) s * SELL_C + lane;
+            const size_t start = (r < n) ? row_ptr[S->perm[r]] : 0;
+            const size_t len = (r < n) ? row_ptr[S->perm[r] + 1] - start : 0;
+            for (size_t k = 0; k < width; ++k) {
+                const size_t pos = base + k * SELL_C + lane;
+                const size_t col = (k < len) ? crs_col(A, start + k) : 0;
+                S->values[pos] = 0.0;
+                if (S->col_idx32) {
+                    S->col_idx32[pos] = (uint32_t) col;
+                } else {
+                    S->col_idx[pos] = col;
+                }
+            }
+        }
+    }
+    sell_copy_values(A, S);
+
+    return 0;
+}
+
+/*
+ * Function: crs_attach_sell
+ * -------------------------
+ * Builds a SELL-C-sigma copy of A and stores it in A->sell, replacing a previous copy. From
+ * then on crs_mat_vec_mult and crs_cg_update_direction (and so every solver working on A) use
+ * the SELL kernels. The copy holds its own values: after changing the values of A in place,
+ * call crs_refresh_sell (or this function again). The kernels only use the copy while
+ * A->values is the array it was copied from, so re-assembling A into new arrays falls back
+ * to the CRS kernel. It is freed by free_crs_matrix and dropped by crs_validate.
+ *
+ * Returns:
+ *   - 0 on success
+ *   - -1 on invalid input or memory allocation failure (A then has no SELL copy)
+ */
+int crs_attach_sell(CRSMatrix* A, size_t sigma) {
+
+    if (!A || !A->validated) {
+        fprintf(stderr, "Invalid input to crs_attach_sell.\n");
+        return -1;
+    }
+
+    if (A->sell) {
+        free_sell_matrix(A->sell);
+        free(A->sell);
+        A->sell = NULL;
+    }
+
+    SELLMatrix* S = (SELLMatrix*) malloc(sizeof(SELLMatrix));
+    if (!S) {
+        fprintf(stderr, "Memory allocation failed in crs_attach_sell.\n");
+        return -1;
+    }
+    if (crs_to_sell(A, sigma, S) != 0) {
+        free(S);
+        return -1;
+    }
+
+    A->sell = S;
+    return 0;
+}
+
+/*
+ * Function: crs_refresh_sell
+ * --------------------------
+ * Copies the current values of A into its SELL-C-sigma copy, O(nnz). Must be called whenever
+ * the values of A change in place (same sparsity pattern); a changed pattern requires
+ * crs_validate and crs_attach_sell instead. Does nothing if A has no SELL copy.
+ *
+ * Returns:
+ *   - 0 on success
+ *   - -1 on invalid input
+ */
+int crs_refresh_sell(CRSMatrix* A) {
+
+    if (!A || !A->validated) {
+        fprintf(stderr, "Invalid input to crs_refresh_sell.\n");
+        return -1;
+    }
+    if (!A->sell) {
+        return 0;
+    }
+    if (A->sell->rows != A->rows || A->sell->nnz != A->nnz) {
+        fprintf(stderr, "Error: the SELL copy does not match the pattern of the matrix in crs_refresh_sell.\n");
+        return -1;
+    }
+
+    sell_copy_values(A, A->sell);
+    return 0;
+}
+
+/*
+ * Computes the SELL_C row sums of slice s: acc[lane] = sum_k values * x[col_idx], with 32-bit
+ * column indices.
+ */
+static inline void sell_slice32(const SELLMatrix* S, size_t s, const double* x, double* acc) {
+    const size_t base = S->slice_ptr[s];
+    const size_t width = (S->slice_ptr[s + 1] - base) / SELL_C;
+    const double* values = S->values + base;
+    const uint32_t* col_idx = S->col_idx32 + base;
+
+#if defined(SELL_AVX512)
+    __m512d sum = _mm512_setzero_pd();
+    for (size_t k = 0; k < width; ++k) {
+        const __m256i idx = _mm256_loadu_si256((const __m256i*) (col_idx + k * SELL_C));
+        const __m512d xv = _mm512_i32gather_pd(idx, x, 8);
+        sum = _mm512_fmadd_pd(_mm512_loadu_pd(values + k * SELL_C), xv, sum);
+    }
+    _mm512_storeu_pd(acc, sum);
+#elif defined(SELL_AVX2)
+    __m256d lo = _mm256_setzero_pd();
+    __m256d hi = _mm256_setzero_pd();
+    for (size_t k = 0; k < width; ++k) {
+        const double* v = values + k * SELL_C;
+        const uint32_t* c = col_idx + k * SELL_C;
+        const __m256d x_lo = _mm256_i32gather_pd(x, _mm_loadu_si128((const __m128i*) c), 8);
+        const __m256d x_hi = _mm256_i32gather_pd(x, _mm_loadu_si128((const __m128i*) (c + 4)), 8);
+#if defined(__FMA__)
+        lo = _mm256_fmadd_pd(_mm256_loadu_pd(v), x_lo, lo);
+        hi = _mm256_fmadd_pd(_mm256_loadu_pd(v + 4), x_hi, hi);
+#else
+        lo = _mm256_add_pd(lo, _mm256_mul_pd(_mm256_loadu_pd(v), x_lo));
+        hi = _mm256_add_pd(hi, _mm256_mul_pd(_mm256_loadu_pd(v + 4), x_hi));
+#endif
+    }
+    _mm256_storeu_pd(acc, lo);
+    _mm256_storeu_pd(acc + 4, hi);
+#else
+    for (size_t lane = 0; lane < SELL_C; ++lane) {
+        acc[lane] = 0.0;
+    }
+    for (size_t k = 0; k < width; ++k) {
+        const double* v = values + k * SELL_C;
+        const uint32_t* c = col_idx + k * SELL_C;
+        #pragma omp simd
+        for (size_t lane = 0; lane < SELL_C; ++lane) {
+            acc[lane] += v[lane] * x[c[lane]];
+        }
+    }
+#endif
+}
+
+/*
+ * Same as sell_slice32 with size_t column indices.
+ */
+static inline void sell_slice64(const SELLMatrix* S, size_t s, const double* x, double* acc) {
+    const size_t base = S->slice_ptr[s];
+    const size_t width = (S->slice_ptr[s + 1] - base) / SELL_C;
+    const double* values = S->values + base;
+    const size_t* col_idx = S->col_idx + base;
+
+#if defined(SELL_AVX512) && defined(SELL_GATHER64)
+    __m512d sum = _mm512_setzero_pd();
+    for (size_t k = 0; k < width; ++k) {
+        const __m512i idx = _mm512_loadu_si512((const void*) (col_idx + k * SELL_C));
+        const __m512d xv = _mm512_i64gather_pd(idx, x, 8);
+        sum = _mm512_fmadd_pd(_mm512_loadu_pd(values + k * SELL_C), xv, sum);
+    }
+    _mm512_storeu_pd(acc, sum);
+#elif defined(SELL_AVX2) && defined(SELL_GATHER64)
+    __m256d lo = _mm256_setzero_pd();
+    __m256d hi = _mm256_setzero_pd();
+    for (size_t k = 0; k < width; ++k) {
+        const double* v = values + k * SELL_C;
+        const size_t* c = col_idx + k * SELL_C;
+        const __m256d x_lo = _mm256_i64gather_pd(x, _mm256_loadu_si256((const __m256i*) c), 8);
+        const __m256d x_hi = _mm256_i64gather_pd(x, _mm256_loadu_si256((const __m256i*) (c + 4)), 8);
+#if defined(__FMA__)
+        lo = _mm256_fmadd_pd(_mm256_loadu_pd(v), x_lo, lo);
+        hi = _mm256_fmadd_pd(_mm256_loadu_pd(v + 4), x_hi, hi);
+#else
+        lo = _mm256_add_pd(lo, _mm256_mul_pd(_mm256_loadu_pd(v), x_lo));
+        hi = _mm256_add_pd(hi, _mm256_mul_pd(_mm256_loadu_pd(v + 4), x_hi));
+#endif
+    }
+    _mm256_storeu_pd(acc, lo);
+    _mm256_storeu_pd(acc + 4, hi);
+#else
+    for (size_t lane = 0; lane < SELL_C; ++lane) {
+        acc[lane] = 0.0;
+    }
+    for (size_t k = 0; k < width; ++k) {
+        const double* v = values + k * SELL_C;
+        const size_t* c = col_idx + k * SELL_C;
+        #pragma omp simd
+        for (size_t lane = 0; lane < SELL_C; ++lane) {
+            acc[lane] += v[lane] * x[c[lane]];
+        }
+    }
+#endif
+}
+
+static inline void sell_slice(const SELLMatrix* S, size_t s, const double* x, double* acc) {
+    if (S->col_idx32) {
+        sell_slice32(S, s, x, acc);
+    } else {
+        sell_slice64(S, s, x, acc);
+    }
+}
+
+/*
+ * Function: sell_mat_vec_mult
+ * ---------------------------
+ * Computes y = A * x with the SELL-C-sigma matrix; y is indexed like the rows of the source
+ * CRS matrix. Slices are distributed over the OpenMP threads, small matrices
+ * (nnz < SPARSE_PARALLEL_THRESHOLD) are multiplied serially.
+ *
+ * Returns:
+ *   - 0 on success
+ *   - -1 on null pointers
+ */
+int sell_mat_vec_mult(const SELLMatrix* S, const double* x, double* y) {
+
+    if (!S || !S->slice_ptr || !x || !y) {
+        fprintf(stderr, "Error: Null pointer passed to sell_mat_vec_mult.\n");
+        return -1;
+    }
+
+    const size_t n = S->rows;
+    const size_t* perm = S->perm;
+
+    #pragma omp parallel for schedule(static) if (S->nnz >= (size_t) SPARSE_PARALLEL_THRESHOLD)
+    for (long long s = 0; s < (long long) S->num_slices; ++s) {
+        double acc[SELL_C];
+        sell_slice(S, (size_t) s, x, acc);
+
+        const size_t first = (size_t) s * SELL_C;
+        const size_t lanes = (n - first < SELL_C) ? n - first : SELL_C;
+        for (size_t lane = 0; lane < lanes; ++lane) {
+            y[perm[first + lane]] = acc[lane];
+        }
+    }
+
+    return 0;
+}
+
+/*
+ * Function: sell_cg_update_direction
+ * ----------------------------------
+ * Fused CG search-direction kernel of the SELL-C-sigma matrix (see crs_cg_update_direction):
+ *
+ *     p = z + beta * p,   Ap = A * z + beta * Ap,   p_dot_Ap = dot(p, Ap)
+ *
+ * p and Ap are read and written at the rows of the slice only. With beta = 0, p and Ap are
+ * not read.
+ *
+ * Returns:
+ *   - 0 on success
+ *   - -1 on null pointers
+ */
+int sell_cg_update_direction(const SELLMatrix* S, const double* z, double beta, double* p, double* Ap,
+                             double* p_dot_Ap) {
+
+    if (!S || !S->slice_ptr || !z || !p || !Ap || !p_dot_Ap) {
+        fprintf(stderr, "Error: Invalid input to sell_cg_update_direction.\n");
+        return -1;
+    }
+
+    const size_t n = S->rows;
+    const size_t* perm = S->perm;
+    const int first_iteration = (beta == 0.0);
+    double dot = 0.0;
+
+    #pragma omp parallel for schedule(static) reduction(+:dot) if (S->nnz >= (size_t) SPARSE_PARALLEL_THRESHOLD)
+    for (long long s = 0; s < (long long) S->num_slices; ++s) {
+        double acc[SELL_C];
+        sell_slice(S, (size_t) s, z, acc);
+
+        const size_t first = (size_t) s * SELL_C;
+        const size_t lanes = (n - first < SELL_C) ? n - first : SELL_C;
+        for (size_t lane = 0; lane < lanes; ++lane) {
+            const size_t i = perm[first + lane];
+            const double p_i = first_iteration ? z[i] : z[i] + beta * p[i];
+            const double Ap_i = first_iteration ? acc[lane] : acc[lane] + beta * Ap[i];
+            p[i] = p_i;
+            Ap[i] = Ap_i;
+            dot += p_i * Ap_i;
+        }
+    }
+
+    *p_dot_Ap = dot;
+    return 0;
+}
+
+/*
+ * Function: sell_fill_ratio
+ * -------------------------
+ * Returns the number of stored entries (including the padding) per non-zero, 1 meaning no
+ * padding at all.
+ */
+double sell_fill_ratio(const SELLMatrix* S) {
+    if (!S || !S->slice_ptr || S->nnz == 0) {
+        return 1.0;
+    }
+    return (double) S->slice_ptr[S->num_slices] / (double) S->nnz;
+}
+
+/*
+ * Function: sell_simd_kernel
+ * --------------------------
+ * Returns the instruction set of the slice kernels in this build: "AVX512", "AVX2" or
+ * "generic" (loop over the lanes vectorized by the compiler).
+ */
+const char* sell_simd_kernel(void) {
+#if defined(SELL_AVX512)
+    return "AVX512";
+#elif defined(SELL_AVX2)
+    return "AVX2";
+#else
+    return "generic";
+#endif
+}
+
+/*
+ * Function: free_sell_matrix
+ * --------------------------
+ * Frees the arrays of a SELL-C-sigma matrix (not the structure itself).
+ */
+void free_sell_matrix(SELLMatrix* S) {
+    if (!S) return;
+    free(S->slice_ptr);
+    free(S->values);
+    free(S->col_idx);
+    free(S->col_idx32);
+    free(S->perm);
+
+    S->slice_ptr = NULL;
+    S->values = NULL;
+    S->source = NULL;
+    S->col_idx = NULL;
+    S->col_idx32 = NULL;
+    S->perm = NULL;
+    S->num_slices = 0;
+    S->rows = 0;
+    S->nnz = 0;
+}
@@ -0,0 +1,80 @@
+// File: SELLMatrix.h
+
+#ifndef PROJECT_02_FVM_SELLMATRIX_H
+#define PROJECT_02_FVM_SELLMATRIX_H
+
+#include <stddef.h>  // for size_t
+#include "CRSMatrix.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Rows per slice C: one SIMD lane per row (8 doubles = one AVX-512 or two AVX2 registers)
+#define SELL_C 8
+
+// Default sorting window sigma (rows, multiple of SELL_C); 1 keeps the original row order
+#define SELL_DEFAULT_SIGMA 256
+
+/*
+ * @struct SELLMatrix
+ * Sparse matrix in SELL-C-sigma (sliced ELLPACK) format.
+ *
+ * The rows are grouped into slices of SELL_C consecutive rows (after sorting the rows by
+ * length inside windows of 'sigma' rows). A slice is stored column-major and padded to its
+ * longest row, so entry k of all SELL_C rows of a slice are contiguous:
+ *
+ *     values[slice_ptr[s] + k * SELL_C + lane]   (padding: value 0, column 0)
+ *
+ * The SpMV then processes one slice as SELL_C independent row sums in SIMD lanes, with a
+ * contiguous load of values / columns and one gather of x per entry, instead of one short
+ * reduction per row as in CRS. 'perm' maps the lanes back to the rows of the CRS matrix.
+ *
+ * The column indices are stored with the width the CRS kernels read for the source matrix:
+ * 32-bit (col_idx32) if it has the 32-bit indices, size_t (col_idx) otherwise.
+ */
+typedef struct SELLMatrix {
+    size_t rows;            // Number of rows
+    size_t cols;            // Number of columns
+    size_t nnz;             // Non-zeros of the source matrix (without padding)
+    size_t num_slices;      // ceil(rows / SELL_C)
+    size_t sigma;           // Sorting window (rows)
+    size_t* slice_ptr;      // Start of every slice in values / col_idx (num_slices + 1 entries)
+    double* values;         // Slice-wise column-major values, padded with zeros
+    const double* source;   // Values array of the CRS matrix the values were copied from
+    size_t* col_idx;        // Column indices, padded with column 0 (NULL if col_idx32 is used)
+    uint32_t* col_idx32;    // 32-bit column indices, padded with column 0 (NULL if col_idx is used)
+    size_t* perm;           // perm[s * SELL_C + lane] = row of the CRS matrix (rows entries)
+} SELLMatrix;
+
+// Convert a validated CRS matrix, sigma = 1 (no sorting) up to rows (global sorting)
+int crs_to_sell(const CRSMatrix* A, size_t sigma, SELLMatrix* S);
+
+// Build a SELL-C-sigma copy of A owned by A: crs_mat_vec_mult and the fused CRS CG kernel then
+// use it while A->values is the array it was copied from. Call again after changing the
+// pattern of A; freed by free_crs_matrix.
+int crs_attach_sell(CRSMatrix* A, size_t sigma);
+
+// Copy the values of A into its SELL-C-sigma copy, after changing them in place (no-op without copy)
+int crs_refresh_sell(CRSMatrix* A);
+
+// y = A * x with the SELL-C-sigma copy (y indexed like the CRS rows)
+int sell_mat_vec_mult(const SELLMatrix* S, const double* x, double* y);
+
+// Fused CG direction update p = z + beta * p, Ap = A * z + beta * Ap, p_dot_Ap = dot(p, Ap)
+int sell_cg_update_direction(const SELLMatrix* S, const double* z, double beta, double* p, double* Ap,
+                             double* p_dot_Ap);
+
+// Padding overhead: stored entries / nnz (1 = no padding)
+double sell_fill_ratio(const SELLMatrix* S);
+
+// Instruction set of the SELL kernels in this build: "AVX512", "AVX2" or "generic" (see FVM_SIMD)
+const char* sell_simd_kernel(void);
+
+void free_sell_matrix(SELLMatrix* S);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif //PROJECT_02_FVM_SELLMATRIX_H
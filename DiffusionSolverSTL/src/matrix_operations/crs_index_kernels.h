@@ -0,0 +1,149 @@
+/*
+ * File: crs_index_kernels.h
+ * -------------------------
+ * Row kernels of a validated CRS matrix for one column index width. The file has no include
+ * guard: linear_algebra.h includes it once per width, with
+ *
+ *   CRS_INDEX     - column index type (uint32_t for A->col_idx32, size_t for A->col_idx)
+ *   CRS_KERNEL(f) - name of kernel f for this width (f##_u32 / f##_size)
+ *
+ * Every kernel gets A and its column index array and works on a range of rows. Callers pick
+ * the width once per call (or per row part) with CRS_INDEX_CALL, never per row.
+ */
+
+// Sum of values[j] * x[col_idx[j]] over the entries [begin, end)
+static inline double CRS_KERNEL(crs_range_dot)(const CRSMatrix* A, const CRS_INDEX* col_idx, size_t begin,
+                                               size_t end, const double* x) {
+    const double* values = A->values;
+    double sum = 0.0;
+    #pragma omp simd reduction(+:sum)
+    for (size_t j = begin; j < end; ++j) {
+        sum += values[j] * x[col_idx[j]];
+    }
+    return sum;
+}
+
+// y[i - first] = (A * x)_i for the rows [first, last) (y points at the entry of row 'first')
+static inline void CRS_KERNEL(crs_rows_mult)(const CRSMatrix* A, const CRS_INDEX* col_idx, size_t first,
+                                             size_t last, const double* x, double* y) {
+    const size_t* row_ptr = A->row_ptr;
+    for (size_t i = first; i < last; ++i) {
+        y[i - first] = CRS_KERNEL(crs_range_dot)(A, col_idx, row_ptr[i], row_ptr[i + 1], x);
+    }
+}
+
+// Rows [first, last) of crs_cg_update_direction (p = z + beta * p, Ap = A * z + beta * Ap),
+// returns their part of dot(p, Ap); beta == 0 does not read p and Ap
+static inline double CRS_KERNEL(crs_rows_cg_direction)(const CRSMatrix* A, const CRS_INDEX* col_idx, size_t first,
+                                                       size_t last, const double* z, double beta, double* p,
+                                                       double* Ap) {
+    const size_t* row_ptr = A->row_ptr;
+    const int initial = (beta == 0.0);
+    double dot = 0.0;
+    for (size_t i = first; i < last; ++i) {
+        const double sum = CRS_KERNEL(crs_range_dot)(A, col_idx, row_ptr[i], row_ptr[i + 1], z);
+        const double p_i = initial ? z[i] : z[i] + beta * p[i];
+        const double Ap_i = initial ? sum : sum + beta * Ap[i];
+        p[i] = p_i;
+        Ap[i] = Ap_i;
+        dot += p_i * Ap_i;
+    }
+    return dot;
+}
+
+// Rows [first, last) of Y = A * X for k column-major vectors (see crs_mat_vec_mult_block)
+static inline void CRS_KERNEL(crs_rows_mult_block)(const CRSMatrix* A, const CRS_INDEX* col_idx, size_t first,
+                                                   size_t last, const double* X, double* Y, size_t k) {
+    const double* values = A->values;
+    const size_t* row_ptr = A->row_ptr;
+    const size_t rows = A->rows;
+    const size_t cols = A->cols;
+    for (size_t i = first; i < last; ++i) {
+        for (size_t c0 = 0; c0 < k; c0 += CRS_BLOCK_WIDTH) {
+            const size_t width = (k - c0 < CRS_BLOCK_WIDTH) ? k - c0 : CRS_BLOCK_WIDTH;
+            const double* Xc = X + c0 * cols;
+            double sum[CRS_BLOCK_WIDTH] = {0.0};
+            for (size_t j = row_ptr[i]; j < row_ptr[i + 1]; ++j) {
+                const double a = values[j];
+                const size_t col = col_idx[j];
+                #pragma omp simd
+                for (size_t c = 0; c < width; ++c) {
+                    sum[c] += a * Xc[c * cols + col];
+                }
+            }
+            for (size_t c = 0; c < width; ++c) {
+                Y[(c0 + c) * rows + i] = sum[c];
+            }
+        }
+    }
+}
+
+// diag[i] = A(i, i) (0 if not stored) for the rows [first, last)
+static inline void CRS_KERNEL(crs_rows_diagonal)(const CRSMatrix* A, const CRS_INDEX* col_idx, size_t first,
+                                                 size_t last, double* diag) {
+    const size_t* row_ptr = A->row_ptr;
+    for (size_t i = first; i < last; ++i) {
+        diag[i] = 0.0;
+        for (size_t j = row_ptr[i]; j < row_ptr[i + 1]; ++j) {
+            if ((size_t) col_idx[j] == i) {
+                diag[i] = A->values[j];
+                break;
+            }
+        }
+    }
+}
+
+// x_i += omega * (b_i - (A * x)_i) * inv_diag_i for the rows rows[begin .. end), in this order
+static inline void CRS_KERNEL(crs_rows_relax)(const CRSMatrix* A, const CRS_INDEX* col_idx, const size_t* rows,
+                                              size_t begin, size_t end, const double* b, const double* inv_diag,
+                                              double omega, double* x) {
+    const size_t* row_ptr = A->row_ptr;
+    for (size_t q = begin; q < end; ++q) {
+        const size_t i = rows[q];
+        const double sum = CRS_KERNEL(crs_range_dot)(A, col_idx, row_ptr[i], row_ptr[i + 1], x);
+        x[i] += omega * (b[i] - sum) * inv_diag[i];
+    }
+}
+
+// Gauss-Seidel on the rows [lo, hi) (forward or backward), Jacobi with x_old for the columns
+// outside the range: x_i = inv_diag_i * (b_i - sum_{c != i} A(i, c) * x_c)
+static inline void CRS_KERNEL(crs_rows_gauss_seidel)(const CRSMatrix* A, const CRS_INDEX* col_idx, size_t lo,
+                                                     size_t hi, int forward, const double* b, const double* x_old,
+                                                     const double* inv_diag, double* x) {
+    const double* values = A->values;
+    const size_t* row_ptr = A->row_ptr;
+    for (size_t t = 0; t < hi - lo; ++t) {
+        const size_t i = forward ? lo + t : hi - 1 - t;
+        double sum = b[i];
+        for (size_t j = row_ptr[i]; j < row_ptr[i + 1]; ++j) {
+            const size_t c = col_idx[j];
+            if (c == i) continue;
+            sum -= values[j] * ((c >= lo && c < hi) ? x[c] : x_old[c]);
+        }
+        x[i] = sum * inv_diag[i];
+    }
+}
+
+// Serial L * L^T * z = r for a lower-triangular L with sorted rows and the diagonal last in
+// every row (z may alias r): forward substitution by rows of L, backward by columns of L^T
+static inline void CRS_KERNEL(crs_cholesky_solve)(const CRSMatrix* L, const CRS_INDEX* col_idx, const double* r,
+                                                  double* z) {
+    const double* values = L->values;
+    const size_t* row_ptr = L->row_ptr;
+    const size_t n = L->rows;
+
+    for (size_t i = 0; i < n; ++i) {
+        const size_t diag = row_ptr[i + 1] - 1;
+        z[i] = (r[i] - CRS_KERNEL(crs_range_dot)(L, col_idx, row_ptr[i], diag, z)) / values[diag];
+    }
+
+    // Once z[i] is known, remove its contribution from the rows above through row i of L
+    for (size_t i = n; i-- > 0;) {
+        const size_t diag = row_ptr[i + 1] - 1;
+        z[i] /= values[diag];
+        const double zi = z[i];
+        for (size_t j = row_ptr[i]; j < diag; ++j) {
+            z[col_idx[j]] -= values[j] * zi;
+        }
+    }
+}
@@ -4,12 +4,17 @@
 
 #include "linear_algebra.h"
 #include "stdio.h"
+#include <stdlib.h>
 #include <omp_llvm.h>
 #include "CRSMatrix.h"
-#include "CPPVec2CArr.hpp"
+#include "SELLMatrix.h"
 
-// Define a threshold for parallel computation (Should be tune for better performance according different systems/hardware)
-const int PARALLEL_THRESHOLD = 1000;
+// Thresholds for parallel computation (see linear_algebra.h) and tile size of mat_vec_mult:
+// defaults, replaced per machine at startup by the autotuner (utils/autotune.c)
+int PARALLEL_THRESHOLD = 1000;
+int SPARSE_PARALLEL_THRESHOLD = 5000;
+int DENSE_PARALLEL_THRESHOLD = 1000000;
+int MAT_VEC_BLOCK_SIZE = 32;
 
 /*
  * Function: mat_vec_mult
@@ -54,10 +59,8 @@ int mat_vec_mult(const double* A, const double* x, double* y, int n) {
 //        }
 //    }
 
-    // Set the number of threads
-    omp_set_num_threads(omp_get_max_threads());  // Set the number of threads to 4
-    // Optimal block size may vary based on hardware
-    int block_size = 32;
+    // Tile size (tuned per machine, see autotune.c); the thread count is the OpenMP default
+    const int block_size = (MAT_VEC_BLOCK_SIZE > 0) ? MAT_VEC_BLOCK_SIZE : 32;
 
     long long i;
     for (i = 0; i < n; ++i) {
@@ -65,8 +68,7 @@ int mat_vec_mult(const double* A, const double* x, double* y, int n) {
     }
 
     // Check if the matrix size exceeds the threshold for parallelization
-    if (n >= PARALLEL_THRESHOLD) {
-        printf("Parallel computation used for matrix-vector multiplication with %d threads.\n", 32);
+    if ((size_t) n * (size_t) n >= (size_t) DENSE_PARALLEL_THRESHOLD) {
         // Parallel matrix-vector multiplication
 
                 #pragma omp parallel for schedule(static)
@@ -81,7 +83,6 @@ int mat_vec_mult(const double* A, const double* x, double* y, int n) {
                     }
 
     } else {
-        printf("Serial computation used for matrix-vector multiplication\n");
         // Serial matrix-vector multiplication
 //        for (i = 0; i < n; ++i) {   // Initialization for the y vector (Done before if)
 //            y[i] = 0.0;
@@ -98,40 +99,178 @@ int mat_vec_mult(const double* A, const double* x, double* y, int n) {
     return 0;  // Return success code
 }
 
+// True if A carries a SELL-C-sigma copy of its current structure and values array (see
+// crs_attach_sell; in-place value changes are copied by crs_refresh_sell)
+static inline int crs_has_sell(const CRSMatrix* A) {
+    return A->sell != NULL && A->sell->rows == A->rows && A->sell->nnz == A->nnz && A->sell->source == A->values;
+}
+
 /*
  * Function: crs_mat_vec_mult
  * ----------------------
  * This function performs CRS format matrix-vector multiplications: y = A * x.
  *
  * Inputs:
- *   - crs_matrix: Pointer to matrix A (1D array, flattened(if using std::vector or Eigen::VectorX))
+ *   - crs_matrix: Pointer to matrix A, already checked by 'crs_validate'
  *   - x: Pointer to vector x
  *   - y: Pointer to output vector y
  *
+ * Parallelization:
+ *   - The rows are distributed over the threads using the nnz-balanced partition stored in
+ *     A->row_part, so every thread gets roughly the same amount of work.
+ *   - The inner loop over the non-zeros of a row is a SIMD reduction. The index width (the
+ *     32-bit copy if crs_validate stored one) is dispatched once per part (CRS_INDEX_CALL).
+ *   - Small matrices (nnz < SPARSE_PARALLEL_THRESHOLD) are multiplied serially.
+ *   - If a SELL-C-sigma copy is attached (crs_attach_sell), the SIMD SELL kernel is used.
+ *
  * Error handling:
  *   - Checks for null pointers (A, x, or y) and returns an error if found.
- *   - Verifies that the matrix dimension (n) is positive.
- *   - Verifies that the matrix dimension (rows, cols and nnz) is valid.
- *   - Verifies that the bounds of nnz
+ *   - The structure (row_ptr / col_idx bounds) is NOT checked here, this is done once by
+ *     'crs_validate'. Unvalidated matrices are rejected. In debug builds, use
+ *     'crs_mat_vec_mult_checked' to bounds-check every entry on every call.
  */
 int crs_mat_vec_mult(const CRSMatrix* A, const double* x, double* y) {
     // Check for null pointers
     if (A == NULL || x == NULL || y == NULL) {
-        printf("Error: Initialization is not correct due to inputs has NULL pointers.\n");
+        fprintf(stderr, "Error: Null pointer passed to crs_mat_vec_mult.\n");
         return -1;  // Error code
     }
-    // Check for valid matrix dimensions
-    if (A->rows <= 0 || A->cols <= 0 || A->nnz < 0) {
-        printf("Matrix dimensions or non-zero count are invalid.\n");
+    // Structure must have been checked once by crs_validate
+    if (!A->validated) {
+        fprintf(stderr, "Error: CRS matrix passed to crs_mat_vec_mult has not been validated.\n");
         return -1;  // Error code
     }
+    if (crs_has_sell(A)) {
+        return sell_mat_vec_mult(A->sell, x, y);
+    }
 
-    // Initialize y vector to 0 for all rows
-    for (size_t i= 0; i < A->rows; ++i) {
-        y[i] = 0.0;
+    const size_t* row_part = A->row_part;
+    const int num_parts = A->num_parts;
+
+    #pragma omp parallel if (A->nnz >= (size_t) SPARSE_PARALLEL_THRESHOLD)
+    {
+        const int num_threads = omp_get_num_threads();
+
+        // Each thread handles the parts tid, tid + num_threads, ... of the row partition
+        for (int part = omp_get_thread_num(); part < num_parts; part += num_threads) {
+            const size_t first = row_part[part];
+            CRS_INDEX_CALL(A, crs_rows_mult, first, row_part[part + 1], x, y + first);
+        }
+    }
+
+    return 0;
+
+}
+
+/*
+ * Function: crs_mat_vec_mult_block
+ * --------------------------------
+ * Multi-vector SpMV: Y = A * X for k vectors at once. X and Y are column-major blocks, vector c
+ * at X + c * A->cols and Y + c * A->rows (k vectors of the usual layout, stored back to back).
+ *
+ * Every entry of a row is loaded once and multiplied with the k vectors; the sums of up to
+ * CRS_BLOCK_WIDTH vectors are kept in registers, wider blocks revisit the row (still in L1),
+ * so A streams from memory once for all k products instead of once per product.
+ *
+ * The rows are distributed like in crs_mat_vec_mult (nnz-balanced partition). The SELL copy
+ * is not used here.
+ *
+ * Returns:
+ *   - 0 on success
+ *   - -1 on null pointers, k == 0 or unvalidated matrices
+ */
+int crs_mat_vec_mult_block(const CRSMatrix* A, const double* X, double* Y, size_t k) {
+    if (A == NULL || X == NULL || Y == NULL || k == 0 || !A->validated) {
+        fprintf(stderr, "Error: Invalid input to crs_mat_vec_mult_block.\n");
+        return -1;
+    }
+
+    const size_t* row_part = A->row_part;
+    const int num_parts = A->num_parts;
+
+    #pragma omp parallel if (A->nnz * k >= (size_t) SPARSE_PARALLEL_THRESHOLD)
+    {
+        const int num_threads = omp_get_num_threads();
+
+        for (int part = omp_get_thread_num(); part < num_parts; part += num_threads) {
+            CRS_INDEX_CALL(A, crs_rows_mult_block, row_part[part], row_part[part + 1], X, Y, k);
+        }
+    }
+
+    return 0;
+}
+
+/*
+ * Function: crs_cg_update_direction
+ * ---------------------------------
+ * Fused CG search-direction kernel for a CRS matrix. In one sweep over the rows it computes
+ *
+ *     p   = z + beta * p
+ *     Ap  = A * z + beta * Ap        (= A * p_new, without reading p_new at neighbour rows)
+ *     p_dot_Ap = dot(p, Ap)
+ *
+ * Using the recurrence A * p_new = A * z + beta * A * p_old, the SpMV only gathers z, and
+ * p / Ap are read and written at the own row index, so the p update can be folded into the
+ * product without a race. This replaces the separate p update, SpMV and dot(p, Ap) sweeps.
+ *
+ * With beta = 0, p and Ap are not read (first CG iteration, p = z). If a SELL-C-sigma copy is
+ * attached (crs_attach_sell), the SIMD SELL kernel is used.
+ *
+ * Returns:
+ *   - 0 on success
+ *   - -1 on null pointers or unvalidated matrices
+ */
+int crs_cg_update_direction(const CRSMatrix* A, const double* z, double beta, double* p, double* Ap,
+                            double* p_dot_Ap) {
+    if (A == NULL || z == NULL || p == NULL || Ap == NULL || p_dot_Ap == NULL || !A->validated) {
+        fprintf(stderr, "Error: Invalid input to crs_cg_update_direction.\n");
+        return -1;
+    }
+    if (crs_has_sell(A)) {
+        return sell_cg_update_direction(A->sell, z, beta, p, Ap, p_dot_Ap);
+    }
+
+    const size_t* row_part = A->row_part;
+    const int num_parts = A->num_parts;
+    double dot = 0.0;
+
+    #pragma omp parallel if (A->nnz >= (size_t) SPARSE_PARALLEL_THRESHOLD) reduction(+:dot)
+    {
+        const int num_threads = omp_get_num_threads();
+
+        for (int part = omp_get_thread_num(); part < num_parts; part += num_threads) {
+            dot += CRS_INDEX_CALL(A, crs_rows_cg_direction, row_part[part], row_part[part + 1], z, beta, p, Ap);
+        }
+    }
+
+    *p_dot_Ap = dot;
+    return 0;
+}
+
+#ifndef NDEBUG
+/*
+ * Function: crs_mat_vec_mult_checked (debug builds only)
+ * ------------------------------------------------------
+ * Serial reference version of crs_mat_vec_mult that bounds-checks row_ptr and col_idx on
+ * every call. It does not require 'crs_validate' and is meant for debugging new assembly
+ * code, not for production runs.
+ *
+ * Returns:
+ *   - 0 on success
+ *   - -1 on null pointers, invalid dimensions or out-of-bounds indices
+ */
+int crs_mat_vec_mult_checked(const CRSMatrix* A, const double* x, double* y) {
+    // Check for null pointers
+    if (A == NULL || x == NULL || y == NULL || A->row_ptr == NULL) {
+        fprintf(stderr, "Error: Initialization is not correct due to inputs has NULL pointers.\n");
+        return -1;  // Error code
+    }
+    // Check for valid matrix dimensions
+    if (A->rows == 0 || A->cols == 0) {
+        fprintf(stderr, "Matrix dimensions or non-zero count are invalid.\n");
+        return -1;  // Error code
     }
 
-    // Perform matrix-vector multiplication
     for (size_t i = 0; i < A->rows; ++i) {
         //Get the range of non-zero elements for row i
         size_t start = A->row_ptr[i];
@@ -139,26 +278,211 @@ int crs_mat_vec_mult(const CRSMatrix* A, const double* x, double* y) {
 
         // Check that start and end indices are within bounds of nnz
         if (start > A->nnz || end > A->nnz || start > end) {
-            printf("Error: row_ptr indices out of bounds for row %zu.\n", i);
+            fprintf(stderr, "Error: row_ptr indices out of bounds for row %zu.\n", i);
             return -1;  // Error code for out-of-bounds indices
         }
 
-        //Accumulate the dot product for row i
+        double sum = 0.0;
         for (size_t j = start; j < end; ++j) {
-            size_t col = A->col_idx[j];
+            size_t col = crs_col(A, j);
 
             // Check that col index is within bounds of matrix columns
             if (col >= A->cols) {
-                printf("Error: col_idx out of bounds at index %zu.\n", j);
+                fprintf(stderr, "Error: col_idx out of bounds at index %zu.\n", j);
                 return -1;  // Error code for out-of-bounds column index
             }
 
-            y[i] += A->values[j] * x[col];
+            sum += A->values[j] * x[col];
+        }
+        y[i] = sum;
+    }
+
+    return 0;
+}
+#endif
+
+/*
+ * Function: crs_extract_diagonal
+ * ------------------------------
+ * Extracts the diagonal of a square CRS matrix: diag[i] = A(i, i), or 0 if the diagonal entry
+ * is not stored. The row parts are scanned in parallel, the cost is O(nnz).
+ *
+ * Returns:
+ *   - 0 on success
+ *   - -1 on null pointers or unvalidated matrices
+ */
+int crs_extract_diagonal(const CRSMatrix* A, double* diag) {
+    if (A == NULL || diag == NULL || !A->validated) {
+        fprintf(stderr, "Error: Invalid input to crs_extract_diagonal.\n");
+        return -1;
+    }
+
+    const size_t* row_part = A->row_part;
+    const int num_parts = A->num_parts;
+
+    #pragma omp parallel if (A->nnz >= (size_t) SPARSE_PARALLEL_THRESHOLD)
+    {
+        const int num_threads = omp_get_num_threads();
+
+        for (int part = omp_get_thread_num(); part < num_parts; part += num_threads) {
+            CRS_INDEX_CALL(A, crs_rows_diagonal, row_part[part], row_part[part + 1], diag);
         }
     }
 
     return 0;
+}
 
+// Ascending order of column indices (qsort)
+static int crs_compare_index(const void* a, const void* b) {
+    const size_t x = *(const size_t*) a;
+    const size_t y = *(const size_t*) b;
+    return (x > y) - (x < y);
+}
+
+/*
+ * Function: crs_mat_mat_mult
+ * --------------------------
+ * Sparse matrix-matrix product C = A * B (Gustavson's row-by-row algorithm), in two parallel
+ * passes over the rows of A:
+ *  1. Symbolic: every thread counts the distinct columns of its rows of C with a private
+ *     marker array of length B->cols; a prefix sum gives row_ptr of C (exact allocation).
+ *  2. Numeric: every thread accumulates its rows in a private dense accumulator, sorts the
+ *     column indices of the row and writes the values.
+ * Rows are distributed dynamically because their cost varies (e.g. the Galerkin products of
+ * algebraic multigrid).
+ *
+ * Parameters:
+ *   A, B - Validated CRS matrices with A->cols == B->rows
+ *   C    - Output matrix (allocated here, sorted rows, validated, free with free_crs_matrix)
+ *
+ * Returns:
+ *   - 0 on success
+ *   - -1 on invalid input or memory allocation failure
+ */
+int crs_mat_mat_mult(const CRSMatrix* A, const CRSMatrix* B, CRSMatrix* C) {
+    if (A == NULL || B == NULL || C == NULL || !A->validated || !B->validated || A->cols != B->rows) {
+        fprintf(stderr, "Error: Invalid input to crs_mat_mat_mult.\n");
+        return -1;
+    }
+
+    const size_t rows = A->rows;
+    const size_t cols = B->cols;
+    C->rows = rows;
+    C->cols = cols;
+    C->nnz = 0;
+    C->values = NULL;
+    C->col_idx = NULL;
+    C->row_part = NULL;
+    C->num_parts = 0;
+    C->validated = 0;
+    C->sell = NULL;
+    C->col_idx32 = NULL;
+    C->row_ptr = (size_t*) calloc(rows + 1, sizeof(size_t));
+    if (!C->row_ptr) {
+        fprintf(stderr, "Memory allocation failed in crs_mat_mat_mult.\n");
+        return -1;
+    }
+
+    const int parallel = (A->nnz + B->nnz >= (size_t) SPARSE_PARALLEL_THRESHOLD);
+    int memory_error = 0;
+
+    // Pass 1: number of entries of every row of C
+    #pragma omp parallel if (parallel)
+    {
+        size_t* marker = (size_t*) malloc(cols * sizeof(size_t));
+        if (!marker) {
+            #pragma omp atomic write
+            memory_error = 1;
+        } else {
+            for (size_t c = 0; c < cols; ++c) marker[c] = (size_t) -1;
+        }
+
+        // Every thread takes part in the worksharing loop (a thread without workspace skips its rows)
+        #pragma omp for schedule(dynamic, 256)
+        for (long long i = 0; i < (long long) rows; ++i) {
+            if (marker) {
+                size_t count = 0;
+                for (size_t ja = A->row_ptr[i]; ja < A->row_ptr[i + 1]; ++ja) {
+                    const size_t k = crs_col(A, ja);
+                    for (size_t jb = B->row_ptr[k]; jb < B->row_ptr[k + 1]; ++jb) {
+                        const size_t c = crs_col(B, jb);
+                        if (marker[c] != (size_t) i) {
+                            marker[c] = (size_t) i;
+                            count++;
+                        }
+                    }
+                }
+                C->row_ptr[i + 1] = count;
+            }
+        }
+        free(marker);
+    }
+    if (memory_error) {
+        fprintf(stderr, "Memory allocation failed in crs_mat_mat_mult.\n");
+        free_crs_matrix(C);
+        return -1;
+    }
+
+    for (size_t i = 0; i < rows; ++i) {
+        C->row_ptr[i + 1] += C->row_ptr[i];
+    }
+    C->nnz = C->row_ptr[rows];
+    C->values = (double*) malloc((C->nnz + 1) * sizeof(double));
+    C->col_idx = (size_t*) malloc((C->nnz + 1) * sizeof(size_t));
+    if (!C->values || !C->col_idx) {
+        fprintf(stderr, "Memory allocation failed in crs_mat_mat_mult.\n");
+        free_crs_matrix(C);
+        return -1;
+    }
+
+    // Pass 2: accumulate, sort and store every row of C
+    #pragma omp parallel if (parallel)
+    {
+        size_t* marker = (size_t*) malloc(cols * sizeof(size_t));
+        double* acc = (double*) malloc(cols * sizeof(double));
+        if (!marker || !acc) {
+            #pragma omp atomic write
+            memory_error = 1;
+        } else {
+            for (size_t c = 0; c < cols; ++c) marker[c] = (size_t) -1;
+        }
+
+        #pragma omp for schedule(dynamic, 256)
+        for (long long i = 0; i < (long long) rows; ++i) {
+            if (marker && acc) {
+                size_t* row_cols = C->col_idx + C->row_ptr[i];
+                size_t len = 0;
+                for (size_t ja = A->row_ptr[i]; ja < A->row_ptr[i + 1]; ++ja) {
+                    const size_t k = crs_col(A, ja);
+                    const double a = A->values[ja];
+                    for (size_t jb = B->row_ptr[k]; jb < B->row_ptr[k + 1]; ++jb) {
+                        const size_t c = crs_col(B, jb);
+                        if (marker[c] != (size_t) i) {
+                            marker[c] = (size_t) i;
+                            row_cols[len++] = c;
+                            acc[c] = a * B->values[jb];
+                        } else {
+                            acc[c] += a * B->values[jb];
+                        }
+                    }
+                }
+                qsort(row_cols, len, sizeof(size_t), crs_compare_index);
+                double* row_values = C->values + C->row_ptr[i];
+                for (size_t j = 0; j < len; ++j) {
+                    row_values[j] = acc[row_cols[j]];
+                }
+            }
+        }
+        free(marker);
+        free(acc);
+    }
+    if (memory_error) {
+        fprintf(stderr, "Memory allocation failed in crs_mat_mat_mult.\n");
+        free_crs_matrix(C);
+        return -1;
+    }
+
+    return crs_validate(C);
 }
 
 // Dot product of two vectors
@@ -179,4 +503,83 @@ void vec_subtract(const double* a, const double* b, double* result, int n) {
         result[i] = a[i] - b[i];
     }
 
+}
+
+/*
+ * Function: cg_update_direction
+ * -----------------------------
+ * Vector part of the fused CG direction update for operators without a fused kernel, where
+ * w = A * z has already been computed:
+ *
+ *     p = z + beta * p,   Ap = w + beta * Ap,   returns dot(p, Ap)
+ *
+ * With beta = 0, p and Ap are not read.
+ */
+double cg_update_direction(const double* z, const double* w, double beta, double* p, double* Ap, int n) {
+
+    double dot = 0.0;
+    if (beta == 0.0) {
+        #pragma omp parallel for simd reduction(+:dot) if (n >= PARALLEL_THRESHOLD)
+        for (int i = 0; i < n; ++i) {
+            p[i] = z[i];
+            Ap[i] = w[i];
+            dot += z[i] * w[i];
+        }
+    } else {
+        #pragma omp parallel for simd reduction(+:dot) if (n >= PARALLEL_THRESHOLD)
+        for (int i = 0; i < n; ++i) {
+            p[i] = z[i] + beta * p[i];
+            Ap[i] = w[i] + beta * Ap[i];
+            dot += p[i] * Ap[i];
+        }
+    }
+    return dot;
+
+}
+
+/*
+ * Function: cg_update_solution
+ * ----------------------------
+ * Fused CG update of the solution and the residual, with the residual norm in the same sweep:
+ *
+ *     x += alpha * p,   r -= alpha * Ap,   returns dot(r, r)
+ */
+double cg_update_solution(double alpha, const double* p, const double* Ap, double* x, double* r, int n) {
+
+    double r_dot_r = 0.0;
+    #pragma omp parallel for simd reduction(+:r_dot_r) if (n >= PARALLEL_THRESHOLD)
+    for (int i = 0; i < n; ++i) {
+        x[i] += alpha * p[i];
+        r[i] -= alpha * Ap[i];
+        r_dot_r += r[i] * r[i];
+    }
+    return r_dot_r;
+
+}
+
+/*
+ * Function: cg_update_solution_jacobi
+ * -----------------------------------
+ * Same as cg_update_solution, with the Jacobi preconditioner applied in the same sweep:
+ *
+ *     x += alpha * p,   r -= alpha * Ap,   z = inv_diag * r
+ *     returns dot(r, r), and dot(r, z) in 'r_dot_z'
+ */
+double cg_update_solution_jacobi(double alpha, const double* p, const double* Ap, const double* inv_diag,
+                                 double* x, double* r, double* z, int n, double* r_dot_z) {
+
+    double r_dot_r = 0.0, rz = 0.0;
+    #pragma omp parallel for simd reduction(+:r_dot_r, rz) if (n >= PARALLEL_THRESHOLD)
+    for (int i = 0; i < n; ++i) {
+        x[i] += alpha * p[i];
+        const double r_i = r[i] - alpha * Ap[i];
+        const double z_i = inv_diag[i] * r_i;
+        r[i] = r_i;
+        z[i] = z_i;
+        r_dot_r += r_i * r_i;
+        rz += r_i * z_i;
+    }
+    *r_dot_z = rz;
+    return r_dot_r;
+
 }
\ No newline at end of file
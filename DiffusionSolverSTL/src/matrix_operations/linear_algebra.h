@@ -8,9 +8,67 @@
 
 #include "CRSMatrix.h"
 
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Minimum amount of work for which the kernels switch to OpenMP parallel execution, one threshold
+// per kernel class and unit of work:
+//   PARALLEL_THRESHOLD        - vector kernels (and other streaming loops), in vector entries
+//   SPARSE_PARALLEL_THRESHOLD - sparse row kernels (SpMV, sweeps, triangular solves), in stored
+//                               entries (nnz, nnz * k for k vectors)
+//   DENSE_PARALLEL_THRESHOLD  - dense matrix kernels, in matrix entries (rows * cols)
+// and the tile size of the dense mat_vec_mult. Set once at startup (autotune_init), not while
+// kernels run.
+extern int PARALLEL_THRESHOLD;
+extern int SPARSE_PARALLEL_THRESHOLD;
+extern int DENSE_PARALLEL_THRESHOLD;
+extern int MAT_VEC_BLOCK_SIZE;
+
 int mat_vec_mult(const double* A, const double* x, double* y, int n);
 int crs_mat_vec_mult(const CRSMatrix* A, const double* x, double* y);
+
+// Vectors per register block of crs_mat_vec_mult_block
+#define CRS_BLOCK_WIDTH 8
+
+// Y = A * X for k column-major vectors (vector c at X + c * cols / Y + c * rows), A read once
+int crs_mat_vec_mult_block(const CRSMatrix* A, const double* X, double* Y, size_t k);
+#ifndef NDEBUG
+int crs_mat_vec_mult_checked(const CRSMatrix* A, const double* x, double* y);   // Debug builds only
+#endif
+int crs_extract_diagonal(const CRSMatrix* A, double* diag);
+int crs_mat_mat_mult(const CRSMatrix* A, const CRSMatrix* B, CRSMatrix* C);      // C = A * B (sparse)
 double dot_product(const double* a, const double* b, int n);
 void vec_subtract(const double* a, const double* b, double* result, int n);
 
+// Fused Krylov kernels (one sweep instead of several, see linear_algebra.c)
+int crs_cg_update_direction(const CRSMatrix* A, const double* z, double beta, double* p, double* Ap,
+                            double* p_dot_Ap);
+double cg_update_direction(const double* z, const double* w, double beta, double* p, double* Ap, int n);
+double cg_update_solution(double alpha, const double* p, const double* Ap, double* x, double* r, int n);
+double cg_update_solution_jacobi(double alpha, const double* p, const double* Ap, const double* inv_diag,
+                                 double* x, double* r, double* z, int n, double* r_dot_z);
+
+// Row kernels of crs_index_kernels.h for both column index widths (name##_u32 / name##_size)
+#define CRS_INDEX uint32_t
+#define CRS_KERNEL(name) name##_u32
+#include "crs_index_kernels.h"
+#undef CRS_INDEX
+#undef CRS_KERNEL
+#define CRS_INDEX size_t
+#define CRS_KERNEL(name) name##_size
+#include "crs_index_kernels.h"
+#undef CRS_INDEX
+#undef CRS_KERNEL
+
+// Calls the row kernel on the 32-bit indices of A if crs_validate stored them (size_t otherwise):
+// once per call or row part, so the width is not tested inside the loops
+#define CRS_INDEX_CALL(A, kernel, ...) \
+    ((A)->col_idx32 ? kernel##_u32((A), (A)->col_idx32, __VA_ARGS__) \
+                    : kernel##_size((A), (A)->col_idx, __VA_ARGS__))
+
+#ifdef __cplusplus
+}
+#endif
+
 #endif //PROJECT_02_FVM_LINEAR_ALGEBRA_H
\ No newline at end of file
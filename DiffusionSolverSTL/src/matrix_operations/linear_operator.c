@@ -0,0 +1,88 @@
+/*
+ * File: linear_operator.c
+ * -----------------------
+ * This file contains the dense and CRS backends of the 'LinearOperator' interface.
+ * The matrix-free stencil backend lives in 'stencil_operator.c'.
+ *
+ * Functions:
+ *  - linear_operator_dense: Wraps a dense row-major matrix.
+ *  - linear_operator_crs: Wraps a validated CRS matrix.
+ */
+
+#include "linear_operator.h"
+#include "linear_algebra.h"
+#include <stdio.h>
+
+// y = A * x for a dense row-major matrix
+static int dense_apply(const LinearOperator* op, const double* x, double* y) {
+    return mat_vec_mult((const double*) op->data, x, y, (int) op->n);
+}
+
+// diag = diag(A) for a dense row-major matrix
+static int dense_diagonal(const LinearOperator* op, double* diag) {
+    const double* A = (const double*) op->data;
+    for (size_t i = 0; i < op->n; ++i) {
+        diag[i] = A[i * op->n + i];
+    }
+    return 0;
+}
+
+// y = A * x for a CRS matrix
+static int crs_apply(const LinearOperator* op, const double* x, double* y) {
+    return crs_mat_vec_mult((const CRSMatrix*) op->data, x, y);
+}
+
+// Fused CG direction update for a CRS matrix
+static int crs_update_direction(const LinearOperator* op, const double* z, double beta, double* p, double* Ap,
+                                double* p_dot_Ap) {
+    return crs_cg_update_direction((const CRSMatrix*) op->data, z, beta, p, Ap, p_dot_Ap);
+}
+
+// diag = diag(A) for a CRS matrix (zero where the diagonal entry is not stored)
+static int crs_diagonal(const LinearOperator* op, double* diag) {
+    return crs_extract_diagonal((const CRSMatrix*) op->data, diag);
+}
+
+/*
+ * Function: linear_operator_dense
+ * -------------------------------
+ * Initializes 'op' as the dense row-major n x n matrix A.
+ *
+ * Returns:
+ *   - 0 on success
+ *   - -1 on null pointers or non-positive dimension
+ */
+int linear_operator_dense(LinearOperator* op, const double* A, int n) {
+    if (!op || !A || n <= 0) {
+        fprintf(stderr, "Invalid input to linear_operator_dense.\n");
+        return -1;
+    }
+    op->n = (size_t) n;
+    op->apply = dense_apply;
+    op->diagonal = dense_diagonal;
+    op->update_direction = NULL;
+    op->data = A;
+    return 0;
+}
+
+/*
+ * Function: linear_operator_crs
+ * -----------------------------
+ * Initializes 'op' as the square CRS matrix A. A must have been checked by 'crs_validate'.
+ *
+ * Returns:
+ *   - 0 on success
+ *   - -1 on null pointers, non-square or unvalidated matrices
+ */
+int linear_operator_crs(LinearOperator* op, const CRSMatrix* A) {
+    if (!op || !A || A->rows != A->cols || !A->validated) {
+        fprintf(stderr, "Invalid input to linear_operator_crs.\n");
+        return -1;
+    }
+    op->n = A->rows;
+    op->apply = crs_apply;
+    op->diagonal = crs_diagonal;
+    op->update_direction = crs_update_direction;
+    op->data = A;
+    return 0;
+}
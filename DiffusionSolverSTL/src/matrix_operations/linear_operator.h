@@ -0,0 +1,49 @@
+// File: linear_operator.h
+
+#ifndef PROJECT_02_FVM_LINEAR_OPERATOR_H
+#define PROJECT_02_FVM_LINEAR_OPERATOR_H
+
+#include <stddef.h>  // for size_t
+#include "CRSMatrix.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * @struct LinearOperator
+ * Abstract linear operator y = A * x used by the Krylov solvers.
+ *
+ * The solvers only need to apply A (and, for Jacobi preconditioning, its diagonal), so A does
+ * not have to be stored as a matrix. Backends:
+ *  - dense row-major n x n array      (linear_operator_dense)
+ *  - CRS sparse matrix                (linear_operator_crs)
+ *  - matrix-free finite-volume stencil (linear_operator_stencil, see stencil_operator.h)
+ *
+ * 'update_direction' is the fused CG kernel p = z + beta * p, Ap = A * z + beta * Ap, returning
+ * dot(p, Ap) (one sweep instead of three). Backends without it fall back to 'apply' followed by
+ * the vector kernel 'cg_update_direction'.
+ *
+ * The operator does not own 'data', the backend object must outlive the operator.
+ */
+typedef struct LinearOperator LinearOperator;
+struct LinearOperator {
+    size_t n;                                                               // Number of rows/columns
+    int (*apply)(const LinearOperator* op, const double* x, double* y);     // y = A * x
+    int (*diagonal)(const LinearOperator* op, double* diag);                // diag = diag(A), may be NULL
+    int (*update_direction)(const LinearOperator* op, const double* z, double beta,
+                            double* p, double* Ap, double* p_dot_Ap);       // Fused CG direction update, may be NULL
+    const void* data;                                                       // Backend data (matrix, stencil, ...)
+};
+
+// Wrap a dense row-major n x n matrix
+int linear_operator_dense(LinearOperator* op, const double* A, int n);
+
+// Wrap a CRS matrix (must have been checked by crs_validate)
+int linear_operator_crs(LinearOperator* op, const CRSMatrix* A);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif //PROJECT_02_FVM_LINEAR_OPERATOR_H
@@ -0,0 +1,611 @@
+/*
+ * File: reordering.c
+ * ------------------
+ * This file contains orderings of the unknowns of sparse systems and the symmetric
+ * permutation B = P * A * P^T of a CRS matrix (see reordering.h for the convention).
+ *
+ * The order of the unknowns decides how far apart the entries of x used by one row are
+ * (locality of the x accesses in the SpMV) and how much an incomplete factorization fills in.
+ * The lexicographic order of a 3D grid puts the k-neighbours nx * ny entries away; for
+ * unstructured or renumbered meshes the order can be arbitrary.
+ *  - Reverse Cuthill-McKee numbers the unknowns level by level of a breadth-first search from
+ *    a pseudo-peripheral node, which keeps every row's columns within a narrow band.
+ *  - Morton (Z-order) and Hilbert curves number the cells of a structured grid so that cells
+ *    close in space get close indices in all directions; the Hilbert curve moves only to a
+ *    face neighbour from one cell to the next.
+ *
+ * Functions:
+ *  - crs_rcm_ordering: Reverse Cuthill-McKee ordering of a sparsity pattern.
+ *  - grid_morton_ordering: Z-order of the cells of a structured grid.
+ *  - grid_hilbert_ordering: Hilbert-curve order of the cells of a structured grid.
+ *  - permutation_invert: Inverse permutation (with validity check).
+ *  - crs_permute_symmetric: B = P * A * P^T.
+ *  - permute_vector / unpermute_vector: y = P * x and x = P^T * y.
+ *  - crs_bandwidth: Largest distance of an entry from the diagonal.
+ *  - crs_ordering_parse / crs_reordering_setup: Reordered system B = P * A * P^T of a named
+ *    ordering, with the permuted right-hand side and solution (crs_reordering_permute /
+ *    crs_reordering_unpermute).
+ */
+
+#include "reordering.h"
+#include "linear_algebra.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <omp_llvm.h>
+
+// Sorts the neighbours of a node by degree (ascending, ties by index): lists are short
+static void rcm_sort_by_degree(size_t* nodes, size_t len, const size_t* degree) {
+    for (size_t a = 1; a < len; ++a) {
+        const size_t v = nodes[a];
+        size_t b = a;
+        while (b > 0 && (degree[nodes[b - 1]] > degree[v] ||
+                         (degree[nodes[b - 1]] == degree[v] && nodes[b - 1] > v))) {
+            nodes[b] = nodes[b - 1];
+            b--;
+        }
+        nodes[b] = v;
+    }
+}
+
+/*
+ * Breadth-first search from 'root' over the nodes not yet numbered (mark[v] != done) and not
+ * visited in this search (mark[v] != stamp). Appends the visited nodes to 'order' from position
+ * 'start', level by level; with 'sorted' the new nodes of every node are sorted by degree
+ * (Cuthill-McKee). Returns the position after the last node; *depth is the number of levels
+ * and *last_level the position where the last level starts.
+ */
+static size_t rcm_bfs(const CRSMatrix* A, const size_t* degree, size_t root, size_t* order, size_t start,
+                      size_t* mark, size_t stamp, size_t done, int sorted, size_t* depth, size_t* last_level) {
+    size_t head = start;
+    size_t tail = start;
+    order[tail++] = root;
+    mark[root] = stamp;
+    *depth = 0;
+    *last_level = start;
+
+    while (head < tail) {
+        const size_t level_end = tail;
+        *last_level = head;
+        (*depth)++;
+        for (; head < level_end; ++head) {
+            const size_t v = order[head];
+            const size_t first = tail;
+            for (size_t j = A->row_ptr[v]; j < A->row_ptr[v + 1]; ++j) {
+                const size_t w = crs_col(A, j);
+                if (mark[w] != stamp && mark[w] != done) {
+                    mark[w] = stamp;
+                    order[tail++] = w;
+                }
+            }
+            if (sorted) {
+                rcm_sort_by_degree(order + first, tail - first, degree);
+            }
+        }
+    }
+    return tail;
+}
+
+/*
+ * Function: crs_rcm_ordering
+ * --------------------------
+ * Reverse Cuthill-McKee ordering of the sparsity pattern of A (treated as symmetric: the
+ * neighbours of i are the columns of row i). Every connected component is numbered by a
+ * breadth-first search from a pseudo-peripheral node (George-Liu: repeat the search from a
+ * node of minimum degree in the last level while the number of levels grows), visiting the
+ * neighbours of a node in order of increasing degree; the whole order is then reversed.
+ *
+ * The search is sequential; it is a setup cost of O(nnz) per search (a few searches per
+ * component), paid once per pattern.
+ *
+ * Parameters:
+ *   A    - Validated square CRS matrix
+ *   perm - Output permutation (A->rows entries, perm[new] = old)
+ *
+ * Returns:
+ *   - 0 on success
+ *   - -1 on invalid input or memory allocation failure
+ */
+int crs_rcm_ordering(const CRSMatrix* A, size_t* perm) {
+
+    if (!A || !perm || !A->validated || A->rows != A->cols) {
+        fprintf(stderr, "Invalid input to crs_rcm_ordering.\n");
+        return -1;
+    }
+
+    const size_t n = A->rows;
+    size_t* degree = (size_t*) malloc((n + 1) * sizeof(size_t));
+    size_t* mark = (size_t*) malloc((n + 1) * sizeof(size_t));
+    size_t* order = (size_t*) malloc((n + 1) * sizeof(size_t));
+    if (!degree || !mark || !order) {
+        fprintf(stderr, "Memory allocation failed in crs_rcm_ordering.\n");
+        free(degree);
+        free(mark);
+        free(order);
+        return -1;
+    }
+
+    // Degree = off-diagonal entries of the row; stamp 0 = never visited, 1 = numbered
+    const size_t done = 1;
+    size_t stamp = 1;
+    for (size_t i = 0; i < n; ++i) {
+        degree[i] = 0;
+        for (size_t j = A->row_ptr[i]; j < A->row_ptr[i + 1]; ++j) {
+            degree[i] += (crs_col(A, j) != i);
+        }
+        mark[i] = 0;
+    }
+
+    size_t numbered = 0;
+    for (size_t seed = 0; seed < n; ++seed) {
+        if (mark[seed] == done) {
+            continue;
+        }
+
+        // Pseudo-peripheral node of the component of 'seed' (trial searches behind 'numbered')
+        size_t root = seed;
+        size_t depth;
+        size_t last_level;
+        size_t end = rcm_bfs(A, degree, root, order, numbered, mark, ++stamp, done, 0, &depth, &last_level);
+        for (int trial = 0; trial < 8; ++trial) {
+            size_t candidate = order[last_level];
+            for (size_t p = last_level + 1; p < end; ++p) {
+                if (degree[order[p]] < degree[candidate]) {
+                    candidate = order[p];
+                }
+            }
+            size_t candidate_depth;
+            size_t candidate_last;
+            end = rcm_bfs(A, degree, candidate, order, numbered, mark, ++stamp, done, 0, &candidate_depth,
+                          &candidate_last);
+            if (candidate_depth <= depth) {
+                break;
+            }
+            root = candidate;
+            depth = candidate_depth;
+            last_level = candidate_last;
+        }
+
+        // Cuthill-McKee numbering of the component, then mark it as numbered
+        end = rcm_bfs(A, degree, root, order, numbered, mark, ++stamp, done, 1, &depth, &last_level);
+        for (size_t p = numbered; p < end; ++p) {
+            mark[order[p]] = done;
+        }
+        numbered = end;
+    }
+
+    // Reverse
+    for (size_t i = 0; i < n; ++i) {
+        perm[i] = order[n - 1 - i];
+    }
+
+    free(degree);
+    free(mark);
+    free(order);
+    return 0;
+}
+
+// Cell index and curve key, sorted by key
+typedef struct {
+    uint64_t key;
+    size_t cell;
+} curve_cell;
+
+static int curve_compare(const void* a, const void* b) {
+    const curve_cell* ca = (const curve_cell*) a;
+    const curve_cell* cb = (const curve_cell*) b;
+    return (ca->key > cb->key) - (ca->key < cb->key);
+}
+
+// Interleaves the 'bits' low bits of the 'dims' coordinates, most significant bit first
+static uint64_t curve_interleave(const uint32_t* x, int dims, int bits) {
+    uint64_t key = 0;
+    for (int b = bits - 1; b >= 0; --b) {
+        for (int d = 0; d < dims; ++d) {
+            key = (key << 1) | ((x[d] >> b) & 1u);
+        }
+    }
+    return key;
+}
+
+/*
+ * Hilbert index of the point x (in place): Skilling's transform of the coordinates into the
+ * "transposed" Hilbert index (J. Skilling, Programming the Hilbert curve, 2004), whose bits
+ * are then interleaved like a Morton key.
+ */
+static uint64_t curve_hilbert_key(uint32_t* x, int dims, int bits) {
+    const uint32_t m = 1u << (bits - 1);
+
+    // Inverse undo of the excess work
+    for (uint32_t q = m; q > 1; q >>= 1) {
+        const uint32_t p = q - 1;
+        for (int d = 0; d < dims; ++d) {
+            if (x[d] & q) {
+                x[0] ^= p;
+            } else {
+                const uint32_t t = (x[0] ^ x[d]) & p;
+                x[0] ^= t;
+                x[d] ^= t;
+            }
+        }
+    }
+
+    // Gray encode
+    for (int d = 1; d < dims; ++d) {
+        x[d] ^= x[d - 1];
+    }
+    uint32_t t = 0;
+    for (uint32_t q = m; q > 1; q >>= 1) {
+        if (x[dims - 1] & q) {
+            t ^= q - 1;
+        }
+    }
+    for (int d = 0; d < dims; ++d) {
+        x[d] ^= t;
+    }
+    return curve_interleave(x, dims, bits);
+}
+
+/*
+ * Orders the cells of an nx x ny x nz grid by their key on a space-filling curve (Morton or
+ * Hilbert) over the enclosing 2^bits cube; cells outside the grid are skipped, so any grid
+ * size works. nz = 1 uses the 2D curve.
+ */
+static int grid_curve_ordering(int nx, int ny, int nz, int hilbert, size_t* perm, const char* name) {
+
+    if (nx <= 0 || ny <= 0 || nz <= 0 || !perm) {
+        fprintf(stderr, "Invalid input to %s.\n", name);
+        return -1;
+    }
+
+    const int dims = (nz > 1) ? 3 : 2;
+    const int max_dim = (nx > ny) ? ((nx > nz) ? nx : nz) : ((ny > nz) ? ny : nz);
+    int bits = 1;
+    while (bits < 31 && (1L << bits) < max_dim) {
+        bits++;
+    }
+    if (bits * dims > 64) {
+        fprintf(stderr, "Grid too large for a 64-bit curve key in %s.\n", name);
+        return -1;
+    }
+
+    const size_t n = (size_t) nx * ny * nz;
+    curve_cell* cells = (curve_cell*) malloc(n * sizeof(curve_cell));
+    if (!cells) {
+        fprintf(stderr, "Memory allocation failed in %s.\n", name);
+        return -1;
+    }
+
+#pragma omp parallel for if (n >= (size_t) PARALLEL_THRESHOLD)
+    for (long long c = 0; c < (long long) n; ++c) {
+        uint32_t x[3];
+        x[0] = (uint32_t) (c % nx);
+        x[1] = (uint32_t) ((c / nx) % ny);
+        x[2] = (uint32_t) (c / ((long long) nx * ny));
+        cells[c].cell = (size_t) c;
+        cells[c].key = hilbert ? curve_hilbert_key(x, dims, bits) : curve_interleave(x, dims, bits);
+    }
+
+    qsort(cells, n, sizeof(curve_cell), curve_compare);
+    for (size_t c = 0; c < n; ++c) {
+        perm[c] = cells[c].cell;
+    }
+
+    free(cells);
+    return 0;
+}
+
+/*
+ * Function: grid_morton_ordering
+ * ------------------------------
+ * Z-order (Morton order) of the cells of an nx x ny x nz grid: cells sorted by the interleaved
+ * bits of their (i, j, k) coordinates, i.e. recursively by octants (quadrants in 2D).
+ *
+ * Returns:
+ *   - 0 on success
+ *   - -1 on invalid input or memory allocation failure
+ */
+int grid_morton_ordering(int nx, int ny, int nz, size_t* perm) {
+    return grid_curve_ordering(nx, ny, nz, 0, perm, "grid_morton_ordering");
+}
+
+/*
+ * Function: grid_hilbert_ordering
+ * -------------------------------
+ * Hilbert-curve order of the cells of an nx x ny x nz grid. Unlike the Z-order the curve never
+ * jumps: consecutive cells are face neighbours (on grids with power-of-two sizes; otherwise
+ * the curve is cut where it leaves the grid).
+ *
+ * Returns:
+ *   - 0 on success
+ *   - -1 on invalid input or memory allocation failure
+ */
+int grid_hilbert_ordering(int nx, int ny, int nz, size_t* perm) {
+    return grid_curve_ordering(nx, ny, nz, 1, perm, "grid_hilbert_ordering");
+}
+
+/*
+ * Function: permutation_invert
+ * ----------------------------
+ * Computes inv with inv[perm[i]] = i.
+ *
+ * Returns:
+ *   - 0 on success
+ *   - -1 on invalid input (perm out of range or with repeated entries)
+ */
+int permutation_invert(const size_t* perm, size_t n, size_t* inv) {
+
+    if (!perm || !inv) {
+        fprintf(stderr, "Invalid input to permutation_invert.\n");
+        return -1;
+    }
+
+    for (size_t i = 0; i < n; ++i) {
+        inv[i] = n;
+    }
+    for (size_t i = 0; i < n; ++i) {
+        if (perm[i] >= n || inv[perm[i]] != n) {
+            fprintf(stderr, "Invalid permutation in permutation_invert (entry %zu).\n", i);
+            return -1;
+        }
+        inv[perm[i]] = i;
+    }
+    return 0;
+}
+
+/*
+ * Function: crs_permute_symmetric
+ * -------------------------------
+ * Computes B = P * A * P^T: row i of B is row perm[i] of A with every column c renumbered to
+ * inv[c], then sorted by column. The rows are independent and built in parallel.
+ *
+ * Parameters:
+ *   A    - Validated square CRS matrix
+ *   perm - Permutation (A->rows entries, perm[new] = old)
+ *   B    - Output matrix (allocated here, validated, free with free_crs_matrix)
+ *
+ * Returns:
+ *   - 0 on success
+ *   - -1 on invalid input or memory allocation failure
+ */
+int crs_permute_symmetric(const CRSMatrix* A, const size_t* perm, CRSMatrix* B) {
+
+    if (!A || !perm || !B || !A->validated || A->rows != A->cols) {
+        fprintf(stderr, "Invalid input to crs_permute_symmetric.\n");
+        return -1;
+    }
+
+    const size_t n = A->rows;
+    B->values = (double*) malloc((A->nnz + 1) * sizeof(double));
+    B->col_idx = (size_t*) malloc((A->nnz + 1) * sizeof(size_t));
+    B->row_ptr = (size_t*) malloc((n + 1) * sizeof(size_t));
+    B->row_part = NULL;
+    B->num_parts = 0;
+    B->validated = 0;
+    B->sell = NULL;
+    B->col_idx32 = NULL;
+    B->nnz = A->nnz;
+    B->rows = n;
+    B->cols = n;
+    size_t* inv = (size_t*) malloc((n + 1) * sizeof(size_t));
+    if (!B->values || !B->col_idx || !B->row_ptr || !inv) {
+        fprintf(stderr, "Memory allocation failed in crs_permute_symmetric.\n");
+        free(inv);
+        free_crs_matrix(B);
+        return -1;
+    }
+    if (permutation_invert(perm, n, inv) != 0) {
+        free(inv);
+        free_crs_matrix(B);
+        return -1;
+    }
+
+    // Row pointers from the lengths of the source rows
+    B->row_ptr[0] = 0;
+    for (size_t i = 0; i < n; ++i) {
+        B->row_ptr[i + 1] = B->row_ptr[i] + (A->row_ptr[perm[i] + 1] - A->row_ptr[perm[i]]);
+    }
+
+#pragma omp parallel for schedule(static) if (n >= (size_t) PARALLEL_THRESHOLD)
+    for (long long i = 0; i < (long long) n; ++i) {
+        const size_t src = A->row_ptr[perm[i]];
+        const size_t begin = B->row_ptr[i];
+        const size_t len = B->row_ptr[i + 1] - begin;
+        size_t* cols = B->col_idx + begin;
+        double* vals = B->values + begin;
+
+        // Insertion sort while copying (rows of a stencil matrix are short)
+        for (size_t a = 0; a < len; ++a) {
+            const size_t c = inv[crs_col(A, src + a)];
+            const double v = A->values[src + a];
+            size_t b = a;
+            while (b > 0 && cols[b - 1] > c) {
+                cols[b] = cols[b - 1];
+                vals[b] = vals[b - 1];
+                b--;
+            }
+            cols[b] = c;
+            vals[b] = v;
+        }
+    }
+
+    free(inv);
+    return crs_validate(B);
+}
+
+/*
+ * Function: permute_vector
+ * ------------------------
+ * y = P * x, i.e. y[i] = x[perm[i]] (x in the original, y in the new numbering).
+ */
+void permute_vector(const size_t* perm, const double* x, double* y, size_t n) {
+#pragma omp parallel for simd schedule(static) if (n >= (size_t) PARALLEL_THRESHOLD)
+    for (long long i = 0; i < (long long) n; ++i) {
+        y[i] = x[perm[i]];
+    }
+}
+
+/*
+ * Function: unpermute_vector
+ * --------------------------
+ * x = P^T * y, i.e. x[perm[i]] = y[i] (y in the new, x in the original numbering).
+ */
+void unpermute_vector(const size_t* perm, const double* y, double* x, size_t n) {
+#pragma omp parallel for simd schedule(static) if (n >= (size_t) PARALLEL_THRESHOLD)
+    for (long long i = 0; i < (long long) n; ++i) {
+        x[perm[i]] = y[i];
+    }
+}
+
+/*
+ * Function: crs_bandwidth
+ * -----------------------
+ * Returns the largest |i - j| over the stored entries (i, j) of A (0 for invalid input).
+ */
+size_t crs_bandwidth(const CRSMatrix* A) {
+    if (!A || !A->row_ptr || (A->nnz > 0 && !A->col_idx && !A->col_idx32)) {
+        return 0;
+    }
+    size_t bandwidth = 0;
+#pragma omp parallel for reduction(max : bandwidth) if (A->nnz >= (size_t) SPARSE_PARALLEL_THRESHOLD)
+    for (long long i = 0; i < (long long) A->rows; ++i) {
+        for (size_t j = A->row_ptr[i]; j < A->row_ptr[i + 1]; ++j) {
+            const size_t c = crs_col(A, j);
+            const size_t d = (c > (size_t) i) ? c - (size_t) i : (size_t) i - c;
+            bandwidth = (d > bandwidth) ? d : bandwidth;
+        }
+    }
+    return bandwidth;
+}
+
+/*
+ * Function: crs_ordering_parse
+ * ----------------------------
+ * Maps the name of an ordering ("Natural", "RCM", "Morton", "Hilbert") onto CRSOrdering.
+ *
+ * Returns:
+ *   - 0 on success
+ *   - -1 on null pointers or an unknown name
+ */
+int crs_ordering_parse(const char* name, CRSOrdering* ordering) {
+    if (!name || !ordering) {
+        return -1;
+    }
+    if (strcmp(name, "Natural") == 0) {
+        *ordering = CRS_ORDERING_NATURAL;
+    } else if (strcmp(name, "RCM") == 0) {
+        *ordering = CRS_ORDERING_RCM;
+    } else if (strcmp(name, "Morton") == 0) {
+        *ordering = CRS_ORDERING_MORTON;
+    } else if (strcmp(name, "Hilbert") == 0) {
+        *ordering = CRS_ORDERING_HILBERT;
+    } else {
+        return -1;
+    }
+    return 0;
+}
+
+/*
+ * Function: crs_reordering_setup
+ * ------------------------------
+ * Computes the permutation of 'ordering' and the reordered matrix B = P * A * P^T once, and
+ * allocates the permuted right-hand side and solution. The solver, its preconditioner (e.g.
+ * the incomplete Cholesky factor, whose fill-in depends on the ordering) and a SELL copy are
+ * then built on R->B.
+ *
+ * Parameters:
+ *   A          - Validated square CRS matrix
+ *   ordering   - CRS_ORDERING_NATURAL (nothing is built), _RCM, _MORTON or _HILBERT
+ *   nx, ny, nz - Grid of the unknowns (Morton / Hilbert only, cell (i, j, k) at (k * ny + j) * nx + i)
+ *   R          - Output (free with crs_reordering_free)
+ *
+ * Returns:
+ *   - 0 on success
+ *   - -1 on invalid input (including a grid that does not match A) or memory allocation failure
+ */
+int crs_reordering_setup(const CRSMatrix* A, CRSOrdering ordering, int nx, int ny, int nz, CRSReordering* R) {
+
+    if (!A || !R || !A->validated || A->rows != A->cols) {
+        fprintf(stderr, "Invalid input to crs_reordering_setup.\n");
+        return -1;
+    }
+    const CRSMatrix empty = {NULL, NULL, NULL, 0, 0, 0, NULL, 0, 0, NULL, NULL};
+    const size_t n = A->rows;
+    R->ordering = ordering;
+    R->n = n;
+    R->perm = NULL;
+    R->B = empty;
+    R->b = NULL;
+    R->x = NULL;
+    if (ordering == CRS_ORDERING_NATURAL) {
+        return 0;
+    }
+    if ((ordering == CRS_ORDERING_MORTON || ordering == CRS_ORDERING_HILBERT) &&
+        (nx <= 0 || ny <= 0 || nz <= 0 || (size_t) nx * (size_t) ny * (size_t) nz != n)) {
+        fprintf(stderr, "Grid %d x %d x %d does not match the matrix in crs_reordering_setup.\n", nx, ny, nz);
+        return -1;
+    }
+
+    R->perm = (size_t*) malloc(n * sizeof(size_t));
+    R->b = (double*) malloc(n * sizeof(double));
+    R->x = (double*) malloc(n * sizeof(double));
+    if (!R->perm || !R->b || !R->x) {
+        fprintf(stderr, "Memory allocation failed in crs_reordering_setup.\n");
+        crs_reordering_free(R);
+        return -1;
+    }
+
+    int status;
+    if (ordering == CRS_ORDERING_RCM) {
+        status = crs_rcm_ordering(A, R->perm);
+    } else if (ordering == CRS_ORDERING_MORTON) {
+        status = grid_morton_ordering(nx, ny, nz, R->perm);
+    } else {
+        status = grid_hilbert_ordering(nx, ny, nz, R->perm);
+    }
+    if (status == 0) {
+        status = crs_permute_symmetric(A, R->perm, &R->B);
+    }
+    if (status != 0) {
+        crs_reordering_free(R);
+        return -1;
+    }
+    return 0;
+}
+
+/*
+ * Function: crs_reordering_permute
+ * --------------------------------
+ * R->b = P * b and R->x = P * x (initial guess), before a solve on R->B.
+ */
+void crs_reordering_permute(CRSReordering* R, const double* b, const double* x) {
+    permute_vector(R->perm, b, R->b, R->n);
+    permute_vector(R->perm, x, R->x, R->n);
+}
+
+/*
+ * Function: crs_reordering_unpermute
+ * ----------------------------------
+ * x = P^T * R->x, the solution in the original numbering.
+ */
+void crs_reordering_unpermute(const CRSReordering* R, double* x) {
+    unpermute_vector(R->perm, R->x, x, R->n);
+}
+
+/*
+ * Function: crs_reordering_free
+ * -----------------------------
+ * Frees the permutation, B and the work vectors (safe on a partially built reordering).
+ */
+void crs_reordering_free(CRSReordering* R) {
+    if (!R) return;
+    free(R->perm);
+    free(R->b);
+    free(R->x);
+    free_crs_matrix(&R->B);
+    R->perm = NULL;
+    R->b = NULL;
+    R->x = NULL;
+    R->ordering = CRS_ORDERING_NATURAL;
+}
@@ -0,0 +1,88 @@
+// File: reordering.h
+
+#ifndef PROJECT_02_FVM_REORDERING_H
+#define PROJECT_02_FVM_REORDERING_H
+
+#include <stddef.h>  // for size_t
+#include "CRSMatrix.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Permutations
+ * A permutation 'perm' of n unknowns lists the old index of every new index: new unknown i is
+ * old unknown perm[i]. The reordered system is B * y = c with
+ *
+ *     B = P * A * P^T   (B(i, j) = A(perm[i], perm[j])),   y = P * x,   c = P * b,
+ *
+ * so a solver runs on B and c = permute(b), and x = unpermute(y).
+ */
+
+// Reverse Cuthill-McKee ordering of the (symmetric) sparsity pattern of A: small bandwidth
+int crs_rcm_ordering(const CRSMatrix* A, size_t* perm);
+
+// Space-filling-curve orderings of the cells of an nx x ny x nz grid (cell (i, j, k) at
+// (k * ny + j) * nx + i, nz = 1 for 2D): Z-order (Morton) and Hilbert curve
+int grid_morton_ordering(int nx, int ny, int nz, size_t* perm);
+int grid_hilbert_ordering(int nx, int ny, int nz, size_t* perm);
+
+// inv[perm[i]] = i; fails if perm is not a permutation of 0 .. n-1
+int permutation_invert(const size_t* perm, size_t n, size_t* inv);
+
+// B = P * A * P^T (validated, rows sorted by column, free with free_crs_matrix)
+int crs_permute_symmetric(const CRSMatrix* A, const size_t* perm, CRSMatrix* B);
+
+// y = P * x (y[i] = x[perm[i]]) and x = P^T * y (x[perm[i]] = y[i])
+void permute_vector(const size_t* perm, const double* x, double* y, size_t n);
+void unpermute_vector(const size_t* perm, const double* y, double* x, size_t n);
+
+// Largest |i - j| over the entries (i, j) of A
+size_t crs_bandwidth(const CRSMatrix* A);
+
+/*
+ * @enum CRSOrdering
+ * Ordering of the unknowns of a reordered CRS system ('Matrix_ordering' in config.txt).
+ */
+typedef enum {
+    CRS_ORDERING_NATURAL = 0,     // Assembly order, nothing is permuted
+    CRS_ORDERING_RCM,             // Reverse Cuthill-McKee of the pattern
+    CRS_ORDERING_MORTON,          // Z-order of the grid cells
+    CRS_ORDERING_HILBERT          // Hilbert curve of the grid cells
+} CRSOrdering;
+
+/*
+ * @struct CRSReordering
+ * A CRS system A * x = b solved in another numbering: B = P * A * P^T is built once by
+ * 'crs_reordering_setup'; every solve permutes b and the initial guess into the work vectors
+ * (crs_reordering_permute), runs on B, and un-permutes the solution (crs_reordering_unpermute).
+ * With the natural ordering perm is NULL and nothing is built.
+ */
+typedef struct {
+    CRSOrdering ordering;
+    size_t n;
+    size_t* perm;       // perm[new] = old (NULL: natural ordering)
+    CRSMatrix B;        // P * A * P^T
+    double* b;          // P * b
+    double* x;          // P * x (initial guess, then solution)
+} CRSReordering;
+
+// "Natural", "RCM", "Morton" or "Hilbert"; returns 0, or -1 for an unknown name
+int crs_ordering_parse(const char* name, CRSOrdering* ordering);
+
+// Builds perm and B for A (validated, square); Morton / Hilbert number the cells of an
+// nx x ny x nz grid (nx * ny * nz == A->rows), RCM and the natural ordering ignore the grid
+int crs_reordering_setup(const CRSMatrix* A, CRSOrdering ordering, int nx, int ny, int nz, CRSReordering* R);
+
+// R->b = P * b and R->x = P * x before a solve on R->B, x = P^T * R->x after it
+void crs_reordering_permute(CRSReordering* R, const double* b, const double* x);
+void crs_reordering_unpermute(const CRSReordering* R, double* x);
+
+void crs_reordering_free(CRSReordering* R);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif //PROJECT_02_FVM_REORDERING_H
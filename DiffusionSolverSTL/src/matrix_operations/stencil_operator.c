@@ -0,0 +1,418 @@
+/*
+ * File: stencil_operator.c
+ * ------------------------
+ * This file contains the matrix-free 5-point (2D) / 7-point (3D) finite-volume diffusion
+ * operator. Instead of storing an n x n (or CRS) matrix, the operator is applied directly from
+ * the face coefficients of the grid, so memory is O(n) and one product costs O(n).
+ *
+ * Functions:
+ *  - stencil_apply: y = A * x.
+ *  - stencil_cg_update_direction: Fused CG direction update p = z + beta * p, Ap = A * p, dot(p, Ap).
+ *  - stencil_diagonal: Extracts diag(A) (used by the Jacobi preconditioner).
+ *  - stencil_sor_sweep: One red-black SOR half sweep (Gauss-Seidel for omega = 1).
+ *  - stencil_to_crs: Assembles the operator directly into CRS format (no dense matrix).
+ *  - linear_operator_stencil: Wraps the stencil as a LinearOperator.
+ */
+
+#include "stencil_operator.h"
+#include "linear_algebra.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <omp_llvm.h>
+
+// Check the operator description
+static int stencil_check(const StencilOperator* S) {
+    if (!S || S->nx <= 0 || S->ny <= 0 || S->nz <= 0 ||
+        !S->ce || !S->cw || !S->cn || !S->cs || !S->co ||
+        (S->nz > 1 && (!S->cf || !S->cb))) {
+        return -1;
+    }
+    return 0;
+}
+
+/*
+ * Computes one x-row (j, k) of y = A * x + beta * y (y is not read when beta = 0).
+ *
+ * Neighbours in y/z are read through row pointers; a neighbour on the boundary gets weight 0
+ * and points back to the row itself, so the inner loops have no branches and are vectorized.
+ */
+static inline void stencil_row(const StencilOperator* S, long long r, const double* x, double* y, double beta) {
+    const int nx = S->nx, ny = S->ny, nz = S->nz;
+    const int j = (int) (r % ny);
+    const int k = (int) (r / ny);
+    const size_t plane = (size_t) nx * ny;
+    const size_t base = (size_t) r * nx;
+    const double theta = S->theta;
+    const double* ce = S->ce;
+    const double* cw = S->cw;
+
+    const double* xp = x + base;
+    double* yp = y + base;
+
+    // Neighbour rows in y and z (weight 0 on the boundary)
+    const double cn = S->cn[j], cs = S->cs[j];
+    const double cf = (nz > 1) ? S->cf[k] : 0.0;
+    const double cb = (nz > 1) ? S->cb[k] : 0.0;
+
+    const double wN = (j + 1 < ny) ? theta * cn : 0.0;
+    const double wS = (j > 0) ? theta * cs : 0.0;
+    const double wF = (k + 1 < nz) ? theta * cf : 0.0;
+    const double wB = (k > 0) ? theta * cb : 0.0;
+    const double* xN = (j + 1 < ny) ? xp + nx : xp;
+    const double* xS = (j > 0) ? xp - nx : xp;
+    const double* xF = (k + 1 < nz) ? xp + plane : xp;
+    const double* xB = (k > 0) ? xp - plane : xp;
+
+    const double d_row = theta * (cn + cs + cf + cb);
+    const double* cop = S->co + base;
+
+    // Diagonal and y/z neighbours
+    if (beta == 0.0) {
+        #pragma omp simd
+        for (int i = 0; i < nx; ++i) {
+            yp[i] = (cop[i] + theta * (ce[i] + cw[i]) + d_row) * xp[i]
+                    - wN * xN[i] - wS * xS[i] - wF * xF[i] - wB * xB[i];
+        }
+    } else {
+        #pragma omp simd
+        for (int i = 0; i < nx; ++i) {
+            yp[i] = beta * yp[i] + (cop[i] + theta * (ce[i] + cw[i]) + d_row) * xp[i]
+                    - wN * xN[i] - wS * xS[i] - wF * xF[i] - wB * xB[i];
+        }
+    }
+
+    // East neighbours (the last cell borders the boundary)
+    #pragma omp simd
+    for (int i = 0; i < nx - 1; ++i) {
+        yp[i] -= theta * ce[i] * xp[i + 1];
+    }
+
+    // West neighbours (the first cell borders the boundary)
+    #pragma omp simd
+    for (int i = 1; i < nx; ++i) {
+        yp[i] -= theta * cw[i] * xp[i - 1];
+    }
+}
+
+/*
+ * Function: stencil_apply
+ * -----------------------
+ * Computes y = A * x, where A is the finite-volume diffusion operator described in
+ * 'stencil_operator.h'.
+ *
+ * Every x-row (j, k) is handled independently (rows are distributed over the OpenMP threads)
+ * by branch-free, vectorized loops.
+ *
+ * Returns:
+ *   - 0 on success
+ *   - -1 on invalid input
+ */
+int stencil_apply(const StencilOperator* S, const double* x, double* y) {
+
+    if (stencil_check(S) != 0 || !x || !y) {
+        fprintf(stderr, "Invalid input to stencil_apply.\n");
+        return -1;
+    }
+
+    const long long num_rows = (long long) S->ny * S->nz;
+    const size_t n = (size_t) num_rows * S->nx;
+
+    #pragma omp parallel for schedule(static) if (n >= (size_t) PARALLEL_THRESHOLD)
+    for (long long r = 0; r < num_rows; ++r) {
+        stencil_row(S, r, x, y, 0.0);
+    }
+
+    return 0;
+}
+
+/*
+ * Function: stencil_cg_update_direction
+ * -------------------------------------
+ * Fused CG search-direction kernel for the stencil (see crs_cg_update_direction):
+ *
+ *     p = z + beta * p,   Ap = A * z + beta * Ap,   p_dot_Ap = dot(p, Ap)
+ *
+ * Each x-row of Ap is computed and immediately combined with p while it is still in cache,
+ * so p and Ap make a single pass through memory. With beta = 0, p and Ap are not read.
+ *
+ * Returns:
+ *   - 0 on success
+ *   - -1 on invalid input
+ */
+int stencil_cg_update_direction(const StencilOperator* S, const double* z, double beta, double* p, double* Ap,
+                                double* p_dot_Ap) {
+
+    if (stencil_check(S) != 0 || !z || !p || !Ap || !p_dot_Ap) {
+        fprintf(stderr, "Invalid input to stencil_cg_update_direction.\n");
+        return -1;
+    }
+
+    const int nx = S->nx;
+    const long long num_rows = (long long) S->ny * S->nz;
+    const size_t n = (size_t) num_rows * nx;
+    double dot = 0.0;
+
+    #pragma omp parallel for schedule(static) reduction(+:dot) if (n >= (size_t) PARALLEL_THRESHOLD)
+    for (long long r = 0; r < num_rows; ++r) {
+        stencil_row(S, r, z, Ap, beta);
+
+        const double* zp = z + (size_t) r * nx;
+        const double* Ap_row = Ap + (size_t) r * nx;
+        double* pp = p + (size_t) r * nx;
+        double row_dot = 0.0;
+        if (beta == 0.0) {
+            #pragma omp simd reduction(+:row_dot)
+            for (int i = 0; i < nx; ++i) {
+                pp[i] = zp[i];
+                row_dot += zp[i] * Ap_row[i];
+            }
+        } else {
+            #pragma omp simd reduction(+:row_dot)
+            for (int i = 0; i < nx; ++i) {
+                pp[i] = zp[i] + beta * pp[i];
+                row_dot += pp[i] * Ap_row[i];
+            }
+        }
+        dot += row_dot;
+    }
+
+    *p_dot_Ap = dot;
+    return 0;
+}
+
+/*
+ * Function: stencil_diagonal
+ * --------------------------
+ * Writes the diagonal of the stencil operator into 'diag' (length nx * ny * nz).
+ *
+ * Returns:
+ *   - 0 on success
+ *   - -1 on invalid input
+ */
+int stencil_diagonal(const StencilOperator* S, double* diag) {
+
+    if (stencil_check(S) != 0 || !diag) {
+        fprintf(stderr, "Invalid input to stencil_diagonal.\n");
+        return -1;
+    }
+
+    const int nx = S->nx, ny = S->ny, nz = S->nz;
+    const long long num_rows = (long long) ny * nz;
+
+    #pragma omp parallel for schedule(static) if ((size_t) num_rows * nx >= (size_t) PARALLEL_THRESHOLD)
+    for (long long r = 0; r < num_rows; ++r) {
+        const int j = (int) (r % ny);
+        const int k = (int) (r / ny);
+        const size_t base = (size_t) r * nx;
+        const double d_row = S->cn[j] + S->cs[j] + ((nz > 1) ? S->cf[k] + S->cb[k] : 0.0);
+
+        #pragma omp simd
+        for (int i = 0; i < nx; ++i) {
+            diag[base + i] = S->co[base + i] + S->theta * (S->ce[i] + S->cw[i] + d_row);
+        }
+    }
+
+    return 0;
+}
+
+/*
+ * Function: stencil_sor_sweep
+ * ---------------------------
+ * Relaxes the cells of one colour of the red-black ordering ((i + j + k + color) even):
+ *
+ *     x_p = (1 - omega) * x_p + omega * (b_p + theta * sum of the neighbour couplings) * inv_diag_p
+ *
+ * The 5-point (7-point) stencil only couples cells of different colour, so all cells of one
+ * colour are independent: the x-rows are distributed over the threads and the result does not
+ * depend on the number of threads. A full sweep is colour 0 then colour 1 (the reverse order
+ * gives the adjoint sweep).
+ *
+ * Parameters:
+ *   S        - Stencil description
+ *   b        - Right-hand side
+ *   x        - Current iterate, updated in place on the cells of the colour
+ *   inv_diag - Inverse diagonal of the operator (see stencil_diagonal)
+ *   omega    - Relaxation factor (1 = Gauss-Seidel, over-relaxation for 1 < omega < 2)
+ *   color    - 0 or 1
+ *
+ * Returns:
+ *   - 0 on success
+ *   - -1 on invalid input
+ */
+int stencil_sor_sweep(const StencilOperator* S, const double* b, double* x, const double* inv_diag, double omega,
+                      int color) {
+
+    if (stencil_check(S) != 0 || !b || !x || !inv_diag || (color != 0 && color != 1)) {
+        fprintf(stderr, "Invalid input to stencil_sor_sweep.\n");
+        return -1;
+    }
+
+    const int nx = S->nx, ny = S->ny, nz = S->nz;
+    const long long num_rows = (long long) ny * nz;
+    const size_t plane = (size_t) nx * ny;
+    const double theta = S->theta;
+
+    #pragma omp parallel for schedule(static) if ((size_t) num_rows * nx >= (size_t) PARALLEL_THRESHOLD)
+    for (long long r = 0; r < num_rows; ++r) {
+        const int j = (int) (r % ny);
+        const int k = (int) (r / ny);
+        const size_t base = (size_t) r * nx;
+        double* xp = x + base;
+        const double* bp = b + base;
+        const double* dp = inv_diag + base;
+
+        // Neighbour rows in y and z (weight 0 on the boundary, as in stencil_row)
+        const double wN = (j + 1 < ny) ? theta * S->cn[j] : 0.0;
+        const double wS = (j > 0) ? theta * S->cs[j] : 0.0;
+        const double wF = (k + 1 < nz) ? theta * S->cf[k] : 0.0;
+        const double wB = (k > 0) ? theta * S->cb[k] : 0.0;
+        const double* xN = (j + 1 < ny) ? xp + nx : xp;
+        const double* xS = (j > 0) ? xp - nx : xp;
+        const double* xF = (k + 1 < nz) ? xp + plane : xp;
+        const double* xB = (k > 0) ? xp - plane : xp;
+
+        for (int i = (j + k + color) & 1; i < nx; i += 2) {
+            double sum = bp[i] + wN * xN[i] + wS * xS[i] + wF * xF[i] + wB * xB[i];
+            if (i + 1 < nx) sum += theta * S->ce[i] * xp[i + 1];
+            if (i > 0) sum += theta * S->cw[i] * xp[i - 1];
+            xp[i] += omega * (sum * dp[i] - xp[i]);
+        }
+    }
+
+    return 0;
+}
+
+/*
+ * Function: stencil_to_crs
+ * ------------------------
+ * Assembles the stencil operator directly into CRS format, without going through a dense
+ * n x n buffer (dense_to_crs).
+ *
+ * Every cell has 1 diagonal entry plus one entry per interior neighbour, so the number of
+ * entries of each x-row (j, k) is known in closed form. The x-row offsets are computed first
+ * (one value per x-row), then the arrays are allocated with their exact sizes (rows + 1 row
+ * pointers, nnz values / column indices) and the x-rows are filled in parallel. Columns are
+ * stored in increasing order: back, south, west, diagonal, east, north, front.
+ *
+ * Parameters:
+ *   S - Stencil description
+ *   A - Output CRS matrix (allocated here, validated, free with free_crs_matrix)
+ *
+ * Returns:
+ *   - 0 on success
+ *   - -1 on invalid input or memory allocation failure
+ */
+int stencil_to_crs(const StencilOperator* S, CRSMatrix* A) {
+
+    if (stencil_check(S) != 0 || !A) {
+        fprintf(stderr, "Invalid input to stencil_to_crs.\n");
+        return -1;
+    }
+
+    const int nx = S->nx, ny = S->ny, nz = S->nz;
+    const size_t num_xrows = (size_t) ny * nz;
+    const size_t plane = (size_t) nx * ny;
+    const size_t n = plane * nz;
+    const double theta = S->theta;
+
+    // Offset of the first entry of every x-row (num_xrows + 1 values)
+    size_t* xrow_start = (size_t*) malloc((num_xrows + 1) * sizeof(size_t));
+    if (!xrow_start) {
+        fprintf(stderr, "Memory allocation failed in stencil_to_crs.\n");
+        return -1;
+    }
+    xrow_start[0] = 0;
+    for (size_t r = 0; r < num_xrows; ++r) {
+        const int j = (int) (r % ny);
+        const int k = (int) (r / ny);
+        const size_t neighbours = (size_t) (j > 0) + (size_t) (j + 1 < ny) + (size_t) (k > 0) + (size_t) (k + 1 < nz);
+        // nx diagonals, 2 * (nx - 1) east/west couplings, nx couplings per y/z neighbour row
+        xrow_start[r + 1] = xrow_start[r] + (size_t) nx * (1 + neighbours) + 2 * (size_t) (nx - 1);
+    }
+
+    const size_t nnz = xrow_start[num_xrows];
+    A->values = (double*) malloc(nnz * sizeof(double));
+    A->col_idx = (size_t*) malloc(nnz * sizeof(size_t));
+    A->row_ptr = (size_t*) malloc((n + 1) * sizeof(size_t));
+    A->row_part = NULL;
+    A->num_parts = 0;
+    A->validated = 0;
+    A->sell = NULL;
+    A->col_idx32 = NULL;
+    if (!A->values || !A->col_idx || !A->row_ptr) {
+        fprintf(stderr, "Memory allocation failed in stencil_to_crs.\n");
+        free(xrow_start);
+        free_crs_matrix(A);
+        return -1;
+    }
+    A->nnz = nnz;
+    A->rows = n;
+    A->cols = n;
+
+    // Fill the x-rows in parallel, every x-row knows where its entries start
+    #pragma omp parallel for schedule(static) if (n >= (size_t) PARALLEL_THRESHOLD)
+    for (long long r = 0; r < (long long) num_xrows; ++r) {
+        const int j = (int) (r % ny);
+        const int k = (int) (r / ny);
+        const double cn = S->cn[j], cs = S->cs[j];
+        const double cf = (nz > 1) ? S->cf[k] : 0.0;
+        const double cb = (nz > 1) ? S->cb[k] : 0.0;
+        const double d_row = theta * (cn + cs + cf + cb);
+
+        size_t pos = xrow_start[r];
+        for (int i = 0; i < nx; ++i) {
+            const size_t p = (size_t) r * nx + i;
+            A->row_ptr[p] = pos;
+
+            if (k > 0)      { A->col_idx[pos] = p - plane; A->values[pos++] = -theta * cb; }
+            if (j > 0)      { A->col_idx[pos] = p - nx;    A->values[pos++] = -theta * cs; }
+            if (i > 0)      { A->col_idx[pos] = p - 1;     A->values[pos++] = -theta * S->cw[i]; }
+            A->col_idx[pos] = p;
+            A->values[pos++] = S->co[p] + theta * (S->ce[i] + S->cw[i]) + d_row;
+            if (i + 1 < nx) { A->col_idx[pos] = p + 1;     A->values[pos++] = -theta * S->ce[i]; }
+            if (j + 1 < ny) { A->col_idx[pos] = p + nx;    A->values[pos++] = -theta * cn; }
+            if (k + 1 < nz) { A->col_idx[pos] = p + plane; A->values[pos++] = -theta * cf; }
+        }
+    }
+    A->row_ptr[n] = nnz;
+
+    free(xrow_start);
+
+    return crs_validate(A);
+}
+
+// LinearOperator callbacks
+static int stencil_op_apply(const LinearOperator* op, const double* x, double* y) {
+    return stencil_apply((const StencilOperator*) op->data, x, y);
+}
+
+static int stencil_op_update_direction(const LinearOperator* op, const double* z, double beta, double* p,
+                                       double* Ap, double* p_dot_Ap) {
+    return stencil_cg_update_direction((const StencilOperator*) op->data, z, beta, p, Ap, p_dot_Ap);
+}
+
+static int stencil_op_diagonal(const LinearOperator* op, double* diag) {
+    return stencil_diagonal((const StencilOperator*) op->data, diag);
+}
+
+/*
+ * Function: linear_operator_stencil
+ * ---------------------------------
+ * Initializes 'op' as the matrix-free stencil operator S. S must outlive 'op'.
+ *
+ * Returns:
+ *   - 0 on success
+ *   - -1 on invalid input
+ */
+int linear_operator_stencil(LinearOperator* op, const StencilOperator* S) {
+    if (!op || stencil_check(S) != 0) {
+        fprintf(stderr, "Invalid input to linear_operator_stencil.\n");
+        return -1;
+    }
+    op->n = (size_t) S->nx * S->ny * S->nz;
+    op->apply = stencil_op_apply;
+    op->diagonal = stencil_op_diagonal;
+    op->update_direction = stencil_op_update_direction;
+    op->data = S;
+    return 0;
+}
@@ -0,0 +1,67 @@
+// File: stencil_operator.h
+
+#ifndef PROJECT_02_FVM_STENCIL_OPERATOR_H
+#define PROJECT_02_FVM_STENCIL_OPERATOR_H
+
+#include "linear_operator.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * @struct StencilOperator
+ * Matrix-free 5-point (2D) / 7-point (3D) finite-volume diffusion operator on the interior
+ * cells of the structured grid.
+ *
+ * Unknown p = (k * ny + j) * nx + i (x-fastest), with 0 <= i < nx, 0 <= j < ny, 0 <= k < nz.
+ * Row p of the operator is
+ *
+ *   (co_p + theta * (ce_i + cw_i + cn_j + cs_j + cf_k + cb_k)) * x_p
+ *       - theta * (ce_i * x_E + cw_i * x_W + cn_j * x_N + cs_j * x_S + cf_k * x_F + cb_k * x_B)
+ *
+ * where neighbours outside the interior are Dirichlet boundary values: they keep their share
+ * of the diagonal but are moved to the right-hand side by the caller. The operator is
+ * symmetric positive definite for co > 0 and theta > 0.
+ *
+ * theta = 1 gives the implicit Euler matrix, theta = 0.5 the Crank-Nicolson matrix.
+ * For 2D set nz = 1 and cf = cb = NULL. The arrays are not owned by the operator.
+ */
+typedef struct {
+    int nx, ny, nz;          // Number of interior cells per direction (nz = 1 for 2D)
+    const double* ce;        // East  face coefficients, length nx
+    const double* cw;        // West  face coefficients, length nx
+    const double* cn;        // North face coefficients, length ny
+    const double* cs;        // South face coefficients, length ny
+    const double* cf;        // Front face coefficients, length nz (NULL for 2D)
+    const double* cb;        // Back  face coefficients, length nz (NULL for 2D)
+    const double* co;        // Storage coefficients rhoCp * V / dt, length nx * ny * nz
+    double theta;            // Weight of the diffusion part (1 = implicit Euler, 0.5 = Crank-Nicolson)
+} StencilOperator;
+
+// y = A * x without assembling A
+int stencil_apply(const StencilOperator* S, const double* x, double* y);
+
+// Fused CG direction update: p = z + beta * p, Ap = A * z + beta * Ap, p_dot_Ap = dot(p, Ap)
+int stencil_cg_update_direction(const StencilOperator* S, const double* z, double beta, double* p, double* Ap,
+                                double* p_dot_Ap);
+
+// diag = diag(A)
+int stencil_diagonal(const StencilOperator* S, double* diag);
+
+// One SOR half sweep over the cells of one colour ((i + j + k) % 2 == color, red-black order):
+// x_p += omega * (b_p - (A * x)_p) * inv_diag_p; cells of one colour only couple to the other one
+int stencil_sor_sweep(const StencilOperator* S, const double* b, double* x, const double* inv_diag, double omega,
+                      int color);
+
+// Assemble the stencil directly into a (validated) CRS matrix, O(nnz) time and memory
+int stencil_to_crs(const StencilOperator* S, CRSMatrix* A);
+
+// Wrap a stencil as a LinearOperator for the Krylov solvers
+int linear_operator_stencil(LinearOperator* op, const StencilOperator* S);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif //PROJECT_02_FVM_STENCIL_OPERATOR_H
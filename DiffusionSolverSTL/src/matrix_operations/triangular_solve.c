@@ -0,0 +1,402 @@
+/*
+ * File: triangular_solve.c
+ * ------------------------
+ * This file contains the parallel sparse triangular solves used to apply incomplete Cholesky
+ * preconditioners, L * L^T * z = r, where L is a sparse lower-triangular CRS factor.
+ *
+ * A plain forward/backward substitution is serial: row i needs the solution of every row it
+ * references. The dependencies form a DAG which is analyzed once ('trisolve_analyze'):
+ *
+ *  - Level scheduling: level(i) = 1 + max level(j) over the rows j that row i depends on.
+ *    Rows of the same level are independent and are solved in parallel (OpenMP 'for' per
+ *    level, one barrier between levels). For a 5-point (7-point) stencil the levels are the
+ *    anti-diagonals (anti-diagonal planes) of the grid.
+ *
+ *  - Sync-free: every row has an atomic counter of unresolved dependencies. When a row is
+ *    solved, it pushes its contribution into the partial sums of the rows depending on it and
+ *    decrements their counters; a row starts as soon as its counter is zero. There are no
+ *    barriers, threads only wait for the rows they actually need. Every thread processes its
+ *    rows in dependency order, so the row with the smallest (forward) index that is not yet
+ *    solved can always proceed and the solve cannot deadlock.
+ *
+ * The forward solve reads L by rows (level schedule) or by columns (sync-free push, rows of
+ * L^T), the backward solve the other way around, so L^T is built once during the analysis.
+ *
+ * Functions:
+ *  - trisolve_analyze: Builds L^T, the level schedules and the dependency counts.
+ *  - trisolve_lower / trisolve_upper / trisolve_llt: Parallel solves.
+ *  - trisolve_llt_team: L * L^T * z = r inside an enclosing parallel region.
+ *  - trisolve_use_single: Stores the factor values in single precision.
+ *  - trisolve_free: Frees the analysis.
+ *
+ * The solves themselves are in triangular_solve_kernels.h, instantiated for both column index
+ * widths and both precisions of the factor values and picked once per solve.
+ */
+
+#include "triangular_solve.h"
+#include "linear_algebra.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <omp_llvm.h>
+
+// Rows per block of the sync-free solves (every thread processes whole blocks in order)
+#define TRISOLVE_BLOCK 64
+
+/*
+ * Groups the rows into levels, 'dep(i)' being the off-diagonal entries of row i of M
+ * (M = L for the forward solve, M = L^T for the backward solve).
+ *
+ * 'forward' selects the processing order (increasing or decreasing row index). Returns 0 on
+ * success, -1 on memory allocation failure.
+ */
+static int trisolve_levels(const CRSMatrix* M, int forward, size_t* num_levels, size_t** level_ptr,
+                           size_t** level_rows) {
+
+    const size_t n = M->rows;
+    size_t* level = (size_t*) malloc(n * sizeof(size_t));
+    if (!level) {
+        return -1;
+    }
+
+    // level(i) = 1 + max level of the dependencies (they are all solved before i)
+    size_t max_level = 0;
+    for (size_t t = 0; t < n; ++t) {
+        const size_t i = forward ? t : n - 1 - t;
+        size_t lev = 0;
+        for (size_t j = M->row_ptr[i]; j < M->row_ptr[i + 1]; ++j) {
+            const size_t c = crs_col(M, j);
+            if (c != i && level[c] + 1 > lev) {
+                lev = level[c] + 1;
+            }
+        }
+        level[i] = lev;
+        if (lev > max_level) {
+            max_level = lev;
+        }
+    }
+
+    // Counting sort of the rows by level (increasing row index inside a level)
+    *num_levels = max_level + 1;
+    *level_ptr = (size_t*) calloc(*num_levels + 1, sizeof(size_t));
+    *level_rows = (size_t*) malloc(n * sizeof(size_t));
+    if (!*level_ptr || !*level_rows) {
+        free(level);
+        return -1;
+    }
+    for (size_t i = 0; i < n; ++i) {
+        (*level_ptr)[level[i] + 1]++;
+    }
+    for (size_t l = 0; l < *num_levels; ++l) {
+        (*level_ptr)[l + 1] += (*level_ptr)[l];
+    }
+    size_t* cursor = (size_t*) malloc(*num_levels * sizeof(size_t));
+    if (!cursor) {
+        free(level);
+        return -1;
+    }
+    for (size_t l = 0; l < *num_levels; ++l) {
+        cursor[l] = (*level_ptr)[l];
+    }
+    for (size_t i = 0; i < n; ++i) {
+        (*level_rows)[cursor[level[i]]++] = i;
+    }
+
+    free(cursor);
+    free(level);
+    return 0;
+}
+
+/*
+ * Function: trisolve_analyze
+ * --------------------------
+ * Analyzes the lower-triangular factor L once: builds L^T, the level schedules of the forward
+ * and backward solves and the dependency counts of the sync-free solves. The result is reused
+ * by every solve with the same factor.
+ *
+ * Parameters:
+ *   L      - Validated square lower-triangular CRS matrix, sorted rows, diagonal last in every row
+ *   method - TRISOLVE_LEVEL_SCHEDULE or TRISOLVE_SYNC_FREE
+ *   T      - Output analysis (free with trisolve_free)
+ *
+ * Returns:
+ *   - 0 on success
+ *   - -1 on invalid input (including a missing diagonal) or memory allocation failure
+ */
+int trisolve_analyze(const CRSMatrix* L, TriangularSolveMethod method, TriangularSolve* T) {
+
+    if (!L || !T || !L->validated || L->rows != L->cols) {
+        fprintf(stderr, "Invalid input to trisolve_analyze.\n");
+        return -1;
+    }
+
+    const size_t n = L->rows;
+    for (size_t i = 0; i < n; ++i) {
+        if (L->row_ptr[i + 1] == L->row_ptr[i] || crs_col(L, L->row_ptr[i + 1] - 1) != i) {
+            fprintf(stderr, "Row %zu of the factor does not end with its diagonal in trisolve_analyze.\n", i);
+            return -1;
+        }
+    }
+
+    T->L = L;
+    T->method = method;
+    T->num_levels_fwd = 0;
+    T->level_ptr_fwd = NULL;
+    T->level_rows_fwd = NULL;
+    T->num_levels_bwd = 0;
+    T->level_ptr_bwd = NULL;
+    T->level_rows_bwd = NULL;
+    T->deps_fwd = NULL;
+    T->deps_bwd = NULL;
+    T->counter = NULL;
+    T->left_sum = NULL;
+    T->values32_fwd = NULL;
+    T->values32_bwd = NULL;
+
+    // L^T: its rows are sorted, so the diagonal is the first entry of every row
+    if (crs_transpose(L, &T->Lt) != 0) {
+        return -1;
+    }
+
+    int status = 0;
+    if (method == TRISOLVE_LEVEL_SCHEDULE) {
+        status |= trisolve_levels(L, 1, &T->num_levels_fwd, &T->level_ptr_fwd, &T->level_rows_fwd);
+        status |= trisolve_levels(&T->Lt, 0, &T->num_levels_bwd, &T->level_ptr_bwd, &T->level_rows_bwd);
+    } else {
+        T->deps_fwd = (int*) malloc(n * sizeof(int));
+        T->deps_bwd = (int*) malloc(n * sizeof(int));
+        T->counter = (int*) malloc(n * sizeof(int));
+        T->left_sum = (double*) malloc(n * sizeof(double));
+        if (!T->deps_fwd || !T->deps_bwd || !T->counter || !T->left_sum) {
+            status = -1;
+        } else {
+            for (size_t i = 0; i < n; ++i) {
+                T->deps_fwd[i] = (int) (L->row_ptr[i + 1] - L->row_ptr[i] - 1);         // Row i of L
+                T->deps_bwd[i] = (int) (T->Lt.row_ptr[i + 1] - T->Lt.row_ptr[i] - 1);   // Column i of L
+            }
+        }
+    }
+
+    if (status != 0) {
+        fprintf(stderr, "Memory allocation failed in trisolve_analyze.\n");
+        trisolve_free(T);
+        return -1;
+    }
+    return 0;
+}
+
+// Waits until every dependency of row i has been pushed
+static void trisolve_wait(const int* counter, size_t i) {
+    int pending;
+    do {
+        #pragma omp atomic read
+        pending = counter[i];
+    } while (pending > 0);
+    #pragma omp flush
+}
+
+// Adds 'value' to the partial sum of row k and resolves one of its dependencies
+static void trisolve_push(int* counter, double* left_sum, size_t k, double value) {
+    #pragma omp atomic
+    left_sum[k] += value;
+    #pragma omp flush
+    #pragma omp atomic
+    counter[k] -= 1;
+}
+
+// Solves of triangular_solve_kernels.h for both index widths and both value precisions
+#define TRISOLVE_INDEX uint32_t
+#define TRISOLVE_VALUE double
+#define TRISOLVE_KERNEL(name) name##_u32_double
+#include "triangular_solve_kernels.h"
+#undef TRISOLVE_VALUE
+#undef TRISOLVE_KERNEL
+#define TRISOLVE_VALUE float
+#define TRISOLVE_KERNEL(name) name##_u32_float
+#include "triangular_solve_kernels.h"
+#undef TRISOLVE_INDEX
+#undef TRISOLVE_VALUE
+#undef TRISOLVE_KERNEL
+#define TRISOLVE_INDEX size_t
+#define TRISOLVE_VALUE double
+#define TRISOLVE_KERNEL(name) name##_size_double
+#include "triangular_solve_kernels.h"
+#undef TRISOLVE_VALUE
+#undef TRISOLVE_KERNEL
+#define TRISOLVE_VALUE float
+#define TRISOLVE_KERNEL(name) name##_size_float
+#include "triangular_solve_kernels.h"
+#undef TRISOLVE_INDEX
+#undef TRISOLVE_VALUE
+#undef TRISOLVE_KERNEL
+
+// Calls the solve for the index width of L (L^T, square, has the same) and the precision of
+// the factor values, once per solve
+#define TRISOLVE_CALL(T, solve, ...) \
+    ((T)->L->col_idx32 \
+        ? ((T)->values32_fwd \
+            ? solve##_u32_float((T), (T)->L->col_idx32, (T)->Lt.col_idx32, (T)->values32_fwd, (T)->values32_bwd, __VA_ARGS__) \
+            : solve##_u32_double((T), (T)->L->col_idx32, (T)->Lt.col_idx32, (T)->L->values, (T)->Lt.values, __VA_ARGS__)) \
+        : ((T)->values32_fwd \
+            ? solve##_size_float((T), (T)->L->col_idx, (T)->Lt.col_idx, (T)->values32_fwd, (T)->values32_bwd, __VA_ARGS__) \
+            : solve##_size_double((T), (T)->L->col_idx, (T)->Lt.col_idx, (T)->L->values, (T)->Lt.values, __VA_ARGS__)))
+
+static void trisolve_lower_team(const TriangularSolve* T, const double* r, double* y) {
+    if (omp_get_num_threads() == 1) {
+        TRISOLVE_CALL(T, trisolve_lower_serial, r, y);
+    } else if (T->method == TRISOLVE_SYNC_FREE) {
+        TRISOLVE_CALL(T, trisolve_lower_sync_free, r, y);
+    } else {
+        TRISOLVE_CALL(T, trisolve_lower_levels, r, y);
+    }
+}
+
+static void trisolve_upper_team(const TriangularSolve* T, const double* y, double* z) {
+    if (omp_get_num_threads() == 1) {
+        TRISOLVE_CALL(T, trisolve_upper_serial, y, z);
+    } else if (T->method == TRISOLVE_SYNC_FREE) {
+        TRISOLVE_CALL(T, trisolve_upper_sync_free, y, z);
+    } else {
+        TRISOLVE_CALL(T, trisolve_upper_levels, y, z);
+    }
+}
+
+/*
+ * Function: trisolve_llt_team
+ * ---------------------------
+ * Solves L * L^T * z = r (z may alias r) with the threads of the enclosing parallel region.
+ * Every thread of the team must call it; outside a parallel region (or with a team of one
+ * thread) it falls back to plain forward/backward substitution.
+ */
+void trisolve_llt_team(const TriangularSolve* T, const double* r, double* z) {
+    trisolve_lower_team(T, r, z);
+    trisolve_upper_team(T, z, z);
+}
+
+/*
+ * Function: trisolve_lower
+ * ------------------------
+ * Solves L * y = r in parallel with the analyzed schedule.
+ *
+ * Returns:
+ *   - 0 on success
+ *   - -1 on null pointers
+ */
+int trisolve_lower(const TriangularSolve* T, const double* r, double* y) {
+    if (!T || !T->L || !r || !y) {
+        fprintf(stderr, "Invalid input to trisolve_lower.\n");
+        return -1;
+    }
+    #pragma omp parallel if (T->L->nnz >= (size_t) SPARSE_PARALLEL_THRESHOLD)
+    trisolve_lower_team(T, r, y);
+    return 0;
+}
+
+/*
+ * Function: trisolve_upper
+ * ------------------------
+ * Solves L^T * z = y in parallel with the analyzed schedule (z may alias y).
+ *
+ * Returns:
+ *   - 0 on success
+ *   - -1 on null pointers
+ */
+int trisolve_upper(const TriangularSolve* T, const double* y, double* z) {
+    if (!T || !T->L || !y || !z) {
+        fprintf(stderr, "Invalid input to trisolve_upper.\n");
+        return -1;
+    }
+    #pragma omp parallel if (T->L->nnz >= (size_t) SPARSE_PARALLEL_THRESHOLD)
+    trisolve_upper_team(T, y, z);
+    return 0;
+}
+
+/*
+ * Function: trisolve_llt
+ * ----------------------
+ * Solves L * L^T * z = r (incomplete Cholesky preconditioner application) in one parallel
+ * region. z may alias r.
+ *
+ * Returns:
+ *   - 0 on success
+ *   - -1 on null pointers
+ */
+int trisolve_llt(const TriangularSolve* T, const double* r, double* z) {
+    if (!T || !T->L || !r || !z) {
+        fprintf(stderr, "Invalid input to trisolve_llt.\n");
+        return -1;
+    }
+    #pragma omp parallel if (T->L->nnz >= (size_t) SPARSE_PARALLEL_THRESHOLD)
+    trisolve_llt_team(T, r, z);
+    return 0;
+}
+
+/*
+ * Function: trisolve_use_single
+ * -----------------------------
+ * Switches the solves to single-precision factor values: float copies of the values of L and
+ * L^T are stored and the double values of L^T are freed. The solves then read 4 instead of 8
+ * bytes per factor entry; the right-hand side, the solution and all sums stay in double. The
+ * double values of L are not read any more (the owner of L may free them).
+ *
+ * Returns:
+ *   - 0 on success (also if the solves already use single precision)
+ *   - -1 on null pointers or memory allocation failure (the solves stay in double)
+ */
+int trisolve_use_single(TriangularSolve* T) {
+    if (!T || !T->L) {
+        fprintf(stderr, "Invalid input to trisolve_use_single.\n");
+        return -1;
+    }
+    if (T->values32_fwd) {
+        return 0;
+    }
+
+    const size_t nnz = T->L->nnz;
+    float* fwd = (float*) malloc(nnz * sizeof(float));
+    float* bwd = (float*) malloc(nnz * sizeof(float));
+    if (!fwd || !bwd) {
+        fprintf(stderr, "Memory allocation failed in trisolve_use_single.\n");
+        free(fwd);
+        free(bwd);
+        return -1;
+    }
+
+    #pragma omp parallel for simd if (nnz >= (size_t) PARALLEL_THRESHOLD)
+    for (long long j = 0; j < (long long) nnz; ++j) {
+        fwd[j] = (float) T->L->values[j];
+        bwd[j] = (float) T->Lt.values[j];
+    }
+
+    free(T->Lt.values);
+    T->Lt.values = NULL;
+    T->values32_fwd = fwd;
+    T->values32_bwd = bwd;
+    return 0;
+}
+
+/*
+ * Function: trisolve_free
+ * -----------------------
+ * Frees the memory of the analysis (L itself is not owned and is not freed).
+ */
+void trisolve_free(TriangularSolve* T) {
+    if (!T) return;
+    free_crs_matrix(&T->Lt);
+    free(T->level_ptr_fwd);
+    free(T->level_rows_fwd);
+    free(T->level_ptr_bwd);
+    free(T->level_rows_bwd);
+    free(T->deps_fwd);
+    free(T->deps_bwd);
+    free(T->counter);
+    free(T->left_sum);
+    free(T->values32_fwd);
+    free(T->values32_bwd);
+    T->values32_fwd = T->values32_bwd = NULL;
+    T->level_ptr_fwd = T->level_rows_fwd = T->level_ptr_bwd = T->level_rows_bwd = NULL;
+    T->deps_fwd = T->deps_bwd = T->counter = NULL;
+    T->left_sum = NULL;
+    T->num_levels_fwd = T->num_levels_bwd = 0;
+    T->L = NULL;
+}
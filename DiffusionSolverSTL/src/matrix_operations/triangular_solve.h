@@ -0,0 +1,79 @@
+// File: triangular_solve.h
+
+#ifndef PROJECT_02_FVM_TRIANGULAR_SOLVE_H
+#define PROJECT_02_FVM_TRIANGULAR_SOLVE_H
+
+#include <stddef.h>  // for size_t
+#include "CRSMatrix.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * @enum TriangularSolveMethod
+ * Parallel execution strategy of the sparse triangular solves.
+ *  - TRISOLVE_LEVEL_SCHEDULE: rows are grouped into levels of the dependency DAG; the rows of
+ *    one level are independent and solved in parallel, with a barrier between levels.
+ *  - TRISOLVE_SYNC_FREE: no barriers; every row has an atomic counter of unresolved
+ *    dependencies, decremented by the rows it depends on when they are solved.
+ */
+typedef enum {
+    TRISOLVE_LEVEL_SCHEDULE = 0,
+    TRISOLVE_SYNC_FREE = 1
+} TriangularSolveMethod;
+
+/*
+ * @struct TriangularSolve
+ * Analysis of a lower-triangular factor L (CRS, sorted rows, diagonal last in every row, e.g.
+ * from incomplete_cholesky_crs) for the solves L * y = r and L^T * z = y.
+ *
+ * The dependency DAG is analyzed once by 'trisolve_analyze' and the schedule is reused by
+ * every solve, e.g. every preconditioner application of every time step. L is not owned and
+ * must outlive the analysis.
+ */
+typedef struct {
+    const CRSMatrix* L;               // Lower factor (not owned)
+    CRSMatrix Lt;                     // L^T in CRS (sorted rows, diagonal first)
+    TriangularSolveMethod method;
+
+    // Level schedule: rows of level l are level_rows[level_ptr[l] .. level_ptr[l + 1])
+    size_t num_levels_fwd;
+    size_t* level_ptr_fwd;
+    size_t* level_rows_fwd;
+    size_t num_levels_bwd;
+    size_t* level_ptr_bwd;
+    size_t* level_rows_bwd;
+
+    // Sync-free: dependencies of every row (forward / backward) and per-solve work arrays
+    int* deps_fwd;
+    int* deps_bwd;
+    int* counter;
+    double* left_sum;
+
+    // Single-precision factor values of L and L^T (trisolve_use_single), NULL in double precision
+    float* values32_fwd;
+    float* values32_bwd;
+} TriangularSolve;
+
+// Analyze L once (level schedule and dependency counts, O(nnz))
+int trisolve_analyze(const CRSMatrix* L, TriangularSolveMethod method, TriangularSolve* T);
+
+// L * y = r, L^T * z = y and L * L^T * z = r (parallel, z may alias r in trisolve_llt)
+int trisolve_lower(const TriangularSolve* T, const double* r, double* y);
+int trisolve_upper(const TriangularSolve* T, const double* y, double* z);
+int trisolve_llt(const TriangularSolve* T, const double* r, double* z);
+
+// L * L^T * z = r executed by the threads of an enclosing parallel region (all threads must call it)
+void trisolve_llt_team(const TriangularSolve* T, const double* r, double* z);
+
+// Store the factor values in single precision (vectors and sums stay in double)
+int trisolve_use_single(TriangularSolve* T);
+
+void trisolve_free(TriangularSolve* T);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif //PROJECT_02_FVM_TRIANGULAR_SOLVE_H
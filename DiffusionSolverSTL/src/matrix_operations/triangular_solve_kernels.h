@@ -0,0 +1,153 @@
+/*
+ * File: triangular_solve_kernels.h
+ * --------------------------------
+ * Forward and backward solves of triangular_solve.c for one column index width and one
+ * precision of the factor values. The file has no include guard: triangular_solve.c includes
+ * it once per combination, with
+ *
+ *   TRISOLVE_INDEX     - column index type of L and L^T (uint32_t or size_t)
+ *   TRISOLVE_VALUE     - type of the factor values (double, or float after trisolve_use_single)
+ *   TRISOLVE_KERNEL(f) - name of solve f for this combination
+ *
+ * Every solve gets the column indices (Lc, Uc) and values (Lv, Uv) of L and of U = L^T, picked
+ * once per solve by TRISOLVE_CALL; the sums are always accumulated in double.
+ */
+
+// Sum of v[j] * x[c[j]] over the entries [begin, end)
+static inline double TRISOLVE_KERNEL(trisolve_dot)(const TRISOLVE_INDEX* c, const TRISOLVE_VALUE* v, size_t begin,
+                                                   size_t end, const double* x) {
+    double sum = 0.0;
+    #pragma omp simd reduction(+:sum)
+    for (size_t j = begin; j < end; ++j) {
+        sum += (double) v[j] * x[c[j]];
+    }
+    return sum;
+}
+
+// Level-scheduled L * y = r (orphaned worksharing, called by every thread of the team)
+static void TRISOLVE_KERNEL(trisolve_lower_levels)(const TriangularSolve* T, const TRISOLVE_INDEX* Lc,
+                                                   const TRISOLVE_INDEX* Uc, const TRISOLVE_VALUE* Lv,
+                                                   const TRISOLVE_VALUE* Uv, const double* r, double* y) {
+    (void) Uc;
+    (void) Uv;
+    const size_t* row_ptr = T->L->row_ptr;
+    for (size_t lev = 0; lev < T->num_levels_fwd; ++lev) {
+        #pragma omp for schedule(static)
+        for (long long t = (long long) T->level_ptr_fwd[lev]; t < (long long) T->level_ptr_fwd[lev + 1]; ++t) {
+            const size_t i = T->level_rows_fwd[t];
+            const size_t diag = row_ptr[i + 1] - 1;
+            y[i] = (r[i] - TRISOLVE_KERNEL(trisolve_dot)(Lc, Lv, row_ptr[i], diag, y)) / (double) Lv[diag];
+        }
+    }
+}
+
+// Level-scheduled L^T * z = y, rows of L^T (diagonal first)
+static void TRISOLVE_KERNEL(trisolve_upper_levels)(const TriangularSolve* T, const TRISOLVE_INDEX* Lc,
+                                                   const TRISOLVE_INDEX* Uc, const TRISOLVE_VALUE* Lv,
+                                                   const TRISOLVE_VALUE* Uv, const double* y, double* z) {
+    (void) Lc;
+    (void) Lv;
+    const size_t* row_ptr = T->Lt.row_ptr;
+    for (size_t lev = 0; lev < T->num_levels_bwd; ++lev) {
+        #pragma omp for schedule(static)
+        for (long long t = (long long) T->level_ptr_bwd[lev]; t < (long long) T->level_ptr_bwd[lev + 1]; ++t) {
+            const size_t i = T->level_rows_bwd[t];
+            const size_t diag = row_ptr[i];
+            z[i] = (y[i] - TRISOLVE_KERNEL(trisolve_dot)(Uc, Uv, diag + 1, row_ptr[i + 1], z)) / (double) Uv[diag];
+        }
+    }
+}
+
+// Sync-free L * y = r: row i of L^T lists the rows depending on y[i]
+static void TRISOLVE_KERNEL(trisolve_lower_sync_free)(const TriangularSolve* T, const TRISOLVE_INDEX* Lc,
+                                                      const TRISOLVE_INDEX* Uc, const TRISOLVE_VALUE* Lv,
+                                                      const TRISOLVE_VALUE* Uv, const double* r, double* y) {
+    (void) Lc;
+    const size_t* L_ptr = T->L->row_ptr;
+    const size_t* U_ptr = T->Lt.row_ptr;
+    const size_t n = T->L->rows;
+    int* counter = T->counter;
+    double* left_sum = T->left_sum;
+
+    #pragma omp for schedule(static)
+    for (long long i = 0; i < (long long) n; ++i) {
+        counter[i] = T->deps_fwd[i];
+        left_sum[i] = 0.0;
+    }
+
+    const size_t num_blocks = (n + TRISOLVE_BLOCK - 1) / TRISOLVE_BLOCK;
+    const int num_threads = omp_get_num_threads();
+    for (size_t blk = (size_t) omp_get_thread_num(); blk < num_blocks; blk += (size_t) num_threads) {
+        const size_t end = (blk + 1) * TRISOLVE_BLOCK < n ? (blk + 1) * TRISOLVE_BLOCK : n;
+        for (size_t i = blk * TRISOLVE_BLOCK; i < end; ++i) {
+            trisolve_wait(counter, i);
+            const double yi = (r[i] - left_sum[i]) / (double) Lv[L_ptr[i + 1] - 1];
+            y[i] = yi;
+            for (size_t j = U_ptr[i] + 1; j < U_ptr[i + 1]; ++j) {
+                trisolve_push(counter, left_sum, Uc[j], (double) Uv[j] * yi);
+            }
+        }
+    }
+    #pragma omp barrier
+}
+
+// Sync-free L^T * z = y, in decreasing row order: row i of L lists the rows depending on z[i]
+static void TRISOLVE_KERNEL(trisolve_upper_sync_free)(const TriangularSolve* T, const TRISOLVE_INDEX* Lc,
+                                                      const TRISOLVE_INDEX* Uc, const TRISOLVE_VALUE* Lv,
+                                                      const TRISOLVE_VALUE* Uv, const double* y, double* z) {
+    (void) Uc;
+    const size_t* L_ptr = T->L->row_ptr;
+    const size_t* U_ptr = T->Lt.row_ptr;
+    const size_t n = T->L->rows;
+    int* counter = T->counter;
+    double* left_sum = T->left_sum;
+
+    #pragma omp for schedule(static)
+    for (long long i = 0; i < (long long) n; ++i) {
+        counter[i] = T->deps_bwd[i];
+        left_sum[i] = 0.0;
+    }
+
+    const size_t num_blocks = (n + TRISOLVE_BLOCK - 1) / TRISOLVE_BLOCK;
+    const int num_threads = omp_get_num_threads();
+    for (size_t blk = (size_t) omp_get_thread_num(); blk < num_blocks; blk += (size_t) num_threads) {
+        // Block 0 holds the last rows
+        const size_t end = n - blk * TRISOLVE_BLOCK;
+        const size_t begin = end > TRISOLVE_BLOCK ? end - TRISOLVE_BLOCK : 0;
+        for (size_t i = end; i-- > begin;) {
+            trisolve_wait(counter, i);
+            const double zi = (y[i] - left_sum[i]) / (double) Uv[U_ptr[i]];
+            z[i] = zi;
+            for (size_t j = L_ptr[i]; j < L_ptr[i + 1] - 1; ++j) {
+                trisolve_push(counter, left_sum, Lc[j], (double) Lv[j] * zi);
+            }
+        }
+    }
+    #pragma omp barrier
+}
+
+// Plain forward substitution in row order (single thread: the schedule only costs locality)
+static void TRISOLVE_KERNEL(trisolve_lower_serial)(const TriangularSolve* T, const TRISOLVE_INDEX* Lc,
+                                                   const TRISOLVE_INDEX* Uc, const TRISOLVE_VALUE* Lv,
+                                                   const TRISOLVE_VALUE* Uv, const double* r, double* y) {
+    (void) Uc;
+    (void) Uv;
+    const size_t* row_ptr = T->L->row_ptr;
+    for (size_t i = 0; i < T->L->rows; ++i) {
+        const size_t diag = row_ptr[i + 1] - 1;
+        y[i] = (r[i] - TRISOLVE_KERNEL(trisolve_dot)(Lc, Lv, row_ptr[i], diag, y)) / (double) Lv[diag];
+    }
+}
+
+// Plain backward substitution over the rows of L^T
+static void TRISOLVE_KERNEL(trisolve_upper_serial)(const TriangularSolve* T, const TRISOLVE_INDEX* Lc,
+                                                   const TRISOLVE_INDEX* Uc, const TRISOLVE_VALUE* Lv,
+                                                   const TRISOLVE_VALUE* Uv, const double* y, double* z) {
+    (void) Lc;
+    (void) Lv;
+    const size_t* row_ptr = T->Lt.row_ptr;
+    for (size_t i = T->Lt.rows; i-- > 0;) {
+        const size_t diag = row_ptr[i];
+        z[i] = (y[i] - TRISOLVE_KERNEL(trisolve_dot)(Uc, Uv, diag + 1, row_ptr[i + 1], z)) / (double) Uv[diag];
+    }
+}
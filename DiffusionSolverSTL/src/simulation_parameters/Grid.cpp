@@ -17,10 +17,10 @@ Grid::Grid(int N, double L, double lm, double rhoCp, double dt)
     cs(vector<double>(N + 1, 0.0)),
     cf(vector<double>(N + 1, 0.0)),
     cb(vector<double>(N + 1, 0.0)),
-    co2D(N + 1, vector<double>(N + 1, 0.0)),
-    cd2D(N + 1, vector<double>(N + 1, 0.0)),
-    co3D(N + 1, vector<vector<double>>(N + 1, vector<double>(N + 1, 0.0))),
-    cd3D(N + 1, vector<vector<double>>(N + 1, vector<double>(N + 1, 0.0)))
+    co2D(N, N, 0.0, 0),
+    cd2D(N, N, 0.0, 0),
+    co3D(N, N, N, 0.0, 0),
+    cd3D(N, N, N, 0.0, 0)
 {
 
     // Initialize grid points and spacing
@@ -38,8 +38,8 @@ void Grid::initialize_grid() {
     dy[N + 1] = 0.0;
     dz[N + 1] = 0.0;
 
-    // Assign default grid spacing to the interior points
-    for (int i = 0; i < N + 1; ++i) {
+    // Assign default grid spacing to the interior points (0 and N + 1 are the boundary faces)
+    for (int i = 1; i < N + 1; ++i) {
         dx[i] = dl;  // Constant grid spacing in x-direction
         dy[i] = dl;  // Constant grid spacing in y-direction
         dz[i] = dl;  // Constant grid spacing in z-direction
@@ -56,8 +56,9 @@ void Grid::initialize_grid() {
 
 // Initialize coefficients (ce, cw, cn, cs, co, cd)
 void Grid::initialize_coefficients() {
-    // Loop over all grid points and calculate coefficients
-    for (int i = 0; i < N + 1; ++i) {
+    // Loop over all interior grid points and calculate coefficients
+    // (the cells next to the boundary see the boundary face at half a cell distance)
+    for (int i = 1; i < N + 1; ++i) {
         ce[i] = lm * dl / (0.5 * (dx[i] + dx[i + 1]));  // East coefficient
         cw[i] = lm * dl / (0.5 * (dx[i] + dx[i - 1]));  // West coefficient
         cn[i] = lm * dl / (0.5 * (dy[i] + dy[i + 1]));  // North coefficient
@@ -66,20 +67,21 @@ void Grid::initialize_coefficients() {
         cb[i] = lm * dl / (0.5 * (dz[i] + dz[i - 1]));  // Back coefficient
     }
 
-    // Loop through the grid to calculate co and cd for 2D cases
-    for (int j = 0; j < N + 1; ++j) {
-        for (int i = 0; i < N + 1; ++i) {
-            co2D[j][i] = rhoCp * dx[i] * dy[j] / dt;
-            cd2D[j][i] = co2D[j][i] + ce[i] + cw[i] + cn[j] + cs[j];
+    // Loop through the interior cells to calculate co and cd for 2D cases (field cell i is grid cell i + 1)
+    for (int j = 0; j < N; ++j) {
+        for (int i = 0; i < N; ++i) {
+            co2D(i, j) = rhoCp * dx[i + 1] * dy[j + 1] / dt;
+            cd2D(i, j) = co2D(i, j) + ce[i + 1] + cw[i + 1] + cn[j + 1] + cs[j + 1];
         }
     }
 
-    // Loop through the grid to calculate co and cd for 3D cases
-    for (int k = 0; k < N + 1; ++k) {
-        for (int j = 0; j < N + 1; ++j) {
-            for (int i = 0; i < N + 1; ++i) {
-                co3D[k][j][i] = rhoCp * dx[i] * dy[j] / dt;
-                cd3D[k][j][i] = co3D[k][j][i] + ce[i] + cw[i] + cn[j] + cs[j];    // TODO: This is not correct for now, need derivation
+    // Loop through the interior cells to calculate co and cd for 3D cases
+    for (int k = 0; k < N; ++k) {
+        for (int j = 0; j < N; ++j) {
+            for (int i = 0; i < N; ++i) {
+                co3D(i, j, k) = rhoCp * dx[i + 1] * dy[j + 1] / dt;
+                // The 3D balance is divided by the uniform cell depth, so co3D and ce..cb keep the 2D form
+                cd3D(i, j, k) = co3D(i, j, k) + ce[i + 1] + cw[i + 1] + cn[j + 1] + cs[j + 1] + cf[k + 1] + cb[k + 1];
             }
         }
     }
@@ -6,6 +6,7 @@
 #define PROJECT_02_FVM_GRID_HPP
 
 #include <vector>
+#include "field/Field.hpp"
 
 using namespace std;
 
@@ -37,8 +38,10 @@ public:
 
     // Conduction coefficients
     vector<double> ce, cw, cn, cs, cf, cb;          // East, West, North, South, Front, Back conduction coefficients
-    vector<vector<double>> co2D, cd2D;              // coefficients for the finite volume equation 2D
-    vector<vector<vector<double>>> co3D, cd3D;      // coefficients for the finite volume equation 3D
+    // Coefficients of the finite volume equation per interior cell: N x N (x N) fields indexed like
+    // the temperature fields, i.e. field cell (i, j) is grid cell (i + 1, j + 1)
+    Field2D co2D, cd2D;                             // coefficients for the finite volume equation 2D
+    Field3D co3D, cd3D;                             // coefficients for the finite volume equation 3D
 
 private:
     // Internal function to initialize grid points and spacing
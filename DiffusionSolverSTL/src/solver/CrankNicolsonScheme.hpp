@@ -1,24 +1,48 @@
 //
 // Created by QCZ on 9/29/2024.
 //
+/*
+ * File: CrankNicolsonScheme.hpp
+ * -----------------------------
+ * This file contains the definition of the CrankNicolsonScheme class, which implements the
+ * Crank-Nicolson (trapezoidal, theta = 0.5) time-stepping method for the diffusion equation
+ * in 2D and 3D:
+ *
+ *   (co + K / 2) * T^(n+1) = (co - K / 2) * T^n + boundary terms
+ *
+ * The scheme is unconditionally stable and second-order accurate in time. As for the implicit
+ * scheme, the operator and the preconditioner are built once (see ImplicitSystem) and every
+ * step only rebuilds the right-hand side and warm-starts the solver from T^n.
+ */
 
 #ifndef PROJECT_02_FVM_CRANKNICOLSONSCHEME_HPP
 #define PROJECT_02_FVM_CRANKNICOLSONSCHEME_HPP
 
+#include <memory>
 #include "TimeStepping.hpp"
+#include "ImplicitSystem.hpp"
 #include "simulation_parameters/Grid.hpp"
 
 class CrankNicolsonScheme : public TimeStepping {
 public:
-    // Override the step function for the explicit scheme
-    void step(vector<vector<double>>& T, vector<vector<double>>& To,
+    // 'settings': linear solver and preconditioner used for every time step
+    explicit CrankNicolsonScheme(LinearSolverSettings settings = {}) : settings(std::move(settings)) {}
+
+    // Override the step function for the Crank-Nicolson scheme
+    void step(TimeLevels2D& T,
                       Grid& grid, int time_step_num, int output_stride,
-                      vector<vector<vector<double>>>& Ts) override;
+                      vector<Field2D>& Ts) override;
 
-    void step(vector<vector<vector<double>>>& T, vector<vector<vector<double>>>& To,
+    void step(TimeLevels3D& T,
                       Grid& grid, int time_step_num, int output_stride,
-                      vector<vector<vector<vector<double>>>>& Ts) override;
+                      vector<Field3D>& Ts) override;
+
+    // Linear system of the last step (nullptr before the first step)
+    [[nodiscard]] const ImplicitSystem* linear_system() const { return system.get(); }
 
+private:
+    LinearSolverSettings settings;
+    unique_ptr<ImplicitSystem> system;   // Built on the first step, reused by all the others
 };
 
 #endif //PROJECT_02_FVM_CRANKNICOLSONSCHEME_HPP
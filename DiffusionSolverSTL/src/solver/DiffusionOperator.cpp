@@ -0,0 +1,47 @@
+#include "DiffusionOperator.hpp"
+#include <stdexcept>
+
+DiffusionOperator::DiffusionOperator(const Grid& grid, int dimension, double theta)
+    : dim(dimension) {
+
+    if (dimension != 2 && dimension != 3) {
+        throw invalid_argument("DiffusionOperator: dimension must be either 2 or 3.");
+    }
+
+    const int N = grid.N;
+    const int nz = (dimension == 3) ? N : 1;
+
+    // Pack the storage coefficients of the interior cells (co2D / co3D use the same indexing)
+    co.resize(static_cast<size_t>(N) * N * nz);
+    for (int k = 0; k < nz; ++k) {
+        for (int j = 0; j < N; ++j) {
+            for (int i = 0; i < N; ++i) {
+                co[(static_cast<size_t>(k) * N + j) * N + i] =
+                        (dimension == 2) ? grid.co2D(i, j) : grid.co3D(i, j, k);
+            }
+        }
+    }
+
+    // Face coefficients are used in place, shifted so that interior cell 0 is grid index 1
+    S.nx = N;
+    S.ny = N;
+    S.nz = nz;
+    S.ce = grid.ce.data() + 1;
+    S.cw = grid.cw.data() + 1;
+    S.cn = grid.cn.data() + 1;
+    S.cs = grid.cs.data() + 1;
+    S.cf = (dimension == 3) ? grid.cf.data() + 1 : nullptr;
+    S.cb = (dimension == 3) ? grid.cb.data() + 1 : nullptr;
+    S.co = co.data();
+    S.theta = theta;
+
+    if (linear_operator_stencil(&linear_op, &S) != 0) {
+        throw runtime_error("DiffusionOperator: invalid stencil.");
+    }
+}
+
+void DiffusionOperator::assemble(CRSMatrix& A) const {
+    if (stencil_to_crs(&S, &A) != 0) {
+        throw runtime_error("DiffusionOperator: CRS assembly failed.");
+    }
+}
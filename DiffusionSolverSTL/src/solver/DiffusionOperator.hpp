@@ -0,0 +1,61 @@
+/*
+ * File: DiffusionOperator.hpp
+ * ---------------------------
+ * This file defines the 'DiffusionOperator' class, which builds the matrix-free finite-volume
+ * operator of the implicit diffusion schemes directly from the Grid coefficients.
+ *
+ * The operator acts on the interior cells 1..N of the grid (N^2 unknowns in 2D, N^3 in 3D):
+ *
+ *   (co + theta * (ce + cw + cn + cs [+ cf + cb])) * T_P - theta * sum(c_nb * T_nb)
+ *
+ * theta = 1 is the implicit Euler matrix and theta = 0.5 the Crank-Nicolson matrix. Only the
+ * storage coefficients co2D/co3D are packed (once) into a contiguous array; the face
+ * coefficients are read in place from the Grid. Nothing of size n x n is ever stored, so the
+ * PCG solver can handle the million-cell grids through 'pcg_solver_op'.
+ *
+ * When a stored matrix is required (e.g. for incomplete Cholesky), 'assemble' builds the CRS
+ * matrix straight from the same coefficients.
+ *
+ * The Grid must outlive the operator and 'Grid::initialize_coefficients' must have been called.
+ */
+
+#ifndef PROJECT_02_FVM_DIFFUSIONOPERATOR_HPP
+#define PROJECT_02_FVM_DIFFUSIONOPERATOR_HPP
+
+#include <vector>
+#include "simulation_parameters/Grid.hpp"
+#include "matrix_operations/stencil_operator.h"
+
+using namespace std;
+
+class DiffusionOperator {
+public:
+    // Build the operator of a 2D (dimension = 2) or 3D (dimension = 3) grid
+    DiffusionOperator(const Grid& grid, int dimension, double theta);
+
+    // The operator holds pointers to its own members, so it is neither copied nor moved
+    DiffusionOperator(const DiffusionOperator&) = delete;
+    DiffusionOperator& operator=(const DiffusionOperator&) = delete;
+
+    // Operator handle for the Krylov solvers
+    [[nodiscard]] const LinearOperator* op() const { return &linear_op; }
+
+    // Stencil description (face and storage coefficients of the interior cells)
+    [[nodiscard]] const StencilOperator& stencil() const { return S; }
+
+    // Assemble the same operator into CRS format (O(nnz), no dense buffer), free with free_crs_matrix
+    void assemble(CRSMatrix& A) const;
+
+    // Number of unknowns (interior cells)
+    [[nodiscard]] size_t size() const { return linear_op.n; }
+
+    [[nodiscard]] int dimension() const { return dim; }
+
+private:
+    int dim;
+    vector<double> co;          // Storage coefficients of the interior cells, x-fastest
+    StencilOperator S{};
+    LinearOperator linear_op{};
+};
+
+#endif //PROJECT_02_FVM_DIFFUSIONOPERATOR_HPP
@@ -21,38 +21,52 @@
  * Function: step (2D)
  * -------------------
  * This function implements the explicit time-stepping scheme for 2D cases.
- * It advanced the temperature field 'T' by one time step based on the previous
- * temperature field 'To'. The new values are calculated using an explicit Euler method
- * for solving the heat equation.
+ * It computes the new time level 'T.current()' from the previous level 'T.old()'.
+ * The new values are calculated using an explicit Euler method for solving the heat equation.
  *
  * Parameters:
- * - T: The current temperature field (2D vector).
- * - To: The temperature field at the previous time step (2D vector).
+ * - T: The time levels of the temperature field (2D fields).
  * - grid: The Grid object containing spatial discretization information.
  * - time_step_num: The current time step number.
  * - output_stride: Determines how often simulation results are written to the output.
- * - Ts: A 3D vector that stores temperature snapshots fot output.
+ * - Ts: A vector of 2D fields that stores temperature snapshots fot output.
  */
-void ExplicitScheme::step(vector<vector<double>> &T, vector<vector<double>> &To, Grid &grid, int time_step_num,
-                          int output_stride, vector<vector<vector<double>>> &Ts) {
+void ExplicitScheme::step(TimeLevels2D &T, Grid &grid, int time_step_num,
+                          int output_stride, vector<Field2D> &Ts) {
 
-    for (size_t j = 0; j < grid.N + 1; ++j) {
-        for (size_t i = 0; i < grid.N + 1; ++i) {
+    const int N = grid.N;
+    const Field2D& To = T.old();
+    Field2D& Tn = T.current();
+    // Face coefficients shifted so that interior cell i is grid index i + 1
+    const double* ce = grid.ce.data() + 1;
+    const double* cw = grid.cw.data() + 1;
+
+    // Interior cells 0 .. N - 1 only: the halo rows and columns -1 and N hold the boundary values
+    for (int j = 0; j < N; ++j) {
+        // Row pointers into the contiguous fields (row(j) is the aligned cell i = 0), so the inner
+        // loop is a unit-stride SIMD loop
+        const double* To_p = To.row(j);
+        const double* To_n = To.row(j + 1);
+        const double* To_s = To.row(j - 1);
+        const double* co = grid.co2D.row(j);
+        const double cn = grid.cn[j + 1];
+        const double cs = grid.cs[j + 1];
+        double* T_p = Tn.row(j);
+
+        #pragma omp simd
+        for (int i = 0; i < N; ++i) {
             // Explicit time-stepping formula (2D case)
-            T[j][i] = (grid.ce[i] * To[j][i + 1] +
-                       grid.cw[i] * To[j][i - 1] +
-                       grid.cn[i] * To[j + 1][i] +
-                       grid.cs[j] * To[j - 1][i] +
-                       grid.co2D[j][i] - grid.ce[i] - grid.cw[i] - grid.cn[j] - grid.cs[j]) * To[j][i] / grid.co2D[j][i];
+            T_p[i] = (ce[i] * To_p[i + 1] +
+                      cw[i] * To_p[i - 1] +
+                      cn * To_n[i] +
+                      cs * To_s[i] +
+                      (co[i] - ce[i] - cw[i] - cn - cs) * To_p[i]) / co[i];
         }
     }
 
-    // Call the inherited 'update' function to update the temperature field
-    update(To, T, grid.N);
-
     // Store temperature field in output if output_stride is met
     if (time_step_num % output_stride == 0) {
-        Ts.push_back(T);
+        Ts.push_back(Tn);
     }
 }
 
@@ -60,36 +74,55 @@ void ExplicitScheme::step(vector<vector<double>> &T, vector<vector<double>> &To,
  * Function: step (3D)
  * -------------------
  * This function implements the explicit time-stepping scheme for 3D cases.
- * It advanced the temperature field 'T' by one time step based on the previous
- * temperature field 'To'. The new values are calculated using an explicit Euler method
- * for solving the heat equation.
+ * It computes the new time level 'T.current()' from the previous level 'T.old()'.
+ * The new values are calculated using an explicit Euler method for solving the heat equation.
  *
  * Parameters:
- * - T: The current temperature field (3D vector).
- * - To: The temperature field at the previous time step (3D vector).
+ * - T: The time levels of the temperature field (3D fields).
  * - grid: The Grid object containing spatial discretization information.
  * - time_step_num: The current time step number.
  * - output_stride: Determines how often simulation results are written to the output.
- * - Ts: A 4D vector that stores temperature snapshots fot output.
+ * - Ts: A vector of 3D fields that stores temperature snapshots fot output.
  */
-void ExplicitScheme::step(vector<vector<vector<double>>> &T, vector<vector<vector<double>>> &To, Grid &grid,
-                          int time_step_num, int output_stride, vector<vector<vector<vector<double>>>> &Ts) {
+void ExplicitScheme::step(TimeLevels3D &T, Grid &grid,
+                          int time_step_num, int output_stride, vector<Field3D> &Ts) {
 
-    for (int k = 0; k < grid.N + 1; ++k) {
-        for (int j = 0; j < grid.N + 1; ++j) {
-            for (int i = 0; i < grid.N + 1; ++i) {
+    const int N = grid.N;
+    const Field3D& To = T.old();
+    Field3D& Tn = T.current();
+    const double* ce = grid.ce.data() + 1;
+    const double* cw = grid.cw.data() + 1;
+
+    for (int k = 0; k < N; ++k) {
+        const double cf = grid.cf[k + 1];
+        const double cb = grid.cb[k + 1];
+        for (int j = 0; j < N; ++j) {
+            const double* To_p = To.row(j, k);
+            const double* To_n = To.row(j + 1, k);
+            const double* To_s = To.row(j - 1, k);
+            const double* To_f = To.row(j, k + 1);
+            const double* To_b = To.row(j, k - 1);
+            const double* co = grid.co3D.row(j, k);
+            const double cn = grid.cn[j + 1];
+            const double cs = grid.cs[j + 1];
+            double* T_p = Tn.row(j, k);
+
+            #pragma omp simd
+            for (int i = 0; i < N; ++i) {
                 // Explicit time-stepping formula (3D case)
-                // (Dummy operation here, replace with actual formula for 3D)
-                T[k][j][i] = 1.0;
+                T_p[i] = (ce[i] * To_p[i + 1] +
+                          cw[i] * To_p[i - 1] +
+                          cn * To_n[i] +
+                          cs * To_s[i] +
+                          cf * To_f[i] +
+                          cb * To_b[i] +
+                          (co[i] - ce[i] - cw[i] - cn - cs - cf - cb) * To_p[i]) / co[i];
             }
         }
     }
 
-    // Call the inherited 'update' function to update the temperature field
-    update(To, T, grid.N);
-
     // Store temperature field in output if output_stride is met
     if (time_step_num % output_stride == 0) {
-        Ts.push_back(T);
+        Ts.push_back(Tn);
     }
 }
\ No newline at end of file
@@ -16,8 +16,8 @@
  * at the current time step. However, explicit schemes require smaller time steps to maintain simulation stability.
  *
  * The class provides two overloaded 'step' methods:
- * - One for 2D grids (a 2D vector of doubles).
- * - One for 3D grids (a 3D vector of doubles).
+ * - One for 2D grids (a contiguous Field2D).
+ * - One for 3D grids (a contiguous Field3D).
  *
  * Dependencies:
  * This class depends on the "TimeStepping" base class and the "Grid" class for handling the
@@ -48,16 +48,15 @@ public:
      * Performs a time step using the explicit method for 2D grids.
      *
      * Parameters:
-     * - T: The current temperature field (2D vector).
-     * - To: The temperature field at the previous time step (2D vector).
+     * - T: The time levels of the temperature field (2D fields).
      * - grid: The Grid object containing spatial discretization information.
      * - time_step_num: The current time step number.
      * - output_stride: Determines how often simulation results are written to the output.
-     * - Ts: A 3D vector that stores temperature snapshots fot output.
+     * - Ts: A vector of 2D fields that stores temperature snapshots fot output.
      */
-    void step(vector<vector<double>>& T, vector<vector<double>>& To,
+    void step(TimeLevels2D& T,
                       Grid& grid, int time_step_num, int output_stride,
-                      vector<vector<vector<double>>>& Ts) override;
+                      vector<Field2D>& Ts) override;
 
     /*
      * Function: step (3D)
@@ -65,16 +64,15 @@ public:
      * Performs a time step using the explicit method for 2D grids.
      *
      * Parameters:
-     * - T: The current temperature field (3D vector).
-     * - To: The temperature field at the previous time step (3D vector).
+     * - T: The time levels of the temperature field (3D fields).
      * - grid: The Grid object containing spatial discretization information.
      * - time_step_num: The current time step number.
      * - output_stride: Determines how often simulation results are written to the output.
-     * - Ts: A 4D vector that stores temperature snapshots fot output.
+     * - Ts: A vector of 3D fields that stores temperature snapshots fot output.
      */
-    void step(vector<vector<vector<double>>>& T, vector<vector<vector<double>>>& To,
+    void step(TimeLevels3D& T,
               Grid& grid, int time_step_num, int output_stride,
-              vector<vector<vector<vector<double>>>>& Ts) override;
+              vector<Field3D>& Ts) override;
 
 };
 
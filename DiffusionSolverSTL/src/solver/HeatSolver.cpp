@@ -18,15 +18,12 @@ HeatSolver::HeatSolver(SimulationParameters &params, unique_ptr<TimeStepping> ti
       convergence(params.crit, params.max_iter, "convergence_log.txt", params),
       output("output.txt"){
 
-    // Initialize 2D and 3D temperature fields size based on dimension
+    // Initialize 2D and 3D temperature fields size based on dimension: N interior cells per
+    // direction, the boundary values live in the halo (index -1 and N)
     if (params.dimension == 2) {
-        T2D.resize(params.N + 2, vector<double>(params.N + 2, params.TL));
-        Tp2D.resize(params.N + 2, vector<double>(params.N + 2, params.TL));
-        To2D.resize(params.N + 2, vector<double>(params.N + 2, params.TL));
+        T2D = TimeLevels2D(Field2D(params.N, params.N, params.TL, 1));
     } else if (params.dimension == 3) {
-        T3D.resize(params.N + 2, vector<vector<double>>(params.N + 2, vector<double>(params.N + 2, params.TL)));
-        Tp3D.resize(params.N + 2, vector<vector<double>>(params.N + 2, vector<double>(params.N + 2, params.TL)));
-        To3D.resize(params.N + 2, vector<vector<double>>(params.N + 2, vector<double>(params.N + 2, params.TL)));
+        T3D = TimeLevels3D(Field3D(params.N, params.N, params.N, params.TL, 1));
     }
 }
 
@@ -34,28 +31,20 @@ HeatSolver::HeatSolver(SimulationParameters &params, unique_ptr<TimeStepping> ti
 void HeatSolver::initialization() {
     if (params.dimension == 2) {
         // For 2D initialization
-        for (int j = 0; j < params.N + 2; ++j) {
-            for (int i = 0; i < params.N + 2; ++i) {
-                T2D[j][i] = params.TL;  // Apply the low temperature (300) at all the domain
-            }
-        }
-        for (int i = 0; i < params.N + 2; ++i) {
-            T2D[params.N + 1][i] = params.TH;  // Apply the high temperature at the top boundary
+        Field2D T0(params.N, params.N, params.TL, 1);  // Apply the low temperature (300) at all the domain
+        for (int i = -1; i < params.N + 1; ++i) {
+            T0(i, params.N) = params.TH;  // Apply the high temperature at the top boundary (halo row j = N)
         }
+        T2D = TimeLevels2D(T0);  // Every time level starts from the same state (boundaries included)
     } else if (params.dimension == 3) {
         // For 3D initialization
-        for (int k = 0; k < params.N + 2; ++k) {
-            for (int j = 0; j < params.N + 2; ++j) {
-                for (int i = 0; i < params.N + 2; ++i) {
-                    T3D[k][j][i] = params.TL;  // Apply the low temperature (300) at all the domain
-                }
-            }
-        }
-        for (int j = 0; j < params.N + 2; ++j) {
-            for (int i = 0; i < params.N + 2; ++i) {
-                T3D[params.N + 1][j][i] = params.TH;  // Apply the high temperature at the top boundary
+        Field3D T0(params.N, params.N, params.N, params.TL, 1);  // Apply the low temperature (300) at all the domain
+        for (int j = -1; j < params.N + 1; ++j) {
+            for (int i = -1; i < params.N + 1; ++i) {
+                T0(i, j, params.N) = params.TH;  // Apply the high temperature at the top boundary (halo plane k = N)
             }
         }
+        T3D = TimeLevels3D(T0);  // Every time level starts from the same state (boundaries included)
     }
 }
 
@@ -72,14 +61,14 @@ void HeatSolver::run_simulation() {
 
 void HeatSolver::run_2d_simulation() {
     for (int n = 0; n < params.NO; ++n) {
-        timeStepping->step(T2D, To2D, grid, n, params.ST, Ts2D);
+        timeStepping->step(T2D, grid, n, params.ST, Ts2D);
 
-        if (convergence.check_convergence_2d(T2D)) {
+        if (convergence.check_convergence_2d(T2D.current(), T2D.old())) {
             cout << "Converged at time step " << n << endl;
             break;
         }
 
-        TimeStepping::update(To2D, T2D, params.N);
+        T2D.rotate();  // T^(n+1) becomes the old level, no data is copied
     }
 
     output.write_header({"Time ", "Temperature "});
@@ -87,14 +76,14 @@ void HeatSolver::run_2d_simulation() {
 
 void HeatSolver::run_3d_simulation() {
     for (int n = 0; n < params.NO; ++n) {
-        timeStepping->step(T3D, To3D, grid, n, params.ST, Ts3D);
+        timeStepping->step(T3D, grid, n, params.ST, Ts3D);
 
-        if (convergence.check_convergence_3d(T3D)) {
+        if (convergence.check_convergence_3d(T3D.current(), T3D.old())) {
             cout << "Converged at time step " << n << endl;
             break;
         }
 
-        TimeStepping::update(To3D, T3D, params.N);
+        T3D.rotate();  // T^(n+1) becomes the old level, no data is copied
     }
 
     output.write_header({"Time ", "Temperature "});
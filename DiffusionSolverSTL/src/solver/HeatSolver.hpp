@@ -9,9 +9,11 @@
 #include <memory>
 #include "simulation_parameters/Grid.hpp"
 #include "TimeStepping.hpp"
+#include "TimeLevels.hpp"
 #include "simulation_parameters/SimulationParameters.hpp"
 #include "convergence/Convergence.hpp"
 #include "IO/Output.hpp"
+#include "field/Field.hpp"
 
 using namespace std;
 
@@ -29,10 +31,10 @@ private:
     Output output;
 
     // Data structures for 2D and 3D temperature fields
-    vector<vector<double>> T2D, Tp2D, To2D;
-    vector<vector<vector<double>>> T3D, Tp3D, To3D;
-    vector<vector<vector<double>>> Ts2D;
-    vector<vector<vector<vector<double>>>> Ts3D;
+    TimeLevels2D T2D;   // Time levels T^(n+1), T^n, T^(n-1) rotated in place (2D)
+    TimeLevels3D T3D;   // Time levels T^(n+1), T^n, T^(n-1) rotated in place (3D)
+    vector<Field2D> Ts2D;
+    vector<Field3D> Ts3D;
 
     // Initialize temperature fields based on dimensionality
     void initialization();
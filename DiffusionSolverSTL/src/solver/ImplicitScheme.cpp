@@ -1,22 +1,67 @@
 //
 // Created by QCZ on 9/29/2024.
 //
+/*
+ * File: ImplicitScheme.cpp
+ * ------------------------
+ * This file contains the implementation of the implicit Euler time-stepping scheme
+ * (theta = 1.0). The linear system is set up on the first step, once the grid coefficients
+ * are initialized, and reused by every following step of the same grid.
+ */
 
 #include "ImplicitScheme.hpp"
 #include <vector>
-#include "utils/PCG_solver.h"
 
-void ImplicitScheme::step(vector<vector<double>> &T, vector<vector<double>> &To, Grid &grid, int time_step_num,
-                          int output_stride, vector<vector<vector<double>>> &Ts) {
+/*
+ * Function: step (2D)
+ * -------------------
+ * Computes the new time level 'T.current()' from 'T.old()' with one linear solve.
+ *
+ * Parameters:
+ * - T: The time levels of the temperature field (2D fields).
+ * - grid: The Grid object containing spatial discretization information.
+ * - time_step_num: The current time step number.
+ * - output_stride: Determines how often simulation results are written to the output.
+ * - Ts: A vector of 2D fields that stores temperature snapshots fot output.
+ */
+void ImplicitScheme::step(TimeLevels2D &T, Grid &grid, int time_step_num,
+                          int output_stride, vector<Field2D> &Ts) {
 
-    // TODO: adding code for Implicit Scheme
+    if (!system || !system->matches(grid, 2)) {
+        system.reset();
+        system = make_unique<ImplicitSystem>(grid, 2, 1.0, settings);
+    }
+    system->step(T.old(), T.current());
 
+    // Store temperature field in output if output_stride is met
+    if (time_step_num % output_stride == 0) {
+        Ts.push_back(T.current());
+    }
+}
 
+/*
+ * Function: step (3D)
+ * -------------------
+ * Computes the new time level 'T.current()' from 'T.old()' with one linear solve.
+ *
+ * Parameters:
+ * - T: The time levels of the temperature field (3D fields).
+ * - grid: The Grid object containing spatial discretization information.
+ * - time_step_num: The current time step number.
+ * - output_stride: Determines how often simulation results are written to the output.
+ * - Ts: A vector of 3D fields that stores temperature snapshots fot output.
+ */
+void ImplicitScheme::step(TimeLevels3D &T, Grid &grid, int time_step_num,
+                          int output_stride, vector<Field3D> &Ts) {
 
-    // Call the inherited 'update' function to update the temperature field
-    update(To, T, grid.N);
+    if (!system || !system->matches(grid, 3)) {
+        system.reset();
+        system = make_unique<ImplicitSystem>(grid, 3, 1.0, settings);
+    }
+    system->step(T.old(), T.current());
 
+    // Store temperature field in output if output_stride is met
     if (time_step_num % output_stride == 0) {
-        Ts.push_back(T);
+        Ts.push_back(T.current());
     }
-}
\ No newline at end of file
+}
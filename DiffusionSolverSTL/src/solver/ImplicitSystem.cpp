@@ -0,0 +1,327 @@
+/*
+ * File: ImplicitSystem.cpp
+ * ------------------------
+ * This file contains the implementation of the 'ImplicitSystem' class: the one-time setup of
+ * the solver selected by 'Linear_solver_type' / 'Preconditioner_type', and the per-step
+ * right-hand side, solve and write-back of the theta schemes.
+ *
+ * Solver setup (once):
+ *  - "PCG": matrix-free stencil operator, preconditioner handle of the stencil (Jacobi,
+ *    incomplete Cholesky and AMG on the matrix assembled once by the handle, multigrid,
+ *    Chebyshev polynomial).
+ *  - "PipelinedPCG", "BiCGSTAB", "GMRES", "GMRES(m)": CRS matrix assembled once, preconditioner
+ *    handle of that matrix (PipelinedPCG: None, Jacobi or incomplete Cholesky only, checked here).
+ *  - "Multigrid" / "MultigridW": geometric multigrid hierarchy of the stencil.
+ *  - "AMG": CRS matrix and smoothed-aggregation hierarchy.
+ *  - "Gauss-Seidel", "SOR" (factor 'relaxation_factor') and "SOR(w)": red-black sweeps on the
+ *    matrix-free stencil, nothing to set up.
+ * The assembled CRS matrix also gets a SELL-C-sigma copy, so its products run on the SIMD
+ * SELL kernel (without the copy, e.g. if the allocation fails, the CRS kernel is used).
+ *
+ * With an 'ordering' other than "Natural" ("RCM", "Morton", "Hilbert", see reordering.h), the
+ * assembled matrix is replaced by B = P * A * P^T once, and the preconditioner (e.g. the
+ * incomplete Cholesky factor, whose fill-in and triangular-solve levels depend on the order)
+ * is built on B. Every solve permutes b and the initial guess, solves with B and un-permutes
+ * the solution. Only the methods with an assembled matrix accept an ordering.
+ *
+ * With 'sync_free_trisolve' the triangular solves of incomplete Cholesky use the sync-free
+ * schedule (atomic dependency counters) instead of the level schedule.
+ *
+ * With 'mixed_precision' the IC factor / multigrid hierarchy is stored in single precision;
+ * PCG then runs inside an iterative refinement (pcg_solver_refinement) and standalone
+ * multigrid corrects a double residual, so both still reach 'tol'. The AMG hierarchy has no
+ * single-precision version, so AMG (solver or preconditioner) with 'mixed_precision' is rejected.
+ */
+
+#include "ImplicitSystem.hpp"
+#include <stdexcept>
+#include "utils/PCG_solver.h"
+#include "utils/linear_solver.h"
+#include "utils/SOR_solver.h"
+#include "utils/pipelined_PCG_solver.h"
+#include "matrix_operations/SELLMatrix.h"
+#include "matrix_operations/reordering.h"
+
+ImplicitSystem::ImplicitSystem(const Grid& grid, int dimension, double theta, const LinearSolverSettings& settings)
+    : grid(&grid), theta(theta), settings(settings), op(grid, dimension, theta),
+      b(op.size(), 0.0), x(op.size(), 0.0) {
+
+    const string& type = settings.solver_type;
+    const char* preconditioner = settings.preconditioner_type.c_str();
+    int status;
+
+    CRSOrdering ordering;
+    if (crs_ordering_parse(settings.ordering.c_str(), &ordering) != 0) {
+        throw invalid_argument("ImplicitSystem: unsupported matrix ordering '" + settings.ordering + "'.");
+    }
+    const bool assembled = (type == "PipelinedPCG" || type == "BiCGSTAB" || type.rfind("GMRES", 0) == 0 ||
+                            type == "AMG");
+    if (ordering != CRS_ORDERING_NATURAL && !assembled) {
+        throw invalid_argument("ImplicitSystem: matrix ordering '" + settings.ordering + "' needs a linear solver "
+                               "with an assembled matrix (PipelinedPCG, BiCGSTAB, GMRES or AMG).");
+    }
+    const bool preconditioned = (type == "PCG" || (assembled && type != "AMG"));
+    if (settings.mixed_precision && (type == "AMG" || (preconditioned && settings.preconditioner_type == "AMG"))) {
+        throw invalid_argument("ImplicitSystem: single-precision preconditioning is not supported by AMG "
+                               "(its hierarchy is stored in double); use Preconditioner_precision = double.");
+    }
+
+    if (type == "PCG") {
+        method = Method::PCG;
+        status = preconditioner_stencil(&M, &op.stencil(), preconditioner);
+        if (status == 0 && settings.sync_free_trisolve) {
+            status = preconditioner_set_trisolve(&M, TRISOLVE_SYNC_FREE);
+        }
+        if (status == 0 && settings.mixed_precision) {
+            status = preconditioner_set_precision(&M, PRECONDITIONER_SINGLE);
+        }
+    } else if (type == "PipelinedPCG" || type == "BiCGSTAB" || type.rfind("GMRES", 0) == 0) {
+        method = Method::KrylovCRS;
+        status = assemble();
+        if (status == 0) {
+            status = preconditioner_crs(&M, matrix, preconditioner);
+        }
+        if (status == 0 && settings.sync_free_trisolve) {
+            status = preconditioner_set_trisolve(&M, TRISOLVE_SYNC_FREE);
+        }
+        if (status == 0 && settings.mixed_precision) {
+            status = preconditioner_set_precision(&M, PRECONDITIONER_SINGLE);
+        }
+        if (status == 0 && type == "PipelinedPCG" && !pipelined_pcg_supports(&M)) {
+            release();
+            throw invalid_argument("ImplicitSystem: preconditioner '" + settings.preconditioner_type +
+                                   "' is not supported by PipelinedPCG (None, Jacobi or incomplete Cholesky).");
+        }
+    } else if (type == "Multigrid" || type == "MultigridW") {
+        method = Method::Multigrid;
+        status = multigrid_setup(&op.stencil(), (type == "MultigridW") ? MULTIGRID_W_CYCLE : MULTIGRID_V_CYCLE, &mg);
+        if (status == 0 && settings.mixed_precision) {
+            status = multigrid_use_single(&mg);
+        }
+    } else if (type == "AMG") {
+        method = Method::AMG;
+        status = assemble();
+        if (status == 0) {
+            status = amg_setup(matrix, &amg);
+        }
+    } else if (type == "SOR" || sor_parse_type(type.c_str(), &omega)) {
+        method = Method::SOR;
+        if (type == "SOR") {
+            omega = settings.relaxation_factor;
+        }
+        status = (omega > 0.0 && omega < 2.0) ? 0 : -1;
+    } else {
+        throw invalid_argument("ImplicitSystem: unsupported linear solver type '" + type + "'.");
+    }
+
+    if (status != 0) {
+        release();
+        throw runtime_error("ImplicitSystem: setup of the linear solver '" + type + "' with the preconditioner '" +
+                            settings.preconditioner_type + "' failed.");
+    }
+}
+
+ImplicitSystem::~ImplicitSystem() {
+    release();
+}
+
+void ImplicitSystem::release() {
+    preconditioner_free(&M);
+    multigrid_free(&mg);
+    amg_free(&amg);
+    free_crs_matrix(&A);
+    crs_reordering_free(&reorder);
+    workspace_free(&ws);
+}
+
+// Assembles the operator once; with a matrix ordering, the solver gets P * A * P^T instead
+int ImplicitSystem::assemble() {
+    op.assemble(A);
+    CRSOrdering ordering;
+    crs_ordering_parse(settings.ordering.c_str(), &ordering);
+    if (ordering != CRS_ORDERING_NATURAL) {
+        const int N = grid->N;
+        if (crs_reordering_setup(&A, ordering, N, N, op.dimension() == 3 ? N : 1, &reorder) != 0) {
+            return -1;
+        }
+        free_crs_matrix(&A);
+        matrix = &reorder.B;
+    }
+    crs_narrow_index(matrix);   // The system matrix is owned here: keep only the 32-bit indices
+    crs_attach_sell(matrix, SELL_DEFAULT_SIGMA);
+    return 0;
+}
+
+// Solves A * x = b with the method prepared by the constructor, x holding the initial guess
+void ImplicitSystem::solve() {
+    int status = -1;
+
+    // Reordered system: solve B * (P * x) = P * b
+    const bool reordered = (reorder.perm != nullptr);
+    const double* rhs = b.data();
+    double* sol = x.data();
+    if (reordered) {
+        crs_reordering_permute(&reorder, b.data(), x.data());
+        rhs = reorder.b;
+        sol = reorder.x;
+    }
+
+    switch (method) {
+        case Method::PCG:
+            status = settings.mixed_precision
+                     ? pcg_solver_refinement(op.op(), b.data(), x.data(), settings.max_iter, settings.tol, &M, &ws)
+                     : pcg_solver_precond(op.op(), b.data(), x.data(), settings.max_iter, settings.tol, &M, &ws);
+            break;
+        case Method::KrylovCRS:
+            status = linear_solver_crs_precond(matrix, rhs, sol, settings.max_iter, settings.tol,
+                                               settings.solver_type.c_str(), &M, &ws);
+            break;
+        case Method::Multigrid:
+            status = multigrid_solve(&mg, b.data(), x.data(), settings.max_iter, settings.tol);
+            break;
+        case Method::AMG:
+            status = amg_solve(&amg, rhs, sol, settings.max_iter, settings.tol);
+            break;
+        case Method::SOR:
+            status = sor_solver_stencil(&op.stencil(), b.data(), x.data(), settings.max_iter, settings.tol, omega);
+            break;
+    }
+
+    if (reordered) {
+        crs_reordering_unpermute(&reorder, x.data());
+    }
+
+    // Non-convergence (status 1) is reported by the solver; the last iterate is kept
+    if (status < 0) {
+        throw runtime_error("ImplicitSystem: linear solver '" + settings.solver_type + "' failed.");
+    }
+}
+
+/*
+ * Function: step (2D)
+ * -------------------
+ * Computes the interior cells of Tn = T^(n+1) from To = T^n:
+ *
+ *   b_P = co * T_P + (1 - theta) * sum(c_nb * (T_nb - T_P)) + theta * sum_boundary(c_nb * T_nb)
+ *
+ * The boundary neighbours are known values, so their implicit share moves to the right-hand
+ * side. The same sweep copies T^n into x, the initial guess of the solver.
+ */
+void ImplicitSystem::step(const Field2D& To, Field2D& Tn) {
+    const int N = grid->N;
+    const double w = 1.0 - theta;   // Weight of the explicit part
+    const double* ce = grid->ce.data() + 1;   // Shifted so that interior cell i is grid index i + 1
+    const double* cw = grid->cw.data() + 1;
+
+    for (int j = 0; j < N; ++j) {
+        const double* To_p = To.row(j);
+        const double* To_n = To.row(j + 1);
+        const double* To_s = To.row(j - 1);
+        const double* co = grid->co2D.row(j);
+        const double cn = grid->cn[j + 1];
+        const double cs = grid->cs[j + 1];
+        double* b_p = b.data() + static_cast<size_t>(j) * N;   // Row j of b and x
+        double* x_p = x.data() + static_cast<size_t>(j) * N;
+
+        #pragma omp simd
+        for (int i = 0; i < N; ++i) {
+            b_p[i] = co[i] * To_p[i] + w * (ce[i] * (To_p[i + 1] - To_p[i]) +
+                                            cw[i] * (To_p[i - 1] - To_p[i]) +
+                                            cn * (To_n[i] - To_p[i]) +
+                                            cs * (To_s[i] - To_p[i]));
+            x_p[i] = To_p[i];
+        }
+
+        b_p[0] += theta * cw[0] * To_p[-1];
+        b_p[N - 1] += theta * ce[N - 1] * To_p[N];
+        if (j == 0 || j == N - 1) {
+            const double* To_b = (j == 0) ? To_s : To_n;
+            const double c_b = (j == 0) ? cs : cn;
+            for (int i = 0; i < N; ++i) {
+                b_p[i] += theta * c_b * To_b[i];
+            }
+        }
+    }
+
+    solve();
+
+    for (int j = 0; j < N; ++j) {
+        const double* x_p = x.data() + static_cast<size_t>(j) * N;
+        double* T_p = Tn.row(j);
+        #pragma omp simd
+        for (int i = 0; i < N; ++i) {
+            T_p[i] = x_p[i];
+        }
+    }
+}
+
+/*
+ * Function: step (3D)
+ * -------------------
+ * Same as the 2D version with the front / back neighbours.
+ */
+void ImplicitSystem::step(const Field3D& To, Field3D& Tn) {
+    const int N = grid->N;
+    const double w = 1.0 - theta;
+    const double* ce = grid->ce.data() + 1;
+    const double* cw = grid->cw.data() + 1;
+
+    for (int k = 0; k < N; ++k) {
+        const double cf = grid->cf[k + 1];
+        const double cb = grid->cb[k + 1];
+        for (int j = 0; j < N; ++j) {
+            const double* To_p = To.row(j, k);
+            const double* To_n = To.row(j + 1, k);
+            const double* To_s = To.row(j - 1, k);
+            const double* To_f = To.row(j, k + 1);
+            const double* To_b = To.row(j, k - 1);
+            const double* co = grid->co3D.row(j, k);
+            const double cn = grid->cn[j + 1];
+            const double cs = grid->cs[j + 1];
+            const size_t offset = (static_cast<size_t>(k) * N + j) * N;
+            double* b_p = b.data() + offset;
+            double* x_p = x.data() + offset;
+
+            #pragma omp simd
+            for (int i = 0; i < N; ++i) {
+                b_p[i] = co[i] * To_p[i] + w * (ce[i] * (To_p[i + 1] - To_p[i]) +
+                                                cw[i] * (To_p[i - 1] - To_p[i]) +
+                                                cn * (To_n[i] - To_p[i]) +
+                                                cs * (To_s[i] - To_p[i]) +
+                                                cf * (To_f[i] - To_p[i]) +
+                                                cb * (To_b[i] - To_p[i]));
+                x_p[i] = To_p[i];
+            }
+
+            b_p[0] += theta * cw[0] * To_p[-1];
+            b_p[N - 1] += theta * ce[N - 1] * To_p[N];
+            if (j == 0 || j == N - 1) {
+                const double* To_y = (j == 0) ? To_s : To_n;
+                const double c_y = (j == 0) ? cs : cn;
+                for (int i = 0; i < N; ++i) {
+                    b_p[i] += theta * c_y * To_y[i];
+                }
+            }
+            if (k == 0 || k == N - 1) {
+                const double* To_z = (k == 0) ? To_b : To_f;
+                const double c_z = (k == 0) ? cb : cf;
+                for (int i = 0; i < N; ++i) {
+                    b_p[i] += theta * c_z * To_z[i];
+                }
+            }
+        }
+    }
+
+    solve();
+
+    for (int k = 0; k < N; ++k) {
+        for (int j = 0; j < N; ++j) {
+            const double* x_p = x.data() + (static_cast<size_t>(k) * N + j) * N;
+            double* T_p = Tn.row(j, k);
+            #pragma omp simd
+            for (int i = 0; i < N; ++i) {
+                T_p[i] = x_p[i];
+            }
+        }
+    }
+}
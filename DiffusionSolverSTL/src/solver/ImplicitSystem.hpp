@@ -0,0 +1,103 @@
+/*
+ * File: ImplicitSystem.hpp
+ * ------------------------
+ * This file defines the 'ImplicitSystem' class, which holds everything the theta schemes
+ * (implicit Euler, theta = 1, and Crank-Nicolson, theta = 0.5) need to solve
+ *
+ *   (co + theta * K) * T^(n+1) = (co - (1 - theta) * K) * T^n + boundary terms
+ *
+ * on every time step, where K is the finite-volume diffusion operator (see DiffusionOperator).
+ *
+ * With a constant time step the matrix never changes, so the operator is built, assembled
+ * (only for the solvers that need a stored matrix) and preconditioned ONCE, when the system is
+ * created. A time step then only
+ *  - builds the right-hand side from T^n and, in the same sweep, copies T^n into the initial
+ *    guess (warm start: T^(n+1) differs from T^n by one time step only),
+ *  - runs the selected solver with the prebuilt preconditioner / hierarchy and the work vectors
+ *    kept from the previous step (no allocation after the first step),
+ *  - writes the solution into the interior cells of T^(n+1).
+ *
+ * The Grid must outlive the system, and its coefficients (including dt) must not change while
+ * the system is in use.
+ */
+
+#ifndef PROJECT_02_FVM_IMPLICITSYSTEM_HPP
+#define PROJECT_02_FVM_IMPLICITSYSTEM_HPP
+
+#include <string>
+#include <vector>
+#include "DiffusionOperator.hpp"
+#include "field/Field.hpp"
+#include "simulation_parameters/Grid.hpp"
+#include "utils/preconditioner.h"
+#include "utils/multigrid.h"
+#include "utils/amg.h"
+#include "utils/solver_workspace.h"
+#include "matrix_operations/reordering.h"
+
+using namespace std;
+
+/*
+ * Struct: LinearSolverSettings
+ * ----------------------------
+ * The 'Linear System Settings' of config.txt.
+ */
+struct LinearSolverSettings {
+    string solver_type = "PCG";                         // Linear_solver_type
+    string preconditioner_type = "IncompleteCholesky";  // Preconditioner_type
+    int max_iter = 1000;                                // Max_iterations
+    double tol = 1e-6;                                  // Solver_tolerance
+    bool mixed_precision = false;                       // Preconditioner_precision "single"
+    double relaxation_factor = 1.0;                     // Relaxation_factor (linear solver "SOR")
+    bool sync_free_trisolve = false;                    // Triangular_solve "SyncFree"
+    string ordering = "Natural";                        // Matrix_ordering (assembled CRS matrix only)
+};
+
+class ImplicitSystem {
+public:
+    // Builds the operator of the grid and sets up the solver 'settings' once
+    ImplicitSystem(const Grid& grid, int dimension, double theta, const LinearSolverSettings& settings);
+    ~ImplicitSystem();
+
+    // The system holds pointers to its own members, so it is neither copied nor moved
+    ImplicitSystem(const ImplicitSystem&) = delete;
+    ImplicitSystem& operator=(const ImplicitSystem&) = delete;
+
+    // Computes the interior cells of Tn (T^(n+1)) from To (T^n)
+    void step(const Field2D& To, Field2D& Tn);
+    void step(const Field3D& To, Field3D& Tn);
+
+    // True if the system was built for this grid and dimension
+    [[nodiscard]] bool matches(const Grid& other, int dimension) const {
+        return &other == grid && dimension == op.dimension();
+    }
+
+    // Preconditioner handle of the PCG and CRS Krylov methods (empty for the other methods)
+    [[nodiscard]] const Preconditioner& preconditioner() const { return M; }
+
+private:
+    // Solution method, resolved from the settings once
+    enum class Method { PCG, KrylovCRS, Multigrid, AMG, SOR };
+
+    void solve();
+    void release();
+    int assemble();
+
+    const Grid* grid;
+    double theta;
+    LinearSolverSettings settings;
+    Method method = Method::PCG;
+    double omega = 1.0;           // Relaxation factor (SOR only)
+    DiffusionOperator op;
+    CRSMatrix A{};                // Assembled operator (CRS Krylov methods and AMG only)
+    CRSReordering reorder{};      // P * A * P^T and the permuted vectors (Matrix_ordering other than "Natural")
+    CRSMatrix* matrix = &A;       // Matrix the solver runs on (A, or reorder.B)
+    Preconditioner M{};           // Built once (PCG and CRS Krylov methods)
+    Multigrid mg{};               // Standalone geometric multigrid hierarchy
+    AMG amg{};                    // Standalone algebraic multigrid hierarchy
+    SolverWorkspace ws{};         // Work vectors of the Krylov methods, allocated by the first solve
+    vector<double> b;             // Right-hand side
+    vector<double> x;             // Solution / initial guess (interior cells, x-fastest)
+};
+
+#endif //PROJECT_02_FVM_IMPLICITSYSTEM_HPP
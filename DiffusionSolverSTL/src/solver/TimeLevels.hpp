@@ -0,0 +1,74 @@
+/*
+ * File: TimeLevels.hpp
+ * --------------------
+ * This file defines the 'TimeLevels' class template, which owns the temperature fields of
+ * consecutive time levels and advances them WITHOUT copying any field data.
+ *
+ * The fields are allocated once. A small array of slot indices maps the logical levels
+ * (n + 1, n, n - 1, ...) onto the physical buffers, and 'rotate' only permutes these indices:
+ *
+ *     before rotate:  current = T^(n+1)   old = T^n       older = T^(n-1)
+ *     after  rotate:  current = (free)    old = T^(n+1)   older = T^n
+ *
+ * The buffer released by the oldest level is reused as the next 'current' level, so one time
+ * step costs no copy traffic regardless of the grid size. Three levels are kept by default,
+ * which is enough for two-step (multistep) schemes such as BDF2.
+ *
+ * Boundary values are never written by the schemes (only interior cells are updated), so
+ * they stay valid in every buffer as long as all levels start from the same initial field.
+ */
+
+#ifndef PROJECT_02_FVM_TIMELEVELS_HPP
+#define PROJECT_02_FVM_TIMELEVELS_HPP
+
+#include <array>
+#include <algorithm>
+#include "field/Field.hpp"
+
+template <typename FieldT, int Levels = 3>
+class TimeLevels {
+    static_assert(Levels >= 2, "TimeLevels needs at least the new and the old time level.");
+
+public:
+    TimeLevels() = default;
+
+    // Initialize every time level with a copy of 'initial' (boundary values included)
+    explicit TimeLevels(const FieldT& initial) {
+        for (int l = 0; l < Levels; ++l) {
+            fields[l] = initial;
+            slot[l] = l;
+        }
+    }
+
+    // T^(n+1): the level being computed by the current time step
+    FieldT& current() { return fields[slot[0]]; }
+    const FieldT& current() const { return fields[slot[0]]; }
+
+    // T^n: the latest completed time level
+    FieldT& old() { return fields[slot[1]]; }
+    const FieldT& old() const { return fields[slot[1]]; }
+
+    // T^(n-1): the level before 'old' (only available with three or more levels)
+    FieldT& older() requires (Levels >= 3) { return fields[slot[2]]; }
+    const FieldT& older() const requires (Levels >= 3) { return fields[slot[2]]; }
+
+    // Generic access: level(0) = current, level(1) = old, level(2) = older, ...
+    FieldT& level(int l) { return fields[slot[l]]; }
+    const FieldT& level(int l) const { return fields[slot[l]]; }
+
+    // Advance to the next time step by rotating the buffer handles (no data is copied)
+    void rotate() {
+        std::rotate(slot.rbegin(), slot.rbegin() + 1, slot.rend());
+    }
+
+    [[nodiscard]] static constexpr int size() { return Levels; }
+
+private:
+    std::array<FieldT, Levels> fields;   // Physical buffers, allocated once
+    std::array<int, Levels> slot{};      // slot[l] = buffer holding logical level l
+};
+
+using TimeLevels2D = TimeLevels<Field2D>;
+using TimeLevels3D = TimeLevels<Field3D>;
+
+#endif //PROJECT_02_FVM_TIMELEVELS_HPP
@@ -8,8 +8,9 @@
  * for time-stepping schemes used in solving the diffusion equation. Derived classes must
  * implement the 'step' function, which is overloaded for both 2D and 3D cases.
  *
- * The 'update' function is shared by all derived classes and is responsible for updating
- * the temperature field from one time step to the next.
+ * The time levels (T^(n+1), T^n, T^(n-1)) are owned by a 'TimeLevels' object. A scheme only
+ * writes the new level 'current()' from the old ones; advancing to the next time step is done
+ * by the caller through 'TimeLevels::rotate', which swaps buffer handles instead of copying.
  */
 
 #ifndef PROJECT_02_FVM_TIMESTEPPING_HPP
@@ -17,6 +18,8 @@
 
 #include <vector>
 #include "simulation_parameters/Grid.hpp"
+#include "field/Field.hpp"
+#include "TimeLevels.hpp"
 
 using namespace std;
 
@@ -27,66 +30,39 @@ public:
     /*
      * Pure virtual function: step (2D)
      * --------------------------------
-     * Advances the temperature field 'T' to the next time step in 2D simulations.
+     * Computes the new time level 'T.current()' from 'T.old()' (and 'T.older()' for
+     * multistep schemes) in 2D simulations.
      * This function must be implemented by any derived class, which defines the
      * specific time-stepping scheme (Explicit, Implicit, CrankNicolson)
      *
      * Parameters:
-     * - T: The current temperature field (2D vector).
-     * - To: The temperature field at the previous time step (2D vector).
+     * - T: The time levels of the temperature field (2D fields).
      * - grid: The Grid object containing spatial discretization information.
      * - time_step_num: The current time step number.
      * - output_stride: Determines how often simulation results are written to the output.
-     * - Ts: A 3D vector that stores temperature snapshots fot output.
+     * - Ts: A vector of 2D fields that stores temperature snapshots fot output.
      */
-    virtual void step(vector<vector<double>>& T, vector<vector<double>>& To,
+    virtual void step(TimeLevels2D& T,
                       Grid& grid, int time_step_num, int output_stride,
-                      vector<vector<vector<double>>>& Ts) = 0;
+                      vector<Field2D>& Ts) = 0;
     /*
-     * Pure virtual function: step (2D)
+     * Pure virtual function: step (3D)
      * --------------------------------
-     * Advances the temperature field 'T' to the next time step in 2D simulations.
+     * Computes the new time level 'T.current()' from 'T.old()' (and 'T.older()' for
+     * multistep schemes) in 3D simulations.
      * This function must be implemented by any derived class, which defines the
      * specific time-stepping scheme (Explicit, Implicit, CrankNicolson)
      *
      * Parameters:
-     * - T: The current temperature field (2D vector).
-     * - To: The temperature field at the previous time step (2D vector).
+     * - T: The time levels of the temperature field (3D fields).
      * - grid: The Grid object containing spatial discretization information.
      * - time_step_num: The current time step number.
      * - output_stride: Determines how often simulation results are written to the output.
-     * - Ts: A 3D vector that stores temperature snapshots fot output.
+     * - Ts: A vector of 3D fields that stores temperature snapshots fot output.
      */
-    virtual void step(vector<vector<vector<double>>>& T, vector<vector<vector<double>>>& To,
+    virtual void step(TimeLevels3D& T,
                       Grid& grid, int time_step_num, int output_stride,
-                      vector<vector<vector<vector<double>>>>& Ts) = 0;
-
-    /*
-     * Function: update (2D)
-     * ---------------------
-     * Updates the previous temperature field 'To' with the current field 'T' for 2D simulations.
-     * This function is used to prepare for the next time step by storing the Latest results.
-     *
-     * Parameters:
-     * - To: The temperature field from the previous time step (will be updated).
-     * - T: The temperature field at the current time step.
-     * - N: The number of grid points in one dimension (excluding boundaries).
-     */
-    static void update(vector<vector<double>>& To, const vector<vector<double>>& T, int N);
-
-    /*
-     * Function: update (2D)
-     * ---------------------
-     * Updates the previous temperature field 'To' with the current field 'T' for 2D simulations.
-     * This function is used to prepare for the next time step by storing the Latest results.
-     *
-     * Parameters:
-     * - To: The temperature field from the previous time step (will be updated).
-     * - T: The temperature field at the current time step.
-     * - N: The number of grid points in one dimension (excluding boundaries).
-     */
-    static void update(vector<vector<vector<double>>>& To, const vector<vector<vector<double>>>& T, int N);
-
+                      vector<Field3D>& Ts) = 0;
 };
 
 #endif //PROJECT_02_FVM_TIMESTEPPING_HPP
\ No newline at end of file
@@ -23,8 +23,31 @@
  *
  * The code also supports different preconditioners, such as:
  *  - Jacobi
- *  - Incomplete Cholesky
+ *  - Incomplete Cholesky, IC(0) and modified MIC(0), stored sparse (CRS)
+ *  - Algebraic (AMG) and geometric multigrid, and the Chebyshev polynomial (see below)
  *  - Identity (Default, preconditioner)
+ *
+ * The preconditioner is a 'Preconditioner' handle (preconditioner.h): it is set up once and
+ * every iteration only calls its 'apply', so the same handle can serve every solve of a run
+ * (pcg_solver_precond). The work vectors come from a 'SolverWorkspace' (solver_workspace.h)
+ * that the caller can keep across solves, so repeated solves do not allocate at all.
+ * pcg_solver_refinement wraps the same iterations in an iterative refinement, for handles whose
+ * factor or hierarchy is stored in single precision. pcg_solver_record also keeps the alpha /
+ * beta coefficients of the iterations. From them, chebyshev.c estimates the spectral bounds of
+ * the Chebyshev preconditioner.
+ *
+ * The other entry points build a handle from the type name for one solve:
+ *  - pcg_solver: A is a dense n x n row-major array ("None", "Jacobi", "IncompleteCholesky").
+ *  - pcg_solver_op: A is a 'LinearOperator', so it can be a CRS matrix or the matrix-free
+ *    finite-volume stencil, which is never stored. Jacobi and the Chebyshev polynomial
+ *    ("Chebyshev", "Chebyshev(k)", see chebyshev.c) only need its diagonal.
+ *  - pcg_solver_crs: A is a CRS matrix; every preconditioner works on sparse storage. The
+ *    triangular solves of incomplete Cholesky run in parallel with a schedule analyzed once
+ *    per factor (triangular_solve.h); "AMG" is smoothed-aggregation algebraic multigrid (amg.c).
+ *  - pcg_solver_stencil: A is the finite-volume stencil of the structured grid; in addition
+ *    to the preconditioners of pcg_solver_crs, geometric multigrid ("Multigrid" V-cycle,
+ *    "MultigridW" W-cycle, see multigrid.c) keeps the iteration count flat as the mesh is
+ *    refined.
  */
 
 #include <stdio.h>
@@ -35,6 +58,9 @@
 #include "matrix_operations/linear_algebra.h"
 #include "preconditioner.h"
 
+// Residual reduction of one inner PCG solve of pcg_solver_refinement
+#define PCG_REFINEMENT_REDUCTION 1e-6
+
 int pcg_solver(const double *A, const double *b, double *x, int n, int max_iter, double tol, const char* preconditioner_type) {
 
     /*
@@ -50,104 +76,415 @@ int pcg_solver(const double *A, const double *b, double *x, int n, int max_iter,
      *  - tol: Convergence tolerance
      *  preconditioner_type: Type of preconditioner ("Jacobi", "IncompleteCholesky", or "Default")
      * Returns:
-     *  -0 if converged, 1 otherwise (max iterations reached without convergence)
+     *  -0 if converged, 1 otherwise (max iterations reached without convergence), -1 on error
      */
 
-    // Allocate memory for the vector
-    double* r = (double*) malloc(n * sizeof(double ));
-    double* z = (double*) malloc(n * sizeof(double ));
-    double* p = (double*) malloc(n * sizeof(double ));
-    double* Ap = (double*) malloc(n * sizeof(double ));
+    LinearOperator op;
+    if (!b || !x || linear_operator_dense(&op, A, n) != 0) {
+        fprintf(stderr, "Invalid input to pcg_solver.\n");
+        return -1;
+    }
+
+    // Preconditioning step (sparse IC(0) factor on the non-zero pattern of A, never dense)
+    Preconditioner M;
+    if (preconditioner_dense(&M, A, n, preconditioner_type) != 0) {
+        return -1;
+    }
+
+    int status = pcg_solver_precond(&op, b, x, max_iter, tol, &M, NULL);
+    preconditioner_free(&M);
+    return status;
+}
+
+// Workspace needed by pcg_iterate (w = A * z only for operators without a fused kernel)
+static size_t pcg_workspace_size(const LinearOperator* A, const Preconditioner* M) {
+    const int num_vectors = 3 + (M->type != PRECONDITIONER_NONE) + !A->update_direction;
+    return num_vectors * workspace_size(A->n);
+}
+
+/*
+ * Function: pcg_iterate
+ * ---------------------
+ * PCG iterations shared by all entry points. A is only accessed through the operator callbacks
+ * and the preconditioner through 'M->apply'.
+ *
+ * The vector work of one iteration is done by fused kernels (see linear_algebra.c):
+ *  - p = z + beta * p, Ap = A * p and dot(p, Ap) in one sweep ('A->update_direction', which
+ *    uses A * p_new = A * z + beta * A * p_old so the p update is folded into the SpMV);
+ *  - x += alpha * p, r -= alpha * Ap and dot(r, r) in one sweep ('cg_update_solution');
+ *  - with Jacobi, z = D^(-1) * r and dot(r, z) are added to that same sweep;
+ *  - without a preconditioner, z is r itself and dot(r, z) = dot(r, r).
+ * Operators without a fused kernel compute w = A * z with 'A->apply' and then use the vector
+ * kernel 'cg_update_direction'.
+ *
+ * 'iterations' (may be NULL) receives the number of iterations run (0 if the initial guess
+ * already converged); the caller then reports the convergence instead of this function. 'coeffs' (may be NULL) records alpha_k / beta_k.
+ *
+ * Returns:
+ *  -0 if converged, 1 otherwise (max iterations reached without convergence), -1 on error
+ */
+static int pcg_iterate(const LinearOperator* A, const double *b, double *x, int max_iter, double tol,
+                       const Preconditioner* M, SolverWorkspace* ws, int* iterations, CGCoefficients* coeffs) {
+
+    const int n = (int) A->n;
+    const int identity = (M->type == PRECONDITIONER_NONE);
+    const double* inv_diag = (M->type == PRECONDITIONER_JACOBI) ? M->inv_diag : NULL;
 
-    // Checking for Allocations
-    if (!r || !z || !p || !Ap) {
-        fprintf(stderr, "Memory allocation failed in pcg_solver.\n");
-        free(r); free(z); free(p); free(Ap);
+    // Work vectors from the workspace; a temporary workspace is used if the caller has none
+    SolverWorkspace local = SOLVER_WORKSPACE_INIT;
+    SolverWorkspace* W = ws ? ws : &local;
+    if (workspace_reserve(W, pcg_workspace_size(A, M)) != 0) {
+        fprintf(stderr, "Memory allocation failed in pcg_iterate.\n");
         return -1;
     }
+    double* r = workspace_take(W, n);
+    double* z = identity ? r : workspace_take(W, n);
+    double* p = workspace_take(W, n);
+    double* Ap = workspace_take(W, n);
+    double* w = A->update_direction ? NULL : workspace_take(W, n);
 
     // Compute initial residual: r = b - A * x
-    mat_vec_mult(A, x, r, n);  // y = A * x, return
-    vec_subtract(b, r, r, n);  // in this case, initialize the first residual as r,
-                               // using r as the intermediate variable to pass the result from vector multiply.
-
-    // Preconditioning step
-    double* L = NULL;
-    if (strcmp(preconditioner_type, "IncompleteCholesky") == 0) {
-        L = (double*) malloc(n * n * sizeof(double));
-        if (!L) {
-            fprintf(stderr, "Memory allocation for incomplete Cholesky preconditioner failed.\n");
-            free(r); free(z); free(p); free(Ap);
-            return -1;
+    A->apply(A, x, r);
+    vec_subtract(b, r, r, n);
+
+    // A warm start that already meets the tolerance is returned as is (alpha would be 0 / 0)
+    if (sqrt(dot_product(r, r, n)) < tol) {
+        if (iterations) {
+            *iterations = 0;
+        } else {
+            printf("PCG converged after 0 iterations\n");
         }
-        incomplete_cholesky(A, L, n);
+        workspace_free(&local);
+        return 0;
     }
 
     // Initial preconditioning step
-    if (strcmp(preconditioner_type, "Jacobi") == 0) {
-        jacobi_precondition(A, r, z, n);
-    } else if (strcmp(preconditioner_type, "IncompleteCholesky") == 0) {
-        ic_precondition(L, r, z, n);
-    } else {
-        precondition(A, r, z, n);  // Default to identity
-        // memcpy(z, r, n * sizeof(double));  // No preconditioner (identity)
+    if (!identity) {
+        M->apply(M, r, z);
     }
-
-    // Set initial search direction p = z
-//    for (int i = 0; i < n; ++i) {
-//        p[i] = z[i];
-//    }
-    memcpy(p, z, n * sizeof(double));
     double r_dot_z_old = dot_product(r, z, n);
+    double beta = 0.0;   // First direction: p = z
 
-    // Iterative loop
-    for (int i = 0; i < max_iter; ++i) {
+    int status = 1;
+    int iter;
+    for (iter = 0; iter < max_iter; ++iter) {
 
-        // do A * pk
-        mat_vec_mult(A, p, Ap, n);
+        // p_k = z_k + beta_k * p_k-1, Ap_k and dot(p_k, A * p_k) in one sweep
+        double p_dot_Ap;
+        if (A->update_direction) {
+            A->update_direction(A, z, beta, p, Ap, &p_dot_Ap);
+        } else {
+            A->apply(A, z, w);
+            p_dot_Ap = cg_update_direction(z, w, beta, p, Ap, n);
+        }
 
-        // alpha_k = dot(rk, rk) / dot(pk, A * pk);
-        double alpha = r_dot_z_old / dot_product(p, Ap, n);
+        // alpha_k = dot(rk, zk) / dot(pk, A * pk);
+        double alpha = r_dot_z_old / p_dot_Ap;
+        if (coeffs && iter < coeffs->capacity) {
+            coeffs->alpha[iter] = alpha;
+            coeffs->count = iter + 1;
+        }
 
-        // Update x and r
-        for (int j = 0; j < n; ++j) {
-            x[j] += alpha * p[j];   // Update solution x : x_k+1 = x_k + alpha_k * pk
-            r[j] -= alpha * Ap[j];  // Update residual r : r_k+1 = r_k - alpha_k * A * pk
+        // Update x and r (and z for Jacobi), together with the residual norm
+        double r_dot_z_new = 0.0;
+        double r_dot_r;
+        if (inv_diag) {
+            r_dot_r = cg_update_solution_jacobi(alpha, p, Ap, inv_diag, x, r, z, n, &r_dot_z_new);
+        } else {
+            r_dot_r = cg_update_solution(alpha, p, Ap, x, r, n);
         }
 
         // Check for the convergence
-        double r_norm = sqrt(dot_product(r, r, n));
-        if (r_norm < tol) {
-            printf("PCG converged after %d iterations\n", i + 1);
-            free(r); free(z); free(p); free(Ap);free(L);
-            return 0;
+        if (sqrt(r_dot_r) < tol) {
+            status = 0;
+            break;
         }
 
         // Apply preconditioner
-        if (strcmp(preconditioner_type, "Jacobi") == 0) {
-            jacobi_precondition(A, r, z, n);
-        } else if (strcmp(preconditioner_type, "IncompleteCholesky") == 0) {
-            ic_precondition(L, r, z, n);
-        } else {
-            memcpy(z, r, n * sizeof(double));  // No preconditioner
+        if (identity) {
+            r_dot_z_new = r_dot_r;
+        } else if (!inv_diag) {
+            M->apply(M, r, z);
+            r_dot_z_new = dot_product(r, z, n);
+        }
+
+        // beta_k = dot(r_k+1, z_k+1) / dot(rk, zk);
+        beta = r_dot_z_new / r_dot_z_old;
+        if (coeffs && iter < coeffs->capacity) {
+            coeffs->beta[iter] = beta;
         }
+        r_dot_z_old = r_dot_z_new;  //Update for next iteration
+
+    }
+
+    if (iterations) {
+        *iterations = (status == 0) ? iter + 1 : max_iter;
+    } else if (status == 0) {
+        printf("PCG converged after %d iterations\n", iter + 1);
+    } else {
+        // If we reach this point, the algorithm did not converge within max_iter
+        printf("PCG did not converge after %d iterations\n", max_iter);
+    }
+    workspace_free(&local);
+    return status;
+}
+
+int pcg_solver_precond(const LinearOperator* A, const double *b, double *x, int max_iter, double tol, const Preconditioner* M,
+                       SolverWorkspace* ws) {
+
+    /*
+     * Function: pcg_solver_precond
+     * ----------------------------
+     * Solve the linear system Ax = b using the Preconditioned Conjugate Gradient method with a
+     * preconditioner handle that was set up beforehand (and can be reused for further solves).
+     * Parameters:
+     *  - A: Linear operator (dense, CRS or matrix-free stencil)
+     *  - b: Pointer to vector b (right-hand side)
+     *  - x: Pointer to the initial guess vector x (also stores the solution)
+     *  - max_iter: Maximum number of iterations
+     *  - tol: Convergence tolerance
+     *  - M: Preconditioner of A (preconditioner_crs, preconditioner_stencil, ...)
+     *  - ws: Workspace kept across solves for the work vectors (NULL: allocated for this solve)
+     * Returns:
+     *  -0 if converged, 1 otherwise (max iterations reached without convergence), -1 on error
+     */
+
+    if (!A || !A->apply || !b || !x || !M || !M->apply || M->n != A->n) {
+        fprintf(stderr, "Invalid input to pcg_solver_precond.\n");
+        return -1;
+    }
+    return pcg_iterate(A, b, x, max_iter, tol, M, ws, NULL, NULL);
+}
+
+int pcg_solver_record(const LinearOperator* A, const double *b, double *x, int max_iter, double tol, const Preconditioner* M,
+                      SolverWorkspace* ws, CGCoefficients* coeffs) {
+
+    /*
+     * Function: pcg_solver_record
+     * ---------------------------
+     * pcg_solver_precond that also records alpha_k and beta_k of the first 'coeffs->capacity'
+     * iterations. They are the Lanczos tridiagonal of M^(-1) * A, so a Jacobi-preconditioned
+     * solve yields the spectral bounds of a Chebyshev preconditioner / smoother of the same
+     * operator without any extra work (chebyshev_cg_bounds, preconditioner_set_spectrum).
+     * Parameters:
+     *  - A, b, x, max_iter, tol, M, ws: as in pcg_solver_precond
+     *  - coeffs: arrays of 'capacity' entries (owned by the caller); 'count' receives the
+     *    number of alpha_k recorded (beta of the last recorded iteration may be missing)
+     * Returns:
+     *  -0 if converged, 1 otherwise (max iterations reached without convergence), -1 on error
+     */
+
+    if (!A || !A->apply || !b || !x || !M || !M->apply || M->n != A->n || !coeffs || coeffs->capacity < 0 ||
+        (coeffs->capacity > 0 && (!coeffs->alpha || !coeffs->beta))) {
+        fprintf(stderr, "Invalid input to pcg_solver_record.\n");
+        return -1;
+    }
+    coeffs->count = 0;
+    return pcg_iterate(A, b, x, max_iter, tol, M, ws, NULL, coeffs);
+}
+
+int pcg_solver_refinement(const LinearOperator* A, const double *b, double *x, int max_iter, double tol,
+                          const Preconditioner* M, SolverWorkspace* ws) {
+
+    /*
+     * Function: pcg_solver_refinement
+     * -------------------------------
+     * Solve the linear system Ax = b by iterative refinement around PCG, for preconditioners
+     * stored in single precision (preconditioner_set_precision):
+     *   r = b - A * x                 (double)
+     *   A * e = r with PCG from e = 0 down to max(PCG_REFINEMENT_REDUCTION * ||r||, tol / 2)
+     *   x += e
+     * until ||b - A * x|| < tol. Every outer step recomputes the true residual in double, so
+     * the drift of the recursively updated CG residual (larger with an inexact preconditioner)
+     * cannot stop the solve short of the tolerance. max_iter bounds the PCG iterations of all
+     * refinement steps together.
+     * Parameters:
+     *  - A, b, x, max_iter, tol, M, ws: as in pcg_solver_precond
+     * Returns:
+     *  -0 if converged, 1 otherwise (max iterations reached without convergence), -1 on error
+     */
+
+    if (!A || !A->apply || !b || !x || !M || !M->apply || M->n != A->n) {
+        fprintf(stderr, "Invalid input to pcg_solver_refinement.\n");
+        return -1;
+    }
 
-        double r_dot_z_new = dot_product(r, z, n);
+    const int n = (int) A->n;
 
-        // beta_k = dot(r_k+1, r_k+1) / dot(rk, rk);
-        double beta = r_dot_z_new / r_dot_z_old;
+    // r and e lie behind the vectors of the inner solves: those reserve at most the front part
+    // of the block (no reallocation), so r and e stay valid across the refinement steps
+    SolverWorkspace local = SOLVER_WORKSPACE_INIT;
+    SolverWorkspace* W = ws ? ws : &local;
+    const size_t inner = pcg_workspace_size(A, M);
+    if (workspace_reserve(W, inner + 2 * workspace_size((size_t) n)) != 0 || !workspace_take(W, inner)) {
+        fprintf(stderr, "Memory allocation failed in pcg_solver_refinement.\n");
+        workspace_free(&local);
+        return -1;
+    }
+    double* r = workspace_take(W, n);
+    double* e = workspace_take(W, n);
 
-        // p_k+1 = r_k+1 + beta_k * p_k;
-        for (int j = 0; j < n; ++j) {
-            p[j] = z[j] + beta * p[j];
+    int status = 1;
+    int total = 0;
+    int steps = 0;
+    double r_norm = 0.0;
+    while (1) {
+        // True residual in double
+        A->apply(A, x, r);
+        vec_subtract(b, r, r, n);
+        r_norm = sqrt(dot_product(r, r, n));
+        if (r_norm < tol) {
+            status = 0;
+            break;
+        }
+        if (total >= max_iter) {
+            break;
         }
 
-        r_dot_z_old = r_dot_z_new;  //Update for next iteration
+        // Correction from the (single-precision) preconditioned inner solve
+        const double inner_tol = fmax(PCG_REFINEMENT_REDUCTION * r_norm, 0.5 * tol);
+        int iterations = 0;
+        memset(e, 0, n * sizeof(double));
+        if (pcg_iterate(A, r, e, max_iter - total, inner_tol, M, W, &iterations, NULL) < 0) {
+            status = -1;
+            break;
+        }
+        total += iterations;
+        steps++;
+        #pragma omp parallel for simd if (n >= PARALLEL_THRESHOLD)
+        for (int i = 0; i < n; ++i) {
+            x[i] += e[i];
+        }
+    }
+
+    if (status == 0) {
+        printf("PCG converged after %d iterations (%d refinement steps)\n", total, steps);
+    } else if (status == 1) {
+        printf("PCG did not converge after %d iterations (%d refinement steps)\n", total, steps);
+    }
+    workspace_free(&local);
+    return status;
+}
+
+int pcg_solver_op(const LinearOperator* A, const double *b, double *x, int max_iter, double tol, const char* preconditioner_type) {
+
+    /*
+     * Function: pcg_solver_op
+     * -----------------------
+     * Solve the linear system Ax = b using the Preconditioned Conjugate Gradient method, where A
+     * is only accessed through 'A->apply' (and 'A->diagonal' for Jacobi).
+     * Parameters:
+     *  - A: Linear operator (dense, CRS or matrix-free stencil)
+     *  - b: Pointer to vector b (right-hand side)
+     *  - x: Pointer to the initial guess vector x (also stores the solution)
+     *  - max_iter: Maximum number of iterations
+     *  - tol: Convergence tolerance
+     *  preconditioner_type: Type of preconditioner ("None", "Jacobi", "Chebyshev" or
+     *                       "Chebyshev(k)"). Incomplete Cholesky and AMG need the matrix
+     *                       entries and are available in pcg_solver_crs.
+     * Returns:
+     *  -0 if converged, 1 otherwise (max iterations reached without convergence), -1 on error
+     */
+
+    if (!A || !A->apply || !b || !x || !preconditioner_type) {
+        fprintf(stderr, "Invalid input to pcg_solver_op.\n");
+        return -1;
+    }
+
+    // Jacobi: the inverse diagonal is extracted once from the operator
+    Preconditioner M;
+    if (preconditioner_operator(&M, A, preconditioner_type) != 0) {
+        return -1;
+    }
+
+    int status = pcg_iterate(A, b, x, max_iter, tol, &M, NULL, NULL, NULL);
+    preconditioner_free(&M);
+    return status;
+}
+
+int pcg_solver_crs(const CRSMatrix* A, const double *b, double *x, int max_iter, double tol, const char* preconditioner_type) {
+
+    /*
+     * Function: pcg_solver_crs
+     * ------------------------
+     * Solve the linear system Ax = b using the Preconditioned Conjugate Gradient method with A
+     * stored in CRS format. The SpMV, the Jacobi diagonal extraction and the incomplete
+     * Cholesky factor all work on sparse storage, so the cost scales with nnz instead of n^2.
+     * Parameters:
+     *  - A: Pointer to the CRS matrix (checked once by crs_validate)
+     *  - b: Pointer to vector b (right-hand side)
+     *  - x: Pointer to the initial guess vector x (also stores the solution)
+     *  - max_iter: Maximum number of iterations
+     *  - tol: Convergence tolerance
+     *  preconditioner_type: Type of preconditioner ("None", "Jacobi", "IncompleteCholesky",
+     *                       "ModifiedIncompleteCholesky", "AMG", "Chebyshev" or "Chebyshev(k)")
+     * Returns:
+     *  -0 if converged, 1 otherwise (max iterations reached without convergence), -1 on error
+     */
+
+    if (!A || !b || !x || !preconditioner_type) {
+        fprintf(stderr, "Invalid input to pcg_solver_crs.\n");
+        return -1;
+    }
+    if (!A->validated) {
+        fprintf(stderr, "CRS matrix passed to pcg_solver_crs must be checked by crs_validate first.\n");
+        return -1;
+    }
+
+    LinearOperator op;
+    if (linear_operator_crs(&op, A) != 0) {
+        return -1;
+    }
+
+    // Inverse diagonal, IC factor with its triangular-solve schedule or AMG hierarchy, built once
+    Preconditioner M;
+    if (preconditioner_crs(&M, A, preconditioner_type) != 0) {
+        return -1;
+    }
+
+    int status = pcg_iterate(&op, b, x, max_iter, tol, &M, NULL, NULL, NULL);
+    preconditioner_free(&M);
+    return status;
+}
+
+int pcg_solver_stencil(const StencilOperator* S, const double *b, double *x, int max_iter, double tol, const char* preconditioner_type) {
 
+    /*
+     * Function: pcg_solver_stencil
+     * ----------------------------
+     * Solve the linear system Ax = b using the Preconditioned Conjugate Gradient method, where A
+     * is the matrix-free finite-volume stencil of the structured grid.
+     * Parameters:
+     *  - S: Stencil of the grid (never assembled)
+     *  - b: Pointer to vector b (right-hand side)
+     *  - x: Pointer to the initial guess vector x (also stores the solution)
+     *  - max_iter: Maximum number of iterations
+     *  - tol: Convergence tolerance
+     *  preconditioner_type: Type of preconditioner ("None", "Jacobi", "Chebyshev",
+     *                       "Chebyshev(k)", "Multigrid" or "MultigridW" on the stencil;
+     *                       "IncompleteCholesky", "ModifiedIncompleteCholesky" or "AMG" on the
+     *                       matrix assembled once)
+     * Returns:
+     *  -0 if converged, 1 otherwise (max iterations reached without convergence), -1 on error
+     */
+
+    if (!S || !b || !x || !preconditioner_type) {
+        fprintf(stderr, "Invalid input to pcg_solver_stencil.\n");
+        return -1;
+    }
+
+    LinearOperator op;
+    if (linear_operator_stencil(&op, S) != 0) {
+        return -1;
+    }
+
+    // Multigrid hierarchy of the grid (or the preconditioner of the assembled matrix), built once
+    Preconditioner M;
+    if (preconditioner_stencil(&M, S, preconditioner_type) != 0) {
+        return -1;
     }
 
-    // If we reach this point, the algorithm did not converge within max_iter
-    printf("PCG did not converge after %d iterations\n", max_iter);
-    free(r); free(z); free(p); free(Ap); free(L);
-    return 1;
-}
\ No newline at end of file
+    int status = pcg_iterate(&op, b, x, max_iter, tol, &M, NULL, NULL, NULL);
+    preconditioner_free(&M);
+    return status;
+}
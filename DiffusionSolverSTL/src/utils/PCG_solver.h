@@ -5,13 +5,57 @@
 #ifndef PROJECT_02_FVM_PCG_SOLVER_H
 #define PROJECT_02_FVM_PCG_SOLVER_H
 
-#ifdef __cpluscplus
+#include "matrix_operations/linear_operator.h"
+#include "matrix_operations/stencil_operator.h"
+#include "preconditioner.h"
+#include "solver_workspace.h"
+
+#ifdef __cplusplus
 extern "C" {
 #endif
 
 int pcg_solver(const double *A, const double *b, double *x, int n, int max_iter, double tol, const char* preconditioner_type);
 
-#ifdef __cpluscplus
+// PCG with a preconditioner handle set up beforehand and a workspace for the work vectors (NULL:
+// temporary), both reusable across solves and time steps
+int pcg_solver_precond(const LinearOperator* A, const double *b, double *x, int max_iter, double tol, const Preconditioner* M,
+                       SolverWorkspace* ws);
+
+/*
+ * @struct CGCoefficients
+ * alpha_k / beta_k of the first 'capacity' iterations of a PCG solve (pcg_solver_record), i.e.
+ * the Lanczos tridiagonal of M^(-1) * A (see chebyshev_cg_bounds). The caller owns the arrays.
+ */
+typedef struct {
+    double* alpha;
+    double* beta;
+    int capacity;                 // Length of both arrays
+    int count;                    // Number of iterations recorded
+} CGCoefficients;
+
+// pcg_solver_precond that also records the CG coefficients (spectral bounds of M^(-1) * A)
+int pcg_solver_record(const LinearOperator* A, const double *b, double *x, int max_iter, double tol, const Preconditioner* M,
+                      SolverWorkspace* ws, CGCoefficients* coeffs);
+
+// pcg_solver_precond inside an iterative refinement (double residual and solution), for handles
+// stored in single precision (preconditioner_set_precision); max_iter counts all PCG iterations
+int pcg_solver_refinement(const LinearOperator* A, const double *b, double *x, int max_iter, double tol,
+                          const Preconditioner* M, SolverWorkspace* ws);
+
+// PCG on an abstract operator (dense, CRS or matrix-free stencil), preconditioner "None", "Jacobi",
+// "Chebyshev" or "Chebyshev(k)" (only the diagonal of the operator is needed)
+int pcg_solver_op(const LinearOperator* A, const double *b, double *x, int max_iter, double tol, const char* preconditioner_type);
+
+// PCG on a CRS matrix, preconditioner "None", "Jacobi", "IncompleteCholesky",
+// "ModifiedIncompleteCholesky", "AMG", "Chebyshev" or "Chebyshev(k)" (all sparse)
+int pcg_solver_crs(const CRSMatrix* A, const double *b, double *x, int max_iter, double tol, const char* preconditioner_type);
+
+// PCG on the matrix-free grid stencil, preconditioner "None", "Jacobi", "Chebyshev", "Chebyshev(k)",
+// "Multigrid" (V-cycle) or "MultigridW" (W-cycle) on the stencil, or "IncompleteCholesky",
+// "ModifiedIncompleteCholesky" or "AMG" on the stencil assembled once
+int pcg_solver_stencil(const StencilOperator* S, const double *b, double *x, int max_iter, double tol, const char* preconditioner_type);
+
+#ifdef __cplusplus
 }
 #endif
 
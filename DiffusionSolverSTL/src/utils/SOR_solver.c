@@ -0,0 +1,332 @@
+/*
+ * File: SOR_solver.c
+ * ------------------
+ * This file contains Gauss-Seidel / SOR (successive over-relaxation) in multicolour order, as
+ * a standalone solver ("Gauss-Seidel", "SOR(w)") and as a smoother (multigrid.c, amg.c):
+ *
+ *     x_i += omega * (b_i - (A * x)_i) / a_ii,   0 < omega < 2 (omega = 1: Gauss-Seidel)
+ *
+ * The lexicographic sweep is sequential (every row waits for its predecessor). In multicolour
+ * order the unknowns are split into colours such that no two unknowns of one colour are
+ * coupled; all unknowns of a colour then only read unknowns of the other colours, so a colour
+ * is relaxed in parallel and the result does not depend on the number of threads.
+ *  - Stencil: the 5-point (7-point) stencil is coupled only between cells of different parity
+ *    of i + j + k, so two colours (red-black) suffice in 2D and in 3D (stencil_sor_sweep).
+ *  - CRS: the rows are coloured greedily (first free colour in row order) on the pattern of
+ *    A + A^T; the 5/7-point stencil gets 2 colours, 9/27-point stencils 4/8, Galerkin
+ *    operators of AMG a few more.
+ *
+ * SOR converges for symmetric positive definite matrices, but the number of sweeps grows with
+ * the square of the grid size (with the grid size for the optimal omega), so it is meant for
+ * small or strongly diagonally dominant systems and as a cheap, fully parallel smoother.
+ * The residual norm costs one more matrix product, so the standalone solvers check it every
+ * SOR_CHECK_INTERVAL sweeps only.
+ *
+ * Functions:
+ *  - multicolor_setup: Colours the rows of a CRS matrix.
+ *  - multicolor_sor_sweep: One multicolour SOR sweep on a CRS matrix.
+ *  - multicolor_free: Frees a colouring.
+ *  - sor_solver_crs: Standalone multicolour SOR on a CRS matrix.
+ *  - sor_solver_stencil: Standalone red-black SOR on the matrix-free stencil.
+ *  - sor_parse_type: Maps "Gauss-Seidel" / "SOR(w)" to the relaxation factor.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <omp_llvm.h>
+#include "SOR_solver.h"
+#include "matrix_operations/linear_algebra.h"
+
+// Sweeps between two residual checks of the standalone solvers
+#define SOR_CHECK_INTERVAL 4
+
+/*
+ * Function: multicolor_setup
+ * --------------------------
+ * Colours the rows of A greedily in row order: row i gets the smallest colour not used by a
+ * coloured neighbour, the neighbours being the columns of row i of A and of A^T (so the
+ * colouring is also valid for a nonsymmetric pattern). The rows are then grouped by colour
+ * (counting sort, increasing inside a colour).
+ *
+ * Parameters:
+ *   A - Validated square CRS matrix with a nonzero diagonal
+ *   S - Output colouring (free with multicolor_free)
+ *
+ * Returns:
+ *   - 0 on success
+ *   - -1 on invalid input, a zero diagonal entry or memory allocation failure
+ */
+int multicolor_setup(const CRSMatrix* A, MulticolorSOR* S) {
+
+    if (!A || !S || !A->validated || A->rows != A->cols) {
+        fprintf(stderr, "Invalid input to multicolor_setup.\n");
+        return -1;
+    }
+
+    const size_t n = A->rows;
+    S->n = n;
+    S->num_colors = 0;
+    S->color_ptr = NULL;
+    S->rows = (size_t*) malloc((n + 1) * sizeof(size_t));
+    S->inv_diag = (double*) malloc((n + 1) * sizeof(double));
+    int* color = (int*) malloc((n + 1) * sizeof(int));
+    size_t* forbidden = (size_t*) malloc((n + 2) * sizeof(size_t));
+    CRSMatrix At;
+    if (!S->rows || !S->inv_diag || !color || !forbidden || crs_transpose(A, &At) != 0) {
+        fprintf(stderr, "Memory allocation failed in multicolor_setup.\n");
+        free(color);
+        free(forbidden);
+        multicolor_free(S);
+        return -1;
+    }
+
+    crs_extract_diagonal(A, S->inv_diag);
+    for (size_t i = 0; i < n; ++i) {
+        if (S->inv_diag[i] == 0.0) {
+            fprintf(stderr, "Zero diagonal entry (row %zu) in multicolor_setup.\n", i);
+            free(color);
+            free(forbidden);
+            free_crs_matrix(&At);
+            multicolor_free(S);
+            return -1;
+        }
+        S->inv_diag[i] = 1.0 / S->inv_diag[i];
+        color[i] = -1;
+    }
+
+    // forbidden[c] == i + 1: colour c is used by a neighbour of row i
+    for (size_t c = 0; c <= n + 1; ++c) {
+        forbidden[c] = 0;
+    }
+    int num_colors = 0;
+    for (size_t i = 0; i < n; ++i) {
+        const CRSMatrix* patterns[2] = {A, &At};
+        for (int m = 0; m < 2; ++m) {
+            const CRSMatrix* B = patterns[m];
+            for (size_t j = B->row_ptr[i]; j < B->row_ptr[i + 1]; ++j) {
+                const int c = color[crs_col(B, j)];
+                if (c >= 0) {
+                    forbidden[c] = i + 1;
+                }
+            }
+        }
+        int c = 0;
+        while (forbidden[c] == i + 1) {
+            c++;
+        }
+        color[i] = c;
+        num_colors = (c + 1 > num_colors) ? c + 1 : num_colors;
+    }
+    free_crs_matrix(&At);
+    free(forbidden);
+
+    // Group the rows by colour
+    S->color_ptr = (size_t*) calloc((size_t) num_colors + 1, sizeof(size_t));
+    if (!S->color_ptr) {
+        fprintf(stderr, "Memory allocation failed in multicolor_setup.\n");
+        free(color);
+        multicolor_free(S);
+        return -1;
+    }
+    for (size_t i = 0; i < n; ++i) {
+        S->color_ptr[color[i] + 1]++;
+    }
+    for (int c = 0; c < num_colors; ++c) {
+        S->color_ptr[c + 1] += S->color_ptr[c];
+    }
+    for (size_t i = 0; i < n; ++i) {
+        S->rows[S->color_ptr[color[i]]++] = i;
+    }
+    for (int c = num_colors; c > 0; --c) {
+        S->color_ptr[c] = S->color_ptr[c - 1];
+    }
+    S->color_ptr[0] = 0;
+    S->num_colors = num_colors;
+
+    free(color);
+    return 0;
+}
+
+/*
+ * Function: multicolor_sor_sweep
+ * ------------------------------
+ * One SOR sweep over the colours of S in order (reverse: last colour first). The rows of one
+ * colour are distributed over the threads of a single parallel region; the barrier at the end
+ * of every colour makes its new values visible to the next one.
+ */
+void multicolor_sor_sweep(const MulticolorSOR* S, const CRSMatrix* A, const double* b, double* x, double omega,
+                          int reverse) {
+    #pragma omp parallel if (A->nnz >= (size_t) SPARSE_PARALLEL_THRESHOLD)
+    {
+        const size_t tid = (size_t) omp_get_thread_num();
+        const size_t num_threads = (size_t) omp_get_num_threads();
+        for (int t = 0; t < S->num_colors; ++t) {
+            const int c = reverse ? S->num_colors - 1 - t : t;
+            const size_t begin = S->color_ptr[c];
+            const size_t count = S->color_ptr[c + 1] - begin;
+            // Static split of the colour, the index width is picked once per chunk
+            CRS_INDEX_CALL(A, crs_rows_relax, S->rows, begin + count * tid / num_threads,
+                           begin + count * (tid + 1) / num_threads, b, S->inv_diag, omega, x);
+            #pragma omp barrier
+        }
+    }
+}
+
+/*
+ * Function: multicolor_free
+ * -------------------------
+ * Frees a colouring (safe on a partially built one).
+ */
+void multicolor_free(MulticolorSOR* S) {
+    if (!S) return;
+    free(S->color_ptr);
+    free(S->rows);
+    free(S->inv_diag);
+    S->color_ptr = NULL;
+    S->rows = NULL;
+    S->inv_diag = NULL;
+    S->num_colors = 0;
+}
+
+/*
+ * Function: sor_solver_crs
+ * ------------------------
+ * Solves A * x = b (x holds the initial guess) by multicolour SOR sweeps.
+ *
+ * Parameters:
+ *   A        - Validated square CRS matrix (symmetric positive definite for guaranteed convergence)
+ *   b        - Right-hand side
+ *   x        - Initial guess / solution
+ *   max_iter - Maximum number of sweeps
+ *   tol      - Convergence tolerance on ||b - A * x||
+ *   omega    - Relaxation factor, 0 < omega < 2 (1: Gauss-Seidel)
+ *
+ * Returns:
+ *  -0 if converged, 1 otherwise (max iterations reached without convergence), -1 on error
+ */
+int sor_solver_crs(const CRSMatrix* A, const double* b, double* x, int max_iter, double tol, double omega) {
+
+    if (!A || !b || !x || !(omega > 0.0 && omega < 2.0)) {
+        fprintf(stderr, "Invalid input to sor_solver_crs.\n");
+        return -1;
+    }
+
+    const int n = (int) A->rows;
+    MulticolorSOR S;
+    double* r = (double*) malloc((A->rows + 1) * sizeof(double));
+    if (!r || multicolor_setup(A, &S) != 0) {
+        fprintf(stderr, "Setup failed in sor_solver_crs.\n");
+        free(r);
+        return -1;
+    }
+
+    int iter;
+    int converged = 0;
+    for (iter = 0;; ++iter) {
+        if (iter % SOR_CHECK_INTERVAL == 0 || iter == max_iter) {
+            crs_mat_vec_mult(A, x, r);
+            vec_subtract(b, r, r, n);
+            if (sqrt(dot_product(r, r, n)) < tol) {
+                converged = 1;
+                break;
+            }
+        }
+        if (iter >= max_iter) {
+            break;
+        }
+        multicolor_sor_sweep(&S, A, b, x, omega, 0);
+    }
+
+    if (converged) {
+        printf("SOR converged after %d iterations (%d colours)\n", iter, S.num_colors);
+    } else {
+        printf("SOR did not converge after %d iterations\n", max_iter);
+    }
+    multicolor_free(&S);
+    free(r);
+    return converged ? 0 : 1;
+}
+
+/*
+ * Function: sor_solver_stencil
+ * ----------------------------
+ * Solves A * x = b (x holds the initial guess) by red-black SOR sweeps on the matrix-free
+ * stencil (stencil_sor_sweep: red cells, then black cells).
+ *
+ * Returns:
+ *  -0 if converged, 1 otherwise (max iterations reached without convergence), -1 on error
+ */
+int sor_solver_stencil(const StencilOperator* S, const double* b, double* x, int max_iter, double tol, double omega) {
+
+    if (!S || !b || !x || !(omega > 0.0 && omega < 2.0) || S->nx <= 0 || S->ny <= 0 || S->nz <= 0) {
+        fprintf(stderr, "Invalid input to sor_solver_stencil.\n");
+        return -1;
+    }
+
+    const size_t n = (size_t) S->nx * S->ny * S->nz;
+    double* inv_diag = (double*) malloc(n * sizeof(double));
+    double* r = (double*) malloc(n * sizeof(double));
+    if (!inv_diag || !r || stencil_diagonal(S, inv_diag) != 0) {
+        fprintf(stderr, "Setup failed in sor_solver_stencil.\n");
+        free(inv_diag);
+        free(r);
+        return -1;
+    }
+    #pragma omp parallel for simd if (n >= (size_t) PARALLEL_THRESHOLD)
+    for (long long p = 0; p < (long long) n; ++p) {
+        inv_diag[p] = 1.0 / inv_diag[p];
+    }
+
+    int iter;
+    int converged = 0;
+    for (iter = 0;; ++iter) {
+        if (iter % SOR_CHECK_INTERVAL == 0 || iter == max_iter) {
+            stencil_apply(S, x, r);
+            vec_subtract(b, r, r, (int) n);
+            if (sqrt(dot_product(r, r, (int) n)) < tol) {
+                converged = 1;
+                break;
+            }
+        }
+        if (iter >= max_iter) {
+            break;
+        }
+        stencil_sor_sweep(S, b, x, inv_diag, omega, 0);
+        stencil_sor_sweep(S, b, x, inv_diag, omega, 1);
+    }
+
+    if (converged) {
+        printf("SOR converged after %d iterations (red-black)\n", iter);
+    } else {
+        printf("SOR did not converge after %d iterations\n", max_iter);
+    }
+    free(inv_diag);
+    free(r);
+    return converged ? 0 : 1;
+}
+
+/*
+ * Function: sor_parse_type
+ * ------------------------
+ * Returns 1 for the solver types "Gauss-Seidel" (omega = 1) and "SOR(w)" with 0 < w < 2
+ * (omega = w), 0 for every other type (omega unchanged).
+ */
+int sor_parse_type(const char* solver_type, double* omega) {
+    if (!solver_type || !omega) {
+        return 0;
+    }
+    if (strcmp(solver_type, "Gauss-Seidel") == 0) {
+        *omega = 1.0;
+        return 1;
+    }
+    double w = 0.0;
+    int len = 0;
+    if (sscanf(solver_type, "SOR(%lf)%n", &w, &len) == 1 && len > 0 && solver_type[len] == '\0' &&
+        w > 0.0 && w < 2.0) {
+        *omega = w;
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,47 @@
+#ifndef PROJECT_02_FVM_SOR_SOLVER_H
+#define PROJECT_02_FVM_SOR_SOLVER_H
+
+#include <stddef.h>  // for size_t
+#include "matrix_operations/CRSMatrix.h"
+#include "matrix_operations/stencil_operator.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * @struct MulticolorSOR
+ * Colouring of the rows of a CRS matrix for parallel Gauss-Seidel / SOR (see SOR_solver.c):
+ * no two rows of one colour are coupled, so the rows of a colour are relaxed in parallel.
+ * Built once per sparsity pattern by 'multicolor_setup'.
+ */
+typedef struct {
+    size_t n;
+    int num_colors;
+    size_t* color_ptr;      // Rows of colour c: rows[color_ptr[c] .. color_ptr[c + 1]) (num_colors + 1 entries)
+    size_t* rows;           // Rows grouped by colour, increasing inside a colour
+    double* inv_diag;       // Inverse diagonal of the matrix
+} MulticolorSOR;
+
+// Greedy colouring of the (symmetrized) pattern of A and its inverse diagonal
+int multicolor_setup(const CRSMatrix* A, MulticolorSOR* S);
+
+// One multicolour SOR sweep over all colours (reverse = 1: last colour first, the adjoint sweep)
+void multicolor_sor_sweep(const MulticolorSOR* S, const CRSMatrix* A, const double* b, double* x, double omega,
+                          int reverse);
+
+void multicolor_free(MulticolorSOR* S);
+
+// Standalone solvers: SOR sweeps until ||b - A * x|| < tol (omega = 1: Gauss-Seidel, 0 < omega < 2)
+int sor_solver_crs(const CRSMatrix* A, const double* b, double* x, int max_iter, double tol, double omega);
+int sor_solver_stencil(const StencilOperator* S, const double* b, double* x, int max_iter, double tol, double omega);
+
+// Recognizes the solver types "Gauss-Seidel" (omega = 1) and "SOR(w)" (omega = w); returns 1 and
+// sets omega for them, 0 for every other type
+int sor_parse_type(const char* solver_type, double* omega);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif //PROJECT_02_FVM_SOR_SOLVER_H
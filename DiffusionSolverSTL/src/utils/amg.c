@@ -0,0 +1,699 @@
+/*
+ * File: amg.c
+ * -----------
+ * This file contains the smoothed-aggregation algebraic multigrid method (Vanek, Mandel &
+ * Brezina) for symmetric positive definite CRS matrices, used as a PCG preconditioner or as a
+ * standalone solver. Unlike the geometric multigrid (multigrid.c) it only needs the matrix, so
+ * it also applies to non-uniform and unstructured discretizations. Nonsymmetric matrices with
+ * a dominant diffusion part (weak advection) can use it to precondition BiCGSTAB / GMRES
+ * (nonsymmetric_solvers.c); the V-cycle is then no longer symmetric.
+ *
+ * Setup, per level (until the operator has at most AMG_COARSEST_SIZE rows):
+ *  1. Strength of connection: j is a strong neighbour of i if a_ij^2 > eps^2 * |a_ii * a_jj|,
+ *     eps = AMG_STRENGTH_THRESHOLD * 0.5^level (the coarse operators have more, and
+ *     relatively weaker, couplings per row).
+ *  2. Aggregation (greedy, three passes): a node whose strong neighbours are all free starts
+ *     an aggregate with them; the remaining nodes join a neighbouring aggregate of the first
+ *     pass; what is left forms aggregates with its free strong neighbours.
+ *  3. Tentative prolongator: piecewise constant per aggregate (the near null space of a
+ *     diffusion operator), columns scaled to unit norm.
+ *  4. Smoothed prolongator: P = (I - omega * D_F^(-1) * A_F) * P_tent, omega = 4 / (3 * rho),
+ *     rho being the Gershgorin bound of the spectral radius of D_F^(-1) * A_F. A_F is A without
+ *     its weak entries, which keeps P and the coarse operators sparse.
+ *  5. Galerkin coarse operator: A_c = R * (A * P) with R = P^T, both products by the parallel
+ *     sparse matrix-matrix product 'crs_mat_mat_mult'.
+ *  The coarsest operator is factored densely (LU). If coarsening stalls on a large level (no
+ *  strong connections, i.e. a strongly diagonally dominant operator), that level is solved by
+ *  symmetric smoothing sweeps instead.
+ *
+ * Solve phase (V-cycle):
+ *  - Hybrid Gauss-Seidel smoothing: every part of the nnz-balanced row partition of the level
+ *    matrix is relaxed by Gauss-Seidel, couplings to other parts use the values of the start of
+ *    the sweep, so the parts are relaxed in parallel and the result does not depend on timing.
+ *  - Alternatively (amg_set_smoother) multicolour SOR: the rows of every level are coloured
+ *    once and relaxed colour by colour (SOR_solver.c), an exact Gauss-Seidel / SOR sweep in
+ *    colour order.
+ *  - Or a Chebyshev polynomial of degree CHEBYSHEV_SMOOTHER_DEGREE (chebyshev.c) damping the
+ *    upper part of the spectrum of D^(-1) * A, whose bounds are estimated by Lanczos once per
+ *    level: only matrix products, so it parallelizes like the SpMV.
+ *  - The pre-smoother sweeps forward, the post-smoother backward, so the V-cycle is a
+ *    symmetric positive definite preconditioner for PCG.
+ *
+ * Functions:
+ *  - amg_setup: Builds the hierarchy.
+ *  - amg_apply: One V-cycle from a zero initial guess (preconditioner).
+ *  - amg_solve: V-cycles until convergence (standalone solver).
+ *  - amg_set_smoother: Selects hybrid Gauss-Seidel, multicolour SOR or Chebyshev smoothing.
+ *  - amg_free: Frees the hierarchy.
+ */
+
+#include "amg.h"
+#include "matrix_operations/linear_algebra.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <omp_llvm.h>
+
+#define AMG_MAX_LEVELS 25
+#define AMG_COARSEST_SIZE 256
+#define AMG_STRENGTH_THRESHOLD 0.08
+#define AMG_SMOOTHING_SWEEPS 1
+
+// Largest coarsest level factored densely, and the smoothing sweeps replacing the factor otherwise
+#define AMG_MAX_DIRECT_SIZE 2048
+#define AMG_COARSE_SWEEPS 4
+
+// Stop coarsening if the number of aggregates does not drop below this fraction of the rows
+#define AMG_MIN_COARSENING 0.9
+
+static const CRSMatrix AMG_EMPTY_MATRIX = {NULL, NULL, NULL, 0, 0, 0, NULL, 0, 0, NULL, NULL};
+
+/*
+ * Strength of connection: strong[j] = 1 if entry j of A (row i, column c != i) satisfies
+ * a_ic^2 > eps^2 * |a_ii * a_cc|. Returns NULL on allocation failure.
+ */
+static unsigned char* amg_strength(const CRSMatrix* A, const double* diag, double eps) {
+    const double eps2 = eps * eps;
+    unsigned char* strong = (unsigned char*) malloc(A->nnz + 1);
+    if (!strong) {
+        return NULL;
+    }
+
+    #pragma omp parallel for if (A->nnz >= (size_t) SPARSE_PARALLEL_THRESHOLD)
+    for (long long i = 0; i < (long long) A->rows; ++i) {
+        for (size_t j = A->row_ptr[i]; j < A->row_ptr[i + 1]; ++j) {
+            const size_t c = crs_col(A, j);
+            const double a = A->values[j];
+            strong[j] = (c != (size_t) i && a * a > eps2 * fabs(diag[i] * diag[c]));
+        }
+    }
+    return strong;
+}
+
+/*
+ * Greedy aggregation on the strength-of-connection graph of A. Writes the aggregate of every
+ * row to 'agg' and returns the number of aggregates (0 on memory allocation failure).
+ */
+static size_t amg_aggregate(const CRSMatrix* A, const unsigned char* strong, size_t* agg) {
+    const size_t n = A->rows;
+    const size_t FREE = (size_t) -1;
+
+    size_t* first_pass = (size_t*) malloc(n * sizeof(size_t));
+    if (!first_pass) {
+        return 0;
+    }
+
+    for (size_t i = 0; i < n; ++i) {
+        agg[i] = FREE;
+    }
+
+    // Pass 1: nodes whose strong neighbourhood is entirely free become root nodes
+    size_t num_agg = 0;
+    for (size_t i = 0; i < n; ++i) {
+        if (agg[i] != FREE) continue;
+        int all_free = 1;
+        for (size_t j = A->row_ptr[i]; j < A->row_ptr[i + 1] && all_free; ++j) {
+            if (strong[j] && agg[crs_col(A, j)] != FREE) {
+                all_free = 0;
+            }
+        }
+        if (!all_free) continue;
+        agg[i] = num_agg;
+        for (size_t j = A->row_ptr[i]; j < A->row_ptr[i + 1]; ++j) {
+            if (strong[j]) {
+                agg[crs_col(A, j)] = num_agg;
+            }
+        }
+        num_agg++;
+    }
+
+    // Pass 2: free nodes join the aggregate of their strongest neighbour from pass 1
+    memcpy(first_pass, agg, n * sizeof(size_t));
+    for (size_t i = 0; i < n; ++i) {
+        if (agg[i] != FREE) continue;
+        double strongest = 0.0;
+        for (size_t j = A->row_ptr[i]; j < A->row_ptr[i + 1]; ++j) {
+            const size_t c = crs_col(A, j);
+            if (strong[j] && first_pass[c] != FREE && fabs(A->values[j]) > strongest) {
+                strongest = fabs(A->values[j]);
+                agg[i] = first_pass[c];
+            }
+        }
+    }
+
+    // Pass 3: the remaining nodes form aggregates with their free strong neighbours
+    for (size_t i = 0; i < n; ++i) {
+        if (agg[i] != FREE) continue;
+        agg[i] = num_agg;
+        for (size_t j = A->row_ptr[i]; j < A->row_ptr[i + 1]; ++j) {
+            if (strong[j] && agg[crs_col(A, j)] == FREE) {
+                agg[crs_col(A, j)] = num_agg;
+            }
+        }
+        num_agg++;
+    }
+
+    free(first_pass);
+    return num_agg;
+}
+
+/*
+ * Smoothed prolongator P = (I - omega * D_F^(-1) * A_F) * P_tent of the aggregation 'agg'.
+ *
+ * A_F is the filtered matrix: the weak entries of A are dropped, so P stays as sparse as the
+ * strength graph. Without the filter the coarse operators fill in quickly for coefficient
+ * jumps (lumping the weak entries into the diagonal instead was measured to double the PCG
+ * iterations there). Returns 0 on success, -1 on failure.
+ */
+static int amg_prolongator(const CRSMatrix* A, const unsigned char* strong, const size_t* agg, size_t num_agg,
+                           CRSMatrix* P) {
+    const size_t n = A->rows;
+
+    // Filtered matrix: diagonal and strong entries
+    CRSMatrix AF = AMG_EMPTY_MATRIX;
+    double* diag = (double*) malloc(n * sizeof(double));
+    AF.row_ptr = (size_t*) calloc(n + 1, sizeof(size_t));
+    if (!diag || !AF.row_ptr) {
+        free(diag);
+        free_crs_matrix(&AF);
+        return -1;
+    }
+    for (size_t i = 0; i < n; ++i) {
+        size_t count = 1;
+        for (size_t j = A->row_ptr[i]; j < A->row_ptr[i + 1]; ++j) {
+            count += strong[j];
+        }
+        AF.row_ptr[i + 1] = AF.row_ptr[i] + count;
+    }
+    AF.rows = n;
+    AF.cols = n;
+    AF.nnz = AF.row_ptr[n];
+    AF.values = (double*) malloc((AF.nnz + 1) * sizeof(double));
+    AF.col_idx = (size_t*) malloc((AF.nnz + 1) * sizeof(size_t));
+    if (!AF.values || !AF.col_idx) {
+        free(diag);
+        free_crs_matrix(&AF);
+        return -1;
+    }
+    #pragma omp parallel for if (A->nnz >= (size_t) SPARSE_PARALLEL_THRESHOLD)
+    for (long long i = 0; i < (long long) n; ++i) {
+        size_t k = AF.row_ptr[i];
+        size_t k_diag = k;
+        double d = 0.0;
+        for (size_t j = A->row_ptr[i]; j < A->row_ptr[i + 1]; ++j) {
+            const size_t c = crs_col(A, j);
+            if (c == (size_t) i) {
+                k_diag = k;
+                AF.col_idx[k++] = c;
+                d += A->values[j];
+            } else if (strong[j]) {
+                AF.col_idx[k] = c;
+                AF.values[k++] = A->values[j];
+            }
+        }
+        AF.values[k_diag] = d;
+        diag[i] = d;
+    }
+    if (crs_validate(&AF) != 0) {
+        free(diag);
+        free_crs_matrix(&AF);
+        return -1;
+    }
+
+    // Tentative prolongator: one entry per row, 1 / sqrt(|aggregate|)
+    CRSMatrix T = AMG_EMPTY_MATRIX;
+    size_t* agg_size = (size_t*) calloc(num_agg, sizeof(size_t));
+    T.values = (double*) malloc((n + 1) * sizeof(double));
+    T.col_idx = (size_t*) malloc((n + 1) * sizeof(size_t));
+    T.row_ptr = (size_t*) malloc((n + 1) * sizeof(size_t));
+    if (!agg_size || !T.values || !T.col_idx || !T.row_ptr) {
+        free(agg_size);
+        free(diag);
+        free_crs_matrix(&T);
+        free_crs_matrix(&AF);
+        return -1;
+    }
+    T.rows = n;
+    T.cols = num_agg;
+    T.nnz = n;
+    for (size_t i = 0; i < n; ++i) {
+        agg_size[agg[i]]++;
+    }
+    for (size_t i = 0; i < n; ++i) {
+        T.row_ptr[i] = i;
+        T.col_idx[i] = agg[i];
+        T.values[i] = 1.0 / sqrt((double) agg_size[agg[i]]);
+    }
+    T.row_ptr[n] = n;
+    free(agg_size);
+    if (crs_validate(&T) != 0) {
+        free(diag);
+        free_crs_matrix(&T);
+        free_crs_matrix(&AF);
+        return -1;
+    }
+
+    // omega = 4 / (3 * rho(D_F^(-1) * A_F)), rho bounded by the largest absolute row sum
+    double rho = 0.0;
+    #pragma omp parallel for reduction(max:rho) if (AF.nnz >= (size_t) SPARSE_PARALLEL_THRESHOLD)
+    for (long long i = 0; i < (long long) n; ++i) {
+        double row_sum = 0.0;
+        for (size_t j = AF.row_ptr[i]; j < AF.row_ptr[i + 1]; ++j) {
+            row_sum += fabs(AF.values[j]);
+        }
+        row_sum /= fabs(diag[i]);
+        if (row_sum > rho) rho = row_sum;
+    }
+    const double omega = 4.0 / (3.0 * rho);
+
+    // P = T - omega * D_F^(-1) * (A_F * T); the pattern of A_F * T contains the pattern of T
+    int status = crs_mat_mat_mult(&AF, &T, P);
+    if (status == 0) {
+        #pragma omp parallel for if (P->nnz >= (size_t) SPARSE_PARALLEL_THRESHOLD)
+        for (long long i = 0; i < (long long) n; ++i) {
+            const double scale = -omega / diag[i];
+            for (size_t j = P->row_ptr[i]; j < P->row_ptr[i + 1]; ++j) {
+                P->values[j] *= scale;
+                if (crs_col(P, j) == agg[i]) {
+                    P->values[j] += T.values[i];
+                }
+            }
+        }
+    }
+
+    free(diag);
+    free_crs_matrix(&T);
+    free_crs_matrix(&AF);
+    return status;
+}
+
+// Allocates the work vectors and the inverse diagonal of a level
+static int amg_init_level(AMGLevel* L) {
+    const size_t n = L->A->rows;
+    L->inv_diag = (double*) malloc(n * sizeof(double));
+    L->x = (double*) calloc(n, sizeof(double));
+    L->b = (double*) calloc(n, sizeof(double));
+    L->r = (double*) calloc(n, sizeof(double));
+    L->x_old = (double*) calloc(n, sizeof(double));
+    if (!L->inv_diag || !L->x || !L->b || !L->r || !L->x_old) {
+        return -1;
+    }
+    crs_extract_diagonal(L->A, L->inv_diag);
+    for (size_t i = 0; i < n; ++i) {
+        if (L->inv_diag[i] <= 0.0) {
+            fprintf(stderr, "AMG requires a positive diagonal (row %zu).\n", i);
+            return -1;
+        }
+        L->inv_diag[i] = 1.0 / L->inv_diag[i];
+    }
+    return 0;
+}
+
+// Dense LU factor of the coarsest operator (none above AMG_MAX_DIRECT_SIZE rows)
+static int amg_coarse_factorize(AMG* amg) {
+    const CRSMatrix* A = amg->levels[amg->num_levels - 1].A;
+    const size_t n = A->rows;
+    amg->coarse_n = n;
+    if (n > AMG_MAX_DIRECT_SIZE) {
+        return 0;
+    }
+    double* LU = (double*) calloc(n * n, sizeof(double));
+    if (!LU) {
+        return -1;
+    }
+    for (size_t i = 0; i < n; ++i) {
+        for (size_t j = A->row_ptr[i]; j < A->row_ptr[i + 1]; ++j) {
+            LU[i * n + crs_col(A, j)] = A->values[j];
+        }
+    }
+
+    // Doolittle elimination without pivoting (the Galerkin operators keep a dominant diagonal)
+    for (size_t k = 0; k < n; ++k) {
+        const double pivot = LU[k * n + k];
+        if (pivot == 0.0 || !isfinite(pivot)) {
+            free(LU);
+            return -1;
+        }
+        #pragma omp parallel for if (n - k >= (size_t) AMG_COARSEST_SIZE)
+        for (long long i = (long long) k + 1; i < (long long) n; ++i) {
+            double* row = LU + (size_t) i * n;
+            const double l = row[k] / pivot;
+            row[k] = l;
+            if (l != 0.0) {
+                const double* pivot_row = LU + k * n;
+                for (size_t j = k + 1; j < n; ++j) {
+                    row[j] -= l * pivot_row[j];
+                }
+            }
+        }
+    }
+    amg->coarse_lu = LU;
+    return 0;
+}
+
+static void amg_smooth(const AMG* amg, const AMGLevel* L, const double* b, double* x, int forward);
+
+// x = A_c^(-1) * b on the coarsest level (x = 0 on entry)
+static void amg_coarse_solve(const AMG* amg, const double* b, double* x) {
+    if (!amg->coarse_lu) {
+        const AMGLevel* L = &amg->levels[amg->num_levels - 1];
+        for (int s = 0; s < AMG_COARSE_SWEEPS; ++s) {
+            amg_smooth(amg, L, b, x, 1);
+            amg_smooth(amg, L, b, x, 0);
+        }
+        return;
+    }
+    const size_t n = amg->coarse_n;
+    const double* LU = amg->coarse_lu;
+    for (size_t i = 0; i < n; ++i) {
+        double sum = b[i];
+        for (size_t k = 0; k < i; ++k) {
+            sum -= LU[i * n + k] * x[k];
+        }
+        x[i] = sum;
+    }
+    for (size_t i = n; i-- > 0;) {
+        double sum = x[i];
+        for (size_t k = i + 1; k < n; ++k) {
+            sum -= LU[i * n + k] * x[k];
+        }
+        x[i] = sum / LU[i * n + i];
+    }
+}
+
+/*
+ * Hybrid Gauss-Seidel sweep: Gauss-Seidel inside every part of the row partition (forward or
+ * backward), values of the other parts from the start of the sweep. With the multicolour
+ * smoother: one SOR sweep over the colours (backward: in reverse colour order). The Chebyshev
+ * polynomial is the same in both directions.
+ */
+static void amg_smooth(const AMG* amg, const AMGLevel* L, const double* b, double* x, int forward) {
+    const CRSMatrix* A = L->A;
+    if (amg->smoother == AMG_SMOOTHER_MULTICOLOR_SOR) {
+        multicolor_sor_sweep(&L->colors, A, b, x, amg->omega, !forward);
+        return;
+    }
+    if (amg->smoother == AMG_SMOOTHER_CHEBYSHEV) {
+        chebyshev_smooth(&L->cheb, b, x);
+        return;
+    }
+    const size_t n = A->rows;
+    double* x_old = L->x_old;
+
+    #pragma omp parallel if (A->nnz >= (size_t) SPARSE_PARALLEL_THRESHOLD)
+    {
+        #pragma omp for schedule(static)
+        for (long long i = 0; i < (long long) n; ++i) {
+            x_old[i] = x[i];
+        }
+
+        const int num_threads = omp_get_num_threads();
+        for (int part = omp_get_thread_num(); part < A->num_parts; part += num_threads) {
+            CRS_INDEX_CALL(A, crs_rows_gauss_seidel, A->row_part[part], A->row_part[part + 1], forward, b, x_old,
+                           L->inv_diag, x);
+        }
+    }
+}
+
+// V-cycle on level l for A_l * x = b, starting from the current x
+static void amg_cycle(const AMG* amg, int l, const double* b, double* x) {
+    if (l == amg->num_levels - 1) {
+        amg_coarse_solve(amg, b, x);
+        return;
+    }
+    const AMGLevel* F = &amg->levels[l];
+    const AMGLevel* C = &amg->levels[l + 1];
+    const int n = (int) F->A->rows;
+
+    for (int s = 0; s < amg->sweeps; ++s) {
+        amg_smooth(amg, F, b, x, 1);
+    }
+
+    // Coarse-grid correction: x += P * A_c^(-1) * R * (b - A * x)
+    crs_mat_vec_mult(F->A, x, F->r);
+    vec_subtract(b, F->r, F->r, n);
+    crs_mat_vec_mult(&F->R, F->r, C->b);
+    memset(C->x, 0, C->A->rows * sizeof(double));
+    amg_cycle(amg, l + 1, C->b, C->x);
+    crs_mat_vec_mult(&F->P, C->x, F->r);
+    #pragma omp parallel for simd if (n >= PARALLEL_THRESHOLD)
+    for (int i = 0; i < n; ++i) {
+        x[i] += F->r[i];
+    }
+
+    for (int s = 0; s < amg->sweeps; ++s) {
+        amg_smooth(amg, F, b, x, 0);
+    }
+}
+
+/*
+ * Function: amg_setup
+ * -------------------
+ * Builds the smoothed-aggregation hierarchy of A (see the file header) and factors the
+ * coarsest operator.
+ *
+ * Parameters:
+ *   A   - Validated, symmetric positive definite CRS matrix (not copied, must outlive amg)
+ *   amg - Output hierarchy (free with amg_free)
+ *
+ * Returns:
+ *   - 0 on success
+ *   - -1 on invalid input, memory allocation failure or a non positive definite coarse operator
+ */
+int amg_setup(const CRSMatrix* A, AMG* amg) {
+
+    if (!A || !amg || !A->validated || A->rows != A->cols || A->rows == 0) {
+        fprintf(stderr, "Invalid input to amg_setup.\n");
+        return -1;
+    }
+
+    amg->num_levels = 0;
+    amg->sweeps = AMG_SMOOTHING_SWEEPS;
+    amg->smoother = AMG_SMOOTHER_HYBRID_GS;
+    amg->omega = 1.0;
+    amg->coarse_n = 0;
+    amg->coarse_lu = NULL;
+    amg->levels = (AMGLevel*) calloc(AMG_MAX_LEVELS, sizeof(AMGLevel));
+    if (!amg->levels) {
+        fprintf(stderr, "Memory allocation failed in amg_setup.\n");
+        return -1;
+    }
+    for (int l = 0; l < AMG_MAX_LEVELS; ++l) {
+        amg->levels[l].Ac = AMG_EMPTY_MATRIX;
+        amg->levels[l].P = AMG_EMPTY_MATRIX;
+        amg->levels[l].R = AMG_EMPTY_MATRIX;
+    }
+
+    amg->levels[0].A = A;
+    amg->num_levels = 1;
+    if (amg_init_level(&amg->levels[0]) != 0) {
+        fprintf(stderr, "Level setup failed in amg_setup.\n");
+        amg_free(amg);
+        return -1;
+    }
+
+    while (amg->num_levels < AMG_MAX_LEVELS) {
+        AMGLevel* F = &amg->levels[amg->num_levels - 1];
+        const size_t n = F->A->rows;
+        if (n <= AMG_COARSEST_SIZE) {
+            break;
+        }
+
+        // Strength of connection (the level keeps the inverse diagonal) and aggregates
+        const double eps = AMG_STRENGTH_THRESHOLD * pow(0.5, amg->num_levels - 1);
+        double* diag = (double*) malloc(n * sizeof(double));
+        size_t* agg = (size_t*) malloc(n * sizeof(size_t));
+        unsigned char* strong = NULL;
+        size_t num_agg = 0;
+        if (diag && agg) {
+            for (size_t i = 0; i < n; ++i) {
+                diag[i] = 1.0 / F->inv_diag[i];
+            }
+            strong = amg_strength(F->A, diag, eps);
+        }
+        if (strong) {
+            num_agg = amg_aggregate(F->A, strong, agg);
+        }
+        free(diag);
+        if (num_agg == 0) {
+            free(agg);
+            free(strong);
+            fprintf(stderr, "Aggregation failed in amg_setup.\n");
+            amg_free(amg);
+            return -1;
+        }
+        if ((double) num_agg > AMG_MIN_COARSENING * (double) n) {
+            free(agg);
+            free(strong);
+            break;
+        }
+
+        // Smoothed prolongator, restriction and Galerkin operator A_c = R * (A * P)
+        AMGLevel* C = &amg->levels[amg->num_levels];
+        CRSMatrix AP = AMG_EMPTY_MATRIX;
+        int status = amg_prolongator(F->A, strong, agg, num_agg, &F->P);
+        free(agg);
+        free(strong);
+        if (status == 0) status = crs_transpose(&F->P, &F->R);
+        if (status == 0) status = crs_mat_mat_mult(F->A, &F->P, &AP);
+        if (status == 0) status = crs_mat_mat_mult(&F->R, &AP, &C->Ac);
+        free_crs_matrix(&AP);
+        amg->num_levels++;
+        if (status == 0) {
+            C->A = &C->Ac;
+            status = amg_init_level(C);
+        }
+        if (status != 0) {
+            fprintf(stderr, "Level setup failed in amg_setup.\n");
+            amg_free(amg);
+            return -1;
+        }
+    }
+
+    if (amg_coarse_factorize(amg) != 0) {
+        fprintf(stderr, "Coarse-grid factorization failed in amg_setup.\n");
+        amg_free(amg);
+        return -1;
+    }
+    return 0;
+}
+
+/*
+ * Function: amg_apply
+ * -------------------
+ * Applies the AMG preconditioner: one V-cycle for A * z = r starting from z = 0.
+ *
+ * Returns:
+ *   - 0 on success
+ *   - -1 on null pointers
+ */
+int amg_apply(const AMG* amg, const double* r, double* z) {
+    if (!amg || !amg->levels || !r || !z) {
+        fprintf(stderr, "Invalid input to amg_apply.\n");
+        return -1;
+    }
+    memset(z, 0, amg->levels[0].A->rows * sizeof(double));
+    amg_cycle(amg, 0, r, z);
+    return 0;
+}
+
+/*
+ * Function: amg_solve
+ * -------------------
+ * Solves A * x = b with AMG V-cycles (x holds the initial guess): every cycle computes the
+ * residual r = b - A * x, a correction e = M^(-1) * r and updates x += e.
+ *
+ * Returns:
+ *  -0 if converged, 1 otherwise (max iterations reached without convergence), -1 on error
+ */
+int amg_solve(const AMG* amg, const double* b, double* x, int max_iter, double tol) {
+    if (!amg || !amg->levels || !b || !x) {
+        fprintf(stderr, "Invalid input to amg_solve.\n");
+        return -1;
+    }
+    const AMGLevel* F = &amg->levels[0];
+    const int n = (int) F->A->rows;
+
+    for (int iter = 0; iter <= max_iter; ++iter) {
+        crs_mat_vec_mult(F->A, x, F->b);
+        vec_subtract(b, F->b, F->b, n);
+        if (sqrt(dot_product(F->b, F->b, n)) < tol) {
+            printf("AMG converged after %d cycles\n", iter);
+            return 0;
+        }
+        if (iter == max_iter) {
+            break;
+        }
+        memset(F->x, 0, F->A->rows * sizeof(double));
+        amg_cycle(amg, 0, F->b, F->x);
+        #pragma omp parallel for simd if (n >= PARALLEL_THRESHOLD)
+        for (int i = 0; i < n; ++i) {
+            x[i] += F->x[i];
+        }
+    }
+
+    printf("AMG did not converge after %d cycles\n", max_iter);
+    return 1;
+}
+
+/*
+ * Function: amg_set_smoother
+ * --------------------------
+ * Selects the smoother of the V-cycle. AMG_SMOOTHER_MULTICOLOR_SOR colours the operator of every
+ * level once (multicolor_setup) and relaxes with factor omega; AMG_SMOOTHER_CHEBYSHEV sets up
+ * the smoothing polynomial of every level (chebyshev_setup, omega is not used);
+ * AMG_SMOOTHER_HYBRID_GS frees the colourings / polynomials again.
+ *
+ * Returns:
+ *   - 0 on success
+ *   - -1 on invalid input or a failed colouring / estimate (the hierarchy keeps the hybrid smoother)
+ */
+int amg_set_smoother(AMG* amg, AMGSmoother smoother, double omega) {
+    if (!amg || !amg->levels || !(omega > 0.0 && omega < 2.0) ||
+        (smoother != AMG_SMOOTHER_HYBRID_GS && smoother != AMG_SMOOTHER_MULTICOLOR_SOR &&
+         smoother != AMG_SMOOTHER_CHEBYSHEV)) {
+        fprintf(stderr, "Invalid input to amg_set_smoother.\n");
+        return -1;
+    }
+
+    for (int l = 0; l < amg->num_levels; ++l) {
+        multicolor_free(&amg->levels[l].colors);
+        chebyshev_free(&amg->levels[l].cheb);
+    }
+    amg->smoother = AMG_SMOOTHER_HYBRID_GS;
+    amg->omega = 1.0;
+    if (smoother == AMG_SMOOTHER_HYBRID_GS) {
+        return 0;
+    }
+
+    for (int l = 0; l < amg->num_levels; ++l) {
+        AMGLevel* L = &amg->levels[l];
+        int status;
+        if (smoother == AMG_SMOOTHER_MULTICOLOR_SOR) {
+            status = multicolor_setup(L->A, &L->colors);
+        } else {
+            LinearOperator op;
+            status = linear_operator_crs(&op, L->A);
+            if (status == 0) {
+                status = chebyshev_setup(&op, CHEBYSHEV_SMOOTHER_DEGREE, CHEBYSHEV_SMOOTHER, &L->cheb);
+            }
+        }
+        if (status != 0) {
+            for (int m = 0; m < l; ++m) {
+                multicolor_free(&amg->levels[m].colors);
+                chebyshev_free(&amg->levels[m].cheb);
+            }
+            return -1;
+        }
+    }
+    amg->smoother = smoother;
+    amg->omega = omega;
+    return 0;
+}
+
+/*
+ * Function: amg_free
+ * ------------------
+ * Frees the hierarchy (the input matrix is not freed).
+ */
+void amg_free(AMG* amg) {
+    if (!amg) return;
+    if (amg->levels) {
+        for (int l = 0; l < amg->num_levels; ++l) {
+            AMGLevel* L = &amg->levels[l];
+            free_crs_matrix(&L->Ac);
+            free_crs_matrix(&L->P);
+            free_crs_matrix(&L->R);
+            free(L->inv_diag);
+            free(L->x); free(L->b); free(L->r); free(L->x_old);
+            multicolor_free(&L->colors);
+            chebyshev_free(&L->cheb);
+        }
+        free(amg->levels);
+    }
+    free(amg->coarse_lu);
+    amg->levels = NULL;
+    amg->coarse_lu = NULL;
+    amg->num_levels = 0;
+}
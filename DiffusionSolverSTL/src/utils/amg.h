@@ -0,0 +1,79 @@
+// File: amg.h
+
+#ifndef PROJECT_02_FVM_AMG_H
+#define PROJECT_02_FVM_AMG_H
+
+#include <stddef.h>  // for size_t
+#include "matrix_operations/CRSMatrix.h"
+#include "SOR_solver.h"
+#include "chebyshev.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * @enum AMGSmoother
+ * Smoother of the V-cycle: hybrid Gauss-Seidel on the row partition (default), multicolour
+ * SOR (exact Gauss-Seidel / SOR in colour order, independent of the partition), or a Chebyshev
+ * polynomial (matrix products only, no sequential order and no inner products).
+ */
+typedef enum {
+    AMG_SMOOTHER_HYBRID_GS = 0,
+    AMG_SMOOTHER_MULTICOLOR_SOR,
+    AMG_SMOOTHER_CHEBYSHEV
+} AMGSmoother;
+
+/*
+ * @struct AMGLevel
+ * One level of the smoothed-aggregation hierarchy. P prolongates from the next coarser level
+ * to this one (rows x aggregates) and R = P^T; both are empty on the coarsest level.
+ */
+typedef struct {
+    const CRSMatrix* A;           // Level operator (levels[0]: the input matrix, not owned; else &Ac)
+    CRSMatrix Ac;                 // Galerkin operator R * A * P of the finer level (owned, coarse levels)
+    CRSMatrix P;                  // Smoothed prolongator
+    CRSMatrix R;                  // Restriction P^T
+    double* inv_diag;
+    double *x, *b, *r, *x_old;    // Work vectors (correction, right-hand side, residual, smoother snapshot)
+    MulticolorSOR colors;         // Colouring of A (AMG_SMOOTHER_MULTICOLOR_SOR only)
+    Chebyshev cheb;               // Smoothing polynomial of A with its cached bounds (AMG_SMOOTHER_CHEBYSHEV only)
+} AMGLevel;
+
+/*
+ * @struct AMG
+ * Smoothed-aggregation algebraic multigrid hierarchy (see amg.c), built once by 'amg_setup'
+ * and reused for every cycle. The work vectors live in the hierarchy, so one hierarchy must not
+ * be applied by two threads at the same time.
+ */
+typedef struct {
+    int num_levels;
+    AMGLevel* levels;             // levels[0] is the input matrix
+    int sweeps;                   // Smoothing sweeps before and after the coarse-grid correction
+    AMGSmoother smoother;
+    double omega;                 // Relaxation factor of the multicolour smoother
+    size_t coarse_n;              // Size of the coarsest operator
+    double* coarse_lu;            // Dense LU factor of the coarsest operator (row-major, unit lower L)
+} AMG;
+
+// Setup phase: strength of connection, aggregation, smoothed prolongators and Galerkin products.
+// A (validated, symmetric positive definite) must outlive the hierarchy.
+int amg_setup(const CRSMatrix* A, AMG* amg);
+
+// One V-cycle from a zero initial guess, z = M^(-1) * r (symmetric positive definite preconditioner)
+int amg_apply(const AMG* amg, const double* r, double* z);
+
+// Standalone solver: V-cycles until ||b - A * x|| < tol
+int amg_solve(const AMG* amg, const double* b, double* x, int max_iter, double tol);
+
+// Select the smoother (multicolour SOR: colours every level, relaxation factor 0 < omega < 2;
+// Chebyshev: estimates the spectrum of every level, omega is not used)
+int amg_set_smoother(AMG* amg, AMGSmoother smoother, double omega);
+
+void amg_free(AMG* amg);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif //PROJECT_02_FVM_AMG_H
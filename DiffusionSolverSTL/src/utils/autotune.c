@@ -0,0 +1,541 @@
+/*
+ * File: autotune.c
+ * ----------------
+ * This file contains the startup autotuner of the kernel parameters that depend on the host:
+ *  - the OpenMP thread count: the SpMV of a 3D stencil matrix (memory bound) is timed for 1, 2,
+ *    4, ... threads up to the number of processors; the fastest count is kept (fewer threads
+ *    win ties, the memory bandwidth often saturates before all cores are busy). An explicit
+ *    OMP_NUM_THREADS is respected and not searched;
+ *  - the parallel thresholds, one per kernel class in its own unit of work (see linear_algebra.h):
+ *    a representative kernel is timed serially and in parallel for growing sizes, and the
+ *    threshold is the smallest amount of work from which on the parallel version is always
+ *    faster (no size at all: the kernels of the class stay serial):
+ *      PARALLEL_THRESHOLD        - cg_update_solution, in vector entries;
+ *      SPARSE_PARALLEL_THRESHOLD - crs_mat_vec_mult of 3D stencil matrices, in stored entries;
+ *      DENSE_PARALLEL_THRESHOLD  - the dense mat_vec_mult, in matrix entries;
+ *  - MAT_VEC_BLOCK_SIZE: the dense mat_vec_mult is timed for tile sizes 8 ... 256.
+ * Every measurement is the best of AUTOTUNE_TRIALS runs of at least AUTOTUNE_MIN_TIME seconds,
+ * so the whole search takes about a second.
+ *
+ * The result is cached in a profile file, one line per machine:
+ *
+ *     parallel_threshold sparse_threshold dense_threshold block_size num_threads | host
+ *
+ * 'host' is the CPU model and the number of processors, so nodes of different CPU generations
+ * sharing one file (e.g. on a cluster file system) each find their own entry; a machine
+ * without an entry is benchmarked once and its line added. Lines in another format (e.g. the
+ * older "parallel_threshold block_size num_threads | host") are ignored and dropped on the
+ * next save, so those machines are benchmarked again. The file is never rewritten in place:
+ * autotune_save writes a temporary file next to it and renames it over the profile, so a
+ * reader (or a crash) never sees a half-written profile.
+ *
+ * Functions:
+ *  - autotune_init: Load or benchmark the profile of this machine and apply it (startup).
+ *  - autotune_run: Benchmarks the kernels.
+ *  - autotune_load / autotune_save: Profile file access.
+ *  - autotune_apply: Sets the kernel parameters.
+ *  - autotune_host: Identification of this machine.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <omp_llvm.h>
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#include <process.h>
+#else
+#include <unistd.h>
+#endif
+#include "autotune.h"
+#include "matrix_operations/linear_algebra.h"
+#include "matrix_operations/stencil_operator.h"
+
+#define AUTOTUNE_TRIALS 3
+#define AUTOTUNE_MIN_TIME 2e-3
+#define AUTOTUNE_GRID 48                 // SpMV matrix: 7-point stencil of a 48^3 grid (~110k rows)
+#define AUTOTUNE_MIN_VECTOR 128          // Vector sizes of the threshold search (doubling)
+#define AUTOTUNE_MAX_VECTOR (1 << 20)
+#define AUTOTUNE_MIN_SPARSE_GRID 4       // Stencil grids g^3 of the sparse threshold search (g * 5/4)
+#define AUTOTUNE_MIN_DENSE 16            // Dense sizes of the dense threshold search (doubling)
+#define AUTOTUNE_DENSE_SIZE 1024         // Dense matrix of the tile size search
+#define AUTOTUNE_MAX_BLOCK 4096
+
+static const char* AUTOTUNE_HEADER =
+    "# FVM kernel tuning profile: parallel_threshold sparse_threshold dense_threshold block_size num_threads | host\n";
+
+// Operands of the timed kernels
+typedef struct {
+    const CRSMatrix* A;
+    const double* dense;
+    const double* coefficients;  // Stencil coefficients of the AUTOTUNE_GRID^3 matrix
+    double *x, *y, *p, *q;
+    int n;
+} autotune_data;
+
+static void autotune_spmv(autotune_data* d) {
+    crs_mat_vec_mult(d->A, d->x, d->y);
+}
+
+static void autotune_vector(autotune_data* d) {
+    cg_update_solution(1e-12, d->p, d->q, d->x, d->y, d->n);
+}
+
+static void autotune_dense(autotune_data* d) {
+    mat_vec_mult(d->dense, d->x, d->y, d->n);
+}
+
+// Seconds per call of kernel(d): best of AUTOTUNE_TRIALS runs of at least AUTOTUNE_MIN_TIME
+static double autotune_time(void (*kernel)(autotune_data*), autotune_data* d) {
+    double best = 1e300;
+    for (int t = 0; t < AUTOTUNE_TRIALS; ++t) {
+        int calls = 0;
+        const double start = omp_get_wtime();
+        double elapsed;
+        do {
+            kernel(d);
+            calls++;
+            elapsed = omp_get_wtime() - start;
+        } while (elapsed < AUTOTUNE_MIN_TIME);
+        best = (elapsed / calls < best) ? elapsed / calls : best;
+    }
+    return best;
+}
+
+// Thread count with the fastest SpMV (a larger count must be at least 2 % faster)
+static int autotune_threads(autotune_data* d) {
+    const int procs = omp_get_num_procs();
+    int best_threads = 1;
+    double best = 1e300;
+    for (int t = 1;; t = (2 * t < procs) ? 2 * t : procs) {
+        omp_set_num_threads(t);
+        const double time = autotune_time(autotune_spmv, d);
+        if (time < 0.98 * best) {
+            best = time;
+            best_threads = t;
+        }
+        if (t >= procs) {
+            break;
+        }
+    }
+    return best_threads;
+}
+
+// Times kernel(d) serially and in parallel (switched by 'threshold') for 'work' units and
+// updates the search result 'best': the smallest work from which on parallel always won
+static void autotune_compare(void (*kernel)(autotune_data*), autotune_data* d, int* threshold, size_t work,
+                             int* best) {
+    *threshold = INT_MAX;
+    const double serial = autotune_time(kernel, d);
+    *threshold = 0;
+    const double parallel = autotune_time(kernel, d);
+    if (parallel < serial) {
+        if (*best == INT_MAX) {
+            *best = (work < (size_t) INT_MAX) ? (int) work : INT_MAX - 1;
+        }
+    } else {
+        *best = INT_MAX;
+    }
+}
+
+// PARALLEL_THRESHOLD: vector length from which on cg_update_solution is faster in parallel
+static int autotune_vector_threshold(autotune_data* d) {
+    int threshold = INT_MAX;
+    for (int n = AUTOTUNE_MIN_VECTOR; n <= AUTOTUNE_MAX_VECTOR; n *= 2) {
+        d->n = n;
+        autotune_compare(autotune_vector, d, &PARALLEL_THRESHOLD, (size_t) n, &threshold);
+    }
+    return threshold;
+}
+
+// SPARSE_PARALLEL_THRESHOLD: nnz from which on the SpMV of a g^3 stencil matrix is faster in
+// parallel (-1 on a failed matrix setup)
+static int autotune_sparse_threshold(autotune_data* d) {
+    const double* c = d->coefficients;
+    const CRSMatrix* full = d->A;
+    int threshold = INT_MAX;
+    for (int g = AUTOTUNE_MIN_SPARSE_GRID;; g += g / 4) {
+        g = (g < AUTOTUNE_GRID) ? g : AUTOTUNE_GRID;
+        const StencilOperator S = {g, g, g, c, c + g, c + 2 * g, c + 3 * g, c + 4 * g, c + 5 * g, c + 6 * g, 1.0};
+        CRSMatrix A = {NULL, NULL, NULL, 0, 0, 0, NULL, 0, 0, NULL, NULL};
+        if (stencil_to_crs(&S, &A) != 0) {
+            free_crs_matrix(&A);
+            d->A = full;
+            return -1;
+        }
+        d->A = &A;
+        autotune_compare(autotune_spmv, d, &SPARSE_PARALLEL_THRESHOLD, A.nnz, &threshold);
+        free_crs_matrix(&A);
+        if (g == AUTOTUNE_GRID) {
+            break;
+        }
+    }
+    d->A = full;
+    return threshold;
+}
+
+// DENSE_PARALLEL_THRESHOLD: n * n from which on the dense mat_vec_mult is faster in parallel
+static int autotune_dense_threshold(autotune_data* d) {
+    int threshold = INT_MAX;
+    for (int n = AUTOTUNE_MIN_DENSE; n <= AUTOTUNE_DENSE_SIZE; n *= 2) {
+        d->n = n;
+        autotune_compare(autotune_dense, d, &DENSE_PARALLEL_THRESHOLD, (size_t) n * n, &threshold);
+    }
+    return threshold;
+}
+
+// Fastest tile size of the (parallel) dense mat_vec_mult
+static int autotune_block_size(autotune_data* d) {
+    d->n = AUTOTUNE_DENSE_SIZE;
+    DENSE_PARALLEL_THRESHOLD = 0;
+    int best_block = 32;
+    double best = 1e300;
+    for (int block = 8; block <= 256; block *= 2) {
+        MAT_VEC_BLOCK_SIZE = block;
+        const double time = autotune_time(autotune_dense, d);
+        if (time < best) {
+            best = time;
+            best_block = block;
+        }
+    }
+    return best_block;
+}
+
+/*
+ * Function: autotune_run
+ * ----------------------
+ * Benchmarks the kernels on this machine (see the file header) and stores the chosen thread
+ * count, parallel thresholds and tile size in P. The kernel parameters in effect before the
+ * call are restored afterwards; autotune_apply makes the result effective.
+ *
+ * Returns:
+ *   - 0 on success
+ *   - -1 on a null pointer or memory allocation failure
+ */
+int autotune_run(TuningProfile* P) {
+
+    if (!P) {
+        fprintf(stderr, "Invalid input to autotune_run.\n");
+        return -1;
+    }
+
+    const int g = AUTOTUNE_GRID;
+    const size_t rows = (size_t) g * g * g;
+    const size_t dense_n = AUTOTUNE_DENSE_SIZE;
+    const size_t len = (rows > AUTOTUNE_MAX_VECTOR) ? rows : AUTOTUNE_MAX_VECTOR;
+    double* coefficients = (double*) malloc((6 * g + rows) * sizeof(double));
+    double* dense = (double*) malloc(dense_n * dense_n * sizeof(double));
+    double* vectors = (double*) malloc(4 * len * sizeof(double));
+    CRSMatrix A = {NULL, NULL, NULL, 0, 0, 0, NULL, 0, 0, NULL, NULL};
+    int status = (coefficients && dense && vectors) ? 0 : -1;
+    if (status == 0) {
+        for (size_t i = 0; i < 6 * (size_t) g + rows; ++i) {
+            coefficients[i] = 1.0;
+        }
+        const StencilOperator S = {g, g, g, coefficients, coefficients + g, coefficients + 2 * g,
+                                   coefficients + 3 * g, coefficients + 4 * g, coefficients + 5 * g,
+                                   coefficients + 6 * g, 1.0};
+        status = stencil_to_crs(&S, &A);
+    }
+    if (status != 0) {
+        fprintf(stderr, "Setup failed in autotune_run.\n");
+        free(coefficients);
+        free(dense);
+        free(vectors);
+        free_crs_matrix(&A);
+        return -1;
+    }
+    for (size_t i = 0; i < dense_n * dense_n; ++i) {
+        dense[i] = 1.0 / (double) (1 + i % 97);
+    }
+    for (size_t i = 0; i < 4 * len; ++i) {
+        vectors[i] = 1.0;
+    }
+
+    const int saved_threshold = PARALLEL_THRESHOLD;
+    const int saved_sparse = SPARSE_PARALLEL_THRESHOLD;
+    const int saved_dense = DENSE_PARALLEL_THRESHOLD;
+    const int saved_block = MAT_VEC_BLOCK_SIZE;
+    const int saved_threads = omp_get_max_threads();
+    autotune_data d = {&A, dense, coefficients, vectors, vectors + len, vectors + 2 * len, vectors + 3 * len, 0};
+
+    // Thread count first (unless fixed by OMP_NUM_THREADS); the other searches run with it, the
+    // dense threshold with the chosen tile size
+    SPARSE_PARALLEL_THRESHOLD = 0;
+    const char* env = getenv("OMP_NUM_THREADS");
+    P->num_threads = (env && env[0]) ? 0 : autotune_threads(&d);
+    omp_set_num_threads(P->num_threads > 0 ? P->num_threads : saved_threads);
+    P->parallel_threshold = autotune_vector_threshold(&d);
+    P->sparse_threshold = autotune_sparse_threshold(&d);
+    P->block_size = autotune_block_size(&d);
+    MAT_VEC_BLOCK_SIZE = P->block_size;
+    P->dense_threshold = autotune_dense_threshold(&d);
+    autotune_host(P->host, sizeof(P->host));
+
+    PARALLEL_THRESHOLD = saved_threshold;
+    SPARSE_PARALLEL_THRESHOLD = saved_sparse;
+    DENSE_PARALLEL_THRESHOLD = saved_dense;
+    MAT_VEC_BLOCK_SIZE = saved_block;
+    omp_set_num_threads(saved_threads);
+    free(coefficients);
+    free(dense);
+    free(vectors);
+    free_crs_matrix(&A);
+    return (P->sparse_threshold < 0) ? -1 : 0;
+}
+
+// Process id, part of the temporary file name of autotune_save
+static int autotune_pid(void) {
+#if defined(_WIN32)
+    return _getpid();
+#else
+    return (int) getpid();
+#endif
+}
+
+// Renames 'from' to 'to', replacing 'to' in one step (rename fails on Windows if 'to' exists)
+static int autotune_replace(const char* from, const char* to) {
+#if defined(_WIN32)
+    return MoveFileExA(from, to, MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH) ? 0 : -1;
+#else
+    return (rename(from, to) == 0) ? 0 : -1;
+#endif
+}
+
+// Parameters that autotune_apply accepts
+static int autotune_valid(const TuningProfile* P) {
+    return P->parallel_threshold >= 0 && P->sparse_threshold >= 0 && P->dense_threshold >= 0 &&
+           P->block_size > 0 && P->block_size <= AUTOTUNE_MAX_BLOCK && P->num_threads >= 0;
+}
+
+// Parses a profile line "threshold sparse dense block threads | host"; returns 0 and fills P on success
+static int autotune_parse(const char* line, TuningProfile* P) {
+    int offset = 0;
+    if (line[0] == '#' ||
+        sscanf(line, "%d %d %d %d %d | %n", &P->parallel_threshold, &P->sparse_threshold, &P->dense_threshold,
+               &P->block_size, &P->num_threads, &offset) != 5 ||
+        offset == 0 || !autotune_valid(P)) {
+        return -1;
+    }
+    size_t length = strcspn(line + offset, "\r\n");
+    if (length >= sizeof(P->host)) {
+        length = sizeof(P->host) - 1;
+    }
+    memcpy(P->host, line + offset, length);
+    P->host[length] = '\0';
+    return 0;
+}
+
+/*
+ * Function: autotune_load
+ * -----------------------
+ * Reads the entry of this machine (autotune_host) from the profile file 'path'.
+ *
+ * Returns:
+ *   - 0 on success
+ *   - -1 if the file cannot be read or has no valid entry for this machine
+ */
+int autotune_load(const char* path, TuningProfile* P) {
+
+    if (!path || !P) {
+        fprintf(stderr, "Invalid input to autotune_load.\n");
+        return -1;
+    }
+
+    char host[sizeof(P->host)];
+    autotune_host(host, sizeof(host));
+    FILE* file = fopen(path, "r");
+    if (!file) {
+        return -1;
+    }
+    char line[512];
+    int status = -1;
+    TuningProfile entry;
+    while (fgets(line, sizeof(line), file)) {
+        if (autotune_parse(line, &entry) == 0 && strcmp(entry.host, host) == 0) {
+            *P = entry;
+            status = 0;
+        }
+    }
+    fclose(file);
+    return status;
+}
+
+/*
+ * Function: autotune_save
+ * -----------------------
+ * Writes the entry of P->host to the profile file 'path': the entries of the other machines
+ * are kept, an older entry of the same machine is replaced. The new contents go to a temporary
+ * file "<path>.<process id>.tmp" in the same directory, which is then renamed over 'path', so
+ * the profile is replaced in one step: readers see the old or the new file, never a partial
+ * one, and a failed write leaves the old profile intact. (Two machines saving at the same time
+ * both succeed; the entry of the later rename is kept and the other machine is benchmarked
+ * again on its next start.)
+ *
+ * Returns:
+ *   - 0 on success
+ *   - -1 on invalid input or if the file cannot be written or replaced
+ */
+int autotune_save(const char* path, const TuningProfile* P) {
+
+    if (!path || !P || !autotune_valid(P)) {
+        fprintf(stderr, "Invalid input to autotune_save.\n");
+        return -1;
+    }
+
+    // Entries of the other machines
+    char* others = NULL;
+    size_t others_len = 0;
+    FILE* file = fopen(path, "r");
+    if (file) {
+        char line[512];
+        TuningProfile entry;
+        while (fgets(line, sizeof(line), file)) {
+            if (autotune_parse(line, &entry) != 0 || strcmp(entry.host, P->host) == 0) {
+                continue;
+            }
+            const size_t length = strcspn(line, "\r\n");
+            char* grown = (char*) realloc(others, others_len + length + 2);
+            if (!grown) {
+                free(others);
+                fclose(file);
+                fprintf(stderr, "Memory allocation failed in autotune_save.\n");
+                return -1;
+            }
+            others = grown;
+            memcpy(others + others_len, line, length);
+            others[others_len + length] = '\n';
+            others_len += length + 1;
+        }
+        fclose(file);
+    }
+
+    const size_t tmp_size = strlen(path) + 32;
+    char* tmp = (char*) malloc(tmp_size);
+    file = NULL;
+    if (tmp) {
+        snprintf(tmp, tmp_size, "%s.%d.tmp", path, autotune_pid());
+        file = fopen(tmp, "w");
+    }
+    if (!file) {
+        fprintf(stderr, "Cannot write the tuning profile '%s'.\n", path);
+        free(tmp);
+        free(others);
+        return -1;
+    }
+    fputs(AUTOTUNE_HEADER, file);
+    if (others) {
+        fwrite(others, 1, others_len, file);
+    }
+    fprintf(file, "%d %d %d %d %d | %s\n", P->parallel_threshold, P->sparse_threshold, P->dense_threshold,
+            P->block_size, P->num_threads, P->host);
+    free(others);
+    int status = ferror(file) ? -1 : 0;
+    status = (fclose(file) == 0) ? status : -1;
+    if (status == 0) {
+        status = autotune_replace(tmp, path);
+    }
+    if (status != 0) {
+        fprintf(stderr, "Cannot write the tuning profile '%s'.\n", path);
+        remove(tmp);
+    }
+    free(tmp);
+    return status;
+}
+
+/*
+ * Function: autotune_apply
+ * ------------------------
+ * Sets PARALLEL_THRESHOLD, SPARSE_PARALLEL_THRESHOLD, DENSE_PARALLEL_THRESHOLD,
+ * MAT_VEC_BLOCK_SIZE and (num_threads > 0) the OpenMP thread count of the following parallel
+ * regions. Not thread safe: call before the solvers run.
+ *
+ * Returns:
+ *   - 0 on success
+ *   - -1 on invalid input
+ */
+int autotune_apply(const TuningProfile* P) {
+    if (!P || !autotune_valid(P)) {
+        fprintf(stderr, "Invalid input to autotune_apply.\n");
+        return -1;
+    }
+    PARALLEL_THRESHOLD = P->parallel_threshold;
+    SPARSE_PARALLEL_THRESHOLD = P->sparse_threshold;
+    DENSE_PARALLEL_THRESHOLD = P->dense_threshold;
+    MAT_VEC_BLOCK_SIZE = P->block_size;
+    if (P->num_threads > 0) {
+        omp_set_num_threads(P->num_threads);
+    }
+    return 0;
+}
+
+/*
+ * Function: autotune_host
+ * -----------------------
+ * Writes "<CPU model> x<processors>" to 'host' (the CPU model from /proc/cpuinfo on Linux and
+ * PROCESSOR_IDENTIFIER on Windows, "unknown CPU" otherwise).
+ */
+void autotune_host(char* host, size_t size) {
+    char model[96] = "unknown CPU";
+#if defined(_WIN32)
+    const char* id = getenv("PROCESSOR_IDENTIFIER");
+    if (id && id[0]) {
+        snprintf(model, sizeof(model), "%s", id);
+    }
+#else
+    FILE* file = fopen("/proc/cpuinfo", "r");
+    if (file) {
+        char line[256];
+        while (fgets(line, sizeof(line), file)) {
+            const char* colon = strchr(line, ':');
+            if (strncmp(line, "model name", 10) == 0 && colon) {
+                colon++;
+                while (*colon == ' ' || *colon == '\t') {
+                    colon++;
+                }
+                const size_t length = strcspn(colon, "\r\n");
+                snprintf(model, sizeof(model), "%.*s", (int) length, colon);
+                break;
+            }
+        }
+        fclose(file);
+    }
+#endif
+    snprintf(host, size, "%s x%d", model, omp_get_num_procs());
+}
+
+/*
+ * Function: autotune_init
+ * -----------------------
+ * Startup entry point: loads the entry of this machine from the profile file 'path', or
+ * benchmarks the kernels (autotune_run) and adds the result to the file; then applies it.
+ * A profile that cannot be written is reported but still applied.
+ *
+ * Returns:
+ *   - 0 on success
+ *   - -1 on invalid input or a failed benchmark (the defaults stay in effect)
+ */
+int autotune_init(const char* path) {
+
+    if (!path) {
+        fprintf(stderr, "Invalid input to autotune_init.\n");
+        return -1;
+    }
+
+    TuningProfile P;
+    if (autotune_load(path, &P) == 0) {
+        printf("Kernel tuning profile loaded for '%s'\n", P.host);
+    } else {
+        if (autotune_run(&P) != 0) {
+            return -1;
+        }
+        printf("Kernel tuning profile measured for '%s'\n", P.host);
+        autotune_save(path, &P);
+    }
+    printf("  parallel thresholds %d (vector), %d (sparse), %d (dense), block size %d, threads %d\n",
+           P.parallel_threshold, P.sparse_threshold, P.dense_threshold, P.block_size,
+           P.num_threads > 0 ? P.num_threads : omp_get_max_threads());
+    return autotune_apply(&P);
+}
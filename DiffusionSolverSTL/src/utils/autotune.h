@@ -0,0 +1,47 @@
+#ifndef PROJECT_02_FVM_AUTOTUNE_H
+#define PROJECT_02_FVM_AUTOTUNE_H
+
+#include <stddef.h>  // for size_t
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * @struct TuningProfile
+ * Kernel parameters of one machine (see autotune.c), identified by 'host'.
+ */
+typedef struct {
+    int parallel_threshold;     // PARALLEL_THRESHOLD (vector entries)
+    int sparse_threshold;       // SPARSE_PARALLEL_THRESHOLD (stored entries)
+    int dense_threshold;        // DENSE_PARALLEL_THRESHOLD (matrix entries)
+    int block_size;             // MAT_VEC_BLOCK_SIZE
+    int num_threads;            // OpenMP threads of the kernels (0: keep the OpenMP default)
+    char host[128];             // CPU model and number of processors
+} TuningProfile;
+
+// Load the profile of this machine from 'path' or, if there is none, benchmark the kernels and
+// add the result to 'path'; then apply it. Call once at startup, before any solver runs.
+int autotune_init(const char* path);
+
+// Benchmark the kernels on this machine (applies the thread count while measuring)
+int autotune_run(TuningProfile* P);
+
+// Read the entry of this machine from a profile file (-1 if the file or the entry is missing)
+int autotune_load(const char* path, TuningProfile* P);
+
+// Write the entry of P->host to a profile file, keeping the entries of the other machines; the
+// file is replaced atomically (written to a temporary file, then renamed)
+int autotune_save(const char* path, const TuningProfile* P);
+
+// Set the parallel thresholds, MAT_VEC_BLOCK_SIZE and the OpenMP thread count
+int autotune_apply(const TuningProfile* P);
+
+// Identification of this machine (CPU model and number of processors)
+void autotune_host(char* host, size_t size);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif //PROJECT_02_FVM_AUTOTUNE_H
@@ -0,0 +1,219 @@
+/*
+ * File: block_PCG_solver.c
+ * ------------------------
+ * This file contains PCG for many right-hand sides of the same CRS matrix (parameter studies:
+ * one operator, many boundary or source configurations).
+ *
+ * Solving the right-hand sides one after the other streams the matrix from memory once per
+ * iteration and right-hand side, and the SpMV is the memory-bound part of PCG. Here the k
+ * systems advance together: every iteration computes W = A * Z for all active right-hand sides
+ * with one multi-vector SpMV (crs_mat_vec_mult_block), which reads A once for the whole block.
+ *
+ * Every column keeps its own CG scalars (alpha, beta, dot(r, z)), so it converges exactly like
+ * pcg_solver_precond on that right-hand side; the columns only share the matrix traffic. A
+ * column that meets the tolerance is frozen and swapped behind the active ones, so the SpMV
+ * width shrinks as the right-hand sides converge.
+ *
+ * The vector work of a column uses the same kernels as PCG (cg_update_direction,
+ * cg_update_solution(_jacobi)); the preconditioner is applied column by column.
+ *
+ * Functions:
+ *  - block_pcg_solver_precond: Block solve with a preconditioner handle and a workspace.
+ *  - block_pcg_solver_crs: Builds the preconditioner from its name for one block solve.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "block_PCG_solver.h"
+#include "matrix_operations/linear_algebra.h"
+
+/*
+ * Retires the converged column in slot s: exchanges slot s with the last active slot in the
+ * 'num_blocks' blocks (through the scratch vector tmp), in the per-column scalars and in perm.
+ */
+static void block_retire(double* const* blocks, int num_blocks, double* const* scalars, int* perm, size_t n,
+                         int s, int last, double* tmp) {
+    if (s == last) {
+        return;
+    }
+    for (int b = 0; b < num_blocks; ++b) {
+        double* a = blocks[b] + (size_t) s * n;
+        double* l = blocks[b] + (size_t) last * n;
+        memcpy(tmp, a, n * sizeof(double));
+        memcpy(a, l, n * sizeof(double));
+        memcpy(l, tmp, n * sizeof(double));
+    }
+    for (int v = 0; v < 2; ++v) {
+        const double t = scalars[v][s];
+        scalars[v][s] = scalars[v][last];
+        scalars[v][last] = t;
+    }
+    const int c = perm[s];
+    perm[s] = perm[last];
+    perm[last] = c;
+}
+
+/*
+ * Function: block_pcg_solver_precond
+ * ----------------------------------
+ * Solves A * X = B for the k columns of B with PCG, advancing all columns together.
+ *
+ * Parameters:
+ *   A        - Validated square CRS matrix (symmetric positive definite)
+ *   B        - Right-hand sides, column-major n x k (column c at B + c * n)
+ *   X        - Initial guesses / solutions, same layout
+ *   k        - Number of right-hand sides
+ *   max_iter - Maximum number of iterations (of every column)
+ *   tol      - Convergence tolerance on ||b_c - A * x_c|| of every column
+ *   M        - Preconditioner of A
+ *   ws       - Workspace kept across solves (NULL: allocated for this solve)
+ *
+ * Returns:
+ *  -0 if all columns converged, 1 otherwise (max iterations reached without convergence), -1 on error
+ */
+int block_pcg_solver_precond(const CRSMatrix* A, const double* B, double* X, int k, int max_iter, double tol,
+                             const Preconditioner* M, SolverWorkspace* ws) {
+
+    if (!A || !B || !X || k <= 0 || !A->validated || A->rows != A->cols || !M || !M->apply || M->n != A->rows) {
+        fprintf(stderr, "Invalid input to block_pcg_solver_precond.\n");
+        return -1;
+    }
+
+    const size_t n = A->rows;
+    const int identity = (M->type == PRECONDITIONER_NONE);
+    const double* inv_diag = (M->type == PRECONDITIONER_JACOBI) ? M->inv_diag : NULL;
+
+    // Column-major blocks of k vectors; slot s of a block holds the vector of column perm[s]
+    SolverWorkspace local = SOLVER_WORKSPACE_INIT;
+    SolverWorkspace* W = ws ? ws : &local;
+    const size_t block = (size_t) k * n;
+    const int num_blocks = 4 + !identity;
+    int* perm = (int*) malloc(k * sizeof(int));
+    double* scalars = (double*) malloc(2 * k * sizeof(double));
+    if (!perm || !scalars || workspace_reserve(W, num_blocks * workspace_size(block)) != 0) {
+        fprintf(stderr, "Memory allocation failed in block_pcg_solver_precond.\n");
+        free(perm);
+        free(scalars);
+        workspace_free(&local);
+        return -1;
+    }
+    double* R = workspace_take(W, block);
+    double* Z = identity ? R : workspace_take(W, block);
+    double* P = workspace_take(W, block);
+    double* AP = workspace_take(W, block);
+    double* AZ = workspace_take(W, block);
+    double* r_dot_z = scalars;
+    double* beta = scalars + k;
+
+    // Blocks and scalars that move with a column when it is retired (Z is R without a preconditioner)
+    double* const moving[4] = {R, P, AP, Z};
+    double* const moving_scalars[2] = {r_dot_z, beta};
+    const int num_moving = identity ? 3 : 4;
+
+    // Initial residuals R = B - A * X (one block SpMV); columns that already satisfy the
+    // tolerance (e.g. a zero right-hand side) are retired before the first iteration
+    crs_mat_vec_mult_block(A, X, R, (size_t) k);
+    int active = k;
+    for (int c = 0; c < k; ++c) {
+        perm[c] = c;
+        vec_subtract(B + (size_t) c * n, R + (size_t) c * n, R + (size_t) c * n, (int) n);
+    }
+    for (int s = k - 1; s >= 0; --s) {
+        double* r = R + (size_t) s * n;
+        if (sqrt(dot_product(r, r, (int) n)) < tol) {
+            block_retire(moving, num_moving, moving_scalars, perm, n, s, active - 1, AZ);
+            active--;
+        }
+    }
+    for (int s = 0; s < active; ++s) {
+        double* r = R + (size_t) s * n;
+        if (!identity) {
+            M->apply(M, r, Z + (size_t) s * n);
+        }
+        r_dot_z[s] = dot_product(r, Z + (size_t) s * n, (int) n);
+        beta[s] = 0.0;   // First direction: p = z
+    }
+
+    int iter;
+    for (iter = 0; iter < max_iter && active > 0; ++iter) {
+
+        // A * z of all active columns, reading A once
+        crs_mat_vec_mult_block(A, Z, AZ, (size_t) active);
+
+        for (int s = active - 1; s >= 0; --s) {
+            double* r = R + (size_t) s * n;
+            double* z = Z + (size_t) s * n;
+            double* p = P + (size_t) s * n;
+            double* Ap = AP + (size_t) s * n;
+            double* x = X + (size_t) perm[s] * n;
+
+            // p = z + beta * p, Ap = A * z + beta * Ap, then x, r (and z for Jacobi)
+            const double p_dot_Ap = cg_update_direction(z, AZ + (size_t) s * n, beta[s], p, Ap, (int) n);
+            const double alpha = r_dot_z[s] / p_dot_Ap;
+            double r_dot_z_new = 0.0;
+            double r_dot_r;
+            if (inv_diag) {
+                r_dot_r = cg_update_solution_jacobi(alpha, p, Ap, inv_diag, x, r, z, (int) n, &r_dot_z_new);
+            } else {
+                r_dot_r = cg_update_solution(alpha, p, Ap, x, r, (int) n);
+            }
+
+            if (sqrt(r_dot_r) < tol) {
+                // Converged: move the column behind the active ones (AZ is free as scratch)
+                block_retire(moving, num_moving, moving_scalars, perm, n, s, active - 1, AZ + (size_t) s * n);
+                active--;
+                continue;
+            }
+
+            if (identity) {
+                r_dot_z_new = r_dot_r;
+            } else if (!inv_diag) {
+                M->apply(M, r, z);
+                r_dot_z_new = dot_product(r, z, (int) n);
+            }
+            beta[s] = r_dot_z_new / r_dot_z[s];
+            r_dot_z[s] = r_dot_z_new;
+        }
+    }
+
+    int status = 0;
+    if (active == 0) {
+        printf("Block PCG converged after %d iterations (%d right-hand sides)\n", iter, k);
+    } else {
+        printf("Block PCG did not converge after %d iterations (%d of %d right-hand sides)\n", max_iter, active, k);
+        status = 1;
+    }
+    free(perm);
+    free(scalars);
+    workspace_free(&local);
+    return status;
+}
+
+/*
+ * Function: block_pcg_solver_crs
+ * ------------------------------
+ * Builds the preconditioner 'preconditioner_type' of A once and solves the k right-hand sides
+ * with block_pcg_solver_precond.
+ *
+ * Returns:
+ *  -0 if all columns converged, 1 otherwise (max iterations reached without convergence), -1 on error
+ */
+int block_pcg_solver_crs(const CRSMatrix* A, const double* B, double* X, int k, int max_iter, double tol,
+                         const char* preconditioner_type) {
+
+    if (!A || !preconditioner_type) {
+        fprintf(stderr, "Invalid input to block_pcg_solver_crs.\n");
+        return -1;
+    }
+
+    Preconditioner M;
+    if (preconditioner_crs(&M, A, preconditioner_type) != 0) {
+        return -1;
+    }
+
+    int status = block_pcg_solver_precond(A, B, X, k, max_iter, tol, &M, NULL);
+    preconditioner_free(&M);
+    return status;
+}
@@ -0,0 +1,26 @@
+#ifndef PROJECT_02_FVM_BLOCK_PCG_SOLVER_H
+#define PROJECT_02_FVM_BLOCK_PCG_SOLVER_H
+
+#include "matrix_operations/CRSMatrix.h"
+#include "preconditioner.h"
+#include "solver_workspace.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// PCG for k right-hand sides of one CRS matrix at once (one multi-vector SpMV per iteration).
+// B and X are column-major n x k blocks (right-hand side / solution c at B + c * n, X + c * n);
+// preconditioner "None", "Jacobi", "IncompleteCholesky", "ModifiedIncompleteCholesky" or "AMG"
+int block_pcg_solver_crs(const CRSMatrix* A, const double* B, double* X, int k, int max_iter, double tol,
+                         const char* preconditioner_type);
+
+// Same with a preconditioner handle set up beforehand and a workspace for the work vectors (NULL: temporary)
+int block_pcg_solver_precond(const CRSMatrix* A, const double* B, double* X, int k, int max_iter, double tol,
+                             const Preconditioner* M, SolverWorkspace* ws);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif //PROJECT_02_FVM_BLOCK_PCG_SOLVER_H
@@ -0,0 +1,410 @@
+/*
+ * File: chebyshev.c
+ * -----------------
+ * This file contains the Jacobi-preconditioned Chebyshev iteration, used as a PCG
+ * preconditioner ("Chebyshev", "Chebyshev(k)", see preconditioner.c) and as an AMG smoother
+ * (amg_set_smoother). A degree-k application is
+ *
+ *     z = p(D^(-1) * A) * D^(-1) * r,
+ *
+ * p being the polynomial of degree k - 1 for which the residual polynomial 1 - t * p(t) is
+ * the scaled Chebyshev polynomial of the interval [lower, upper]. It is computed by the
+ * three-term recurrence of the Chebyshev iteration (Saad, Iterative Methods, Alg. 12.1): k - 1
+ * matrix products and fused vector updates, but no inner product, so unlike Jacobi-PCG or
+ * Gauss-Seidel it needs neither global reductions nor a sequential order. The polynomial is
+ * fixed (independent of r) and positive on (0, upper], so the preconditioner is symmetric
+ * positive definite for PCG if upper bounds the spectrum of D^(-1) * A.
+ *
+ * Interval:
+ *  - Preconditioner: [eig_min, CHEBYSHEV_SAFETY * eig_max], the whole estimated spectrum.
+ *  - Smoother: [upper / CHEBYSHEV_SMOOTHER_RATIO, upper], only the high-frequency part that
+ *    the coarse-grid correction cannot remove.
+ *  eig_max is a Ritz value, i.e. a lower bound of the largest eigenvalue, hence the safety
+ *  factor; beyond 'upper' the residual polynomial grows quickly.
+ *
+ * Eigenvalue bounds (cached in the struct, computed once per operator):
+ *  - Lanczos: CHEBYSHEV_LANCZOS_STEPS steps on the symmetric D^(-1/2) * A * D^(-1/2) (same
+ *    spectrum as D^(-1) * A) from a fixed start vector, then the extreme eigenvalues of the
+ *    Lanczos tridiagonal by Sturm bisection. The extreme Ritz values converge first.
+ *  - CG coefficients: the alpha_j / beta_j of a PCG solve define the same tridiagonal
+ *    (T_jj = 1 / alpha_j + beta_j-1 / alpha_j-1, T_j,j+1 = sqrt(beta_j) / alpha_j), so a
+ *    Jacobi-PCG solve of the same operator yields the bounds for free (pcg_solver_record).
+ *
+ * Functions:
+ *  - chebyshev_setup: Inverse diagonal and Lanczos bounds of an operator.
+ *  - chebyshev_set_bounds: Replaces the cached bounds.
+ *  - chebyshev_lanczos_bounds: Extreme eigenvalues of D^(-1) * A by Lanczos.
+ *  - chebyshev_cg_bounds: Extreme eigenvalues of M^(-1) * A from PCG coefficients.
+ *  - chebyshev_apply: Preconditioner, zero initial guess.
+ *  - chebyshev_smooth: Smoother, from the current x.
+ *  - chebyshev_free: Frees the vectors.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "chebyshev.h"
+#include "matrix_operations/linear_algebra.h"
+
+// Enlargement of the largest Ritz value, and the ratio upper / lower of the smoother interval
+#define CHEBYSHEV_SAFETY 1.1
+#define CHEBYSHEV_SMOOTHER_RATIO 4.0
+
+// Bisection steps of the tridiagonal eigenvalues
+#define CHEBYSHEV_BISECTION_STEPS 200
+
+// Number of eigenvalues of the symmetric tridiagonal (diag a, off-diagonal b) below x (Sturm sequence)
+static int tridiagonal_count(const double* a, const double* b, int m, double x) {
+    int count = 0;
+    double q = 1.0;
+    for (int i = 0; i < m; ++i) {
+        q = a[i] - x - ((i > 0) ? b[i - 1] * b[i - 1] / q : 0.0);
+        if (q == 0.0) {
+            q = -1e-300;
+        }
+        count += (q < 0.0);
+    }
+    return count;
+}
+
+// Smallest and largest eigenvalue of the symmetric tridiagonal (diag a, off-diagonal b) by bisection
+static void tridiagonal_extremes(const double* a, const double* b, int m, double* lo, double* hi) {
+    double g_lo = a[0], g_hi = a[0];   // Gershgorin interval
+    for (int i = 0; i < m; ++i) {
+        const double radius = ((i > 0) ? fabs(b[i - 1]) : 0.0) + ((i < m - 1) ? fabs(b[i]) : 0.0);
+        g_lo = fmin(g_lo, a[i] - radius);
+        g_hi = fmax(g_hi, a[i] + radius);
+    }
+
+    // Eigenvalue k (1-based) is the smallest x with count(x) >= k
+    for (int e = 0; e < 2; ++e) {
+        const int k = (e == 0) ? 1 : m;
+        double left = g_lo, right = g_hi;
+        for (int s = 0; s < CHEBYSHEV_BISECTION_STEPS && right - left > 1e-14 * fmax(fabs(left), fabs(right)); ++s) {
+            const double mid = 0.5 * (left + right);
+            if (tridiagonal_count(a, b, m, mid) >= k) {
+                right = mid;
+            } else {
+                left = mid;
+            }
+        }
+        *((e == 0) ? lo : hi) = 0.5 * (left + right);
+    }
+}
+
+/*
+ * Function: chebyshev_lanczos_bounds
+ * ----------------------------------
+ * Estimates the extreme eigenvalues of D^(-1) * A by 'steps' Lanczos steps on
+ * D^(-1/2) * A * D^(-1/2) (see the file header). The start vector is fixed, so the estimate
+ * does not change between runs. Stops early if the Krylov space is invariant (the values are
+ * then exact).
+ *
+ * Parameters:
+ *   A        - Symmetric positive definite operator
+ *   inv_diag - Inverse diagonal of A (positive)
+ *   steps    - Number of Lanczos steps (at most n are used)
+ *
+ * Returns:
+ *   - 0 on success
+ *   - -1 on invalid input, memory allocation failure or a non-positive estimate (A is not
+ *     positive definite)
+ */
+int chebyshev_lanczos_bounds(const LinearOperator* A, const double* inv_diag, int steps,
+                             double* eig_min, double* eig_max) {
+
+    if (!A || !A->apply || !inv_diag || steps <= 0 || !eig_min || !eig_max || A->n == 0) {
+        fprintf(stderr, "Invalid input to chebyshev_lanczos_bounds.\n");
+        return -1;
+    }
+
+    const int n = (int) A->n;
+    if (steps > n) {
+        steps = n;
+    }
+    double* s = (double*) malloc(n * sizeof(double));       // D^(-1/2)
+    double* v_prev = (double*) calloc(n, sizeof(double));
+    double* v = (double*) malloc(n * sizeof(double));
+    double* w = (double*) malloc(n * sizeof(double));
+    double* t = (double*) malloc(n * sizeof(double));
+    double* a = (double*) malloc(steps * sizeof(double));
+    double* b = (double*) malloc(steps * sizeof(double));
+    if (!s || !v_prev || !v || !w || !t || !a || !b) {
+        fprintf(stderr, "Memory allocation failed in chebyshev_lanczos_bounds.\n");
+        free(s); free(v_prev); free(v); free(w); free(t); free(a); free(b);
+        return -1;
+    }
+
+    // Start vector: positive (overlaps the smooth modes) with a fixed rough part (overlaps the rough ones)
+    for (int i = 0; i < n; ++i) {
+        s[i] = sqrt(inv_diag[i]);
+        v[i] = 1.0 + (double) ((i * 7919) % 101) / 101.0;
+    }
+    const double norm = sqrt(dot_product(v, v, n));
+    for (int i = 0; i < n; ++i) {
+        v[i] /= norm;
+    }
+
+    int m = 0;
+    for (int j = 0; j < steps; ++j) {
+        // w = D^(-1/2) * A * D^(-1/2) * v - b_j-1 * v_prev, a_j = dot(w, v), w -= a_j * v
+        #pragma omp parallel for simd if (n >= PARALLEL_THRESHOLD)
+        for (int i = 0; i < n; ++i) {
+            t[i] = s[i] * v[i];
+        }
+        A->apply(A, t, w);
+        #pragma omp parallel for simd if (n >= PARALLEL_THRESHOLD)
+        for (int i = 0; i < n; ++i) {
+            w[i] *= s[i];
+        }
+        a[j] = dot_product(w, v, n);
+        const double b_prev = (j > 0) ? b[j - 1] : 0.0;
+        #pragma omp parallel for simd if (n >= PARALLEL_THRESHOLD)
+        for (int i = 0; i < n; ++i) {
+            w[i] -= a[j] * v[i] + b_prev * v_prev[i];
+        }
+        b[j] = sqrt(dot_product(w, w, n));
+        m = j + 1;
+        if (b[j] <= 1e-12 * fabs(a[j])) {
+            break;   // Invariant subspace
+        }
+
+        // v_prev = v, v = w / b_j
+        double* old = v_prev;
+        v_prev = v;
+        v = w;
+        w = old;
+        #pragma omp parallel for simd if (n >= PARALLEL_THRESHOLD)
+        for (int i = 0; i < n; ++i) {
+            v[i] /= b[j];
+        }
+    }
+
+    tridiagonal_extremes(a, b, m, eig_min, eig_max);
+    free(s); free(v_prev); free(v); free(w); free(t); free(a); free(b);
+
+    if (!(*eig_min > 0.0)) {
+        fprintf(stderr, "Lanczos estimate in chebyshev_lanczos_bounds is not positive (operator not positive definite).\n");
+        return -1;
+    }
+    return 0;
+}
+
+/*
+ * Function: chebyshev_cg_bounds
+ * -----------------------------
+ * Extreme eigenvalues of M^(-1) * A from the coefficients of a PCG solve (see the file header;
+ * pcg_solver_record stores them). With a Jacobi-preconditioned solve these are the bounds of
+ * D^(-1) * A needed by chebyshev_set_bounds.
+ *
+ * Parameters:
+ *   alpha, beta - Coefficients of iterations 0 .. k - 1 (beta[k - 1] is not used)
+ *   k           - Number of iterations (>= 1)
+ *
+ * Returns:
+ *   - 0 on success
+ *   - -1 on invalid input, memory allocation failure or non-positive coefficients
+ */
+int chebyshev_cg_bounds(const double* alpha, const double* beta, int k, double* eig_min, double* eig_max) {
+
+    if (!alpha || !beta || k <= 0 || !eig_min || !eig_max) {
+        fprintf(stderr, "Invalid input to chebyshev_cg_bounds.\n");
+        return -1;
+    }
+    for (int j = 0; j < k; ++j) {
+        if (!(alpha[j] > 0.0) || (j < k - 1 && !(beta[j] >= 0.0))) {
+            fprintf(stderr, "Invalid input to chebyshev_cg_bounds.\n");
+            return -1;
+        }
+    }
+
+    double* a = (double*) malloc(k * sizeof(double));
+    double* b = (double*) malloc(k * sizeof(double));
+    if (!a || !b) {
+        fprintf(stderr, "Memory allocation failed in chebyshev_cg_bounds.\n");
+        free(a); free(b);
+        return -1;
+    }
+    for (int j = 0; j < k; ++j) {
+        a[j] = 1.0 / alpha[j] + ((j > 0) ? beta[j - 1] / alpha[j - 1] : 0.0);
+        b[j] = (j < k - 1) ? sqrt(beta[j]) / alpha[j] : 0.0;
+    }
+    tridiagonal_extremes(a, b, k, eig_min, eig_max);
+    free(a);
+    free(b);
+    return 0;
+}
+
+/*
+ * Function: chebyshev_set_bounds
+ * ------------------------------
+ * Replaces the cached eigenvalue bounds of D^(-1) * A and recomputes the interval of the
+ * polynomial for the target of C (see the file header).
+ *
+ * Returns:
+ *   - 0 on success
+ *   - -1 on invalid input (bounds must satisfy 0 < eig_min <= eig_max)
+ */
+int chebyshev_set_bounds(Chebyshev* C, double eig_min, double eig_max) {
+    if (!C || !(eig_min > 0.0) || !(eig_max >= eig_min) || !isfinite(eig_max)) {
+        fprintf(stderr, "Invalid input to chebyshev_set_bounds.\n");
+        return -1;
+    }
+    C->eig_min = eig_min;
+    C->eig_max = eig_max;
+    C->upper = CHEBYSHEV_SAFETY * eig_max;
+    C->lower = (C->target == CHEBYSHEV_SMOOTHER) ? C->upper / CHEBYSHEV_SMOOTHER_RATIO : eig_min;
+    return 0;
+}
+
+/*
+ * Function: chebyshev_setup
+ * -------------------------
+ * Binds the operator, computes its inverse diagonal and caches the Lanczos bounds of
+ * D^(-1) * A. Call again after the values of the operator changed.
+ *
+ * Parameters:
+ *   A      - Symmetric positive definite operator with 'diagonal' (copied, its backend must
+ *            outlive C)
+ *   degree - Matrix products per application (>= 1; 1 is Jacobi scaled by 1 / theta)
+ *   target - Preconditioner or smoother interval
+ *   C      - Output (free with chebyshev_free)
+ *
+ * Returns:
+ *   - 0 on success
+ *   - -1 on invalid input, a non-positive diagonal, memory allocation failure or a failed estimate
+ */
+int chebyshev_setup(const LinearOperator* A, int degree, ChebyshevTarget target, Chebyshev* C) {
+
+    if (!C) {
+        fprintf(stderr, "Invalid input to chebyshev_setup.\n");
+        return -1;
+    }
+    memset(C, 0, sizeof(Chebyshev));
+    if (!A || !A->apply || !A->diagonal || A->n == 0 || degree < 1 ||
+        (target != CHEBYSHEV_PRECONDITIONER && target != CHEBYSHEV_SMOOTHER)) {
+        fprintf(stderr, "Invalid input to chebyshev_setup.\n");
+        return -1;
+    }
+
+    const size_t n = A->n;
+    C->A = *A;
+    C->target = target;
+    C->degree = degree;
+    C->inv_diag = (double*) malloc(n * sizeof(double));
+    C->res = (double*) malloc(n * sizeof(double));
+    C->d = (double*) malloc(n * sizeof(double));
+    if (!C->inv_diag || !C->res || !C->d) {
+        fprintf(stderr, "Memory allocation failed in chebyshev_setup.\n");
+        chebyshev_free(C);
+        return -1;
+    }
+
+    if (A->diagonal(A, C->inv_diag) != 0) {
+        chebyshev_free(C);
+        return -1;
+    }
+    for (size_t i = 0; i < n; ++i) {
+        if (!(C->inv_diag[i] > 0.0)) {
+            fprintf(stderr, "Non-positive diagonal entry in chebyshev_setup.\n");
+            chebyshev_free(C);
+            return -1;
+        }
+        C->inv_diag[i] = 1.0 / C->inv_diag[i];
+    }
+
+    double eig_min, eig_max;
+    if (chebyshev_lanczos_bounds(A, C->inv_diag, CHEBYSHEV_LANCZOS_STEPS, &eig_min, &eig_max) != 0 ||
+        chebyshev_set_bounds(C, eig_min, eig_max) != 0) {
+        chebyshev_free(C);
+        return -1;
+    }
+    return 0;
+}
+
+/*
+ * Chebyshev iteration for A * x = b (Saad, Alg. 12.1 with the Jacobi preconditioner):
+ *
+ *   d_0 = D^(-1) * (b - A * x_0) / theta,  x_1 = x_0 + d_0
+ *   rho_k = 1 / (2 * sigma - rho_k-1),     d_k = rho_k * rho_k-1 * d_k-1 + 2 * rho_k / delta * D^(-1) * (b - A * x_k)
+ *
+ * with theta / delta the centre / half width of the interval, sigma = theta / delta and
+ * rho_0 = 1 / sigma. Each step after the first is one matrix product and one fused sweep.
+ */
+static void chebyshev_iterate(const Chebyshev* C, const double* b, double* x, int zero_guess) {
+    const LinearOperator* A = &C->A;
+    const int n = (int) A->n;
+    const double* inv_diag = C->inv_diag;
+    double* res = C->res;
+    double* d = C->d;
+
+    const double theta = 0.5 * (C->upper + C->lower);
+    const double delta = 0.5 * (C->upper - C->lower);
+    const double sigma = theta / delta;
+    double rho = 1.0 / sigma;
+
+    if (zero_guess) {
+        #pragma omp parallel for simd if (n >= PARALLEL_THRESHOLD)
+        for (int i = 0; i < n; ++i) {
+            d[i] = inv_diag[i] * b[i] / theta;
+            x[i] = d[i];
+        }
+    } else {
+        A->apply(A, x, res);
+        #pragma omp parallel for simd if (n >= PARALLEL_THRESHOLD)
+        for (int i = 0; i < n; ++i) {
+            d[i] = inv_diag[i] * (b[i] - res[i]) / theta;
+            x[i] += d[i];
+        }
+    }
+
+    for (int k = 1; k < C->degree; ++k) {
+        A->apply(A, x, res);
+        const double rho_new = 1.0 / (2.0 * sigma - rho);
+        const double c_d = rho_new * rho;
+        const double c_r = 2.0 * rho_new / delta;
+        #pragma omp parallel for simd if (n >= PARALLEL_THRESHOLD)
+        for (int i = 0; i < n; ++i) {
+            d[i] = c_d * d[i] + c_r * inv_diag[i] * (b[i] - res[i]);
+            x[i] += d[i];
+        }
+        rho = rho_new;
+    }
+}
+
+/*
+ * Function: chebyshev_apply
+ * -------------------------
+ * Preconditioner z = p(D^(-1) * A) * D^(-1) * r: 'degree' Chebyshev steps for A * z = r from
+ * z = 0 (r and z must not overlap).
+ */
+void chebyshev_apply(const Chebyshev* C, const double* r, double* z) {
+    chebyshev_iterate(C, r, z, 1);
+}
+
+/*
+ * Function: chebyshev_smooth
+ * --------------------------
+ * Smoother: 'degree' Chebyshev steps for A * x = b from the current x. The update is a fixed
+ * polynomial in A applied to the residual, so pre- and post-smoothing keep a V-cycle symmetric.
+ */
+void chebyshev_smooth(const Chebyshev* C, const double* b, double* x) {
+    chebyshev_iterate(C, b, x, 0);
+}
+
+/*
+ * Function: chebyshev_free
+ * ------------------------
+ * Frees the vectors (safe on a zero-initialized struct and after a failed setup).
+ */
+void chebyshev_free(Chebyshev* C) {
+    if (!C) return;
+    free(C->inv_diag);
+    free(C->res);
+    free(C->d);
+    C->inv_diag = NULL;
+    C->res = NULL;
+    C->d = NULL;
+    C->degree = 0;
+}
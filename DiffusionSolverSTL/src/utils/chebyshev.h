@@ -0,0 +1,67 @@
+#ifndef PROJECT_02_FVM_CHEBYSHEV_H
+#define PROJECT_02_FVM_CHEBYSHEV_H
+
+#include <stddef.h>  // for size_t
+#include "matrix_operations/linear_operator.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Degree of the "Chebyshev" preconditioner and of the AMG smoother, and the Lanczos steps of the estimate
+#define CHEBYSHEV_DEFAULT_DEGREE 4
+#define CHEBYSHEV_SMOOTHER_DEGREE 2
+#define CHEBYSHEV_LANCZOS_STEPS 10
+
+/*
+ * @enum ChebyshevTarget
+ * Interval of the spectrum of D^(-1) * A damped by the polynomial (see chebyshev.c).
+ */
+typedef enum {
+    CHEBYSHEV_PRECONDITIONER = 0,     // Whole estimated spectrum
+    CHEBYSHEV_SMOOTHER                // Upper part [lambda_max / CHEBYSHEV_SMOOTHER_RATIO, lambda_max]
+} ChebyshevTarget;
+
+/*
+ * @struct Chebyshev
+ * Jacobi-preconditioned Chebyshev polynomial of an operator (see chebyshev.c). The eigenvalue
+ * estimates of D^(-1) * A are cached: 'chebyshev_setup' runs the Lanczos estimate once per
+ * operator, 'chebyshev_set_bounds' replaces them (e.g. by the bounds of an earlier CG solve).
+ * The work vectors live in the struct, so it must not be applied by two threads at the same time.
+ */
+typedef struct {
+    LinearOperator A;             // Copy of the operator wrapper (the backend is not owned)
+    ChebyshevTarget target;
+    int degree;                   // Number of matrix products per application
+    double eig_min, eig_max;      // Cached estimates of the extreme eigenvalues of D^(-1) * A
+    double lower, upper;          // Interval of the polynomial
+    double* inv_diag;
+    double *res, *d;              // Work vectors (residual, update)
+} Chebyshev;
+
+// Inverse diagonal and Lanczos bounds of A (needs 'A->diagonal'; A must outlive C)
+int chebyshev_setup(const LinearOperator* A, int degree, ChebyshevTarget target, Chebyshev* C);
+
+// Replace the cached eigenvalue bounds of D^(-1) * A and recompute the interval
+int chebyshev_set_bounds(Chebyshev* C, double eig_min, double eig_max);
+
+// Extreme eigenvalues of D^(-1) * A from 'steps' Lanczos steps (inv_diag: D^(-1), positive)
+int chebyshev_lanczos_bounds(const LinearOperator* A, const double* inv_diag, int steps,
+                             double* eig_min, double* eig_max);
+
+// Extreme eigenvalues of M^(-1) * A from the first k alpha / beta coefficients of a PCG solve
+int chebyshev_cg_bounds(const double* alpha, const double* beta, int k, double* eig_min, double* eig_max);
+
+// Preconditioner z = p(D^(-1) * A) * D^(-1) * r (no inner products)
+void chebyshev_apply(const Chebyshev* C, const double* r, double* z);
+
+// Smoother x += p(D^(-1) * A) * D^(-1) * (b - A * x) (no inner products)
+void chebyshev_smooth(const Chebyshev* C, const double* b, double* x);
+
+void chebyshev_free(Chebyshev* C);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif //PROJECT_02_FVM_CHEBYSHEV_H
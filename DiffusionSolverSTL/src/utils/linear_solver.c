@@ -0,0 +1,177 @@
+/*
+ * File: linear_solver.c
+ * ---------------------
+ * This file maps the 'Linear_solver_type' configuration parameter onto the Krylov solvers:
+ *  - "PCG":          Preconditioned Conjugate Gradient ('PCG_solver.c')
+ *  - "PipelinedPCG": Pipelined PCG, one synchronization per iteration ('pipelined_PCG_solver.c')
+ *  - "Multigrid" / "MultigridW": Geometric multigrid V / W-cycles as a standalone solver
+ *                    ('multigrid.c', structured grid only)
+ *  - "AMG":          Smoothed-aggregation algebraic multigrid V-cycles as a standalone solver
+ *                    ('amg.c')
+ *  - "BiCGSTAB":     BiCGSTAB for nonsymmetric systems ('nonsymmetric_solvers.c')
+ *  - "GMRES" / "GMRES(m)": Restarted GMRES, restart length m (default GMRES_DEFAULT_RESTART)
+ *                    for nonsymmetric systems ('nonsymmetric_solvers.c')
+ *  - "Gauss-Seidel" / "SOR(w)": Multicolour (red-black on the stencil) Gauss-Seidel / SOR with
+ *                    relaxation factor w as a standalone solver ('SOR_solver.c')
+ *
+ * Functions:
+ *  - linear_solver_crs: Solves a CRS system with the selected method.
+ *  - linear_solver_crs_precond: Same for the Krylov methods, with a preconditioner built beforehand.
+ *  - linear_solver_stencil: Solves a structured-grid (stencil) system with the selected method.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include "linear_solver.h"
+#include "PCG_solver.h"
+#include "pipelined_PCG_solver.h"
+#include "multigrid.h"
+#include "amg.h"
+#include "nonsymmetric_solvers.h"
+#include "SOR_solver.h"
+
+/*
+ * Function: linear_solver_crs
+ * ---------------------------
+ * Solves Ax = b, A in CRS format, with the Krylov method 'solver_type' and the preconditioner
+ * 'preconditioner_type'.
+ *
+ * Returns:
+ *  -0 if converged, 1 otherwise (max iterations reached without convergence), -1 on error
+ *   (including an unknown solver type)
+ */
+int linear_solver_crs(const CRSMatrix* A, const double* b, double* x, int max_iter, double tol,
+                      const char* solver_type, const char* preconditioner_type) {
+
+    if (!solver_type) {
+        fprintf(stderr, "Invalid input to linear_solver_crs.\n");
+        return -1;
+    }
+
+    if (strcmp(solver_type, "PCG") == 0) {
+        return pcg_solver_crs(A, b, x, max_iter, tol, preconditioner_type);
+    }
+    if (strcmp(solver_type, "PipelinedPCG") == 0) {
+        return pipelined_pcg_solver_crs(A, b, x, max_iter, tol, preconditioner_type);
+    }
+    if (strcmp(solver_type, "AMG") == 0) {
+        AMG amg;
+        if (amg_setup(A, &amg) != 0) {
+            return -1;
+        }
+        int status = amg_solve(&amg, b, x, max_iter, tol);
+        amg_free(&amg);
+        return status;
+    }
+    if (strcmp(solver_type, "BiCGSTAB") == 0) {
+        return bicgstab_solver_crs(A, b, x, max_iter, tol, preconditioner_type);
+    }
+    double omega = 1.0;
+    if (sor_parse_type(solver_type, &omega)) {
+        return sor_solver_crs(A, b, x, max_iter, tol, omega);
+    }
+    int restart = 0;
+    int len = 0;
+    if (strcmp(solver_type, "GMRES") == 0 ||
+        (sscanf(solver_type, "GMRES(%d)%n", &restart, &len) == 1 && len > 0 && solver_type[len] == '\0' &&
+         restart > 0)) {
+        return gmres_solver_crs(A, b, x, max_iter, tol, restart, preconditioner_type);
+    }
+
+    fprintf(stderr, "Linear solver type '%s' is not supported.\n", solver_type);
+    return -1;
+}
+
+/*
+ * Function: linear_solver_crs_precond
+ * -----------------------------------
+ * Solves Ax = b, A in CRS format, with the Krylov method 'solver_type' ("PCG", "PipelinedPCG",
+ * "BiCGSTAB", "GMRES" or "GMRES(m)") and a preconditioner handle of A set up beforehand, so
+ * repeated solves (time steps) do not rebuild the preconditioner. The work vectors come from
+ * 'ws' (NULL: allocated for this solve).
+ *
+ * Returns:
+ *  -0 if converged, 1 otherwise (max iterations reached without convergence), -1 on error
+ *   (including an unknown solver type)
+ */
+int linear_solver_crs_precond(const CRSMatrix* A, const double* b, double* x, int max_iter, double tol,
+                              const char* solver_type, const Preconditioner* M, SolverWorkspace* ws) {
+
+    if (!A || !solver_type) {
+        fprintf(stderr, "Invalid input to linear_solver_crs_precond.\n");
+        return -1;
+    }
+
+    if (strcmp(solver_type, "PCG") == 0) {
+        LinearOperator op;
+        if (linear_operator_crs(&op, A) != 0) {
+            return -1;
+        }
+        return pcg_solver_precond(&op, b, x, max_iter, tol, M, ws);
+    }
+    if (strcmp(solver_type, "PipelinedPCG") == 0) {
+        return pipelined_pcg_solver_precond(A, b, x, max_iter, tol, M, ws);
+    }
+    if (strcmp(solver_type, "BiCGSTAB") == 0) {
+        return bicgstab_solver_precond(A, b, x, max_iter, tol, M, ws);
+    }
+    int restart = 0;
+    int len = 0;
+    if (strcmp(solver_type, "GMRES") == 0 ||
+        (sscanf(solver_type, "GMRES(%d)%n", &restart, &len) == 1 && len > 0 && solver_type[len] == '\0' &&
+         restart > 0)) {
+        return gmres_solver_precond(A, b, x, max_iter, tol, restart, M, ws);
+    }
+
+    fprintf(stderr, "Linear solver type '%s' is not supported with a preconditioner handle.\n", solver_type);
+    return -1;
+}
+
+/*
+ * Function: linear_solver_stencil
+ * -------------------------------
+ * Solves Ax = b, A being the matrix-free finite-volume stencil of the structured grid.
+ *  - "PCG" runs on the stencil itself (preconditioners of pcg_solver_stencil, incl. multigrid);
+ *  - "Multigrid" / "MultigridW" iterate V / W-cycles (preconditioner_type is not used);
+ *  - "Gauss-Seidel" / "SOR(w)" run red-black sweeps on the stencil (no preconditioner);
+ *  - the other methods assemble the stencil into CRS format once and call linear_solver_crs.
+ *
+ * Returns:
+ *  -0 if converged, 1 otherwise (max iterations reached without convergence), -1 on error
+ *   (including an unknown solver type)
+ */
+int linear_solver_stencil(const StencilOperator* S, const double* b, double* x, int max_iter, double tol,
+                          const char* solver_type, const char* preconditioner_type) {
+
+    if (!S || !solver_type) {
+        fprintf(stderr, "Invalid input to linear_solver_stencil.\n");
+        return -1;
+    }
+
+    if (strcmp(solver_type, "PCG") == 0) {
+        return pcg_solver_stencil(S, b, x, max_iter, tol, preconditioner_type);
+    }
+
+    const int w_cycle = (strcmp(solver_type, "MultigridW") == 0);
+    if (strcmp(solver_type, "Multigrid") == 0 || w_cycle) {
+        Multigrid mg;
+        if (multigrid_setup(S, w_cycle ? MULTIGRID_W_CYCLE : MULTIGRID_V_CYCLE, &mg) != 0) {
+            return -1;
+        }
+        int status = multigrid_solve(&mg, b, x, max_iter, tol);
+        multigrid_free(&mg);
+        return status;
+    }
+    double omega = 1.0;
+    if (sor_parse_type(solver_type, &omega)) {
+        return sor_solver_stencil(S, b, x, max_iter, tol, omega);
+    }
+
+    CRSMatrix A;
+    if (stencil_to_crs(S, &A) != 0) {
+        return -1;
+    }
+    int status = linear_solver_crs(&A, b, x, max_iter, tol, solver_type, preconditioner_type);
+    free_crs_matrix(&A);
+    return status;
+}
@@ -0,0 +1,31 @@
+#ifndef PROJECT_02_FVM_LINEAR_SOLVER_H
+#define PROJECT_02_FVM_LINEAR_SOLVER_H
+
+#include "matrix_operations/CRSMatrix.h"
+#include "matrix_operations/stencil_operator.h"
+#include "preconditioner.h"
+#include "solver_workspace.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Solve Ax = b with the method named by 'Linear_solver_type' ("PCG", "PipelinedPCG", "AMG", "BiCGSTAB",
+// "GMRES", "GMRES(m)", "Gauss-Seidel" or "SOR(w)")
+int linear_solver_crs(const CRSMatrix* A, const double* b, double* x, int max_iter, double tol,
+                      const char* solver_type, const char* preconditioner_type);
+
+// Same for the Krylov methods ("PCG", "PipelinedPCG", "BiCGSTAB", "GMRES(m)") with a preconditioner
+// handle of A set up beforehand and a workspace (NULL: temporary), both reused across solves
+int linear_solver_crs_precond(const CRSMatrix* A, const double* b, double* x, int max_iter, double tol,
+                              const char* solver_type, const Preconditioner* M, SolverWorkspace* ws);
+
+// Same for the matrix-free grid stencil; also accepts "Multigrid" and "MultigridW" (standalone cycles)
+int linear_solver_stencil(const StencilOperator* S, const double* b, double* x, int max_iter, double tol,
+                          const char* solver_type, const char* preconditioner_type);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif //PROJECT_02_FVM_LINEAR_SOLVER_H
@@ -0,0 +1,794 @@
+/*
+ * File: multigrid.c
+ * -----------------
+ * This file contains the geometric multigrid method for the finite-volume diffusion stencil
+ * (stencil_operator.h), used as a PCG preconditioner or as a standalone solver.
+ *
+ * Hierarchy:
+ *  The grid is coarsened by merging pairs of cells in every direction with more than one cell
+ *  (an odd last cell stays alone), until the grid has at most MULTIGRID_COARSEST_SIZE cells.
+ *  The coarse operator is the finite-volume discretization on the coarse cells:
+ *   - storage coefficients are summed over the merged cells;
+ *   - a face coefficient is scaled by (fine cell-centre distance) / (coarse cell-centre
+ *     distance) and multiplied by the coarse face area (the cell widths wx, wy, wz).
+ *  On a uniform grid this is the rediscretization of the coarse grid, so the iteration count
+ *  stays flat as the mesh is refined.
+ *
+ * Cycle (level l, A_l * x = b):
+ *  - Red-black Gauss-Seidel: the 5-point (7-point) stencil only couples cells of different
+ *    colour ((i + j + k) even / odd), so every half sweep updates one colour in parallel.
+ *    multigrid_set_relaxation turns it into red-black SOR (omega != 1).
+ *  - Restriction: the residual is summed over the merged cells (R = P^T); prolongation adds
+ *    the coarse correction to every merged cell (piecewise constant P).
+ *  - The coarse problem is corrected once (V-cycle) or twice (W-cycle) recursively; the
+ *    coarsest level is solved directly with a banded Cholesky factor computed at setup.
+ *  - The post-smoother runs the colours in reverse order, so the cycle is a symmetric
+ *    positive definite preconditioner for PCG.
+ *
+ * Single precision (multigrid_use_single):
+ *  The cycle is memory bound, so it can run on float work vectors and diagonals (the '32'
+ *  kernels), halving the traffic; the face coefficients, the coarse factor and all sums stay
+ *  in double. multigrid_apply converts r and z at the finest level, and multigrid_solve keeps
+ *  its residual and solution in double, so it is an iterative refinement around float cycles
+ *  and converges to the same tolerance.
+ *
+ * Functions:
+ *  - multigrid_setup: Builds the hierarchy and factors the coarsest operator.
+ *  - multigrid_apply: One cycle from a zero initial guess (preconditioner).
+ *  - multigrid_solve: Multigrid cycles until convergence (standalone solver).
+ *  - multigrid_use_single: Switches the cycles to single precision.
+ *  - multigrid_set_relaxation: Sets the SOR factor of the smoother.
+ *  - multigrid_free: Frees the hierarchy.
+ */
+
+#include "multigrid.h"
+#include "matrix_operations/linear_algebra.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <omp_llvm.h>
+
+#define MULTIGRID_MAX_LEVELS 32
+#define MULTIGRID_COARSEST_SIZE 512
+#define MULTIGRID_SMOOTHING_SWEEPS 2
+
+// Allocates the arrays of a level of nx * ny * nz cells (zero-initialized)
+static int mg_alloc_level(MultigridLevel* L, int nx, int ny, int nz, int has_z) {
+    L->nx = nx;
+    L->ny = ny;
+    L->nz = nz;
+    L->n = (size_t) nx * ny * nz;
+    L->ce = (double*) calloc(nx, sizeof(double));
+    L->cw = (double*) calloc(nx, sizeof(double));
+    L->cn = (double*) calloc(ny, sizeof(double));
+    L->cs = (double*) calloc(ny, sizeof(double));
+    L->cf = has_z ? (double*) calloc(nz, sizeof(double)) : NULL;
+    L->cb = has_z ? (double*) calloc(nz, sizeof(double)) : NULL;
+    L->wx = (double*) calloc(nx, sizeof(double));
+    L->wy = (double*) calloc(ny, sizeof(double));
+    L->wz = (double*) calloc(nz, sizeof(double));
+    L->co = (double*) calloc(L->n, sizeof(double));
+    L->diag = (double*) malloc(L->n * sizeof(double));
+    L->inv_diag = (double*) malloc(L->n * sizeof(double));
+    L->x = (double*) calloc(L->n, sizeof(double));
+    L->b = (double*) calloc(L->n, sizeof(double));
+    L->r = (double*) calloc(L->n, sizeof(double));
+    if (!L->ce || !L->cw || !L->cn || !L->cs || (has_z && (!L->cf || !L->cb)) || !L->wx || !L->wy ||
+        !L->wz || !L->co || !L->diag || !L->inv_diag || !L->x || !L->b || !L->r) {
+        return -1;
+    }
+    return 0;
+}
+
+static void mg_free_level(MultigridLevel* L) {
+    free(L->ce); free(L->cw); free(L->cn); free(L->cs); free(L->cf); free(L->cb);
+    free(L->wx); free(L->wy); free(L->wz);
+    free(L->co); free(L->diag); free(L->inv_diag);
+    free(L->x); free(L->b); free(L->r);
+    free(L->diag32); free(L->inv_diag32);
+    free(L->x32); free(L->b32); free(L->r32);
+    memset(L, 0, sizeof(MultigridLevel));
+}
+
+/*
+ * Coarsens one direction: coarse cell I merges the fine cells 2I and 2I + 1 (if it exists).
+ * A face coefficient is proportional to 1 / (distance of the cell centres), the boundary
+ * faces to 1 / (half the cell width). A direction with one cell is copied.
+ */
+static void mg_coarsen_direction(int nf, const double* wf, const double* ce_f, const double* cw_f,
+                                 int nc, double* wc, double* ce_c, double* cw_c) {
+    if (nc == nf) {
+        memcpy(wc, wf, nf * sizeof(double));
+        memcpy(ce_c, ce_f, nf * sizeof(double));
+        memcpy(cw_c, cw_f, nf * sizeof(double));
+        return;
+    }
+    for (int I = 0; I < nc; ++I) {
+        wc[I] = wf[2 * I] + (2 * I + 1 < nf ? wf[2 * I + 1] : 0.0);
+    }
+    for (int I = 0; I < nc; ++I) {
+        const int first = 2 * I;
+        const int last = (2 * I + 1 < nf) ? 2 * I + 1 : 2 * I;
+        cw_c[I] = (I == 0) ? cw_f[0] * wf[0] / wc[0]
+                           : cw_f[first] * (wf[first - 1] + wf[first]) / (wc[I - 1] + wc[I]);
+        ce_c[I] = (I == nc - 1) ? ce_f[last] * wf[last] / wc[I]
+                                : ce_f[last] * (wf[last] + wf[last + 1]) / (wc[I] + wc[I + 1]);
+    }
+}
+
+// theta-free sum of the neighbour couplings times x (sum over the interior neighbours of c_nb * x_nb)
+static inline double mg_neighbours(const MultigridLevel* L, int has_z, const double* x, size_t p,
+                                   int i, int j, int k) {
+    const int nx = L->nx, ny = L->ny, nz = L->nz;
+    const size_t plane = (size_t) nx * ny;
+    double sum = 0.0;
+
+    const double w_yz = L->wy[j] * L->wz[k];
+    if (i > 0)      sum += L->cw[i] * w_yz * x[p - 1];
+    if (i + 1 < nx) sum += L->ce[i] * w_yz * x[p + 1];
+
+    const double w_xz = L->wx[i] * L->wz[k];
+    if (j > 0)      sum += L->cs[j] * w_xz * x[p - nx];
+    if (j + 1 < ny) sum += L->cn[j] * w_xz * x[p + nx];
+
+    if (has_z) {
+        const double w_xy = L->wx[i] * L->wy[j];
+        if (k > 0)      sum += L->cb[k] * w_xy * x[p - plane];
+        if (k + 1 < nz) sum += L->cf[k] * w_xy * x[p + plane];
+    }
+    return sum;
+}
+
+// Diagonal of the level operator (boundary faces included)
+static void mg_level_diagonal(MultigridLevel* L, double theta, int has_z) {
+    const long long num_rows = (long long) L->ny * L->nz;
+    #pragma omp parallel for schedule(static) if (L->n >= (size_t) PARALLEL_THRESHOLD)
+    for (long long row = 0; row < num_rows; ++row) {
+        const int j = (int) (row % L->ny);
+        const int k = (int) (row / L->ny);
+        for (int i = 0; i < L->nx; ++i) {
+            const size_t p = (size_t) row * L->nx + i;
+            double d = (L->ce[i] + L->cw[i]) * L->wy[j] * L->wz[k] + (L->cn[j] + L->cs[j]) * L->wx[i] * L->wz[k];
+            if (has_z) {
+                d += (L->cf[k] + L->cb[k]) * L->wx[i] * L->wy[j];
+            }
+            L->diag[p] = L->co[p] + theta * d;
+            L->inv_diag[p] = 1.0 / L->diag[p];
+        }
+    }
+}
+
+// Builds the coarse level C of the level F
+static int mg_coarsen_level(const MultigridLevel* F, MultigridLevel* C, int has_z) {
+    const int nx = (F->nx > 1) ? (F->nx + 1) / 2 : 1;
+    const int ny = (F->ny > 1) ? (F->ny + 1) / 2 : 1;
+    const int nz = (F->nz > 1) ? (F->nz + 1) / 2 : 1;
+    if (mg_alloc_level(C, nx, ny, nz, has_z) != 0) {
+        return -1;
+    }
+
+    mg_coarsen_direction(F->nx, F->wx, F->ce, F->cw, nx, C->wx, C->ce, C->cw);
+    mg_coarsen_direction(F->ny, F->wy, F->cn, F->cs, ny, C->wy, C->cn, C->cs);
+    if (has_z) {
+        mg_coarsen_direction(F->nz, F->wz, F->cf, F->cb, nz, C->wz, C->cf, C->cb);
+    } else {
+        C->wz[0] = F->wz[0];
+    }
+
+    // Storage coefficients are summed over the merged cells
+    for (int k = 0; k < F->nz; ++k) {
+        const int K = (nz < F->nz) ? k / 2 : k;
+        for (int j = 0; j < F->ny; ++j) {
+            const int J = (ny < F->ny) ? j / 2 : j;
+            for (int i = 0; i < F->nx; ++i) {
+                const int I = (nx < F->nx) ? i / 2 : i;
+                C->co[((size_t) K * ny + J) * nx + I] += F->co[((size_t) k * F->ny + j) * F->nx + i];
+            }
+        }
+    }
+    return 0;
+}
+
+/*
+ * Banded Cholesky factor of the coarsest operator. Row p couples to p - 1, p - nx and
+ * p - nx * ny, so the half bandwidth is nx * ny (3D), nx (2D) or 1 (a single line of cells).
+ * L(i, j) is stored at chol[i * (band + 1) + j - i + band].
+ */
+static int mg_coarse_factorize(Multigrid* mg) {
+    const MultigridLevel* L = &mg->levels[mg->num_levels - 1];
+    const size_t n = L->n;
+    const size_t plane = (size_t) L->nx * L->ny;
+    const size_t band = (L->nz > 1) ? plane : (L->ny > 1 ? (size_t) L->nx : 1);
+    const size_t width = band + 1;
+
+    double* chol = (double*) calloc(n * width, sizeof(double));
+    if (!chol) {
+        return -1;
+    }
+
+    // Lower triangle of the operator
+    for (int k = 0; k < L->nz; ++k) {
+        for (int j = 0; j < L->ny; ++j) {
+            for (int i = 0; i < L->nx; ++i) {
+                const size_t p = ((size_t) k * L->ny + j) * L->nx + i;
+                double* row = chol + p * width + band - p;   // row[q] = A(p, q)
+                row[p] = L->diag[p];
+                if (i > 0) row[p - 1] = -mg->theta * L->cw[i] * L->wy[j] * L->wz[k];
+                if (j > 0) row[p - L->nx] = -mg->theta * L->cs[j] * L->wx[i] * L->wz[k];
+                if (k > 0) row[p - plane] = -mg->theta * L->cb[k] * L->wx[i] * L->wy[j];
+            }
+        }
+    }
+
+    // Row-wise Cholesky inside the band
+    for (size_t i = 0; i < n; ++i) {
+        const size_t j0 = (i > band) ? i - band : 0;
+        double* Li = chol + i * width + band - i;
+        for (size_t j = j0; j <= i; ++j) {
+            const double* Lj = chol + j * width + band - j;
+            double sum = Li[j];
+            for (size_t k = j0; k < j; ++k) {
+                sum -= Li[k] * Lj[k];
+            }
+            if (j == i) {
+                if (sum <= 0.0) {
+                    free(chol);
+                    return -1;
+                }
+                Li[i] = sqrt(sum);
+            } else {
+                Li[j] = sum / Lj[j];
+            }
+        }
+    }
+
+    mg->coarse_band = band;
+    mg->coarse_chol = chol;
+    return 0;
+}
+
+// x = A_c^(-1) * b on the coarsest level (forward and backward banded substitution)
+static void mg_coarse_solve(const Multigrid* mg, const double* b, double* x) {
+    const size_t n = mg->levels[mg->num_levels - 1].n;
+    const size_t band = mg->coarse_band;
+    const size_t width = band + 1;
+    const double* chol = mg->coarse_chol;
+
+    for (size_t i = 0; i < n; ++i) {
+        const double* Li = chol + i * width + band - i;
+        double sum = b[i];
+        for (size_t k = (i > band) ? i - band : 0; k < i; ++k) {
+            sum -= Li[k] * x[k];
+        }
+        x[i] = sum / Li[i];
+    }
+    for (size_t i = n; i-- > 0;) {
+        double sum = x[i];
+        const size_t k_end = (i + band < n) ? i + band : n - 1;
+        for (size_t k = i + 1; k <= k_end; ++k) {
+            sum -= chol[k * width + band - k + i] * x[k];   // L(k, i)
+        }
+        x[i] = sum / chol[i * width + band];
+    }
+}
+
+// One SOR half sweep over the cells of one colour ((i + j + k) % 2 == color); Gauss-Seidel for omega = 1
+static void mg_relax(const Multigrid* mg, const MultigridLevel* L, const double* b, double* x, int color) {
+    const long long num_rows = (long long) L->ny * L->nz;
+    #pragma omp parallel for schedule(static) if (L->n >= (size_t) PARALLEL_THRESHOLD)
+    for (long long row = 0; row < num_rows; ++row) {
+        const int j = (int) (row % L->ny);
+        const int k = (int) (row / L->ny);
+        const size_t base = (size_t) row * L->nx;
+        for (int i = (j + k + color) & 1; i < L->nx; i += 2) {
+            const size_t p = base + i;
+            const double gs = (b[p] + mg->theta * mg_neighbours(L, mg->has_z, x, p, i, j, k)) * L->inv_diag[p];
+            x[p] = gs + (1.0 - mg->omega) * (x[p] - gs);
+        }
+    }
+}
+
+// r = b - A_l * x
+static void mg_residual(const Multigrid* mg, const MultigridLevel* L, const double* b, const double* x, double* r) {
+    const long long num_rows = (long long) L->ny * L->nz;
+    #pragma omp parallel for schedule(static) if (L->n >= (size_t) PARALLEL_THRESHOLD)
+    for (long long row = 0; row < num_rows; ++row) {
+        const int j = (int) (row % L->ny);
+        const int k = (int) (row / L->ny);
+        const size_t base = (size_t) row * L->nx;
+        for (int i = 0; i < L->nx; ++i) {
+            const size_t p = base + i;
+            r[p] = b[p] - L->diag[p] * x[p] + mg->theta * mg_neighbours(L, mg->has_z, x, p, i, j, k);
+        }
+    }
+}
+
+// b_c = R * r_f (sum over the merged cells)
+static void mg_restrict(const MultigridLevel* F, const MultigridLevel* C, const double* r, double* b) {
+    const int sx = (C->nx < F->nx) ? 2 : 1;
+    const int sy = (C->ny < F->ny) ? 2 : 1;
+    const int sz = (C->nz < F->nz) ? 2 : 1;
+    const long long num_rows = (long long) C->ny * C->nz;
+    #pragma omp parallel for schedule(static) if (F->n >= (size_t) PARALLEL_THRESHOLD)
+    for (long long row = 0; row < num_rows; ++row) {
+        const int J = (int) (row % C->ny);
+        const int K = (int) (row / C->ny);
+        for (int I = 0; I < C->nx; ++I) {
+            double sum = 0.0;
+            for (int k = K * sz; k < (K + 1) * sz && k < F->nz; ++k) {
+                for (int j = J * sy; j < (J + 1) * sy && j < F->ny; ++j) {
+                    const double* rp = r + ((size_t) k * F->ny + j) * F->nx;
+                    for (int i = I * sx; i < (I + 1) * sx && i < F->nx; ++i) {
+                        sum += rp[i];
+                    }
+                }
+            }
+            b[(size_t) row * C->nx + I] = sum;
+        }
+    }
+}
+
+// x_f += P * x_c (every fine cell receives the correction of its coarse cell)
+static void mg_prolongate_add(const MultigridLevel* F, const MultigridLevel* C, const double* xc, double* x) {
+    const int sx = (C->nx < F->nx) ? 2 : 1;
+    const int sy = (C->ny < F->ny) ? 2 : 1;
+    const int sz = (C->nz < F->nz) ? 2 : 1;
+    const long long num_rows = (long long) F->ny * F->nz;
+    #pragma omp parallel for schedule(static) if (F->n >= (size_t) PARALLEL_THRESHOLD)
+    for (long long row = 0; row < num_rows; ++row) {
+        const int j = (int) (row % F->ny);
+        const int k = (int) (row / F->ny);
+        const double* xcp = xc + ((size_t) (k / sz) * C->ny + j / sy) * C->nx;
+        double* xp = x + (size_t) row * F->nx;
+        for (int i = 0; i < F->nx; ++i) {
+            xp[i] += xcp[i / sx];
+        }
+    }
+}
+
+// Multigrid cycle on level l for A_l * x = b, starting from the current x
+static void mg_cycle(const Multigrid* mg, int l, const double* b, double* x) {
+    if (l == mg->num_levels - 1) {
+        mg_coarse_solve(mg, b, x);
+        return;
+    }
+    const MultigridLevel* F = &mg->levels[l];
+    const MultigridLevel* C = &mg->levels[l + 1];
+
+    // Pre-smoothing (red, black)
+    for (int s = 0; s < mg->sweeps; ++s) {
+        mg_relax(mg, F, b, x, 0);
+        mg_relax(mg, F, b, x, 1);
+    }
+
+    // Coarse-grid correction(s)
+    mg_residual(mg, F, b, x, F->r);
+    mg_restrict(F, C, F->r, C->b);
+    memset(C->x, 0, C->n * sizeof(double));
+    for (int c = 0; c < (int) mg->cycle; ++c) {
+        mg_cycle(mg, l + 1, C->b, C->x);
+    }
+    mg_prolongate_add(F, C, C->x, x);
+
+    // Post-smoothing in reverse colour order (black, red), keeps the cycle symmetric
+    for (int s = 0; s < mg->sweeps; ++s) {
+        mg_relax(mg, F, b, x, 1);
+        mg_relax(mg, F, b, x, 0);
+    }
+}
+
+/*
+ * Single-precision versions of the cycle kernels (multigrid_use_single): the same operations
+ * on the float work vectors and diagonals; coefficients and sums stay in double.
+ */
+static inline double mg_neighbours32(const MultigridLevel* L, int has_z, const float* x, size_t p,
+                                     int i, int j, int k) {
+    const int nx = L->nx, ny = L->ny, nz = L->nz;
+    const size_t plane = (size_t) nx * ny;
+    double sum = 0.0;
+
+    const double w_yz = L->wy[j] * L->wz[k];
+    if (i > 0)      sum += L->cw[i] * w_yz * x[p - 1];
+    if (i + 1 < nx) sum += L->ce[i] * w_yz * x[p + 1];
+
+    const double w_xz = L->wx[i] * L->wz[k];
+    if (j > 0)      sum += L->cs[j] * w_xz * x[p - nx];
+    if (j + 1 < ny) sum += L->cn[j] * w_xz * x[p + nx];
+
+    if (has_z) {
+        const double w_xy = L->wx[i] * L->wy[j];
+        if (k > 0)      sum += L->cb[k] * w_xy * x[p - plane];
+        if (k + 1 < nz) sum += L->cf[k] * w_xy * x[p + plane];
+    }
+    return sum;
+}
+
+static void mg_coarse_solve32(const Multigrid* mg, const float* b, float* x) {
+    const size_t n = mg->levels[mg->num_levels - 1].n;
+    const size_t band = mg->coarse_band;
+    const size_t width = band + 1;
+    const double* chol = mg->coarse_chol;
+
+    for (size_t i = 0; i < n; ++i) {
+        const double* Li = chol + i * width + band - i;
+        double sum = b[i];
+        for (size_t k = (i > band) ? i - band : 0; k < i; ++k) {
+            sum -= Li[k] * x[k];
+        }
+        x[i] = (float) (sum / Li[i]);
+    }
+    for (size_t i = n; i-- > 0;) {
+        double sum = x[i];
+        const size_t k_end = (i + band < n) ? i + band : n - 1;
+        for (size_t k = i + 1; k <= k_end; ++k) {
+            sum -= chol[k * width + band - k + i] * x[k];   // L(k, i)
+        }
+        x[i] = (float) (sum / chol[i * width + band]);
+    }
+}
+
+static void mg_relax32(const Multigrid* mg, const MultigridLevel* L, const float* b, float* x, int color) {
+    const long long num_rows = (long long) L->ny * L->nz;
+    #pragma omp parallel for schedule(static) if (L->n >= (size_t) PARALLEL_THRESHOLD)
+    for (long long row = 0; row < num_rows; ++row) {
+        const int j = (int) (row % L->ny);
+        const int k = (int) (row / L->ny);
+        const size_t base = (size_t) row * L->nx;
+        for (int i = (j + k + color) & 1; i < L->nx; i += 2) {
+            const size_t p = base + i;
+            const double gs = (b[p] + mg->theta * mg_neighbours32(L, mg->has_z, x, p, i, j, k)) * L->inv_diag32[p];
+            x[p] = (float) (gs + (1.0 - mg->omega) * (x[p] - gs));
+        }
+    }
+}
+
+static void mg_residual32(const Multigrid* mg, const MultigridLevel* L, const float* b, const float* x, float* r) {
+    const long long num_rows = (long long) L->ny * L->nz;
+    #pragma omp parallel for schedule(static) if (L->n >= (size_t) PARALLEL_THRESHOLD)
+    for (long long row = 0; row < num_rows; ++row) {
+        const int j = (int) (row % L->ny);
+        const int k = (int) (row / L->ny);
+        const size_t base = (size_t) row * L->nx;
+        for (int i = 0; i < L->nx; ++i) {
+            const size_t p = base + i;
+            r[p] = (float) (b[p] - (double) L->diag32[p] * x[p] + mg->theta * mg_neighbours32(L, mg->has_z, x, p, i, j, k));
+        }
+    }
+}
+
+static void mg_restrict32(const MultigridLevel* F, const MultigridLevel* C, const float* r, float* b) {
+    const int sx = (C->nx < F->nx) ? 2 : 1;
+    const int sy = (C->ny < F->ny) ? 2 : 1;
+    const int sz = (C->nz < F->nz) ? 2 : 1;
+    const long long num_rows = (long long) C->ny * C->nz;
+    #pragma omp parallel for schedule(static) if (F->n >= (size_t) PARALLEL_THRESHOLD)
+    for (long long row = 0; row < num_rows; ++row) {
+        const int J = (int) (row % C->ny);
+        const int K = (int) (row / C->ny);
+        for (int I = 0; I < C->nx; ++I) {
+            double sum = 0.0;
+            for (int k = K * sz; k < (K + 1) * sz && k < F->nz; ++k) {
+                for (int j = J * sy; j < (J + 1) * sy && j < F->ny; ++j) {
+                    const float* rp = r + ((size_t) k * F->ny + j) * F->nx;
+                    for (int i = I * sx; i < (I + 1) * sx && i < F->nx; ++i) {
+                        sum += rp[i];
+                    }
+                }
+            }
+            b[(size_t) row * C->nx + I] = (float) sum;
+        }
+    }
+}
+
+static void mg_prolongate_add32(const MultigridLevel* F, const MultigridLevel* C, const float* xc, float* x) {
+    const int sx = (C->nx < F->nx) ? 2 : 1;
+    const int sy = (C->ny < F->ny) ? 2 : 1;
+    const int sz = (C->nz < F->nz) ? 2 : 1;
+    const long long num_rows = (long long) F->ny * F->nz;
+    #pragma omp parallel for schedule(static) if (F->n >= (size_t) PARALLEL_THRESHOLD)
+    for (long long row = 0; row < num_rows; ++row) {
+        const int j = (int) (row % F->ny);
+        const int k = (int) (row / F->ny);
+        const float* xcp = xc + ((size_t) (k / sz) * C->ny + j / sy) * C->nx;
+        float* xp = x + (size_t) row * F->nx;
+        for (int i = 0; i < F->nx; ++i) {
+            xp[i] += xcp[i / sx];
+        }
+    }
+}
+
+static void mg_cycle32(const Multigrid* mg, int l, const float* b, float* x) {
+    if (l == mg->num_levels - 1) {
+        mg_coarse_solve32(mg, b, x);
+        return;
+    }
+    const MultigridLevel* F = &mg->levels[l];
+    const MultigridLevel* C = &mg->levels[l + 1];
+
+    for (int s = 0; s < mg->sweeps; ++s) {
+        mg_relax32(mg, F, b, x, 0);
+        mg_relax32(mg, F, b, x, 1);
+    }
+
+    mg_residual32(mg, F, b, x, F->r32);
+    mg_restrict32(F, C, F->r32, C->b32);
+    memset(C->x32, 0, C->n * sizeof(float));
+    for (int c = 0; c < (int) mg->cycle; ++c) {
+        mg_cycle32(mg, l + 1, C->b32, C->x32);
+    }
+    mg_prolongate_add32(F, C, C->x32, x);
+
+    for (int s = 0; s < mg->sweeps; ++s) {
+        mg_relax32(mg, F, b, x, 1);
+        mg_relax32(mg, F, b, x, 0);
+    }
+}
+
+/*
+ * Function: multigrid_setup
+ * -------------------------
+ * Builds the multigrid hierarchy of the stencil S: copies the finest grid, coarsens it until
+ * it has at most MULTIGRID_COARSEST_SIZE cells and factors the coarsest operator. The
+ * hierarchy does not reference S.
+ *
+ * Parameters:
+ *   S     - Finite-volume stencil (finest grid)
+ *   cycle - MULTIGRID_V_CYCLE or MULTIGRID_W_CYCLE
+ *   mg    - Output hierarchy (free with multigrid_free)
+ *
+ * Returns:
+ *   - 0 on success
+ *   - -1 on invalid input, memory allocation failure or a non positive definite coarse operator
+ */
+int multigrid_setup(const StencilOperator* S, MultigridCycle cycle, Multigrid* mg) {
+
+    if (!mg || !S || S->nx <= 0 || S->ny <= 0 || S->nz <= 0 || !S->ce || !S->cw || !S->cn || !S->cs ||
+        !S->co || (S->nz > 1 && (!S->cf || !S->cb)) || (cycle != MULTIGRID_V_CYCLE && cycle != MULTIGRID_W_CYCLE)) {
+        fprintf(stderr, "Invalid input to multigrid_setup.\n");
+        return -1;
+    }
+
+    mg->num_levels = 0;
+    mg->theta = S->theta;
+    mg->has_z = (S->nz > 1);
+    mg->cycle = cycle;
+    mg->sweeps = MULTIGRID_SMOOTHING_SWEEPS;
+    mg->omega = 1.0;
+    mg->coarse_band = 0;
+    mg->coarse_chol = NULL;
+    mg->single = 0;
+    mg->levels = (MultigridLevel*) calloc(MULTIGRID_MAX_LEVELS, sizeof(MultigridLevel));
+    if (!mg->levels) {
+        fprintf(stderr, "Memory allocation failed in multigrid_setup.\n");
+        return -1;
+    }
+
+    // Finest level: the stencil itself (unit cell widths)
+    MultigridLevel* F = &mg->levels[0];
+    mg->num_levels = 1;
+    if (mg_alloc_level(F, S->nx, S->ny, S->nz, mg->has_z) != 0) {
+        fprintf(stderr, "Memory allocation failed in multigrid_setup.\n");
+        multigrid_free(mg);
+        return -1;
+    }
+    memcpy(F->ce, S->ce, S->nx * sizeof(double));
+    memcpy(F->cw, S->cw, S->nx * sizeof(double));
+    memcpy(F->cn, S->cn, S->ny * sizeof(double));
+    memcpy(F->cs, S->cs, S->ny * sizeof(double));
+    if (mg->has_z) {
+        memcpy(F->cf, S->cf, S->nz * sizeof(double));
+        memcpy(F->cb, S->cb, S->nz * sizeof(double));
+    }
+    memcpy(F->co, S->co, F->n * sizeof(double));
+    for (int i = 0; i < S->nx; ++i) F->wx[i] = 1.0;
+    for (int j = 0; j < S->ny; ++j) F->wy[j] = 1.0;
+    for (int k = 0; k < S->nz; ++k) F->wz[k] = 1.0;
+    mg_level_diagonal(F, mg->theta, mg->has_z);
+
+    // Coarse levels
+    while (F->n > MULTIGRID_COARSEST_SIZE && mg->num_levels < MULTIGRID_MAX_LEVELS) {
+        MultigridLevel* C = &mg->levels[mg->num_levels];
+        mg->num_levels++;
+        if (mg_coarsen_level(F, C, mg->has_z) != 0) {
+            fprintf(stderr, "Memory allocation failed in multigrid_setup.\n");
+            multigrid_free(mg);
+            return -1;
+        }
+        mg_level_diagonal(C, mg->theta, mg->has_z);
+        F = C;
+    }
+
+    if (mg_coarse_factorize(mg) != 0) {
+        fprintf(stderr, "Coarse-grid factorization failed in multigrid_setup.\n");
+        multigrid_free(mg);
+        return -1;
+    }
+    return 0;
+}
+
+/*
+ * Function: multigrid_apply
+ * -------------------------
+ * Applies the multigrid preconditioner: one cycle for A * z = r starting from z = 0.
+ *
+ * Returns:
+ *   - 0 on success
+ *   - -1 on null pointers
+ */
+int multigrid_apply(const Multigrid* mg, const double* r, double* z) {
+    if (!mg || !mg->levels || !r || !z) {
+        fprintf(stderr, "Invalid input to multigrid_apply.\n");
+        return -1;
+    }
+    const MultigridLevel* F = &mg->levels[0];
+    const long long n = (long long) F->n;
+    if (mg->single) {
+        #pragma omp parallel for simd if (n >= PARALLEL_THRESHOLD)
+        for (long long i = 0; i < n; ++i) {
+            F->b32[i] = (float) r[i];
+            F->x32[i] = 0.0f;
+        }
+        mg_cycle32(mg, 0, F->b32, F->x32);
+        #pragma omp parallel for simd if (n >= PARALLEL_THRESHOLD)
+        for (long long i = 0; i < n; ++i) {
+            z[i] = F->x32[i];
+        }
+        return 0;
+    }
+    memset(z, 0, F->n * sizeof(double));
+    mg_cycle(mg, 0, r, z);
+    return 0;
+}
+
+/*
+ * Function: multigrid_solve
+ * -------------------------
+ * Solves A * x = b with multigrid cycles (x holds the initial guess): every cycle computes
+ * the residual r = b - A * x, a correction e = M^(-1) * r and updates x += e. r and x are
+ * always double, so with single-precision cycles only the corrections are rounded to float.
+ *
+ * Returns:
+ *  -0 if converged, 1 otherwise (max iterations reached without convergence), -1 on error
+ */
+int multigrid_solve(const Multigrid* mg, const double* b, double* x, int max_iter, double tol) {
+    if (!mg || !mg->levels || !b || !x) {
+        fprintf(stderr, "Invalid input to multigrid_solve.\n");
+        return -1;
+    }
+    const MultigridLevel* F = &mg->levels[0];
+    const int n = (int) F->n;
+
+    for (int iter = 0; iter < max_iter; ++iter) {
+        mg_residual(mg, F, b, x, F->b);
+        if (sqrt(dot_product(F->b, F->b, n)) < tol) {
+            printf("Multigrid converged after %d cycles\n", iter);
+            return 0;
+        }
+        if (mg->single) {
+            #pragma omp parallel for simd if (n >= PARALLEL_THRESHOLD)
+            for (int i = 0; i < n; ++i) {
+                F->b32[i] = (float) F->b[i];
+                F->x32[i] = 0.0f;
+            }
+            mg_cycle32(mg, 0, F->b32, F->x32);
+            #pragma omp parallel for simd if (n >= PARALLEL_THRESHOLD)
+            for (int i = 0; i < n; ++i) {
+                x[i] += F->x32[i];
+            }
+            continue;
+        }
+        memset(F->x, 0, F->n * sizeof(double));
+        mg_cycle(mg, 0, F->b, F->x);
+        #pragma omp parallel for simd if (n >= PARALLEL_THRESHOLD)
+        for (int i = 0; i < n; ++i) {
+            x[i] += F->x[i];
+        }
+    }
+
+    mg_residual(mg, F, b, x, F->b);
+    if (sqrt(dot_product(F->b, F->b, n)) < tol) {
+        printf("Multigrid converged after %d cycles\n", max_iter);
+        return 0;
+    }
+    printf("Multigrid did not converge after %d cycles\n", max_iter);
+    return 1;
+}
+
+/*
+ * Function: multigrid_use_single
+ * ------------------------------
+ * Switches the cycles of multigrid_apply and multigrid_solve to single precision: the work
+ * vectors and diagonals of every level are replaced by float copies. The double diagonal and
+ * right-hand side of the finest level are kept for the double residual of multigrid_solve.
+ * Irreversible; multigrid_setup builds a new double hierarchy.
+ *
+ * Returns:
+ *   - 0 on success (also if the hierarchy already is single precision)
+ *   - -1 on null pointers or memory allocation failure (the hierarchy stays in double)
+ */
+int multigrid_use_single(Multigrid* mg) {
+    if (!mg || !mg->levels) {
+        fprintf(stderr, "Invalid input to multigrid_use_single.\n");
+        return -1;
+    }
+    if (mg->single) {
+        return 0;
+    }
+
+    for (int l = 0; l < mg->num_levels; ++l) {
+        MultigridLevel* L = &mg->levels[l];
+        L->diag32 = (float*) malloc(L->n * sizeof(float));
+        L->inv_diag32 = (float*) malloc(L->n * sizeof(float));
+        L->x32 = (float*) calloc(L->n, sizeof(float));
+        L->b32 = (float*) calloc(L->n, sizeof(float));
+        L->r32 = (float*) calloc(L->n, sizeof(float));
+        if (!L->diag32 || !L->inv_diag32 || !L->x32 || !L->b32 || !L->r32) {
+            fprintf(stderr, "Memory allocation failed in multigrid_use_single.\n");
+            for (int m = 0; m <= l; ++m) {
+                MultigridLevel* M = &mg->levels[m];
+                free(M->diag32); free(M->inv_diag32);
+                free(M->x32); free(M->b32); free(M->r32);
+                M->diag32 = M->inv_diag32 = M->x32 = M->b32 = M->r32 = NULL;
+            }
+            return -1;
+        }
+        for (size_t p = 0; p < L->n; ++p) {
+            L->diag32[p] = (float) L->diag[p];
+            L->inv_diag32[p] = (float) L->inv_diag[p];
+        }
+    }
+
+    // The double work vectors are not used any more (level 0 keeps diag and b for multigrid_solve)
+    for (int l = 0; l < mg->num_levels; ++l) {
+        MultigridLevel* L = &mg->levels[l];
+        free(L->inv_diag); free(L->x); free(L->r);
+        L->inv_diag = L->x = L->r = NULL;
+        if (l > 0) {
+            free(L->diag); free(L->b);
+            L->diag = L->b = NULL;
+        }
+    }
+    mg->single = 1;
+    return 0;
+}
+
+/*
+ * Function: multigrid_set_relaxation
+ * ----------------------------------
+ * Sets the relaxation factor of the red-black smoother (1 = Gauss-Seidel, the default of
+ * multigrid_setup). Pre- and post-smoother use the same factor, so the cycle stays symmetric
+ * for every 0 < omega < 2.
+ *
+ * Returns:
+ *   - 0 on success
+ *   - -1 on a null pointer or omega outside (0, 2)
+ */
+int multigrid_set_relaxation(Multigrid* mg, double omega) {
+    if (!mg || !(omega > 0.0 && omega < 2.0)) {
+        fprintf(stderr, "Invalid input to multigrid_set_relaxation.\n");
+        return -1;
+    }
+    mg->omega = omega;
+    return 0;
+}
+
+/*
+ * Function: multigrid_free
+ * ------------------------
+ * Frees the hierarchy.
+ */
+void multigrid_free(Multigrid* mg) {
+    if (!mg) return;
+    if (mg->levels) {
+        for (int l = 0; l < mg->num_levels; ++l) {
+            mg_free_level(&mg->levels[l]);
+        }
+        free(mg->levels);
+    }
+    free(mg->coarse_chol);
+    mg->levels = NULL;
+    mg->coarse_chol = NULL;
+    mg->num_levels = 0;
+    mg->single = 0;
+}
@@ -0,0 +1,82 @@
+// File: multigrid.h
+
+#ifndef PROJECT_02_FVM_MULTIGRID_H
+#define PROJECT_02_FVM_MULTIGRID_H
+
+#include <stddef.h>  // for size_t
+#include "matrix_operations/stencil_operator.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * @enum MultigridCycle
+ * Number of recursive coarse-grid corrections per level: 1 = V-cycle, 2 = W-cycle.
+ */
+typedef enum {
+    MULTIGRID_V_CYCLE = 1,
+    MULTIGRID_W_CYCLE = 2
+} MultigridCycle;
+
+/*
+ * @struct MultigridLevel
+ * One grid of the hierarchy. Cell (i, j, k) of a coarse level aggregates up to 2 x 2 (x 2)
+ * cells of the next finer level. The face coefficients are stored per direction as on the
+ * finest grid; the coupling of two cells through an x-face is theta * ce[i] * wy[j] * wz[k]
+ * (and similarly for y and z), wx / wy / wz being the cell widths in fine-cell units.
+ */
+typedef struct {
+    int nx, ny, nz;
+    size_t n;
+    double *ce, *cw, *cn, *cs, *cf, *cb;   // Face coefficients per unit width (cf, cb NULL for 2D)
+    double *wx, *wy, *wz;                  // Cell widths in fine-cell units
+    double* co;                            // Storage coefficients (sum over the aggregated cells)
+    double* diag;                          // Diagonal of the level operator
+    double* inv_diag;
+    double *x, *b, *r;                     // Work vectors (correction, right-hand side, residual)
+    float *diag32, *inv_diag32;            // Single-precision copies (multigrid_use_single, else NULL)
+    float *x32, *b32, *r32;
+} MultigridLevel;
+
+/*
+ * @struct Multigrid
+ * Geometric multigrid hierarchy of a StencilOperator (see multigrid.c), built once by
+ * 'multigrid_setup' and reused for every cycle. The work vectors live in the hierarchy, so
+ * one hierarchy must not be applied by two threads at the same time.
+ */
+typedef struct {
+    int num_levels;
+    MultigridLevel* levels;                // levels[0] is the finest grid
+    double theta;
+    int has_z;                             // 3D stencil (front/back faces)
+    MultigridCycle cycle;
+    int sweeps;                            // Red-black Gauss-Seidel sweeps before and after the correction
+    double omega;                          // Relaxation factor of the sweeps (1 = Gauss-Seidel, else SOR)
+    size_t coarse_band;                    // Half bandwidth of the coarsest operator
+    double* coarse_chol;                   // Banded Cholesky factor of the coarsest operator
+    int single;                            // Cycles run on the single-precision vectors (multigrid_use_single)
+} Multigrid;
+
+// Build the hierarchy by coarsening the grid of S (S may be freed afterwards)
+int multigrid_setup(const StencilOperator* S, MultigridCycle cycle, Multigrid* mg);
+
+// One cycle from a zero initial guess, z = M^(-1) * r (symmetric positive definite preconditioner)
+int multigrid_apply(const Multigrid* mg, const double* r, double* z);
+
+// Standalone solver: multigrid cycles until ||b - A * x|| < tol
+int multigrid_solve(const Multigrid* mg, const double* b, double* x, int max_iter, double tol);
+
+// Run the cycles in single precision (the outer residual of multigrid_solve stays in double)
+int multigrid_use_single(Multigrid* mg);
+
+// Red-black SOR smoother with relaxation factor 0 < omega < 2 (multigrid_setup: 1, Gauss-Seidel)
+int multigrid_set_relaxation(Multigrid* mg, double omega);
+
+void multigrid_free(Multigrid* mg);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif //PROJECT_02_FVM_MULTIGRID_H
@@ -0,0 +1,539 @@
+/*
+ * File: nonsymmetric_solvers.c
+ * ----------------------------
+ * This file contains the Krylov methods for nonsymmetric CRS systems (e.g. the upwinded
+ * advection-diffusion operators), where PCG does not apply:
+ *
+ * BiCGSTAB (van der Vorst), right-preconditioned, two SpMVs and two preconditioner
+ * applications per iteration, short recurrences (fixed memory):
+ *     p = r + beta * (p - omega * v),   p^ = M^(-1) * p,   v = A * p^,   alpha = rho / (r0, v)
+ *     s = r - alpha * v,                s^ = M^(-1) * s,   t = A * s^,   omega = (t, s) / (t, t)
+ *     x += alpha * p^ + omega * s^,     r = s - omega * t, beta = (rho_new / rho) * (alpha / omega)
+ *  The vector updates and the dot products they feed are fused into single sweeps. When rho,
+ *  (r0, v) or omega vanishes (breakdown), the shadow residual r0 is reset to the current
+ *  residual. The recursive residual only triggers a check of the true residual b - A * x;
+ *  convergence is reported when the true residual satisfies the tolerance, otherwise the
+ *  iteration restarts from it.
+ *
+ * GMRES(m), right-preconditioned, restarted every m iterations:
+ *  - Arnoldi on A * M^(-1): the basis vectors V_0..V_m are stored contiguously, so the
+ *    orthogonalization of w against V_0..V_j is done by two BLAS2-style kernels (classical
+ *    Gram-Schmidt) instead of j + 1 separate dot products and updates (modified Gram-Schmidt):
+ *        h = V^T * w   (one sweep over the rows, all j + 1 dot products per row block)
+ *        w -= V * h    (one sweep, also returns ||w||^2)
+ *  - Reorthogonalization (DGKS criterion): if ||w|| dropped below ||w_in|| / sqrt(2), the two
+ *    kernels are applied once more, which restores the orthogonality lost by classical GS.
+ *  - The Hessenberg matrix is reduced by Givens rotations, which give the residual norm of
+ *    every iteration without forming x. At a restart (or convergence) x += M^(-1) * (V * y).
+ *  - Convergence is only reported when the true residual b - A * x satisfies the tolerance.
+ *
+ * Both solvers take a Preconditioner handle (preconditioner.h), so a preconditioner built once
+ * can serve many solves; the _crs versions build "None", "Jacobi", "IncompleteCholesky",
+ * "ModifiedIncompleteCholesky" or "AMG" for a single solve. Incomplete Cholesky factors the
+ * lower triangle of A, so for a nonsymmetric A it preconditions with the symmetric matrix of
+ * that triangle; its setup fails when that matrix is not positive definite
+ * (strong advection), use Jacobi or AMG there.
+ *
+ * Functions:
+ *  - bicgstab_solver_precond / bicgstab_solver_crs: BiCGSTAB on a CRS matrix.
+ *  - gmres_solver_precond / gmres_solver_crs: GMRES(m) on a CRS matrix.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <omp_llvm.h>
+#include "nonsymmetric_solvers.h"
+#include "matrix_operations/linear_algebra.h"
+#include "preconditioner.h"
+
+// Rows per block of the Gram-Schmidt kernels (the block of w stays in cache for all basis vectors)
+#define GMRES_ROW_BLOCK 512
+
+// Stride (in doubles) of the per-thread partial sums is padded to a multiple of a cache line
+#define GMRES_PARTIAL_ALIGN 8
+
+// Relative size of rho compared to ||r0|| * ||r|| below which BiCGSTAB restarts r0
+#define BICGSTAB_BREAKDOWN 1e-12
+
+// Checks shared by both solvers
+static int krylov_check_input(const CRSMatrix* A, const double* b, const double* x, const Preconditioner* M,
+                              const char* caller) {
+    if (!A || !b || !x || !M || !M->apply || A->rows != A->cols || M->n != A->rows) {
+        fprintf(stderr, "Invalid input to %s.\n", caller);
+        return -1;
+    }
+    if (!A->validated) {
+        fprintf(stderr, "CRS matrix passed to %s must be checked by crs_validate first.\n", caller);
+        return -1;
+    }
+    return 0;
+}
+
+// p = r + beta * (p - omega * v)
+static void bicgstab_direction(const double* r, const double* v, double beta, double omega, double* p, int n) {
+    #pragma omp parallel for simd if (n >= PARALLEL_THRESHOLD)
+    for (int i = 0; i < n; ++i) {
+        p[i] = r[i] + beta * (p[i] - omega * v[i]);
+    }
+}
+
+// s = r - alpha * v, returns dot(s, s)
+static double bicgstab_half_step(const double* r, const double* v, double alpha, double* s, int n) {
+    double s_dot_s = 0.0;
+    #pragma omp parallel for simd reduction(+:s_dot_s) if (n >= PARALLEL_THRESHOLD)
+    for (int i = 0; i < n; ++i) {
+        s[i] = r[i] - alpha * v[i];
+        s_dot_s += s[i] * s[i];
+    }
+    return s_dot_s;
+}
+
+// Returns dot(t, s), and dot(t, t) in 't_dot_t'
+static double bicgstab_omega_dots(const double* t, const double* s, int n, double* t_dot_t) {
+    double ts = 0.0, tt = 0.0;
+    #pragma omp parallel for simd reduction(+:ts, tt) if (n >= PARALLEL_THRESHOLD)
+    for (int i = 0; i < n; ++i) {
+        ts += t[i] * s[i];
+        tt += t[i] * t[i];
+    }
+    *t_dot_t = tt;
+    return ts;
+}
+
+/*
+ * x += alpha * p^ + omega * s^,  r = s - omega * t
+ * returns dot(r, r), and dot(r0, r) (rho of the next iteration) in 'r0_dot_r'
+ */
+static double bicgstab_update_solution(double alpha, const double* p_hat, double omega, const double* s_hat,
+                                       const double* s, const double* t, const double* r0, double* x, double* r,
+                                       int n, double* r0_dot_r) {
+    double rr = 0.0, r0r = 0.0;
+    #pragma omp parallel for simd reduction(+:rr, r0r) if (n >= PARALLEL_THRESHOLD)
+    for (int i = 0; i < n; ++i) {
+        x[i] += alpha * p_hat[i] + omega * s_hat[i];
+        r[i] = s[i] - omega * t[i];
+        rr += r[i] * r[i];
+        r0r += r0[i] * r[i];
+    }
+    *r0_dot_r = r0r;
+    return rr;
+}
+
+// True residual r = b - A * x, returns dot(r, r)
+static double bicgstab_true_residual(const CRSMatrix* A, const double* b, const double* x, double* r, int n) {
+    crs_mat_vec_mult(A, x, r);
+    vec_subtract(b, r, r, n);
+    return dot_product(r, r, n);
+}
+
+/*
+ * Function: bicgstab_solver_precond
+ * ---------------------------------
+ * Solves Ax = b, A (nonsymmetric) in CRS format, with the right-preconditioned BiCGSTAB method.
+ * Parameters:
+ *  - A: Pointer to the CRS matrix (checked once by crs_validate)
+ *  - b: Pointer to vector b (right-hand side)
+ *  - x: Pointer to the initial guess vector x (also stores the solution)
+ *  - max_iter: Maximum number of iterations (two SpMVs each)
+ *  - tol: Convergence tolerance on the true residual ||b - A * x||
+ *  - M: Preconditioner handle of A set up beforehand (see the file header)
+ *  - ws: Workspace kept across solves for the work vectors (NULL: allocated for this solve)
+ *
+ * Returns:
+ *  -0 if converged, 1 otherwise (max iterations reached without convergence), -1 on error
+ */
+int bicgstab_solver_precond(const CRSMatrix* A, const double* b, double* x, int max_iter, double tol,
+                            const Preconditioner* M, SolverWorkspace* ws) {
+
+    if (krylov_check_input(A, b, x, M, "bicgstab_solver_precond") != 0) {
+        return -1;
+    }
+    const int identity = (M->type == PRECONDITIONER_NONE);
+    const int n = (int) A->rows;
+
+    // Work vectors from the workspace (p^ and s^ are p and s without a preconditioner)
+    SolverWorkspace local = SOLVER_WORKSPACE_INIT;
+    SolverWorkspace* W = ws ? ws : &local;
+    if (workspace_reserve(W, (identity ? 6 : 8) * workspace_size((size_t) n)) != 0) {
+        fprintf(stderr, "Memory allocation failed in bicgstab_solver_precond.\n");
+        return -1;
+    }
+    double* r = workspace_take(W, n);
+    double* r0 = workspace_take(W, n);
+    double* p = workspace_take(W, n);
+    double* v = workspace_take(W, n);
+    double* s = workspace_take(W, n);
+    double* t = workspace_take(W, n);
+    double* p_hat = identity ? p : workspace_take(W, n);
+    double* s_hat = identity ? s : workspace_take(W, n);
+    memset(p, 0, n * sizeof(double));
+    memset(v, 0, n * sizeof(double));
+
+    // Initial residual r = b - A * x, shadow residual r0 = r; (r0, r0) only changes at a restart
+    double r_dot_r = bicgstab_true_residual(A, b, x, r, n);
+    memcpy(r0, r, n * sizeof(double));
+    double r0_dot_r0 = r_dot_r;
+    double rho = r_dot_r;
+    double rho_old = 1.0, alpha = 1.0, omega = 1.0;
+
+    int status = (sqrt(r_dot_r) < tol) ? 0 : 1;
+    int restart = 0;
+    int iter = 0;
+    while (status != 0 && iter < max_iter) {
+        ++iter;
+
+        // Breakdown (r0 nearly orthogonal to r, omega = 0 or (r0, v) = 0) or a recursive residual
+        // replaced by the true one: restart the shadow residual
+        const int restarted = restart || omega == 0.0 || fabs(rho) <= BICGSTAB_BREAKDOWN * sqrt(r0_dot_r0 * r_dot_r);
+        if (restarted) {
+            memcpy(r0, r, n * sizeof(double));
+            memset(p, 0, n * sizeof(double));
+            memset(v, 0, n * sizeof(double));
+            r0_dot_r0 = r_dot_r;
+            rho = r_dot_r;
+            rho_old = alpha = omega = 1.0;
+            restart = 0;
+        }
+
+        // p = r + beta * (p - omega * v), v = A * M^(-1) * p
+        const double beta = (rho / rho_old) * (alpha / omega);
+        bicgstab_direction(r, v, beta, omega, p, n);
+        if (!identity) {
+            M->apply(M, p, p_hat);
+        }
+        crs_mat_vec_mult(A, p_hat, v);
+        const double r0_dot_v = dot_product(r0, v, n);
+        if (r0_dot_v == 0.0 || !isfinite(r0_dot_v)) {
+            if (restarted) {
+                fprintf(stderr, "BiCGSTAB breakdown: (r0, A * M^(-1) * r) = 0 right after a restart.\n");
+                break;
+            }
+            restart = 1;
+            continue;
+        }
+        alpha = rho / r0_dot_v;
+
+        // s = r - alpha * v; if s is already small, x += alpha * p^ and check the true residual
+        const double s_dot_s = bicgstab_half_step(r, v, alpha, s, n);
+        if (sqrt(s_dot_s) < tol) {
+            #pragma omp parallel for simd if (n >= PARALLEL_THRESHOLD)
+            for (int i = 0; i < n; ++i) {
+                x[i] += alpha * p_hat[i];
+            }
+            r_dot_r = bicgstab_true_residual(A, b, x, r, n);
+            if (sqrt(r_dot_r) < tol) {
+                status = 0;
+            } else {
+                restart = 1;
+            }
+            continue;
+        }
+
+        // t = A * M^(-1) * s, omega = (t, s) / (t, t)
+        if (!identity) {
+            M->apply(M, s, s_hat);
+        }
+        crs_mat_vec_mult(A, s_hat, t);
+        double t_dot_t;
+        const double t_dot_s = bicgstab_omega_dots(t, s, n, &t_dot_t);
+        omega = (t_dot_t > 0.0) ? t_dot_s / t_dot_t : 0.0;
+
+        // x += alpha * p^ + omega * s^, r = s - omega * t, together with (r, r) and rho
+        rho_old = rho;
+        r_dot_r = bicgstab_update_solution(alpha, p_hat, omega, s_hat, s, t, r0, x, r, n, &rho);
+        if (sqrt(r_dot_r) < tol) {
+            r_dot_r = bicgstab_true_residual(A, b, x, r, n);
+            if (sqrt(r_dot_r) < tol) {
+                status = 0;
+            } else {
+                restart = 1;
+            }
+        }
+    }
+
+    if (status == 0) {
+        printf("BiCGSTAB converged after %d iterations\n", iter);
+    } else {
+        printf("BiCGSTAB did not converge after %d iterations\n", max_iter);
+    }
+    workspace_free(&local);
+    return status;
+}
+
+/*
+ * Classical Gram-Schmidt projection h = V^T * w over the k basis vectors V_0..V_(k-1) (stored
+ * contiguously, length n each); also returns dot(w, w). Every thread sums its row blocks into
+ * its own line of 'partial' and the lines are added in thread order afterwards, so the result
+ * does not depend on timing.
+ */
+static double gmres_project(const double* V, size_t n, int k, const double* w, double* h,
+                            double* partial, size_t stride) {
+    const size_t num_blocks = (n + GMRES_ROW_BLOCK - 1) / GMRES_ROW_BLOCK;
+    int num_threads = 1;
+
+    #pragma omp parallel if (n >= (size_t) PARALLEL_THRESHOLD)
+    {
+        double* local = partial + (size_t) omp_get_thread_num() * stride;
+        for (int q = 0; q <= k; ++q) {
+            local[q] = 0.0;
+        }
+
+        #pragma omp for schedule(static)
+        for (long long blk = 0; blk < (long long) num_blocks; ++blk) {
+            const size_t begin = (size_t) blk * GMRES_ROW_BLOCK;
+            const size_t end = (begin + GMRES_ROW_BLOCK < n) ? begin + GMRES_ROW_BLOCK : n;
+            for (int q = 0; q < k; ++q) {
+                const double* v = V + (size_t) q * n;
+                double sum = 0.0;
+                #pragma omp simd reduction(+:sum)
+                for (size_t i = begin; i < end; ++i) {
+                    sum += v[i] * w[i];
+                }
+                local[q] += sum;
+            }
+            double sum = 0.0;
+            #pragma omp simd reduction(+:sum)
+            for (size_t i = begin; i < end; ++i) {
+                sum += w[i] * w[i];
+            }
+            local[k] += sum;
+        }
+
+        #pragma omp single
+        num_threads = omp_get_num_threads();
+    }
+
+    for (int q = 0; q <= k; ++q) {
+        double sum = 0.0;
+        for (int tid = 0; tid < num_threads; ++tid) {
+            sum += partial[(size_t) tid * stride + q];
+        }
+        if (q < k) {
+            h[q] = sum;
+        } else {
+            return sum;
+        }
+    }
+    return 0.0;
+}
+
+// w += sign * V * c over the k basis vectors, row block by row block; returns dot(w, w)
+static double gmres_update(const double* V, size_t n, int k, const double* c, double sign, double* w) {
+    const size_t num_blocks = (n + GMRES_ROW_BLOCK - 1) / GMRES_ROW_BLOCK;
+    double w_dot_w = 0.0;
+
+    #pragma omp parallel for schedule(static) reduction(+:w_dot_w) if (n >= (size_t) PARALLEL_THRESHOLD)
+    for (long long blk = 0; blk < (long long) num_blocks; ++blk) {
+        const size_t begin = (size_t) blk * GMRES_ROW_BLOCK;
+        const size_t end = (begin + GMRES_ROW_BLOCK < n) ? begin + GMRES_ROW_BLOCK : n;
+        for (int q = 0; q < k; ++q) {
+            const double* v = V + (size_t) q * n;
+            const double coef = sign * c[q];
+            #pragma omp simd
+            for (size_t i = begin; i < end; ++i) {
+                w[i] += coef * v[i];
+            }
+        }
+        double sum = 0.0;
+        #pragma omp simd reduction(+:sum)
+        for (size_t i = begin; i < end; ++i) {
+            sum += w[i] * w[i];
+        }
+        w_dot_w += sum;
+    }
+    return w_dot_w;
+}
+
+/*
+ * Orthogonalizes w against V_0..V_(k-1) by classical Gram-Schmidt, with one reorthogonalization
+ * pass if ||w|| dropped below ||w_in|| / sqrt(2). Writes the coefficients to h (h_tmp: scratch
+ * of length k) and returns the norm of the orthogonalized w.
+ */
+static double gmres_orthogonalize(const double* V, size_t n, int k, double* w, double* h, double* h_tmp,
+                                  double* partial, size_t stride) {
+    const double w_in = gmres_project(V, n, k, w, h, partial, stride);
+    double w_out = gmres_update(V, n, k, h, -1.0, w);
+
+    if (w_out < 0.5 * w_in) {
+        gmres_project(V, n, k, w, h_tmp, partial, stride);
+        w_out = gmres_update(V, n, k, h_tmp, -1.0, w);
+        for (int q = 0; q < k; ++q) {
+            h[q] += h_tmp[q];
+        }
+    }
+    return sqrt(w_out);
+}
+
+/*
+ * Function: gmres_solver_precond
+ * ------------------------------
+ * Solves Ax = b, A (nonsymmetric) in CRS format, with the right-preconditioned restarted
+ * GMRES(m) method.
+ * Parameters:
+ *  - A: Pointer to the CRS matrix (checked once by crs_validate)
+ *  - b: Pointer to vector b (right-hand side)
+ *  - x: Pointer to the initial guess vector x (also stores the solution)
+ *  - max_iter: Maximum number of iterations (Arnoldi steps, over all restart cycles)
+ *  - tol: Convergence tolerance on ||b - A * x||
+ *  - restart: Krylov subspace dimension m (GMRES_DEFAULT_RESTART if <= 0)
+ *  - M: Preconditioner handle of A set up beforehand (see the file header)
+ *  - ws: Workspace kept across solves for the work vectors (NULL: allocated for this solve)
+ *
+ * Returns:
+ *  -0 if converged, 1 otherwise (max iterations reached without convergence), -1 on error
+ */
+int gmres_solver_precond(const CRSMatrix* A, const double* b, double* x, int max_iter, double tol, int restart,
+                         const Preconditioner* M, SolverWorkspace* ws) {
+
+    if (krylov_check_input(A, b, x, M, "gmres_solver_precond") != 0) {
+        return -1;
+    }
+    const int identity = (M->type == PRECONDITIONER_NONE);
+    const int n = (int) A->rows;
+    const size_t N = A->rows;
+    const int m = (restart > 0) ? restart : GMRES_DEFAULT_RESTART;
+    const size_t ld = (size_t) m + 1;   // Leading dimension of the Hessenberg columns
+    const size_t stride = ((ld + 1 + GMRES_PARTIAL_ALIGN - 1) / GMRES_PARTIAL_ALIGN) * GMRES_PARTIAL_ALIGN;
+
+    // Basis V (m + 1 vectors), Hessenberg matrix (column j holds H(0..j+1, j)), Givens rotations
+    const size_t num_threads = (size_t) omp_get_max_threads();
+    SolverWorkspace local = SOLVER_WORKSPACE_INIT;
+    SolverWorkspace* W = ws ? ws : &local;
+    if (workspace_reserve(W, workspace_size(ld * N) + 2 * workspace_size(N) + workspace_size(ld * m) +
+                             2 * workspace_size(m) + 2 * workspace_size(ld) +
+                             workspace_size(num_threads * stride)) != 0) {
+        fprintf(stderr, "Memory allocation failed in gmres_solver_precond.\n");
+        return -1;
+    }
+    double* V = workspace_take(W, ld * N);
+    double* z = workspace_take(W, N);
+    double* u = workspace_take(W, N);
+    double* H = workspace_take(W, ld * m);
+    double* cs = workspace_take(W, m);
+    double* sn = workspace_take(W, m);
+    double* g = workspace_take(W, ld);
+    double* y = workspace_take(W, ld);
+    double* partial = workspace_take(W, num_threads * stride);
+
+    int status = 1;
+    int iter = 0;
+    for (;;) {
+        // True residual r = b - A * x at every (re)start
+        double* r = V;
+        crs_mat_vec_mult(A, x, r);
+        vec_subtract(b, r, r, n);
+        const double beta = sqrt(dot_product(r, r, n));
+        if (beta < tol) {
+            status = 0;
+            break;
+        }
+        if (iter >= max_iter) {
+            break;
+        }
+
+        #pragma omp parallel for simd if (n >= PARALLEL_THRESHOLD)
+        for (int i = 0; i < n; ++i) {
+            r[i] /= beta;
+        }
+        g[0] = beta;
+
+        // Arnoldi cycle
+        int k = 0;
+        while (k < m && iter < max_iter) {
+            const int j = k;
+            double* h = H + (size_t) j * ld;
+            double* w = V + (size_t) (j + 1) * N;
+            ++iter;
+            ++k;
+
+            // w = A * M^(-1) * V_j, orthogonalized against V_0..V_j
+            if (!identity) {
+                M->apply(M, V + (size_t) j * N, z);
+            }
+            crs_mat_vec_mult(A, identity ? V + (size_t) j * N : z, w);
+            const double h_next = gmres_orthogonalize(V, N, j + 1, w, h, y, partial, stride);
+
+            // Apply the previous rotations to column j, then the rotation eliminating h_next
+            for (int i = 0; i < j; ++i) {
+                const double tmp = cs[i] * h[i] + sn[i] * h[i + 1];
+                h[i + 1] = -sn[i] * h[i] + cs[i] * h[i + 1];
+                h[i] = tmp;
+            }
+            const double d = sqrt(h[j] * h[j] + h_next * h_next);
+            cs[j] = (d > 0.0) ? h[j] / d : 1.0;
+            sn[j] = (d > 0.0) ? h_next / d : 0.0;
+            h[j] = d;
+            h[j + 1] = 0.0;
+            g[j + 1] = -sn[j] * g[j];
+            g[j] *= cs[j];
+
+            // Residual norm of the current iterate is |g(j+1)|; h_next = 0 means the solution is exact
+            if (fabs(g[j + 1]) < tol || h_next == 0.0) {
+                break;
+            }
+            #pragma omp parallel for simd if (n >= PARALLEL_THRESHOLD)
+            for (int i = 0; i < n; ++i) {
+                w[i] /= h_next;
+            }
+        }
+
+        // Solve the triangular system H(0..k-1, 0..k-1) * y = g and update x += M^(-1) * V * y
+        for (int i = k - 1; i >= 0; --i) {
+            double sum = g[i];
+            for (int l = i + 1; l < k; ++l) {
+                sum -= H[(size_t) l * ld + i] * y[l];
+            }
+            y[i] = sum / H[(size_t) i * ld + i];
+        }
+        memset(u, 0, N * sizeof(double));
+        gmres_update(V, N, k, y, 1.0, u);
+        if (!identity) {
+            M->apply(M, u, z);
+        }
+        const double* correction = identity ? u : z;
+        #pragma omp parallel for simd if (n >= PARALLEL_THRESHOLD)
+        for (int i = 0; i < n; ++i) {
+            x[i] += correction[i];
+        }
+    }
+
+    if (status == 0) {
+        printf("GMRES converged after %d iterations\n", iter);
+    } else {
+        printf("GMRES did not converge after %d iterations\n", max_iter);
+    }
+    workspace_free(&local);
+    return status;
+}
+
+/*
+ * Function: bicgstab_solver_crs / gmres_solver_crs
+ * ------------------------------------------------
+ * Same as the _precond versions, with the preconditioner 'preconditioner_type' (see the file
+ * header) built for this solve only.
+ */
+int bicgstab_solver_crs(const CRSMatrix* A, const double* b, double* x, int max_iter, double tol,
+                        const char* preconditioner_type) {
+    Preconditioner M;
+    if (!A || !preconditioner_type || preconditioner_crs(&M, A, preconditioner_type) != 0) {
+        fprintf(stderr, "Preconditioner setup failed in bicgstab_solver_crs.\n");
+        return -1;
+    }
+    int status = bicgstab_solver_precond(A, b, x, max_iter, tol, &M, NULL);
+    preconditioner_free(&M);
+    return status;
+}
+
+int gmres_solver_crs(const CRSMatrix* A, const double* b, double* x, int max_iter, double tol, int restart,
+                     const char* preconditioner_type) {
+    Preconditioner M;
+    if (!A || !preconditioner_type || preconditioner_crs(&M, A, preconditioner_type) != 0) {
+        fprintf(stderr, "Preconditioner setup failed in gmres_solver_crs.\n");
+        return -1;
+    }
+    int status = gmres_solver_precond(A, b, x, max_iter, tol, restart, &M, NULL);
+    preconditioner_free(&M);
+    return status;
+}
@@ -0,0 +1,36 @@
+#ifndef PROJECT_02_FVM_NONSYMMETRIC_SOLVERS_H
+#define PROJECT_02_FVM_NONSYMMETRIC_SOLVERS_H
+
+#include "matrix_operations/CRSMatrix.h"
+#include "preconditioner.h"
+#include "solver_workspace.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Default restart length of GMRES(m) (also used for restart <= 0)
+#define GMRES_DEFAULT_RESTART 30
+
+// Right-preconditioned BiCGSTAB on a CRS matrix (nonsymmetric systems, e.g. upwinded advection),
+// preconditioner "None", "Jacobi", "IncompleteCholesky", "ModifiedIncompleteCholesky" or "AMG"
+int bicgstab_solver_crs(const CRSMatrix* A, const double* b, double* x, int max_iter, double tol,
+                        const char* preconditioner_type);
+
+// Right-preconditioned GMRES(restart) on a CRS matrix, classical Gram-Schmidt with
+// reorthogonalization; same preconditioners as bicgstab_solver_crs
+int gmres_solver_crs(const CRSMatrix* A, const double* b, double* x, int max_iter, double tol, int restart,
+                     const char* preconditioner_type);
+
+// Same with a preconditioner handle of A set up beforehand and a workspace for the work vectors
+// (NULL: temporary), both reused across solves
+int bicgstab_solver_precond(const CRSMatrix* A, const double* b, double* x, int max_iter, double tol,
+                            const Preconditioner* M, SolverWorkspace* ws);
+int gmres_solver_precond(const CRSMatrix* A, const double* b, double* x, int max_iter, double tol, int restart,
+                         const Preconditioner* M, SolverWorkspace* ws);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif //PROJECT_02_FVM_NONSYMMETRIC_SOLVERS_H
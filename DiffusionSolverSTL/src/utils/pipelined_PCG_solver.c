@@ -0,0 +1,381 @@
+/*
+ * File: pipelined_PCG_solver.c
+ * ----------------------------
+ * This file contains the pipelined Preconditioned Conjugate Gradient method (Ghysels & Vanroose)
+ * for CRS matrices.
+ *
+ * Classical PCG needs the dot products of an iteration before it can start the next SpMV, so
+ * every iteration synchronizes all threads several times. Pipelined CG carries the extra
+ * recurrences w = A * u, s = A * p, q = M * s, z = A * q, so that the dot products
+ * gamma = (r, u), delta = (w, u) and (r, r) of one iteration are not needed until after the
+ * preconditioner m = M * w and the SpMV n = A * m have been computed:
+ *
+ *     beta  = gamma / gamma_old,   alpha = gamma / (delta - beta * gamma / alpha_old)
+ *     z = n + beta * z,   q = m + beta * q,   s = w + beta * s,   p = u + beta * p
+ *     x += alpha * p,     r -= alpha * s,     u -= alpha * q,     w -= alpha * z
+ *
+ * Implementation:
+ *  - The whole solve runs inside one OpenMP parallel region. Every thread owns the same rows
+ *    (the nnz-balanced partition of the CRS matrix) during the whole solve.
+ *  - One sweep per iteration computes n = A * m for a chunk of rows and immediately applies
+ *    the eight vector updates to them, the three dot products of the next iteration (per-thread partial sums,
+ *    no reduction barrier) and, for row-local preconditioners (None, Jacobi), m = M * w.
+ *  - The only barrier of an iteration is the one before the next SpMV, which reads m of all
+ *    rows. After it, every thread adds the partial sums in the same order, so all threads
+ *    compute identical alpha / beta without a further synchronization. m and the partial sums
+ *    are double-buffered so a fast thread never overwrites data a slow thread still reads.
+ *  - Incomplete Cholesky is not row-local; its triangular solves synchronize the team and run
+ *    level-scheduled on all threads (the 'apply_team' of the preconditioner handle).
+ *
+ * Residual replacement:
+ *  The recurrences accumulate rounding errors faster than classical CG. Every
+ *  PIPECG_REPLACEMENT_PERIOD iterations, and whenever the recursive residual satisfies the
+ *  tolerance, r, u, w, s, q and z are recomputed from x and p (r = b - A * x, ...). Convergence
+ *  is only reported when the recomputed (true) residual satisfies the tolerance.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <omp_llvm.h>
+#include "pipelined_PCG_solver.h"
+#include "matrix_operations/linear_algebra.h"
+#include "preconditioner.h"
+
+// Iterations between two residual replacements
+#define PIPECG_REPLACEMENT_PERIOD 50
+
+// Stride (in doubles) of the per-thread partial sums, one cache line per thread
+#define PIPECG_PARTIAL_STRIDE 8
+
+// Rows per chunk of the fused sweep: the SpMV of a chunk goes to a stack buffer (in L1), then
+// the vector updates of the chunk read it
+#define PIPECG_CHUNK 256
+
+typedef struct {
+    const CRSMatrix* A;
+    const Preconditioner* M;
+    int row_local;            // M is None or Jacobi (applied row by row inside the sweeps)
+} pipecg_system;
+
+// y_i = (A * x)_i for the rows [begin, end)
+static void pipecg_spmv_rows(const CRSMatrix* A, const double* x, double* y, size_t begin, size_t end) {
+    CRS_INDEX_CALL(A, crs_rows_mult, begin, end, x, y + begin);
+}
+
+// z = M * r for the rows [begin, end) of a row-local preconditioner (None or Jacobi)
+static void pipecg_precond_rows(const pipecg_system* S, const double* r, double* z, size_t begin, size_t end) {
+    if (S->M->type == PRECONDITIONER_JACOBI) {
+        const double* inv_diag = S->M->inv_diag;
+        #pragma omp simd
+        for (size_t i = begin; i < end; ++i) {
+            z[i] = inv_diag[i] * r[i];
+        }
+    } else {
+        memcpy(z + begin, r + begin, (end - begin) * sizeof(double));
+    }
+}
+
+// Partial sums (r, u), (w, u), (r, r) over the rows [begin, end), added to 'partial'
+static void pipecg_dots_rows(const double* r, const double* u, const double* w, double* partial,
+                             size_t begin, size_t end) {
+    double gamma = 0.0, delta = 0.0, rr = 0.0;
+    #pragma omp simd reduction(+:gamma, delta, rr)
+    for (size_t i = begin; i < end; ++i) {
+        gamma += r[i] * u[i];
+        delta += w[i] * u[i];
+        rr += r[i] * r[i];
+    }
+    partial[0] += gamma;
+    partial[1] += delta;
+    partial[2] += rr;
+}
+
+/*
+ * Applies z = M * r on all rows. Row-local preconditioners only touch the rows of the calling
+ * thread (no synchronization); the others (incomplete Cholesky) wait for r of all rows and solve
+ * with the whole team through 'apply_team' (which ends with a barrier).
+ */
+static void pipecg_precond(const pipecg_system* S, const double* r, double* z, int tid, int num_threads) {
+    if (!S->row_local) {
+        #pragma omp barrier
+        S->M->apply_team(S->M, r, z);
+        return;
+    }
+    const CRSMatrix* A = S->A;
+    for (int part = tid; part < A->num_parts; part += num_threads) {
+        pipecg_precond_rows(S, r, z, A->row_part[part], A->row_part[part + 1]);
+    }
+}
+
+// Sums the partial dot products of all threads in a fixed order (identical on every thread)
+static void pipecg_sum_partials(const double* partial, int num_threads, double* gamma, double* delta, double* rr) {
+    *gamma = 0.0;
+    *delta = 0.0;
+    *rr = 0.0;
+    for (int t = 0; t < num_threads; ++t) {
+        *gamma += partial[t * PIPECG_PARTIAL_STRIDE + 0];
+        *delta += partial[t * PIPECG_PARTIAL_STRIDE + 1];
+        *rr += partial[t * PIPECG_PARTIAL_STRIDE + 2];
+    }
+}
+
+/*
+ * Recomputes the recurrence vectors from x and p (residual replacement), then the partial dot
+ * products and m = M * w of the current iteration. Called by all threads.
+ */
+static void pipecg_replace(const pipecg_system* S, const double* b, const double* x, const double* p,
+                           double* r, double* u, double* w, double* s, double* q, double* z, double* m,
+                           double* partial, int tid, int num_threads) {
+    const CRSMatrix* A = S->A;
+
+    // x and p are complete: r = b - A * x, s = A * p
+    for (int part = tid; part < A->num_parts; part += num_threads) {
+        const size_t begin = A->row_part[part], end = A->row_part[part + 1];
+        pipecg_spmv_rows(A, x, r, begin, end);
+        for (size_t i = begin; i < end; ++i) {
+            r[i] = b[i] - r[i];
+        }
+        pipecg_spmv_rows(A, p, s, begin, end);
+    }
+
+    // u = M * r, q = M * s
+    pipecg_precond(S, r, u, tid, num_threads);
+    pipecg_precond(S, s, q, tid, num_threads);
+    #pragma omp barrier
+
+    // w = A * u, z = A * q, dot products and m = M * w
+    double* my_partial = partial + tid * PIPECG_PARTIAL_STRIDE;
+    my_partial[0] = my_partial[1] = my_partial[2] = 0.0;
+    for (int part = tid; part < A->num_parts; part += num_threads) {
+        const size_t begin = A->row_part[part], end = A->row_part[part + 1];
+        pipecg_spmv_rows(A, u, w, begin, end);
+        pipecg_spmv_rows(A, q, z, begin, end);
+        pipecg_dots_rows(r, u, w, my_partial, begin, end);
+    }
+    pipecg_precond(S, w, m, tid, num_threads);
+    #pragma omp barrier
+}
+
+int pipelined_pcg_solver_precond(const CRSMatrix* A, const double* b, double* x, int max_iter, double tol,
+                                 const Preconditioner* M, SolverWorkspace* ws) {
+
+    /*
+     * Function: pipelined_pcg_solver_precond
+     * --------------------------------------
+     * Solve the linear system Ax = b using the pipelined Preconditioned Conjugate Gradient
+     * method (one synchronization per iteration, see the description at the top of the file).
+     * Parameters:
+     *  - A: Pointer to the symmetric positive definite CRS matrix (checked by crs_validate)
+     *  - b: Pointer to vector b (right-hand side)
+     *  - x: Pointer to the initial guess vector x (also stores the solution)
+     *  - max_iter: Maximum number of iterations
+     *  - tol: Convergence tolerance on the (true) residual norm
+     *  - M: Preconditioner handle of A set up beforehand: None, Jacobi, or a method with a team
+     *       apply (incomplete Cholesky)
+     *  - ws: Workspace kept across solves for the work vectors (NULL: allocated for this solve)
+     * Returns:
+     *  -0 if converged, 1 otherwise (max iterations reached without convergence), -1 on error
+     */
+
+    if (!A || !b || !x || !M || !M->apply) {
+        fprintf(stderr, "Invalid input to pipelined_pcg_solver_precond.\n");
+        return -1;
+    }
+    if (!A->validated || A->rows != A->cols || M->n != A->rows) {
+        fprintf(stderr, "CRS matrix passed to pipelined_pcg_solver_precond must be square and checked by crs_validate.\n");
+        return -1;
+    }
+
+    const int n = (int) A->rows;
+    pipecg_system S = {A, M, M->type == PRECONDITIONER_NONE || M->type == PRECONDITIONER_JACOBI};
+    if (!pipelined_pcg_supports(M)) {
+        fprintf(stderr, "Preconditioner type %d is not supported by pipelined_pcg_solver_precond.\n", (int) M->type);
+        return -1;
+    }
+    const double* inv_diag = (M->type == PRECONDITIONER_JACOBI) ? M->inv_diag : NULL;
+
+    // Work vectors (zero-initialized, so the first iteration can use beta = 0) and partial sums,
+    // cut out of the workspace (a temporary one if the caller has none)
+    const int max_threads = omp_get_max_threads();
+    const size_t size = workspace_size((size_t) n);
+    const size_t partial_size = workspace_size((size_t) max_threads * PIPECG_PARTIAL_STRIDE);
+    SolverWorkspace local = SOLVER_WORKSPACE_INIT;
+    SolverWorkspace* W = ws ? ws : &local;
+    if (workspace_reserve(W, 9 * size + 2 * partial_size) != 0) {
+        fprintf(stderr, "Memory allocation failed in pipelined_pcg_solver_precond.\n");
+        return -1;
+    }
+    double* work = workspace_take(W, 9 * size);
+    double* partials = workspace_take(W, 2 * partial_size);
+    memset(work, 0, 9 * size * sizeof(double));
+    memset(partials, 0, 2 * partial_size * sizeof(double));
+    double* r = work;
+    double* u = work + size;
+    double* w = work + 2 * size;
+    double* s = work + 3 * size;
+    double* q = work + 4 * size;
+    double* z = work + 5 * size;
+    double* p = work + 6 * size;
+    double* m[2] = {work + 7 * size, work + 8 * size};   // m = M * w, double-buffered
+    double* partial[2] = {partials, partials + partial_size};
+
+    int status = 1;
+    int iterations = 0;
+
+    #pragma omp parallel if (A->nnz >= (size_t) SPARSE_PARALLEL_THRESHOLD)
+    {
+        const int tid = omp_get_thread_num();
+        const int num_threads = omp_get_num_threads();
+        const size_t* row_part = A->row_part;
+
+        double gamma = 0.0, delta = 0.0, rr = 0.0;
+        double gamma_old = 1.0, alpha_old = 1.0;
+        int first = 1;
+        int buf = 0;
+
+        // r = b - A * x, u = M * r, w = A * u, dot products and m = M * w
+        pipecg_replace(&S, b, x, p, r, u, w, s, q, z, m[buf], partial[buf], tid, num_threads);
+
+        for (int it = 0; ; ++it) {
+
+            pipecg_sum_partials(partial[buf], num_threads, &gamma, &delta, &rr);
+
+            // Residual replacement: periodically, and to confirm convergence with the true residual
+            if (sqrt(rr) < tol || (it > 0 && it % PIPECG_REPLACEMENT_PERIOD == 0)) {
+                #pragma omp barrier
+                pipecg_replace(&S, b, x, p, r, u, w, s, q, z, m[buf], partial[buf], tid, num_threads);
+                pipecg_sum_partials(partial[buf], num_threads, &gamma, &delta, &rr);
+                if (sqrt(rr) < tol) {
+                    #pragma omp single nowait
+                    {
+                        status = 0;
+                        iterations = it;
+                    }
+                    break;
+                }
+            }
+
+            if (it >= max_iter) {
+                break;
+            }
+
+            // Scalars of this iteration (the same on every thread)
+            double alpha, beta;
+            if (first) {
+                beta = 0.0;
+                alpha = gamma / delta;
+            } else {
+                beta = gamma / gamma_old;
+                alpha = gamma / (delta - beta * gamma / alpha_old);
+            }
+
+            // One sweep: n = A * m, vector updates, next dot products and next m = M * w
+            const double* m_cur = m[buf];
+            double* m_next = m[buf ^ 1];
+            double* my_partial = partial[buf ^ 1] + tid * PIPECG_PARTIAL_STRIDE;
+            double g = 0.0, d = 0.0, rr_next = 0.0;
+            double n_chunk[PIPECG_CHUNK];
+            for (int part = tid; part < A->num_parts; part += num_threads) {
+                const size_t part_end = row_part[part + 1];
+                for (size_t lo = row_part[part]; lo < part_end; lo += PIPECG_CHUNK) {
+                    const size_t hi = (part_end - lo < PIPECG_CHUNK) ? part_end : lo + PIPECG_CHUNK;
+                    CRS_INDEX_CALL(A, crs_rows_mult, lo, hi, m_cur, n_chunk);
+                    for (size_t i = lo; i < hi; ++i) {
+                        z[i] = n_chunk[i - lo] + beta * z[i];
+                        q[i] = m_cur[i] + beta * q[i];
+                        s[i] = w[i] + beta * s[i];
+                        p[i] = u[i] + beta * p[i];
+                        x[i] += alpha * p[i];
+                        r[i] -= alpha * s[i];
+                        u[i] -= alpha * q[i];
+                        w[i] -= alpha * z[i];
+
+                        g += r[i] * u[i];
+                        d += w[i] * u[i];
+                        rr_next += r[i] * r[i];
+                        if (S.row_local) {
+                            m_next[i] = inv_diag ? inv_diag[i] * w[i] : w[i];
+                        }
+                    }
+                }
+            }
+            my_partial[0] = g;
+            my_partial[1] = d;
+            my_partial[2] = rr_next;
+
+            // The single synchronization point of the iteration (m_next is read by the next SpMV)
+            if (!S.row_local) {
+                pipecg_precond(&S, w, m_next, tid, num_threads);
+            } else {
+                #pragma omp barrier
+            }
+
+            gamma_old = gamma;
+            alpha_old = alpha;
+            first = 0;
+            buf ^= 1;
+        }
+    }
+
+    if (status == 0) {
+        printf("Pipelined PCG converged after %d iterations\n", iterations);
+    } else {
+        // If we reach this point, the algorithm did not converge within max_iter
+        printf("Pipelined PCG did not converge after %d iterations\n", max_iter);
+    }
+
+    workspace_free(&local);
+    return status;
+}
+
+/*
+ * Function: pipelined_pcg_supports
+ * --------------------------------
+ * Whether the handle can run inside the parallel region of the pipelined solver: row-local
+ * (None, Jacobi) or with a team apply (incomplete Cholesky). AMG, multigrid and Chebyshev
+ * apply the whole operator and are not supported.
+ *
+ * Returns:
+ *   - 1 if supported, 0 otherwise (or for a null handle)
+ */
+int pipelined_pcg_supports(const Preconditioner* M) {
+    if (!M) {
+        return 0;
+    }
+    return M->type == PRECONDITIONER_NONE || M->type == PRECONDITIONER_JACOBI || M->apply_team != NULL;
+}
+
+int pipelined_pcg_solver_crs(const CRSMatrix* A, const double* b, double* x, int max_iter, double tol,
+                             const char* preconditioner_type) {
+
+    /*
+     * Function: pipelined_pcg_solver_crs
+     * ----------------------------------
+     * Same as pipelined_pcg_solver_precond, with the preconditioner built for this solve.
+     *  preconditioner_type: Type of preconditioner ("Jacobi", "IncompleteCholesky",
+     *                       "ModifiedIncompleteCholesky", or "None")
+     * Returns:
+     *  -0 if converged, 1 otherwise (max iterations reached without convergence), -1 on error
+     */
+
+    if (!A || !b || !x || !preconditioner_type) {
+        fprintf(stderr, "Invalid input to pipelined_pcg_solver_crs.\n");
+        return -1;
+    }
+
+    // Preconditioner setup (once per solve)
+    Preconditioner M;
+    if (preconditioner_crs(&M, A, preconditioner_type) != 0) {
+        return -1;
+    }
+    if (!pipelined_pcg_supports(&M)) {
+        fprintf(stderr, "Preconditioner '%s' is not supported by pipelined_pcg_solver_crs.\n", preconditioner_type);
+        preconditioner_free(&M);
+        return -1;
+    }
+    int status = pipelined_pcg_solver_precond(A, b, x, max_iter, tol, &M, NULL);
+    preconditioner_free(&M);
+    return status;
+}
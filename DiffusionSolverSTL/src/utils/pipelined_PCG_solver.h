@@ -0,0 +1,29 @@
+#ifndef PROJECT_02_FVM_PIPELINED_PCG_SOLVER_H
+#define PROJECT_02_FVM_PIPELINED_PCG_SOLVER_H
+
+#include "matrix_operations/CRSMatrix.h"
+#include "preconditioner.h"
+#include "solver_workspace.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Pipelined PCG on a CRS matrix (one synchronization per iteration, with residual replacement),
+// preconditioner "None", "Jacobi", "IncompleteCholesky" or "ModifiedIncompleteCholesky"
+int pipelined_pcg_solver_crs(const CRSMatrix* A, const double* b, double* x, int max_iter, double tol,
+                             const char* preconditioner_type);
+
+// Same with a preconditioner handle set up beforehand (None, Jacobi or incomplete Cholesky) and a
+// workspace for the work vectors (NULL: temporary)
+int pipelined_pcg_solver_precond(const CRSMatrix* A, const double* b, double* x, int max_iter, double tol,
+                                 const Preconditioner* M, SolverWorkspace* ws);
+
+// Whether a handle can be used by the pipelined solver (None, Jacobi or a method with a team apply)
+int pipelined_pcg_supports(const Preconditioner* M);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif //PROJECT_02_FVM_PIPELINED_PCG_SOLVER_H
@@ -9,12 +9,42 @@
  * Jacobi preconditioner is dividing residual by the diagonal element of matrix A.
  * Incomplete Cholesky preconditioner
  *
+ * The sparse preconditioners work on CRS storage end to end:
+ *  - jacobi_precondition_crs uses the inverse diagonal extracted once from the CRS matrix.
+ *  - incomplete_cholesky_crs computes the zero-fill factor L (IC(0)) on the lower-triangular
+ *    pattern of A, stored in CRS (column indices sorted, diagonal last in every row);
+ *    modified_incomplete_cholesky_crs computes the MIC(0) variant.
+ *  - incomplete_cholesky does the same for a dense matrix (the zero entries are dropped), so
+ *    the factor is never stored densely.
+ *  - ic_precondition_crs solves L * L^T * z = r with two O(nnz) sparse triangular sweeps.
+ *
+ * The 'Preconditioner' handle (end of the file) is what the solvers use: the factories map the
+ * 'Preconditioner_type' name onto setup / apply / destroy functions once, setup keeps the
+ * inverse diagonal (Jacobi), the factor and its triangular-solve schedule (IC), the
+ * hierarchy (AMG, multigrid) or the diagonal and spectral bounds (Chebyshev), and apply only
+ * reuses them.
+ *
+ * "Chebyshev" / "Chebyshev(k)" is a degree-k Jacobi-preconditioned Chebyshev polynomial
+ * (chebyshev.c, default CHEBYSHEV_DEFAULT_DEGREE): matrix products and vector updates only, no
+ * inner products, so it adds no global reductions to PCG. Setup estimates the bounds by
+ * Lanczos; preconditioner_set_spectrum replaces them, e.g. by those of an earlier solve.
+ *
+ * preconditioner_set_precision stores the IC factor values (trisolve_use_single) or runs the
+ * multigrid cycles (multigrid_use_single) in single precision: the apply is memory bound, so
+ * it moves about half the bytes. Only the preconditioner is approximated further; the solvers
+ * keep their vectors in double (see pcg_solver_refinement).
  */
 
 #include "preconditioner.h"
 #include "math.h"
 #include "stdio.h"
 #include "stdlib.h"
+#include <string.h>
+#include "matrix_operations/linear_algebra.h"
+#include "matrix_operations/triangular_solve.h"
+#include "amg.h"
+#include "multigrid.h"
+#include "chebyshev.h"
 
 void precondition(const double* M, const double* r, double* z, int n) {
 
@@ -32,54 +62,942 @@ void jacobi_precondition(const double* A, const double* r, double* z, int n) {
 
 }
 
-// Function to compute the Incomplete Cholesky factorization of matrix A
-void incomplete_cholesky(const double* A, double* L, int n) {
+// Apply Jacobi preconditioner with a precomputed inverse diagonal: z = D^(-1) * r
+void jacobi_precondition_crs(const double* inv_diag, const double* r, double* z, int n) {
+
     for (int i = 0; i < n; ++i) {
-        for (int j = 0; j < i; ++j) {
-            double sum = A[i * n +j];
+        z[i] = inv_diag[i] * r[i];
+    }
 
-            for (int k = 0; k < j; ++k) {
-                sum -= L[i * n + k] * L[j * n + k];
-            }
+}
 
-            if (i == j) {
-                // Diagonal element
-                if (sum <= 0.0) {
-                    printf("Matrix is not positive definite.\n");
-                    return;
+// Sort the entries of one CRS row by column index (rows are short, insertion sort is enough)
+static void sort_row(size_t* cols, double* vals, size_t len) {
+    for (size_t a = 1; a < len; ++a) {
+        size_t c = cols[a];
+        double v = vals[a];
+        size_t b = a;
+        while (b > 0 && cols[b - 1] > c) {
+            cols[b] = cols[b - 1];
+            vals[b] = vals[b - 1];
+            b--;
+        }
+        cols[b] = c;
+        vals[b] = v;
+    }
+}
+
+// Checks that every row of the lower-triangular pattern ends with its diagonal entry
+static int ic_check_diagonal(const CRSMatrix* L, const char* caller) {
+    for (size_t i = 0; i < L->rows; ++i) {
+        if (L->row_ptr[i + 1] == L->row_ptr[i] || L->col_idx[L->row_ptr[i + 1] - 1] != i) {
+            fprintf(stderr, "Missing diagonal entry in row %zu in %s.\n", i, caller);
+            return -1;
+        }
+    }
+    return 0;
+}
+
+// Position of entry (i, k) in the sorted row i of L, or (size_t) -1 if it is not in the pattern
+static size_t ic_find(const CRSMatrix* L, size_t i, size_t k) {
+    size_t lo = L->row_ptr[i], hi = L->row_ptr[i + 1];
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        if (L->col_idx[mid] < k) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return (lo < L->row_ptr[i + 1] && L->col_idx[lo] == k) ? lo : (size_t) -1;
+}
+
+/*
+ * Function: ic_factorize
+ * ----------------------
+ * Factorizes in place the lower triangle of A stored in L (sorted rows, diagonal last) into the
+ * zero-fill incomplete Cholesky factor, A ~ L * L^T.
+ *
+ * Right-looking elimination: for every pivot column m,
+ *   L(m,m) = sqrt(a_mm),   L(i,m) = a_im / L(m,m)  for the rows i > m of column m,
+ *   a_ik -= L(i,m) * L(k,m)                        for every pair i >= k > m of column m.
+ * An update that falls outside the pattern of A (fill-in) is dropped (IC(0)); with 'modified'
+ * it is added to the diagonals a_ii and a_kk instead (MIC(0)), so that L * L^T has the same
+ * row sums as A.
+ *
+ * A column index of L (built once here, O(nnz)) gives the entries of column m. For stencil
+ * matrices every column has a bounded number of entries, so the setup cost is O(nnz).
+ *
+ * Returns:
+ *   - 0 on success
+ *   - -1 on memory failure or a non-positive pivot
+ */
+static int ic_factorize(CRSMatrix* L, int modified) {
+
+    const size_t n = L->rows;
+    const size_t* row_ptr = L->row_ptr;
+    const size_t* col_idx = L->col_idx;
+    double* values = L->values;
+
+    // Column index of the strictly lower part: rows and value positions of every column
+    size_t* col_ptr = (size_t*) calloc(n + 1, sizeof(size_t));
+    size_t* col_row = (size_t*) malloc((L->nnz - n + 1) * sizeof(size_t));
+    size_t* col_pos = (size_t*) malloc((L->nnz - n + 1) * sizeof(size_t));
+    if (!col_ptr || !col_row || !col_pos) {
+        fprintf(stderr, "Memory allocation failed in ic_factorize.\n");
+        free(col_ptr); free(col_row); free(col_pos);
+        return -1;
+    }
+    for (size_t i = 0; i < n; ++i) {
+        for (size_t j = row_ptr[i]; j < row_ptr[i + 1] - 1; ++j) {
+            col_ptr[col_idx[j] + 1]++;
+        }
+    }
+    for (size_t m = 0; m < n; ++m) {
+        col_ptr[m + 1] += col_ptr[m];
+    }
+    for (size_t i = 0; i < n; ++i) {   // Rows in increasing order, so every column is sorted
+        for (size_t j = row_ptr[i]; j < row_ptr[i + 1] - 1; ++j) {
+            const size_t dst = col_ptr[col_idx[j]]++;
+            col_row[dst] = i;
+            col_pos[dst] = j;
+        }
+    }
+    for (size_t m = n; m > 0; --m) {   // Undo the shift introduced by the fill loop
+        col_ptr[m] = col_ptr[m - 1];
+    }
+    col_ptr[0] = 0;
+
+    int status = 0;
+    for (size_t m = 0; m < n; ++m) {
+        const size_t diag_m = row_ptr[m + 1] - 1;
+        if (values[diag_m] <= 0.0) {
+            fprintf(stderr, "Matrix is not positive definite (pivot %zu) in ic_factorize.\n", m);
+            status = -1;
+            break;
+        }
+        const double d = sqrt(values[diag_m]);
+        values[diag_m] = d;
+
+        // Column m of L
+        for (size_t a = col_ptr[m]; a < col_ptr[m + 1]; ++a) {
+            values[col_pos[a]] /= d;
+        }
+
+        // Rank-1 update of the remaining lower triangle, restricted to the pattern
+        for (size_t a = col_ptr[m]; a < col_ptr[m + 1]; ++a) {
+            const size_t i = col_row[a];
+            const double l_im = values[col_pos[a]];
+            values[row_ptr[i + 1] - 1] -= l_im * l_im;
+
+            for (size_t b = col_ptr[m]; b < a; ++b) {
+                const size_t k = col_row[b];
+                const double f = l_im * values[col_pos[b]];
+                const size_t pos = ic_find(L, i, k);
+                if (pos != (size_t) -1) {
+                    values[pos] -= f;
+                } else if (modified) {
+                    values[row_ptr[i + 1] - 1] -= f;
+                    values[row_ptr[k + 1] - 1] -= f;
                 }
-                L[i * n + i] = sqrt(sum);
-            } else {
-                // Off-diagonal element
-                L[i * n + j] = sum / L[j * n + j];
             }
         }
     }
+
+    free(col_ptr); free(col_row); free(col_pos);
+    return status;
+}
+
+// Copies the lower triangle of A into L (sorted rows, diagonal last), arrays allocated here
+static int ic_lower_pattern(const CRSMatrix* A, CRSMatrix* L) {
+
+    const size_t n = A->rows;
+
+    // Count the lower-triangular entries of every row
+    size_t* row_ptr = (size_t*) malloc((n + 1) * sizeof(size_t));
+    if (!row_ptr) {
+        fprintf(stderr, "Memory allocation failed in ic_lower_pattern.\n");
+        return -1;
+    }
+    row_ptr[0] = 0;
+    for (size_t i = 0; i < n; ++i) {
+        size_t count = 0;
+        for (size_t j = A->row_ptr[i]; j < A->row_ptr[i + 1]; ++j) {
+            if (crs_col(A, j) <= i) {
+                count++;
+            }
+        }
+        row_ptr[i + 1] = row_ptr[i] + count;
+    }
+
+    const size_t nnz = row_ptr[n];
+    size_t* col_idx = (size_t*) malloc((nnz + 1) * sizeof(size_t));
+    double* values = (double*) malloc((nnz + 1) * sizeof(double));
+    if (!col_idx || !values) {
+        fprintf(stderr, "Memory allocation failed in ic_lower_pattern.\n");
+        free(row_ptr); free(col_idx); free(values);
+        return -1;
+    }
+
+    // Copy the lower triangle of A and sort every row, so the diagonal is the last entry
+    for (size_t i = 0; i < n; ++i) {
+        size_t k = row_ptr[i];
+        for (size_t j = A->row_ptr[i]; j < A->row_ptr[i + 1]; ++j) {
+            if (crs_col(A, j) <= i) {
+                col_idx[k] = crs_col(A, j);
+                values[k] = A->values[j];
+                k++;
+            }
+        }
+        sort_row(col_idx + row_ptr[i], values + row_ptr[i], row_ptr[i + 1] - row_ptr[i]);
+    }
+
+    L->values = values;
+    L->col_idx = col_idx;
+    L->row_ptr = row_ptr;
+    L->nnz = nnz;
+    L->rows = n;
+    L->cols = n;
+    L->row_part = NULL;
+    L->num_parts = 0;
+    L->validated = 0;
+    L->sell = NULL;
+    L->col_idx32 = NULL;
+    return 0;
 }
 
-// Apply Incomplete Cholesky preconditioner: solve M * z = r, where M ≈ A
-void ic_precondition(const double* L, const double* r, double* z, int n) {
+// Shared driver of incomplete_cholesky_crs and modified_incomplete_cholesky_crs
+static int ic_crs(const CRSMatrix* A, CRSMatrix* L, int modified, const char* caller) {
 
-    double* y = (double*) malloc(n * sizeof(double ));
+    if (!A || !L || !A->validated || A->rows != A->cols) {
+        fprintf(stderr, "Invalid input to %s.\n", caller);
+        return -1;
+    }
+    if (ic_lower_pattern(A, L) != 0) {
+        return -1;
+    }
+    if (ic_check_diagonal(L, caller) != 0 || ic_factorize(L, modified) != 0) {
+        free_crs_matrix(L);
+        return -1;
+    }
+    return crs_validate(L);
+}
 
-    // Solve L * y = r (forward substitution)
+/*
+ * Function: incomplete_cholesky_crs
+ * ---------------------------------
+ * Computes the zero-fill incomplete Cholesky factor L (A ~ L * L^T, IC(0)) of a symmetric
+ * positive definite CRS matrix. L has exactly the sparsity pattern of the lower triangle of A
+ * (CRS, sorted columns, diagonal last in every row), so no dense storage is ever allocated and
+ * the setup cost is O(nnz) for stencil matrices (see ic_factorize).
+ *
+ * Parameters:
+ *   A - Validated square CRS matrix (only the lower triangle is read)
+ *   L - Output factor, allocated here, free with free_crs_matrix
+ *
+ * Returns:
+ *   - 0 on success
+ *   - -1 on invalid input, missing diagonal, memory failure or a non-positive pivot
+ */
+int incomplete_cholesky_crs(const CRSMatrix* A, CRSMatrix* L) {
+    return ic_crs(A, L, 0, "incomplete_cholesky_crs");
+}
+
+/*
+ * Function: modified_incomplete_cholesky_crs
+ * ------------------------------------------
+ * Same as incomplete_cholesky_crs, but the dropped fill-in is added to the diagonal (MIC(0)),
+ * so L * L^T reproduces the row sums of A. For diffusion matrices this keeps the smooth error
+ * components well preconditioned and typically reduces the PCG iteration count further.
+ *
+ * Returns:
+ *   - 0 on success
+ *   - -1 on invalid input, missing diagonal, memory failure or a non-positive pivot
+ */
+int modified_incomplete_cholesky_crs(const CRSMatrix* A, CRSMatrix* L) {
+    return ic_crs(A, L, 1, "modified_incomplete_cholesky_crs");
+}
+
+/*
+ * Function: incomplete_cholesky
+ * -----------------------------
+ * Zero-fill incomplete Cholesky factor of a dense row-major matrix A. Only the non-zero entries
+ * of the lower triangle are kept, so L is sparse (CRS) and is applied with ic_precondition_crs.
+ *
+ * Returns:
+ *   - 0 on success
+ *   - -1 on invalid input, missing diagonal, memory failure or a non-positive pivot
+ */
+int incomplete_cholesky(const double* A, CRSMatrix* L, int n) {
+
+    if (!A || !L || n <= 0) {
+        fprintf(stderr, "Invalid input to incomplete_cholesky.\n");
+        return -1;
+    }
+
+    // Count the non-zeros of the lower triangle
+    size_t* row_ptr = (size_t*) malloc((n + 1) * sizeof(size_t));
+    if (!row_ptr) {
+        fprintf(stderr, "Memory allocation failed in incomplete_cholesky.\n");
+        return -1;
+    }
+    row_ptr[0] = 0;
+    for (int i = 0; i < n; ++i) {
+        size_t count = 0;
+        for (int j = 0; j <= i; ++j) {
+            if (A[(size_t) i * n + j] != 0.0) {
+                count++;
+            }
+        }
+        row_ptr[i + 1] = row_ptr[i] + count;
+    }
+
+    const size_t nnz = row_ptr[n];
+    size_t* col_idx = (size_t*) malloc((nnz + 1) * sizeof(size_t));
+    double* values = (double*) malloc((nnz + 1) * sizeof(double));
+    if (!col_idx || !values) {
+        fprintf(stderr, "Memory allocation failed in incomplete_cholesky.\n");
+        free(row_ptr); free(col_idx); free(values);
+        return -1;
+    }
     for (int i = 0; i < n; ++i) {
-        double sum = r[i];
-        for (int j = 0; j < i; ++j) {
-            sum -= L[i * n + j] * y[j];
+        size_t k = row_ptr[i];
+        for (int j = 0; j <= i; ++j) {
+            if (A[(size_t) i * n + j] != 0.0) {
+                col_idx[k] = (size_t) j;
+                values[k] = A[(size_t) i * n + j];
+                k++;
+            }
+        }
+    }
+
+    L->values = values;
+    L->col_idx = col_idx;
+    L->row_ptr = row_ptr;
+    L->nnz = nnz;
+    L->rows = (size_t) n;
+    L->cols = (size_t) n;
+    L->row_part = NULL;
+    L->num_parts = 0;
+    L->validated = 0;
+    L->sell = NULL;
+    L->col_idx32 = NULL;
+
+    if (ic_check_diagonal(L, "incomplete_cholesky") != 0 || ic_factorize(L, 0) != 0) {
+        free_crs_matrix(L);
+        return -1;
+    }
+    return crs_validate(L);
+}
+
+/*
+ * Function: ic_precondition_crs
+ * -----------------------------
+ * Applies the sparse incomplete Cholesky preconditioner: solves L * L^T * z = r, where L comes
+ * from 'incomplete_cholesky_crs'. Both sweeps are done in place in z, without scratch memory:
+ *  - forward:  L * y = r, row by row
+ *  - backward: L^T * z = y, column-oriented using the rows of L
+ */
+void ic_precondition_crs(const CRSMatrix* L, const double* r, double* z) {
+    CRS_INDEX_CALL(L, crs_cholesky_solve, r, z);
+}
+
+/*
+ * Preconditioner handles
+ */
+
+// Objects built by the setup of the IC, AMG, multigrid and Chebyshev handles
+typedef struct {
+    CRSMatrix assembled;      // Stencil assembled for the matrix-based methods
+    CRSMatrix L;              // IC factor
+    TriangularSolve T;        // and its triangular-solve schedule
+    AMG amg;
+    Multigrid mg;
+    Chebyshev cheb;
+    int built;                // L and T / amg / mg / cheb are valid
+} precond_data;
+
+static const CRSMatrix PRECOND_EMPTY_MATRIX = {NULL, NULL, NULL, 0, 0, 0, NULL, 0, 0, NULL, NULL};
+
+// Releases what setup built; the handle stays bound to its operator and can be set up again
+static void precond_release(Preconditioner* M) {
+    precond_data* d = (precond_data*) M->data;
+    free(M->inv_diag);
+    M->inv_diag = NULL;
+    if (!d) {
+        return;
+    }
+    if (d->built) {
+        if (M->type == PRECONDITIONER_IC) {
+            trisolve_free(&d->T);
+            free_crs_matrix(&d->L);
+        } else if (M->type == PRECONDITIONER_AMG) {
+            amg_free(&d->amg);
+        } else if (M->type == PRECONDITIONER_MULTIGRID) {
+            multigrid_free(&d->mg);
+        } else if (M->type == PRECONDITIONER_CHEBYSHEV) {
+            chebyshev_free(&d->cheb);
+        }
+        d->built = 0;
+    }
+    free_crs_matrix(&d->assembled);
+}
+
+static void precond_destroy(Preconditioner* M) {
+    precond_release(M);
+    free(M->data);
+    M->data = NULL;
+    M->setup = NULL;
+    M->apply = NULL;
+    M->apply_team = NULL;
+    M->type = PRECONDITIONER_NONE;
+}
+
+static void precond_apply_identity(const Preconditioner* M, const double* r, double* z) {
+    if (z != r) {
+        memcpy(z, r, M->n * sizeof(double));
+    }
+}
+
+static void precond_apply_jacobi(const Preconditioner* M, const double* r, double* z) {
+    jacobi_precondition_crs(M->inv_diag, r, z, (int) M->n);
+}
+
+static void precond_apply_ic(const Preconditioner* M, const double* r, double* z) {
+    trisolve_llt(&((const precond_data*) M->data)->T, r, z);
+}
+
+static void precond_apply_ic_team(const Preconditioner* M, const double* r, double* z) {
+    trisolve_llt_team(&((const precond_data*) M->data)->T, r, z);
+}
+
+static void precond_apply_amg(const Preconditioner* M, const double* r, double* z) {
+    amg_apply(&((const precond_data*) M->data)->amg, r, z);
+}
+
+static void precond_apply_multigrid(const Preconditioner* M, const double* r, double* z) {
+    multigrid_apply(&((const precond_data*) M->data)->mg, r, z);
+}
+
+static void precond_apply_chebyshev(const Preconditioner* M, const double* r, double* z) {
+    chebyshev_apply(&((const precond_data*) M->data)->cheb, r, z);
+}
+
+static int precond_setup_none(Preconditioner* M) {
+    (void) M;
+    return 0;
+}
+
+// Allocates the inverse diagonal; the callers fill in the diagonal and invert it
+static int precond_alloc_diagonal(Preconditioner* M) {
+    precond_release(M);
+    M->inv_diag = (double*) malloc(M->n * sizeof(double));
+    if (!M->inv_diag) {
+        fprintf(stderr, "Memory allocation failed in the Jacobi preconditioner setup.\n");
+        return -1;
+    }
+    return 0;
+}
+
+static void precond_invert_diagonal(Preconditioner* M) {
+    for (size_t i = 0; i < M->n; ++i) {
+        M->inv_diag[i] = 1.0 / M->inv_diag[i];
+    }
+}
+
+static int precond_setup_jacobi_crs(Preconditioner* M) {
+    if (precond_alloc_diagonal(M) != 0 || crs_extract_diagonal((const CRSMatrix*) M->source, M->inv_diag) != 0) {
+        return -1;
+    }
+    precond_invert_diagonal(M);
+    return 0;
+}
+
+static int precond_setup_jacobi_stencil(Preconditioner* M) {
+    if (precond_alloc_diagonal(M) != 0 || stencil_diagonal((const StencilOperator*) M->source, M->inv_diag) != 0) {
+        return -1;
+    }
+    precond_invert_diagonal(M);
+    return 0;
+}
+
+static int precond_setup_jacobi_dense(Preconditioner* M) {
+    if (precond_alloc_diagonal(M) != 0) {
+        return -1;
+    }
+    const double* A = (const double*) M->source;
+    for (size_t i = 0; i < M->n; ++i) {
+        M->inv_diag[i] = A[i * M->n + i];
+    }
+    precond_invert_diagonal(M);
+    return 0;
+}
+
+static int precond_setup_jacobi_operator(Preconditioner* M) {
+    const LinearOperator* A = (const LinearOperator*) M->source;
+    if (precond_alloc_diagonal(M) != 0 || A->diagonal(A, M->inv_diag) != 0) {
+        return -1;
+    }
+    precond_invert_diagonal(M);
+    return 0;
+}
+
+// Single-precision copy of the built IC factor / multigrid hierarchy (M->precision == SINGLE)
+static int precond_use_single(Preconditioner* M) {
+    precond_data* d = (precond_data*) M->data;
+    if (M->precision != PRECONDITIONER_SINGLE || !d || !d->built) {
+        return 0;
+    }
+    if (M->type == PRECONDITIONER_IC) {
+        if (trisolve_use_single(&d->T) != 0) {
+            return -1;
         }
-        y[i] = sum / L[i * n + i];
+        free(d->L.values);   // Only the float copies are read by the triangular solves
+        d->L.values = NULL;
+    } else if (M->type == PRECONDITIONER_MULTIGRID) {
+        return multigrid_use_single(&d->mg);
     }
+    return 0;
+}
 
-    // Solve L^T * z = y (backward substitution)
-    for (int i = n - 1; i >= 0; --i) {
-        double sum = y[i];
-        for (int j = i + 1; j < n; ++j) {
-            sum -= L[j * n + i] * z[j];
+// IC(0) / MIC(0) factor of A and the analysis of its triangular solves
+static int precond_build_ic(Preconditioner* M, const CRSMatrix* A) {
+    precond_data* d = (precond_data*) M->data;
+    if ((M->variant ? modified_incomplete_cholesky_crs(A, &d->L) : incomplete_cholesky_crs(A, &d->L)) != 0) {
+        fprintf(stderr, "Incomplete Cholesky factorization failed in the preconditioner setup.\n");
+        return -1;
+    }
+    if (trisolve_analyze(&d->L, M->trisolve, &d->T) != 0) {
+        free_crs_matrix(&d->L);
+        return -1;
+    }
+    d->built = 1;
+    M->builds++;
+    return precond_use_single(M);
+}
+
+// New triangular-solve schedule for the built IC factor: only the analysis of L is redone, the
+// factor itself is kept. In single precision the double values of L were freed; they are restored
+// from the float copies (exact), so the new float copies are the same as before.
+static int precond_reschedule_ic(Preconditioner* M) {
+    precond_data* d = (precond_data*) M->data;
+    if (!d || !d->built) {
+        return 0;
+    }
+    if (!d->L.values) {
+        const size_t nnz = d->L.nnz;
+        d->L.values = (double*) malloc(nnz * sizeof(double));
+        if (!d->L.values) {
+            fprintf(stderr, "Memory allocation failed in preconditioner_set_trisolve.\n");
+            return -1;
+        }
+        for (size_t j = 0; j < nnz; ++j) {
+            d->L.values[j] = (double) d->T.values32_fwd[j];
         }
-        z[i] = sum / L[i * n + i];
     }
+    trisolve_free(&d->T);
+    if (trisolve_analyze(&d->L, M->trisolve, &d->T) != 0) {
+        free_crs_matrix(&d->L);
+        d->built = 0;
+        return -1;
+    }
+    return precond_use_single(M);
+}
+
+// Assembles the bound stencil into the CRS matrix of the handle
+static const CRSMatrix* precond_assemble(Preconditioner* M) {
+    precond_data* d = (precond_data*) M->data;
+    if (stencil_to_crs((const StencilOperator*) M->source, &d->assembled) != 0) {
+        return NULL;
+    }
+    return &d->assembled;
+}
+
+static int precond_setup_ic_crs(Preconditioner* M) {
+    precond_release(M);
+    return precond_build_ic(M, (const CRSMatrix*) M->source);
+}
+
+static int precond_setup_ic_stencil(Preconditioner* M) {
+    precond_release(M);
+    const CRSMatrix* A = precond_assemble(M);
+    return A ? precond_build_ic(M, A) : -1;
+}
 
-    free(y);
+static int precond_setup_ic_dense(Preconditioner* M) {
+    precond_data* d = (precond_data*) M->data;
+    precond_release(M);
+    if (incomplete_cholesky((const double*) M->source, &d->L, (int) M->n) != 0) {
+        fprintf(stderr, "Incomplete Cholesky factorization failed in the preconditioner setup.\n");
+        return -1;
+    }
+    if (trisolve_analyze(&d->L, M->trisolve, &d->T) != 0) {
+        free_crs_matrix(&d->L);
+        return -1;
+    }
+    d->built = 1;
+    M->builds++;
+    return precond_use_single(M);
+}
+
+static int precond_build_amg(Preconditioner* M, const CRSMatrix* A) {
+    precond_data* d = (precond_data*) M->data;
+    if (amg_setup(A, &d->amg) != 0) {
+        return -1;
+    }
+    d->built = 1;
+    M->builds++;
+    return 0;
+}
+
+static int precond_setup_amg_crs(Preconditioner* M) {
+    precond_release(M);
+    return precond_build_amg(M, (const CRSMatrix*) M->source);
+}
+
+static int precond_setup_amg_stencil(Preconditioner* M) {
+    precond_release(M);
+    const CRSMatrix* A = precond_assemble(M);
+    return A ? precond_build_amg(M, A) : -1;
+}
+
+static int precond_setup_multigrid(Preconditioner* M) {
+    precond_data* d = (precond_data*) M->data;
+    precond_release(M);
+    if (multigrid_setup((const StencilOperator*) M->source, M->variant ? MULTIGRID_W_CYCLE : MULTIGRID_V_CYCLE,
+                        &d->mg) != 0) {
+        return -1;
+    }
+    d->built = 1;
+    M->builds++;
+    return precond_use_single(M);
+}
+
+// Chebyshev polynomial of degree M->variant of the operator A, with its Lanczos bounds
+static int precond_build_chebyshev(Preconditioner* M, const LinearOperator* A) {
+    precond_data* d = (precond_data*) M->data;
+    if (chebyshev_setup(A, M->variant, CHEBYSHEV_PRECONDITIONER, &d->cheb) != 0) {
+        return -1;
+    }
+    d->built = 1;
+    M->builds++;
+    return 0;
+}
+
+static int precond_setup_chebyshev_crs(Preconditioner* M) {
+    LinearOperator A;
+    precond_release(M);
+    return (linear_operator_crs(&A, (const CRSMatrix*) M->source) == 0) ? precond_build_chebyshev(M, &A) : -1;
+}
+
+static int precond_setup_chebyshev_stencil(Preconditioner* M) {
+    LinearOperator A;
+    precond_release(M);
+    return (linear_operator_stencil(&A, (const StencilOperator*) M->source) == 0) ? precond_build_chebyshev(M, &A) : -1;
+}
+
+static int precond_setup_chebyshev_operator(Preconditioner* M) {
+    precond_release(M);
+    return precond_build_chebyshev(M, (const LinearOperator*) M->source);
+}
+
+// Maps a 'Preconditioner_type' name onto the method (and variant); returns -1 for unknown names
+static int precond_parse(const char* name, PreconditionerType* type, int* variant) {
+    *variant = 0;
+    if (strcmp(name, "None") == 0 || strcmp(name, "Default") == 0) {
+        *type = PRECONDITIONER_NONE;
+    } else if (strcmp(name, "Jacobi") == 0) {
+        *type = PRECONDITIONER_JACOBI;
+    } else if (strcmp(name, "IncompleteCholesky") == 0 || strcmp(name, "ModifiedIncompleteCholesky") == 0) {
+        *type = PRECONDITIONER_IC;
+        *variant = (name[0] == 'M');
+    } else if (strcmp(name, "AMG") == 0) {
+        *type = PRECONDITIONER_AMG;
+    } else if (strcmp(name, "Multigrid") == 0 || strcmp(name, "MultigridW") == 0) {
+        *type = PRECONDITIONER_MULTIGRID;
+        *variant = (strcmp(name, "MultigridW") == 0);
+    } else if (strcmp(name, "Chebyshev") == 0) {
+        *type = PRECONDITIONER_CHEBYSHEV;
+        *variant = CHEBYSHEV_DEFAULT_DEGREE;
+    } else if (strncmp(name, "Chebyshev(", 10) == 0) {
+        int len = 0;
+        if (sscanf(name, "Chebyshev(%d)%n", variant, &len) != 1 || len == 0 || name[len] != '\0' || *variant < 1) {
+            return -1;
+        }
+        *type = PRECONDITIONER_CHEBYSHEV;
+    } else {
+        return -1;
+    }
+    return 0;
+}
+
+// Empty handle, so that preconditioner_free is safe whatever the factory returns
+static void precond_clear(Preconditioner* M) {
+    M->type = PRECONDITIONER_NONE;
+    M->n = 0;
+    M->setup = NULL;
+    M->apply = NULL;
+    M->apply_team = NULL;
+    M->destroy = precond_destroy;
+    M->source = NULL;
+    M->variant = 0;
+    M->precision = PRECONDITIONER_DOUBLE;
+    M->trisolve = TRISOLVE_LEVEL_SCHEDULE;
+    M->inv_diag = NULL;
+    M->data = NULL;
+    M->builds = 0;
+}
+
+/*
+ * Binds the method to the handle and runs the first setup. The setup / apply functions are
+ * indexed by the method: [NONE, JACOBI, IC, AMG, MULTIGRID, CHEBYSHEV], NULL if the source does not
+ * support it.
+ */
+static int precond_create(Preconditioner* M, const void* source, size_t n, const char* name,
+                          int (*const setups[6])(Preconditioner*), const char* caller) {
+    static void (*const applies[6])(const Preconditioner*, const double*, double*) = {
+        precond_apply_identity, precond_apply_jacobi, precond_apply_ic, precond_apply_amg, precond_apply_multigrid,
+        precond_apply_chebyshev
+    };
+
+    PreconditionerType type;
+    int variant;
+    if (precond_parse(name, &type, &variant) != 0 || !setups[type]) {
+        fprintf(stderr, "Preconditioner '%s' is not supported by %s.\n", name, caller);
+        return -1;
+    }
 
-}
\ No newline at end of file
+    M->type = type;
+    M->n = n;
+    M->source = source;
+    M->variant = variant;
+    M->setup = setups[type];
+    M->apply = applies[type];
+    M->apply_team = (type == PRECONDITIONER_IC) ? precond_apply_ic_team : NULL;
+    if (type != PRECONDITIONER_NONE && type != PRECONDITIONER_JACOBI) {
+        precond_data* d = (precond_data*) calloc(1, sizeof(precond_data));
+        if (!d) {
+            fprintf(stderr, "Memory allocation failed in %s.\n", caller);
+            precond_destroy(M);
+            return -1;
+        }
+        d->assembled = PRECOND_EMPTY_MATRIX;
+        d->L = PRECOND_EMPTY_MATRIX;
+        M->data = d;
+    }
+
+    if (M->setup(M) != 0) {
+        fprintf(stderr, "Setup of the preconditioner '%s' failed in %s.\n", name, caller);
+        precond_destroy(M);
+        return -1;
+    }
+    return 0;
+}
+
+/*
+ * Function: preconditioner_crs
+ * ----------------------------
+ * Creates the preconditioner 'type' of a CRS matrix and sets it up.
+ *
+ * Parameters:
+ *   M    - Handle (free with preconditioner_free)
+ *   A    - Validated CRS matrix, bound to the handle (not copied, must outlive it)
+ *   type - "None", "Jacobi", "IncompleteCholesky", "ModifiedIncompleteCholesky", "AMG",
+ *          "Chebyshev" or "Chebyshev(k)"
+ *
+ * Returns:
+ *   - 0 on success
+ *   - -1 on invalid input, an unsupported type or a failed setup
+ */
+int preconditioner_crs(Preconditioner* M, const CRSMatrix* A, const char* type) {
+    static int (*const setups[6])(Preconditioner*) = {
+        precond_setup_none, precond_setup_jacobi_crs, precond_setup_ic_crs, precond_setup_amg_crs, NULL,
+        precond_setup_chebyshev_crs
+    };
+    if (!M) {
+        fprintf(stderr, "Invalid input to preconditioner_crs.\n");
+        return -1;
+    }
+    precond_clear(M);
+    if (!A || !type || !A->validated || A->rows != A->cols) {
+        fprintf(stderr, "Invalid input to preconditioner_crs.\n");
+        return -1;
+    }
+    return precond_create(M, A, A->rows, type, setups, "preconditioner_crs");
+}
+
+/*
+ * Function: preconditioner_stencil
+ * --------------------------------
+ * Creates the preconditioner 'type' of the matrix-free grid stencil and sets it up. Jacobi,
+ * Chebyshev and geometric multigrid work on the stencil itself; incomplete Cholesky and AMG need the matrix
+ * entries, so their setup assembles the stencil into a CRS matrix kept by the handle.
+ *
+ * Returns:
+ *   - 0 on success
+ *   - -1 on invalid input, an unsupported type or a failed setup
+ */
+int preconditioner_stencil(Preconditioner* M, const StencilOperator* S, const char* type) {
+    static int (*const setups[6])(Preconditioner*) = {
+        precond_setup_none, precond_setup_jacobi_stencil, precond_setup_ic_stencil, precond_setup_amg_stencil,
+        precond_setup_multigrid, precond_setup_chebyshev_stencil
+    };
+    if (!M) {
+        fprintf(stderr, "Invalid input to preconditioner_stencil.\n");
+        return -1;
+    }
+    precond_clear(M);
+    if (!S || !type || S->nx <= 0 || S->ny <= 0 || S->nz <= 0) {
+        fprintf(stderr, "Invalid input to preconditioner_stencil.\n");
+        return -1;
+    }
+    return precond_create(M, S, (size_t) S->nx * S->ny * S->nz, type, setups, "preconditioner_stencil");
+}
+
+/*
+ * Function: preconditioner_dense
+ * ------------------------------
+ * Creates the preconditioner 'type' ("None", "Jacobi" or "IncompleteCholesky") of a dense
+ * row-major n x n matrix and sets it up. The IC factor is sparse (see incomplete_cholesky).
+ *
+ * Returns:
+ *   - 0 on success
+ *   - -1 on invalid input, an unsupported type or a failed setup
+ */
+int preconditioner_dense(Preconditioner* M, const double* A, int n, const char* type) {
+    static int (*const setups[6])(Preconditioner*) = {
+        precond_setup_none, precond_setup_jacobi_dense, precond_setup_ic_dense, NULL, NULL, NULL
+    };
+    if (!M) {
+        fprintf(stderr, "Invalid input to preconditioner_dense.\n");
+        return -1;
+    }
+    precond_clear(M);
+    if (!A || !type || n <= 0 || strcmp(type, "ModifiedIncompleteCholesky") == 0) {
+        fprintf(stderr, "Invalid input to preconditioner_dense.\n");
+        return -1;
+    }
+    return precond_create(M, A, (size_t) n, type, setups, "preconditioner_dense");
+}
+
+/*
+ * Function: preconditioner_operator
+ * ---------------------------------
+ * Creates the preconditioner 'type' ("None", "Jacobi", "Chebyshev" or "Chebyshev(k)") of an
+ * abstract linear operator and sets it up; Jacobi and Chebyshev need 'A->diagonal'.
+ *
+ * Returns:
+ *   - 0 on success
+ *   - -1 on invalid input, an unsupported type or a failed setup
+ */
+int preconditioner_operator(Preconditioner* M, const LinearOperator* A, const char* type) {
+    static int (*const setups[6])(Preconditioner*) = {
+        precond_setup_none, precond_setup_jacobi_operator, NULL, NULL, NULL, precond_setup_chebyshev_operator
+    };
+    if (!M) {
+        fprintf(stderr, "Invalid input to preconditioner_operator.\n");
+        return -1;
+    }
+    precond_clear(M);
+    if (!A || !type) {
+        fprintf(stderr, "Invalid input to preconditioner_operator.\n");
+        return -1;
+    }
+    if ((strcmp(type, "Jacobi") == 0 || strncmp(type, "Chebyshev", 9) == 0) && !A->diagonal) {
+        fprintf(stderr, "Jacobi and Chebyshev preconditioners require the diagonal of the operator.\n");
+        return -1;
+    }
+    return precond_create(M, A, A->n, type, setups, "preconditioner_operator");
+}
+
+/*
+ * Function: preconditioner_set_precision
+ * --------------------------------------
+ * Selects the precision of the factor (IC) or of the cycles (multigrid) of the handle. Going
+ * to single precision converts what setup built in place; going back to double runs setup
+ * again. Later setups keep the precision. Jacobi, AMG, Chebyshev and "None" always stay in double.
+ *
+ * The single-precision preconditioner is a slightly different (still symmetric positive
+ * definite) approximation of A^(-1); the solution accuracy is unchanged, as the solvers keep
+ * x, r and all reductions in double.
+ *
+ * Returns:
+ *   - 0 on success
+ *   - -1 on invalid input or a failed conversion / setup
+ */
+int preconditioner_set_precision(Preconditioner* M, PreconditionerPrecision precision) {
+    if (!M || (precision != PRECONDITIONER_DOUBLE && precision != PRECONDITIONER_SINGLE)) {
+        fprintf(stderr, "Invalid input to preconditioner_set_precision.\n");
+        return -1;
+    }
+    if (precision == M->precision) {
+        return 0;
+    }
+    M->precision = precision;
+    if (M->type != PRECONDITIONER_IC && M->type != PRECONDITIONER_MULTIGRID) {
+        return 0;
+    }
+    if (precision == PRECONDITIONER_SINGLE) {
+        if (precond_use_single(M) != 0) {
+            M->precision = PRECONDITIONER_DOUBLE;   // The built factor / hierarchy is unchanged
+            return -1;
+        }
+        return 0;
+    }
+    return M->setup ? M->setup(M) : 0;
+}
+
+/*
+ * Function: preconditioner_set_trisolve
+ * -------------------------------------
+ * Selects the parallel schedule of the triangular solves of an incomplete Cholesky handle
+ * (see triangular_solve.c): TRISOLVE_LEVEL_SCHEDULE (the default, one barrier per level) or
+ * TRISOLVE_SYNC_FREE (atomic dependency counters, no barriers). Only the analysis of the built
+ * factor is redone (O(nnz)); the factorization is not repeated. Later setups keep the schedule.
+ * No effect on the other methods.
+ *
+ * Returns:
+ *   - 0 on success
+ *   - -1 on invalid input or a failed analysis (the handle must then be set up again)
+ */
+int preconditioner_set_trisolve(Preconditioner* M, TriangularSolveMethod method) {
+    if (!M || (method != TRISOLVE_LEVEL_SCHEDULE && method != TRISOLVE_SYNC_FREE)) {
+        fprintf(stderr, "Invalid input to preconditioner_set_trisolve.\n");
+        return -1;
+    }
+    if (method == M->trisolve) {
+        return 0;
+    }
+    M->trisolve = method;
+    return (M->type == PRECONDITIONER_IC) ? precond_reschedule_ic(M) : 0;
+}
+
+/*
+ * Function: preconditioner_set_spectrum
+ * -------------------------------------
+ * Replaces the Lanczos bounds of the spectrum of D^(-1) * A cached by a Chebyshev handle, e.g.
+ * by chebyshev_cg_bounds of the coefficients of an earlier Jacobi-PCG solve of the same
+ * operator (pcg_solver_record). The next setup estimates them again.
+ *
+ * Returns:
+ *   - 0 on success
+ *   - -1 on invalid input (not a Chebyshev handle, or not 0 < eig_min <= eig_max)
+ */
+int preconditioner_set_spectrum(Preconditioner* M, double eig_min, double eig_max) {
+    if (!M || M->type != PRECONDITIONER_CHEBYSHEV || !M->data || !((precond_data*) M->data)->built) {
+        fprintf(stderr, "Invalid input to preconditioner_set_spectrum.\n");
+        return -1;
+    }
+    return chebyshev_set_bounds(&((precond_data*) M->data)->cheb, eig_min, eig_max);
+}
+
+/*
+ * Function: preconditioner_free
+ * -----------------------------
+ * Releases the preconditioner (M->destroy). Safe after a failed factory call.
+ */
+void preconditioner_free(Preconditioner* M) {
+    if (M && M->destroy) {
+        M->destroy(M);
+    }
+}
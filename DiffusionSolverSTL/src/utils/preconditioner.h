@@ -5,9 +5,108 @@
 #ifndef PROJECT_02_FVM_PRECONDITIONER_H
 #define PROJECT_02_FVM_PRECONDITIONER_H
 
+#include <stddef.h>  // for size_t
+#include "matrix_operations/CRSMatrix.h"
+#include "matrix_operations/linear_operator.h"
+#include "matrix_operations/stencil_operator.h"
+#include "matrix_operations/triangular_solve.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
 void precondition(const double* M, const double* r, double* z, int n);
 void jacobi_precondition(const double* A, const double* r, double* z, int n);
-void incomplete_cholesky(const double* A, double* L, int n);
-void ic_precondition(const double* L, const double* r, double* z, int n);
+int incomplete_cholesky(const double* A, CRSMatrix* L, int n);     // Dense A, sparse IC(0) factor
+
+// Sparse (CRS) versions
+void jacobi_precondition_crs(const double* inv_diag, const double* r, double* z, int n);
+int incomplete_cholesky_crs(const CRSMatrix* A, CRSMatrix* L);
+int modified_incomplete_cholesky_crs(const CRSMatrix* A, CRSMatrix* L);
+void ic_precondition_crs(const CRSMatrix* L, const double* r, double* z);
+
+/*
+ * @enum PreconditionerType
+ * Method of a 'Preconditioner' handle.
+ */
+typedef enum {
+    PRECONDITIONER_NONE = 0,      // Identity
+    PRECONDITIONER_JACOBI,        // Inverse diagonal
+    PRECONDITIONER_IC,            // Sparse IC(0) / MIC(0) factor with analyzed triangular solves
+    PRECONDITIONER_AMG,           // Smoothed-aggregation AMG V-cycle
+    PRECONDITIONER_MULTIGRID,     // Geometric multigrid V / W-cycle (structured grid only)
+    PRECONDITIONER_CHEBYSHEV      // Jacobi-preconditioned Chebyshev polynomial (no inner products)
+} PreconditionerType;
+
+/*
+ * @enum PreconditionerPrecision
+ * Storage precision of the factor / hierarchy of a handle (see preconditioner_set_precision).
+ */
+typedef enum {
+    PRECONDITIONER_DOUBLE = 0,
+    PRECONDITIONER_SINGLE         // IC factor values and multigrid cycles in float
+} PreconditionerPrecision;
+
+/*
+ * @struct Preconditioner
+ * z = M^(-1) * r for the Krylov solvers. A factory (preconditioner_crs, preconditioner_stencil,
+ * ...) maps the 'Preconditioner_type' name onto the methods once and runs 'setup'; the solvers
+ * then only call 'apply', so nothing is looked up or recomputed per iteration, and one handle
+ * can be reused by every solve of a run (e.g. every time step).
+ *
+ * 'setup' rebuilds the preconditioner from the bound operator; call it again after the values
+ * of the operator changed (same sparsity pattern / grid). 'apply_team' is the same as 'apply'
+ * executed by all threads of an enclosing parallel region (NULL if not available).
+ *
+ * The bound operator is not owned and must outlive the handle. Multigrid hierarchies keep work
+ * vectors, so a handle must not be applied by two threads at the same time.
+ */
+typedef struct Preconditioner Preconditioner;
+struct Preconditioner {
+    PreconditionerType type;
+    size_t n;                                                                  // Number of rows
+    int (*setup)(Preconditioner* M);                                           // (Re)build from 'source'
+    void (*apply)(const Preconditioner* M, const double* r, double* z);        // z = M^(-1) * r
+    void (*apply_team)(const Preconditioner* M, const double* r, double* z);   // May be NULL
+    void (*destroy)(Preconditioner* M);                                        // Release everything
+    const void* source;           // Bound operator (CRS matrix, stencil, dense array or LinearOperator)
+    int variant;                  // MIC(0) for IC, W-cycle for multigrid, degree for Chebyshev
+    PreconditionerPrecision precision;   // Kept by 'setup' (double for Jacobi and AMG)
+    TriangularSolveMethod trisolve;      // Schedule of the IC triangular solves, kept by 'setup'
+    double* inv_diag;             // Inverse diagonal (Jacobi)
+    void* data;                   // Factor, hierarchy or polynomial (IC, AMG, multigrid, Chebyshev)
+    int builds;                   // Number of times 'setup' built the factor / hierarchy / polynomial
+};
+
+// Preconditioner of a CRS matrix: "None", "Jacobi", "IncompleteCholesky", "ModifiedIncompleteCholesky", "AMG",
+// "Chebyshev" or "Chebyshev(k)" (polynomial degree k)
+int preconditioner_crs(Preconditioner* M, const CRSMatrix* A, const char* type);
+
+// Preconditioner of the grid stencil: "None", "Jacobi", "Multigrid", "MultigridW", "Chebyshev(k)"; the
+// CRS methods assemble the stencil (again at every setup)
+int preconditioner_stencil(Preconditioner* M, const StencilOperator* S, const char* type);
+
+// Preconditioner of a dense row-major n x n matrix: "None", "Jacobi", "IncompleteCholesky" (sparse factor)
+int preconditioner_dense(Preconditioner* M, const double* A, int n, const char* type);
+
+// Preconditioner of an abstract operator: "None", "Jacobi" or "Chebyshev(k)" (both need 'A->diagonal')
+int preconditioner_operator(Preconditioner* M, const LinearOperator* A, const char* type);
+
+// Switch the IC factor / multigrid hierarchy to single (or back to double) precision; r and z stay
+// double. No effect on the other methods. Use with pcg_solver_refinement to reach the tolerance.
+int preconditioner_set_precision(Preconditioner* M, PreconditionerPrecision precision);
+
+// Schedule of the IC triangular solves: level schedule (default) or sync-free; re-analyses the IC factor
+int preconditioner_set_trisolve(Preconditioner* M, TriangularSolveMethod method);
+
+// Replace the spectral bounds of D^(-1) * A cached by a Chebyshev handle (e.g. from chebyshev_cg_bounds)
+int preconditioner_set_spectrum(Preconditioner* M, double eig_min, double eig_max);
+
+// Calls M->destroy (safe on a handle whose factory failed)
+void preconditioner_free(Preconditioner* M);
+
+#ifdef __cplusplus
+}
+#endif
 
-#endif //PROJECT_02_FVM_PRECONDITIONER_H
\ No newline at end of file
+#endif //PROJECT_02_FVM_PRECONDITIONER_H
@@ -0,0 +1,83 @@
+/*
+ * File: solver_workspace.c
+ * ------------------------
+ * This file contains the scratch memory arena of the solvers. Every solve needs a handful of
+ * work vectors (PCG: r, z, p, A * p; GMRES: the Krylov basis, ...); allocating and freeing them
+ * on every call costs system calls and page faults for large vectors, and inside a time loop
+ * the sizes never change. A 'SolverWorkspace' keeps ONE block alive between solves and hands
+ * out 64-byte aligned slices of it (bump allocation), so only the first solve (or a larger
+ * one) allocates.
+ *
+ * Functions:
+ *  - workspace_size: Aligned size of a vector.
+ *  - workspace_reserve: Grow the block if needed and start a new set of vectors.
+ *  - workspace_take: Cut the next vector out of the block.
+ *  - workspace_free: Release the block.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include "solver_workspace.h"
+
+#define WORKSPACE_ALIGN_DOUBLES (WORKSPACE_ALIGNMENT / sizeof(double))
+
+size_t workspace_size(size_t n) {
+    return (n + WORKSPACE_ALIGN_DOUBLES - 1) / WORKSPACE_ALIGN_DOUBLES * WORKSPACE_ALIGN_DOUBLES;
+}
+
+/*
+ * Function: workspace_reserve
+ * ---------------------------
+ * Ensures that 'doubles' aligned doubles are available and resets the workspace, so the
+ * vectors of the previous solve are released (their contents are not kept). The block is
+ * reallocated only if it is too small.
+ *
+ * Returns:
+ *   - 0 on success
+ *   - -1 on invalid input or if the allocation fails (the workspace is then empty)
+ */
+int workspace_reserve(SolverWorkspace* ws, size_t doubles) {
+    if (!ws) {
+        fprintf(stderr, "Invalid input to workspace_reserve.\n");
+        return -1;
+    }
+    ws->used = 0;
+    if (doubles <= ws->capacity) {
+        return 0;
+    }
+
+    // malloc only guarantees the alignment of the largest scalar type: over-allocate one line
+    free(ws->block);
+    ws->block = malloc(doubles * sizeof(double) + WORKSPACE_ALIGNMENT);
+    if (!ws->block) {
+        fprintf(stderr, "Memory allocation failed in workspace_reserve.\n");
+        ws->data = NULL;
+        ws->capacity = 0;
+        return -1;
+    }
+    const uintptr_t address = (uintptr_t) ws->block;
+    ws->data = (double*) ((address + WORKSPACE_ALIGNMENT - 1) & ~(uintptr_t) (WORKSPACE_ALIGNMENT - 1));
+    ws->capacity = doubles;
+    ws->allocations++;
+    return 0;
+}
+
+double* workspace_take(SolverWorkspace* ws, size_t n) {
+    const size_t size = workspace_size(n);
+    if (!ws || ws->used + size > ws->capacity) {
+        return NULL;
+    }
+    double* v = ws->data + ws->used;
+    ws->used += size;
+    return v;
+}
+
+void workspace_free(SolverWorkspace* ws) {
+    if (!ws) return;
+    free(ws->block);
+    ws->block = NULL;
+    ws->data = NULL;
+    ws->capacity = 0;
+    ws->used = 0;
+}
@@ -0,0 +1,49 @@
+#ifndef PROJECT_02_FVM_SOLVER_WORKSPACE_H
+#define PROJECT_02_FVM_SOLVER_WORKSPACE_H
+
+#include <stddef.h>  // for size_t
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Alignment of every vector handed out by a workspace (one cache line / one AVX-512 register)
+#define WORKSPACE_ALIGNMENT 64
+
+/*
+ * @struct SolverWorkspace
+ * Scratch memory of the Krylov solvers, kept across solves (e.g. one workspace per time loop).
+ * A solver reserves the total size it needs, then cuts its work vectors out of the block with
+ * 'workspace_take'; the block is only reallocated when a solve needs more than any solve
+ * before, so repeated solves of the same size never call the allocator.
+ *
+ * Vectors taken from a workspace are valid until the next 'workspace_reserve' (i.e. the next
+ * solve), so one workspace must not be shared by two solves running at the same time.
+ * Zero-initialize (or use SOLVER_WORKSPACE_INIT) before the first use.
+ */
+typedef struct {
+    void* block;                  // Allocation (unaligned)
+    double* data;                 // First aligned double of 'block'
+    size_t capacity;              // Usable size in doubles
+    size_t used;                  // Doubles handed out since the last reserve
+    size_t allocations;           // Number of times the block was (re)allocated
+} SolverWorkspace;
+
+#define SOLVER_WORKSPACE_INIT {NULL, NULL, 0, 0, 0}
+
+// Space (in doubles) occupied by a vector of n doubles, rounded up to the alignment
+size_t workspace_size(size_t n);
+
+// Make room for 'doubles' (sum of workspace_size of all vectors), release previous vectors
+int workspace_reserve(SolverWorkspace* ws, size_t doubles);
+
+// Next aligned vector of n doubles (uninitialized), NULL if the reservation is exceeded
+double* workspace_take(SolverWorkspace* ws, size_t n);
+
+void workspace_free(SolverWorkspace* ws);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif //PROJECT_02_FVM_SOLVER_WORKSPACE_H
@@ -14,13 +14,19 @@
  * 3. Large size sparse matrix
  * 4. Extreme large sparse matrix (for performance testing)
  * 5. Edge cases: all-zero matrix, and a matrix with a large number of non-zero elements.
+ * 6. COO triplets with duplicates (coo_to_crs).
+ * 7. Reordering: RCM, Morton / Hilbert orderings and the symmetric permutation (reordering.c).
  */
 
 #include <gtest/gtest.h>
 #include <vector>
 #include <cstdlib>
 #include <random>
+#include <algorithm>
+#include <cmath>
 #include "CRSMatrix.h"
+#include "linear_algebra.h"
+#include "reordering.h"
 
 using namespace std;
 // Helper function to generate a large sparse matrix
@@ -53,13 +59,56 @@ vector<vector<double>> gen_large_sparse_matrix(size_t rows, size_t cols, double
 // Test for the small size of sparse matrix
 // Verifies that a small 3x3 sparse matrix is correctly converted to CRS format.
 TEST(CRSTest, smallMatrixTest) {
-
+    const double dense[9] = {1.0, 0.0, 2.0,
+                             0.0, 0.0, 0.0,
+                             0.0, 3.0, 0.0};
+    CRSMatrix A{};
+    ASSERT_EQ(dense_to_crs(dense, 3, 3, &A), 0);
+    EXPECT_EQ(A.validated, 1);
+    ASSERT_EQ(A.nnz, 3u);
+    const size_t row_ptr[4] = {0, 2, 2, 3};
+    const size_t col_idx[3] = {0, 2, 1};
+    const double values[3] = {1.0, 2.0, 3.0};
+    for (size_t i = 0; i < 4; ++i) {
+        EXPECT_EQ(A.row_ptr[i], row_ptr[i]);
+    }
+    for (size_t k = 0; k < 3; ++k) {
+        EXPECT_EQ(crs_col(&A, k), col_idx[k]);
+        EXPECT_EQ(A.values[k], values[k]);
+    }
+    free_crs_matrix(&A);
 }
 
 // Test for the medium size of sparse matrix
 // Verifies that a medium 100x100 sparse matrix is correctly converted to CRS format.
 TEST(CRSTest, MiddleMatrixTest) {
+    const size_t n = 100;
+    vector<vector<double>> M = gen_large_sparse_matrix(n, n, 0.05);
+    vector<double> dense(n * n);
+    size_t nnz = 0;
+    for (size_t i = 0; i < n; ++i) {
+        for (size_t j = 0; j < n; ++j) {
+            dense[i * n + j] = M[i][j];
+            nnz += (M[i][j] != 0.0);
+        }
+    }
+    CRSMatrix A{};
+    ASSERT_EQ(dense_to_crs(dense.data(), n, n, &A), 0);
+    ASSERT_EQ(A.nnz, nnz);
+    ASSERT_EQ(A.row_ptr[n], nnz);
 
+    // Rebuild the dense matrix from the CRS arrays
+    vector<double> back(n * n, 0.0);
+    for (size_t i = 0; i < n; ++i) {
+        for (size_t k = A.row_ptr[i]; k < A.row_ptr[i + 1]; ++k) {
+            if (k > A.row_ptr[i]) {
+                EXPECT_LT(crs_col(&A, k - 1), crs_col(&A, k));
+            }
+            back[i * n + crs_col(&A, k)] = A.values[k];
+        }
+    }
+    EXPECT_EQ(back, dense);
+    free_crs_matrix(&A);
 }
 
 // Test for the large size of sparse matrix
@@ -79,6 +128,149 @@ TEST(CRSTest, ExtremeMatrixTest) {
     // Test implementation goes here
 }
 
+// COO triplets in any order with repeated positions: duplicates are summed, rows sorted, empty
+// rows kept; the large case also crosses the parallel threshold and the qsort row length
+TEST(CRSTest, COOToCRSMergesDuplicates) {
+    const vector<size_t> row = {2, 0, 2, 0, 3, 0, 2};
+    const vector<size_t> col = {1, 3, 0, 0, 3, 3, 1};
+    const vector<double> val = {1.0, 2.0, 3.0, 4.0, 5.0, 6.0, 7.0};
+    CRSMatrix A{};
+    ASSERT_EQ(coo_to_crs(row.data(), col.data(), val.data(), row.size(), 4, 4, &A), 0);
+    EXPECT_EQ(A.validated, 1);
+    ASSERT_EQ(A.nnz, 5u);
+    const vector<size_t> row_ptr = {0, 2, 2, 4, 5};
+    const vector<size_t> col_idx = {0, 3, 0, 1, 3};
+    const vector<double> values = {4.0, 8.0, 3.0, 8.0, 5.0};
+    EXPECT_EQ(vector<size_t>(A.row_ptr, A.row_ptr + 5), row_ptr);
+    for (size_t k = 0; k < 5; ++k) {
+        EXPECT_EQ(crs_col(&A, k), col_idx[k]);
+    }
+    EXPECT_EQ(vector<double>(A.values, A.values + 5), values);
+    free_crs_matrix(&A);
+
+    // Random triplets against a dense accumulation (row 0 is long and dense)
+    const size_t n = 300, m = 200000;
+    mt19937 gen(7);
+    uniform_int_distribution<size_t> index(0, n - 1);
+    uniform_int_distribution<int> small(1, 8);
+    vector<size_t> r(m), c(m);
+    vector<double> v(m);
+    vector<double> dense(n * n, 0.0);
+    for (size_t e = 0; e < m; ++e) {
+        r[e] = (e % 10 == 0) ? 0 : index(gen);
+        c[e] = index(gen);
+        v[e] = small(gen);      // Small integers: the sums are exact in any order
+        dense[r[e] * n + c[e]] += v[e];
+    }
+    ASSERT_EQ(coo_to_crs(r.data(), c.data(), v.data(), m, n, n, &A), 0);
+    vector<double> back(n * n, 0.0);
+    for (size_t i = 0; i < n; ++i) {
+        for (size_t k = A.row_ptr[i]; k < A.row_ptr[i + 1]; ++k) {
+            if (k > A.row_ptr[i]) {
+                ASSERT_LT(crs_col(&A, k - 1), crs_col(&A, k));
+            }
+            back[i * n + crs_col(&A, k)] = A.values[k];
+        }
+    }
+    EXPECT_EQ(back, dense);
+    free_crs_matrix(&A);
+
+    // Non-integer values: duplicates are summed in input order, whatever the scatter order of
+    // the threads, so the sums match a serial accumulation bit for bit
+    uniform_real_distribution<double> real(-1.0, 1.0);
+    fill(dense.begin(), dense.end(), 0.0);
+    for (size_t e = 0; e < m; ++e) {
+        v[e] = real(gen);
+        dense[r[e] * n + c[e]] += v[e];
+    }
+    ASSERT_EQ(coo_to_crs(r.data(), c.data(), v.data(), m, n, n, &A), 0);
+    fill(back.begin(), back.end(), 0.0);
+    for (size_t i = 0; i < n; ++i) {
+        for (size_t k = A.row_ptr[i]; k < A.row_ptr[i + 1]; ++k) {
+            back[i * n + crs_col(&A, k)] = A.values[k];
+        }
+    }
+    EXPECT_EQ(back, dense);
+    free_crs_matrix(&A);
+
+    // No triplets: empty but valid matrix; out-of-range indices are rejected
+    ASSERT_EQ(coo_to_crs(nullptr, nullptr, nullptr, 0, 3, 3, &A), 0);
+    EXPECT_EQ(A.nnz, 0u);
+    free_crs_matrix(&A);
+    const size_t bad_row = 4, zero = 0;
+    const double one = 1.0;
+    EXPECT_EQ(coo_to_crs(&bad_row, &zero, &one, 1, 4, 4, &A), -1);
+    free_crs_matrix(&A);
+}
+
+// 7-point Laplacian of an nx x ny x nz grid (lexicographic cells) with its rows renumbered by
+// a random permutation: RCM restores a narrow band, P * A * P^T keeps the products consistent
+// and the space-filling curves are permutations (the Hilbert curve steps to face neighbours)
+TEST(CRSTest, ReorderingPermutesSymmetrically) {
+    const int nx = 12, ny = 10, nz = 8;
+    const size_t n = (size_t) nx * ny * nz;
+    vector<size_t> shuffle(n);
+    for (size_t i = 0; i < n; ++i) shuffle[i] = i;
+    mt19937 gen(3);
+    std::shuffle(shuffle.begin(), shuffle.end(), gen);
+    vector<size_t> r, c;
+    vector<double> v;
+    for (int k = 0; k < nz; ++k)
+        for (int j = 0; j < ny; ++j)
+            for (int i = 0; i < nx; ++i) {
+                const size_t p = ((size_t) k * ny + j) * nx + i;
+                const int d[6][3] = {{-1, 0, 0}, {1, 0, 0}, {0, -1, 0}, {0, 1, 0}, {0, 0, -1}, {0, 0, 1}};
+                r.push_back(shuffle[p]); c.push_back(shuffle[p]); v.push_back(6.5);
+                for (const auto& o : d) {
+                    const int a = i + o[0], b = j + o[1], e = k + o[2];
+                    if (a < 0 || a >= nx || b < 0 || b >= ny || e < 0 || e >= nz) continue;
+                    r.push_back(shuffle[p]); c.push_back(shuffle[((size_t) e * ny + b) * nx + a]); v.push_back(-1.0);
+                }
+            }
+    CRSMatrix A{}, B{};
+    ASSERT_EQ(coo_to_crs(r.data(), c.data(), v.data(), r.size(), n, n, &A), 0);
+
+    vector<size_t> perm(n), inv(n);
+    ASSERT_EQ(crs_rcm_ordering(&A, perm.data()), 0);
+    ASSERT_EQ(permutation_invert(perm.data(), n, inv.data()), 0);
+    ASSERT_EQ(crs_permute_symmetric(&A, perm.data(), &B), 0);
+    EXPECT_GT(crs_bandwidth(&A), n / 2);
+    EXPECT_LE(crs_bandwidth(&B), 2 * (size_t) nx * ny);
+    EXPECT_EQ(B.nnz, A.nnz);
+
+    // (P A P^T)(P x) = P (A x); unpermute is the inverse of permute
+    vector<double> x(n), Ax(n), Px(n), BPx(n), PAx(n), back(n);
+    for (size_t i = 0; i < n; ++i) x[i] = sin(0.1 * (double) i);
+    ASSERT_EQ(crs_mat_vec_mult(&A, x.data(), Ax.data()), 0);
+    permute_vector(perm.data(), x.data(), Px.data(), n);
+    ASSERT_EQ(crs_mat_vec_mult(&B, Px.data(), BPx.data()), 0);
+    permute_vector(perm.data(), Ax.data(), PAx.data(), n);
+    for (size_t i = 0; i < n; ++i) ASSERT_NEAR(BPx[i], PAx[i], 1e-12);
+    unpermute_vector(perm.data(), Px.data(), back.data(), n);
+    EXPECT_EQ(back, x);
+    free_crs_matrix(&B);
+    free_crs_matrix(&A);
+
+    // Curves: permutations for any size, unit steps of the Hilbert curve on 2^k grids
+    ASSERT_EQ(grid_morton_ordering(nx, ny, nz, perm.data()), 0);
+    EXPECT_EQ(permutation_invert(perm.data(), n, inv.data()), 0);
+    ASSERT_EQ(grid_hilbert_ordering(nx, ny, nz, perm.data()), 0);
+    EXPECT_EQ(permutation_invert(perm.data(), n, inv.data()), 0);
+    const int sizes[2][3] = {{16, 16, 1}, {8, 8, 8}};
+    for (const auto& s : sizes) {
+        const size_t m = (size_t) s[0] * s[1] * s[2];
+        vector<size_t> h(m);
+        ASSERT_EQ(grid_hilbert_ordering(s[0], s[1], s[2], h.data()), 0);
+        for (size_t q = 1; q < m; ++q) {
+            const long long a = (long long) h[q - 1], b = (long long) h[q];
+            const long long dist = llabs(a % s[0] - b % s[0]) + llabs(a / s[0] % s[1] - b / s[0] % s[1]) +
+                                   llabs(a / ((long long) s[0] * s[1]) - b / ((long long) s[0] * s[1]));
+            ASSERT_EQ(dist, 1) << "step " << q;
+        }
+    }
+    EXPECT_EQ(grid_morton_ordering(0, 4, 1, perm.data()), -1);
+}
+
 // Pressure test to measure performance on large matrices
 // Measures the time taken for specific operations on very large sparse matrices
 // to evaluate efficiency and scalability of the CRS conversion.
@@ -0,0 +1,190 @@
+#include <gtest/gtest.h>
+#include <array>
+#include <cstdint>
+#include <stdexcept>
+#include "solver/TimeLevels.hpp"
+#include "field/Field.hpp"
+
+using namespace std;
+
+static bool aligned64(const double* p) {
+    return reinterpret_cast<uintptr_t>(p) % 64 == 0;
+}
+
+// T(i, j) sits at (j + halo) * ld + offset + i, offset = halo rounded up to FIELD_PADDING; the
+// halo indices -halo .. n + halo - 1 map to distinct entries inside the buffer
+TEST(FieldTest, IndexAndHaloMapping2D) {
+    for (int halo : {0, 1, 2}) {
+        const int nx = 13, ny = 6;
+        Field2D T(nx, ny, 1.5, halo);
+        EXPECT_EQ(T.nx(), nx);
+        EXPECT_EQ(T.ny(), ny);
+        EXPECT_EQ(T.halo(), halo);
+        EXPECT_EQ(T.stride() % FIELD_PADDING, 0u);
+        EXPECT_GE(T.stride(), static_cast<size_t>(nx + 2 * halo));
+        EXPECT_EQ(T.size(), T.stride() * (ny + 2 * halo));
+
+        const size_t offset = (halo + FIELD_PADDING - 1) / FIELD_PADDING * FIELD_PADDING;
+        vector<bool> used(T.size(), false);
+        for (int j = -halo; j < ny + halo; ++j) {
+            for (int i = -halo; i < nx + halo; ++i) {
+                const size_t p = T.index(i, j);
+                EXPECT_EQ(p, (j + halo) * T.stride() + offset + i) << "halo " << halo;
+                ASSERT_LT(p, T.size());
+                EXPECT_FALSE(used[p]);
+                used[p] = true;
+                EXPECT_DOUBLE_EQ(T(i, j), 1.5);   // Halo filled as well
+                T(i, j) = 100.0 * j + i;
+            }
+        }
+        // Neighbours in x are adjacent, neighbours in y one stride apart
+        EXPECT_EQ(&T(0, 2) + 1, &T(1, 2));
+        EXPECT_EQ(&T(0, 2) + T.stride(), &T(0, 3));
+        if (halo > 0) {
+            EXPECT_DOUBLE_EQ(T.row(0)[-1], -1.0);   // West halo just before the interior cell 0
+            EXPECT_DOUBLE_EQ(T.row(ny)[0], 100.0 * ny);
+        }
+    }
+}
+
+TEST(FieldTest, IndexAndHaloMapping3D) {
+    const int nx = 5, ny = 4, nz = 3, halo = 1;
+    Field3D T(nx, ny, nz, 0.0, halo);
+    EXPECT_EQ(T.plane_stride(), T.stride() * (ny + 2 * halo));
+    EXPECT_EQ(T.size(), T.plane_stride() * (nz + 2 * halo));
+    for (int k = -halo; k < nz + halo; ++k) {
+        for (int j = -halo; j < ny + halo; ++j) {
+            for (int i = -halo; i < nx + halo; ++i) {
+                EXPECT_EQ(T.index(i, j, k), (k + halo) * T.plane_stride() + (j + halo) * T.stride() +
+                                            FIELD_PADDING + i);
+                T(i, j, k) = 10000.0 * k + 100.0 * j + i;
+            }
+        }
+    }
+    EXPECT_EQ(&T(2, 1, 0) + T.plane_stride(), &T(2, 1, 1));
+    EXPECT_DOUBLE_EQ(T(-1, -1, -1), -10101.0);
+    EXPECT_DOUBLE_EQ(T(nx, ny, nz), 10000.0 * nz + 100.0 * ny + nx);
+    EXPECT_DOUBLE_EQ(T.row(2, 1)[3], 10203.0);
+}
+
+// Every row(j) (the interior cell i = 0) starts on a 64-byte boundary, whatever the halo and nx
+TEST(FieldTest, RowsAreAligned) {
+    for (int halo : {0, 1, 3, 9}) {
+        for (int nx : {1, 7, 8, 30}) {
+            Field2D T(nx, 4, 0.0, halo);
+            EXPECT_TRUE(aligned64(T.data()));
+            for (int j = -halo; j < 4 + halo; ++j) {
+                EXPECT_TRUE(aligned64(T.row(j))) << "nx " << nx << " halo " << halo << " row " << j;
+            }
+            Field3D U(nx, 3, 2, 0.0, halo);
+            for (int k = -halo; k < 2 + halo; ++k) {
+                for (int j = -halo; j < 3 + halo; ++j) {
+                    EXPECT_TRUE(aligned64(U.row(j, k))) << "nx " << nx << " halo " << halo;
+                }
+            }
+        }
+    }
+}
+
+// copy_from copies every entry (halo included) into the existing buffer and rejects another shape
+TEST(FieldTest, CopyFrom) {
+    Field2D a(6, 5, 0.0, 1), b(6, 5, 7.0, 1);
+    b(-1, 2) = 3.0;
+    b(4, 5) = 9.0;
+    const double* buffer = a.data();
+    a.copy_from(b);
+    EXPECT_EQ(a.data(), buffer);
+    EXPECT_NE(a.data(), b.data());
+    for (int j = -1; j < 6; ++j) {
+        for (int i = -1; i < 7; ++i) {
+            EXPECT_DOUBLE_EQ(a(i, j), b(i, j));
+        }
+    }
+    b(0, 0) = -1.0;
+    EXPECT_DOUBLE_EQ(a(0, 0), 7.0);   // Independent copies
+
+    Field2D other_shape(5, 6, 0.0, 1), other_halo(6, 5, 0.0, 2);
+    EXPECT_THROW(a.copy_from(other_shape), invalid_argument);
+    EXPECT_THROW(a.copy_from(other_halo), invalid_argument);
+
+    Field3D c(3, 3, 3, 0.0, 1), d(3, 3, 3, 2.0, 1);
+    d(1, 1, 3) = 5.0;
+    c.copy_from(d);
+    EXPECT_DOUBLE_EQ(c(1, 1, 3), 5.0);
+    EXPECT_DOUBLE_EQ(c(0, 0, 0), 2.0);
+    EXPECT_THROW(c.copy_from(Field3D(3, 3, 4, 0.0, 1)), invalid_argument);
+}
+
+// swap exchanges buffers and shapes in O(1): the data() pointers change hands, nothing is copied
+TEST(FieldTest, Swap) {
+    Field2D a(4, 4, 1.0, 1), b(9, 2, 2.0, 2);
+    const double* pa = a.data();
+    const double* pb = b.data();
+    a.swap(b);
+    EXPECT_EQ(a.data(), pb);
+    EXPECT_EQ(b.data(), pa);
+    EXPECT_EQ(a.nx(), 9);
+    EXPECT_EQ(a.halo(), 2);
+    EXPECT_EQ(b.nx(), 4);
+    EXPECT_DOUBLE_EQ(a(8, 1), 2.0);
+    EXPECT_DOUBLE_EQ(b(-1, -1), 1.0);
+
+    Field3D c(2, 2, 2, 1.0, 1), d(3, 3, 3, 2.0, 1);
+    const double* pc = c.data();
+    c.swap(d);
+    EXPECT_EQ(d.data(), pc);
+    EXPECT_EQ(c.nz(), 3);
+    EXPECT_DOUBLE_EQ(c(2, 2, 2), 2.0);
+}
+
+// rotate: n <- n + 1, n - 1 <- n and the buffer of n - 2 becomes the new current level; only the
+// buffer handles move, so the data() pointers are permuted and no value is copied
+TEST(TimeLevelsTest, RotatePermutesBuffers) {
+    const int N = 5;
+    TimeLevels2D T(Field2D(N, N, 0.0, 1));
+    for (int l = 0; l < TimeLevels2D::size(); ++l) {
+        T.level(l).fill(static_cast<double>(l + 1));
+    }
+    const double* p0 = T.current().data();
+    const double* p1 = T.old().data();
+    const double* p2 = T.older().data();
+    EXPECT_NE(p0, p1);
+    EXPECT_NE(p1, p2);
+    EXPECT_NE(p0, p2);
+
+    T.rotate();
+    EXPECT_EQ(T.old().data(), p0);       // T^n     <- T^(n+1)
+    EXPECT_EQ(T.older().data(), p1);     // T^(n-1) <- T^n
+    EXPECT_EQ(T.current().data(), p2);   // The buffer of T^(n-2) is reused
+    EXPECT_DOUBLE_EQ(T.old()(2, 2), 1.0);
+    EXPECT_DOUBLE_EQ(T.older()(2, 2), 2.0);
+    EXPECT_DOUBLE_EQ(T.current()(2, 2), 3.0);   // Reused as is, overwritten by the next step
+
+    // Back to the start after one rotation per level
+    T.rotate();
+    T.rotate();
+    EXPECT_EQ(T.current().data(), p0);
+    EXPECT_EQ(T.old().data(), p1);
+    EXPECT_EQ(T.older().data(), p2);
+}
+
+// Every level starts as a copy of the initial field (boundary values included) in its own buffer
+TEST(TimeLevelsTest, LevelsStartFromInitialField) {
+    const int N = 3;
+    Field3D initial(N, N, N, 300.0, 1);
+    initial(1, 1, N) = 500.0;   // Boundary (halo) value
+    TimeLevels3D T(initial);
+    for (int l = 0; l < TimeLevels3D::size(); ++l) {
+        EXPECT_NE(T.level(l).data(), initial.data());
+        EXPECT_DOUBLE_EQ(T.level(l)(1, 1, N), 500.0);
+        EXPECT_DOUBLE_EQ(T.level(l)(0, 0, 0), 300.0);
+    }
+
+    // Two levels: rotate swaps current and old
+    TimeLevels<Field2D, 2> T2(Field2D(N, N, 1.0, 1));
+    const double* c = T2.current().data();
+    const double* o = T2.old().data();
+    T2.rotate();
+    EXPECT_EQ(T2.current().data(), o);
+    EXPECT_EQ(T2.old().data(), c);
+}
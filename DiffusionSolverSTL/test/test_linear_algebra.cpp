@@ -12,22 +12,44 @@
  *    - Cover edge cases like identity matrices and all-one vectors.
  *    - Tests empty matrices.
  *
- * 2. Dot product (dot_product):
+ * 2. CRS matrix-vector multiplication (crs_mat_vec_mult):
+ *    - Tests a small hand-written CRS matrix and a large tridiagonal matrix (parallel path).
+ *    - Tests that unvalidated or structurally invalid matrices are rejected.
+ *    - Tests the 32-bit index copies against the size_t indices.
+ *    - Tests the SELL-C-sigma copy (crs_attach_sell, crs_refresh_sell) against the CRS kernels
+ *      and that the compiled SIMD kernel is the one selected by FVM_SIMD.
+ *    - Tests the multi-vector SpMV (crs_mat_vec_mult_block) against single products.
+ *
+ * 3. Dot product (dot_product):
  *    - Tests the dot product for vectors of varying sizes.
  *
- * 3. Vector subtraction (vec_subtract):
+ * 4. Vector subtraction (vec_subtract):
  *    - Tests element-wise subtraction for vectors of different sizes.
  *
+ * 5. Autotuner (autotune.c):
+ *    - Tests the measured profile, the profile file round trip (atomic replacement, entries of
+ *      other machines kept, old-format lines dropped) and that the tuned parameters do not
+ *      change the results of mat_vec_mult.
+ *
  * These tests use both dynamically allocated memory and std::vector to ensure flexibility
  * in input data structures.
  */
 
 #include <gtest/gtest.h>
 #include <vector>
+#include <cstdlib>
+#include <cmath>
+#include <cstdio>
+#include <climits>
+#include <fstream>
+#include <string>
+#include <filesystem>
 
 // Declare C function with 'extern "C"' to prevent name mangling
 extern "C" {
     #include "matrix_operations/linear_algebra.h"
+    #include "matrix_operations/SELLMatrix.h"
+    #include "utils/autotune.h"
 }
 
 // Test for the small-size matrix multiplication
@@ -123,7 +145,405 @@ TEST(MatrixMultiplicationTest, LargeMatrix) {
     delete[] expected;
 }
 
+// Helper function to build the CRS form of the tridiagonal matrix tridiag(-1, 2, -1)
+static CRSMatrix make_tridiagonal_crs(size_t n) {
+    CRSMatrix A{};
+    A.rows = n;
+    A.cols = n;
+    A.nnz = 3 * n - 2;
+    A.values = static_cast<double*>(malloc(A.nnz * sizeof(double)));
+    A.col_idx = static_cast<size_t*>(malloc(A.nnz * sizeof(size_t)));
+    A.row_ptr = static_cast<size_t*>(malloc((n + 1) * sizeof(size_t)));
+
+    size_t k = 0;
+    for (size_t i = 0; i < n; ++i) {
+        A.row_ptr[i] = k;
+        if (i > 0) { A.values[k] = -1.0; A.col_idx[k++] = i - 1; }
+        A.values[k] = 2.0; A.col_idx[k++] = i;
+        if (i + 1 < n) { A.values[k] = -1.0; A.col_idx[k++] = i + 1; }
+    }
+    A.row_ptr[n] = k;
+    return A;
+}
+
+// Drops the 32-bit column indices of a validated matrix (as when cols does not fit in 32 bits),
+// to run the kernels on the size_t path
+static void widen_index(CRSMatrix* A) {
+    if (!A->col_idx) {
+        A->col_idx = static_cast<size_t*>(malloc(A->nnz * sizeof(size_t)));
+        for (size_t j = 0; j < A->nnz; ++j) {
+            A->col_idx[j] = A->col_idx32[j];
+        }
+    }
+    free(A->col_idx32);
+    A->col_idx32 = nullptr;
+}
+
+// Test for the small-size CRS matrix multiplication
+TEST(CRSMatrixMultiplicationTest, SmallMatrix) {
+    // A = [1 0 2; 0 3 0; 4 0 5]
+    double values[] = {1, 2, 3, 4, 5};
+    size_t col_idx[] = {0, 2, 1, 0, 2};
+    size_t row_ptr[] = {0, 2, 3, 5};
+    CRSMatrix A{values, col_idx, row_ptr, 5, 3, 3, nullptr, 0, 0};
+
+    double x[] = {1, 2, 3};
+    double y[3];
+    double expected[] = {7, 6, 19};
+
+    ASSERT_EQ(crs_validate(&A), 0);
+    ASSERT_EQ(crs_mat_vec_mult(&A, x, y), 0);
+    for (int i = 0; i < 3; ++i) {
+        EXPECT_DOUBLE_EQ(y[i], expected[i]);
+    }
+
+    // The caller's arrays are left in place; only the derived copies belong to the matrix
+    EXPECT_EQ(A.values, values);
+    EXPECT_EQ(A.col_idx, col_idx);
+    EXPECT_EQ(A.row_ptr, row_ptr);
+    free(A.row_part);
+    free(A.col_idx32);
+}
+
+// Matrices must be validated once before the fast kernel accepts them
+TEST(CRSMatrixMultiplicationTest, RejectsInvalidMatrix) {
+    double values[] = {1, 2};
+    size_t col_idx[] = {0, 5};      // Column 5 is out of bounds
+    size_t row_ptr[] = {0, 1, 2};
+    CRSMatrix A{values, col_idx, row_ptr, 2, 2, 2, nullptr, 0, 0};
+
+    double x[] = {1, 1};
+    double y[2];
+
+    EXPECT_EQ(crs_mat_vec_mult(&A, x, y), -1);   // Not validated
+    EXPECT_EQ(crs_validate(&A), -1);             // Invalid column index
+    EXPECT_EQ(A.validated, 0);
+#ifndef NDEBUG
+    EXPECT_EQ(crs_mat_vec_mult_checked(&A, x, y), -1);
+#endif
+}
+
+// Test for the large-size CRS matrix multiplication (parallel, nnz-balanced path)
+TEST(CRSMatrixMultiplicationTest, LargeTridiagonal) {
+    const size_t N = 200000;
+    CRSMatrix A = make_tridiagonal_crs(N);
+    ASSERT_EQ(crs_validate(&A), 0);
+    ASSERT_GE(A.num_parts, 1);
+    EXPECT_EQ(A.row_part[A.num_parts], N);
+
+    std::vector<double> x(N), y(N, -1.0);
+    for (size_t i = 0; i < N; ++i) {
+        x[i] = static_cast<double>(i % 7);
+    }
+
+    ASSERT_EQ(crs_mat_vec_mult(&A, x.data(), y.data()), 0);
+
+    // Compare with the explicit stencil 2 x_i - x_(i-1) - x_(i+1)
+    for (size_t i = 0; i < N; ++i) {
+        double expected = 2.0 * x[i] - (i > 0 ? x[i - 1] : 0.0) - (i + 1 < N ? x[i + 1] : 0.0);
+        EXPECT_DOUBLE_EQ(y[i], expected);
+    }
+
+#ifndef NDEBUG
+    std::vector<double> y_checked(N);
+    ASSERT_EQ(crs_mat_vec_mult_checked(&A, x.data(), y_checked.data()), 0);
+    for (size_t i = 0; i < N; ++i) {
+        EXPECT_DOUBLE_EQ(y[i], y_checked[i]);
+    }
+#endif
+
+    free_crs_matrix(&A);
+}
+
+// crs_validate stores a 32-bit copy of the column indices when cols fits; crs_narrow_index drops
+// the size_t ones on request. The kernels give the same results on size_t indices (widen_index)
+TEST(CRSMatrixMultiplicationTest, IndexWidths) {
+    const size_t N = 5000;
+    CRSMatrix A = make_tridiagonal_crs(N);
+    CRSMatrix ref = make_tridiagonal_crs(N);
+    EXPECT_EQ(crs_narrow_index(&A), -1);   // Not validated
+    ASSERT_EQ(crs_validate(&A), 0);
+    ASSERT_NE(A.col_idx, nullptr);
+    ASSERT_NE(A.col_idx32, nullptr);
+    for (size_t j = 0; j < A.nnz; ++j) {
+        ASSERT_EQ(A.col_idx[j], ref.col_idx[j]);
+        ASSERT_EQ(A.col_idx32[j], ref.col_idx[j]);
+    }
+
+    // Validating again rebuilds the copy from col_idx
+    A.col_idx[1] = N;
+    EXPECT_EQ(crs_validate(&A), -1);
+    A.col_idx[1] = ref.col_idx[1];
+    ASSERT_EQ(crs_validate(&A), 0);
+
+    // Narrowed: col_idx32 is the only index array, kept and checked by later validations
+    ASSERT_EQ(crs_narrow_index(&A), 0);
+    EXPECT_EQ(A.col_idx, nullptr);
+    ASSERT_NE(A.col_idx32, nullptr);
+    for (size_t j = 0; j < A.nnz; ++j) {
+        ASSERT_EQ(crs_col(&A, j), ref.col_idx[j]);
+    }
+    ASSERT_EQ(crs_validate(&A), 0);
+    ASSERT_NE(A.col_idx32, nullptr);
+    A.col_idx32[1] = static_cast<uint32_t>(N);
+    EXPECT_EQ(crs_validate(&A), -1);
+    A.col_idx32[1] = static_cast<uint32_t>(ref.col_idx[1]);
+    ASSERT_EQ(crs_validate(&A), 0);
+
+    std::vector<double> x(N), y32(N), y64(N), y_sell(N), d32(N), d64(N);
+    for (size_t i = 0; i < N; ++i) {
+        x[i] = static_cast<double>(i % 5) - 2.0;
+    }
+    ASSERT_EQ(crs_mat_vec_mult(&A, x.data(), y32.data()), 0);
+    ASSERT_EQ(crs_extract_diagonal(&A, d32.data()), 0);
+
+    widen_index(&A);
+    ASSERT_EQ(crs_mat_vec_mult(&A, x.data(), y64.data()), 0);
+    ASSERT_EQ(crs_extract_diagonal(&A, d64.data()), 0);
+    EXPECT_EQ(d32, d64);
+
+    // The SELL copy inherits the index width of the matrix
+    ASSERT_EQ(crs_attach_sell(&A, SELL_DEFAULT_SIGMA), 0);
+    EXPECT_EQ(A.sell->col_idx32, nullptr);
+    ASSERT_NE(A.sell->col_idx, nullptr);
+    ASSERT_EQ(crs_mat_vec_mult(&A, x.data(), y_sell.data()), 0);
+
+    for (size_t i = 0; i < N; ++i) {
+        EXPECT_DOUBLE_EQ(y32[i], y64[i]);
+        EXPECT_DOUBLE_EQ(y_sell[i], y64[i]);
+    }
+
+    free_crs_matrix(&A);
+    free_crs_matrix(&ref);
+    EXPECT_EQ(A.col_idx32, nullptr);
+}
+
+// Sparse product: tridiag(-1, 2, -1)^2 is pentadiagonal with sorted columns
+TEST(CRSMatrixMultiplicationTest, SparseMatrixProduct) {
+    const size_t N = 5000;
+    CRSMatrix A = make_tridiagonal_crs(N);
+    CRSMatrix C{};
+    ASSERT_EQ(crs_validate(&A), 0);
+    ASSERT_EQ(crs_mat_mat_mult(&A, &A, &C), 0);
+    EXPECT_EQ(C.rows, N);
+    EXPECT_EQ(C.cols, N);
+    EXPECT_EQ(C.nnz, 5 * N - 6);
+    EXPECT_EQ(C.validated, 1);
+
+    // Interior rows are [1 -4 6 -4 1], the first and last rows [5 -4 1]
+    for (size_t i = 0; i < N; ++i) {
+        for (size_t j = C.row_ptr[i]; j < C.row_ptr[i + 1]; ++j) {
+            if (j > C.row_ptr[i]) {
+                EXPECT_LT(crs_col(&C, j - 1), crs_col(&C, j));
+            }
+            const size_t d = crs_col(&C, j) > i ? crs_col(&C, j) - i : i - crs_col(&C, j);
+            const bool boundary = (i == 0 || i + 1 == N);
+            const double expected = d == 0 ? (boundary ? 5.0 : 6.0) : (d == 1 ? -4.0 : 1.0);
+            EXPECT_DOUBLE_EQ(C.values[j], expected) << "row " << i << " column " << crs_col(&C, j);
+        }
+    }
+
+    // Dimension mismatch
+    CRSMatrix B = make_tridiagonal_crs(N - 1);
+    CRSMatrix D{};
+    ASSERT_EQ(crs_validate(&B), 0);
+    EXPECT_EQ(crs_mat_mat_mult(&A, &B, &D), -1);
+
+    free_crs_matrix(&A);
+    free_crs_matrix(&B);
+    free_crs_matrix(&C);
+}
+
+// The fused CG kernels must give the same result as the separate sweeps
+TEST(FusedKrylovKernelTest, MatchesUnfusedSweeps) {
+    const size_t N = 5000;
+    const int n = static_cast<int>(N);
+    CRSMatrix A = make_tridiagonal_crs(N);
+    ASSERT_EQ(crs_validate(&A), 0);
+
+    std::vector<double> z(N), p(N), Ap(N), inv_diag(N, 0.5);
+    for (size_t i = 0; i < N; ++i) {
+        z[i] = static_cast<double>(i % 11) - 5.0;
+        p[i] = static_cast<double>(i % 3);
+    }
+    ASSERT_EQ(crs_mat_vec_mult(&A, p.data(), Ap.data()), 0);
+
+    // Reference: p = z + beta * p, Ap = A * p, dot(p, Ap)
+    const double beta = 0.75;
+    std::vector<double> p_ref(N), Ap_ref(N);
+    for (size_t i = 0; i < N; ++i) {
+        p_ref[i] = z[i] + beta * p[i];
+    }
+    ASSERT_EQ(crs_mat_vec_mult(&A, p_ref.data(), Ap_ref.data()), 0);
+    const double p_dot_Ap_ref = dot_product(p_ref.data(), Ap_ref.data(), n);
+
+    double p_dot_Ap = 0.0;
+    ASSERT_EQ(crs_cg_update_direction(&A, z.data(), beta, p.data(), Ap.data(), &p_dot_Ap), 0);
+    EXPECT_NEAR(p_dot_Ap, p_dot_Ap_ref, 1e-9 * p_dot_Ap_ref);
+    for (size_t i = 0; i < N; ++i) {
+        EXPECT_DOUBLE_EQ(p[i], p_ref[i]);
+        EXPECT_NEAR(Ap[i], Ap_ref[i], 1e-12);
+    }
+
+    // Reference: x += alpha * p, r -= alpha * Ap, z = D^(-1) r, dot(r, r), dot(r, z)
+    const double alpha = 0.1;
+    std::vector<double> x(N, 1.0), r(z), x_ref(x), r_ref(r);
+    for (size_t i = 0; i < N; ++i) {
+        x_ref[i] += alpha * p[i];
+        r_ref[i] -= alpha * Ap[i];
+    }
+    const double r_dot_r_ref = dot_product(r_ref.data(), r_ref.data(), n);
+
+    double r_dot_z = 0.0;
+    const double r_dot_r = cg_update_solution_jacobi(alpha, p.data(), Ap.data(), inv_diag.data(),
+                                                     x.data(), r.data(), z.data(), n, &r_dot_z);
+    EXPECT_NEAR(r_dot_r, r_dot_r_ref, 1e-9 * r_dot_r_ref);
+    EXPECT_NEAR(r_dot_z, 0.5 * r_dot_r_ref, 1e-9 * r_dot_r_ref);
+    for (size_t i = 0; i < N; ++i) {
+        EXPECT_DOUBLE_EQ(x[i], x_ref[i]);
+        EXPECT_DOUBLE_EQ(r[i], r_ref[i]);
+        EXPECT_DOUBLE_EQ(z[i], 0.5 * r_ref[i]);
+    }
+
+    free_crs_matrix(&A);
+}
+
+// Row i holds (i % 9) entries (empty rows included) at columns i + k^2, so the SELL slices need
+// padding and sorting
+static CRSMatrix make_irregular_crs(size_t n) {
+    CRSMatrix A{};
+    A.rows = n;
+    A.cols = n;
+    A.row_ptr = static_cast<size_t*>(malloc((n + 1) * sizeof(size_t)));
+    A.row_ptr[0] = 0;
+    for (size_t i = 0; i < n; ++i) {
+        A.row_ptr[i + 1] = A.row_ptr[i] + i % 9;
+    }
+    A.nnz = A.row_ptr[n];
+    A.values = static_cast<double*>(malloc(A.nnz * sizeof(double)));
+    A.col_idx = static_cast<size_t*>(malloc(A.nnz * sizeof(size_t)));
+    for (size_t i = 0; i < n; ++i) {
+        for (size_t k = 0; k < i % 9; ++k) {
+            A.values[A.row_ptr[i] + k] = 1.0 + static_cast<double>((i + k) % 5);
+            A.col_idx[A.row_ptr[i] + k] = (i + k * k) % n;
+        }
+    }
+    return A;
+}
+
+// The SELL-C-sigma kernels must give the CRS results for any sorting window
+TEST(CRSMatrixMultiplicationTest, SELLMatchesCRS) {
+    const size_t N = 1003;   // Last slice only partially filled
+    for (int pattern = 0; pattern < 2; ++pattern) {
+        CRSMatrix A = (pattern == 0) ? make_tridiagonal_crs(N) : make_irregular_crs(N);
+        ASSERT_EQ(crs_validate(&A), 0);
+
+        std::vector<double> x(N), y_ref(N), z(N), p_ref(N), Ap_ref(N);
+        for (size_t i = 0; i < N; ++i) {
+            x[i] = static_cast<double>(i % 13) - 6.0;
+            z[i] = static_cast<double>(i % 7) - 3.0;
+            p_ref[i] = static_cast<double>(i % 3);
+        }
+        ASSERT_EQ(crs_mat_vec_mult(&A, x.data(), y_ref.data()), 0);
+        ASSERT_EQ(crs_mat_vec_mult(&A, p_ref.data(), Ap_ref.data()), 0);
+        std::vector<double> p_start(p_ref), Ap_start(Ap_ref);
+        double dot_ref = 0.0;
+        ASSERT_EQ(crs_cg_update_direction(&A, z.data(), 0.5, p_ref.data(), Ap_ref.data(), &dot_ref), 0);
+
+        double fill_unsorted = 0.0;
+        for (size_t sigma : {size_t(1), size_t(SELL_DEFAULT_SIGMA), N}) {
+            ASSERT_EQ(crs_attach_sell(&A, sigma), 0);
+            ASSERT_NE(A.sell, nullptr);
+            EXPECT_NE(A.sell->col_idx32, nullptr);
+            EXPECT_EQ(A.sell->num_slices, (N + SELL_C - 1) / SELL_C);
+            if (sigma == 1) {
+                fill_unsorted = sell_fill_ratio(A.sell);
+            } else {
+                EXPECT_LE(sell_fill_ratio(A.sell), fill_unsorted);
+            }
+
+            std::vector<double> y(N, -1.0), p(p_start), Ap(Ap_start);
+            ASSERT_EQ(crs_mat_vec_mult(&A, x.data(), y.data()), 0);   // Dispatches to the SELL copy
+            double dot = 0.0;
+            ASSERT_EQ(crs_cg_update_direction(&A, z.data(), 0.5, p.data(), Ap.data(), &dot), 0);
+            EXPECT_NEAR(dot, dot_ref, 1e-12 * std::abs(dot_ref));
+            for (size_t i = 0; i < N; ++i) {
+                EXPECT_NEAR(y[i], y_ref[i], 1e-12) << "pattern " << pattern << " sigma " << sigma << " row " << i;
+                EXPECT_DOUBLE_EQ(p[i], p_ref[i]);
+                EXPECT_NEAR(Ap[i], Ap_ref[i], 1e-12);
+            }
+        }
+
+        // Values changed in place reach the copy through crs_refresh_sell
+        for (size_t j = 0; j < A.nnz; ++j) {
+            A.values[j] *= 2.0;
+        }
+        ASSERT_EQ(crs_refresh_sell(&A), 0);
+        std::vector<double> y2(N);
+        ASSERT_EQ(crs_mat_vec_mult(&A, x.data(), y2.data()), 0);
+        for (size_t i = 0; i < N; ++i) {
+            EXPECT_NEAR(y2[i], 2.0 * y_ref[i], 2e-12) << "pattern " << pattern << " row " << i;
+        }
+
+        // A new values array is not multiplied with the copy of the old one
+        double* old_values = A.values;
+        A.values = static_cast<double*>(malloc(A.nnz * sizeof(double)));
+        for (size_t j = 0; j < A.nnz; ++j) {
+            A.values[j] = 0.5 * old_values[j];
+        }
+        free(old_values);
+        ASSERT_EQ(crs_mat_vec_mult(&A, x.data(), y2.data()), 0);
+        for (size_t i = 0; i < N; ++i) {
+            EXPECT_NEAR(y2[i], y_ref[i], 1e-12) << "pattern " << pattern << " row " << i;
+        }
+
+        // Re-validation drops the copy, free_crs_matrix releases it
+        ASSERT_EQ(crs_validate(&A), 0);
+        EXPECT_EQ(A.sell, nullptr);
+        ASSERT_EQ(crs_attach_sell(&A, SELL_DEFAULT_SIGMA), 0);
+        free_crs_matrix(&A);
+        EXPECT_EQ(A.sell, nullptr);
+    }
+}
+
+// The SELL kernels are the ones selected by the CMake option FVM_SIMD
+TEST(CRSMatrixMultiplicationTest, SELLKernelMatchesBuildOption) {
+#ifdef FVM_SIMD
+    EXPECT_STREQ(sell_simd_kernel(), FVM_SIMD);
+#else
+    GTEST_SKIP() << "FVM_SIMD not defined for this build";
+#endif
+}
+
 // Test for the dot product of two vectors
+// Multi-vector SpMV: every column of the block matches a single SpMV (widths below, at and
+// above the register block, 32-bit and size_t indices)
+TEST(CRSMatrixMultiplicationTest, BlockMatchesColumns) {
+    const size_t N = 3000;
+    for (int wide = 0; wide < 2; ++wide) {
+        CRSMatrix A = make_irregular_crs(N);
+        ASSERT_EQ(crs_validate(&A), 0);
+        if (wide) {
+            widen_index(&A);
+        }
+        for (size_t k : {1u, 3u, 8u, 11u}) {
+            std::vector<double> X(N * k), Y(N * k), y(N);
+            for (size_t i = 0; i < N * k; ++i) {
+                X[i] = std::sin(0.37 * static_cast<double>(i));
+            }
+            ASSERT_EQ(crs_mat_vec_mult_block(&A, X.data(), Y.data(), k), 0);
+            for (size_t c = 0; c < k; ++c) {
+                ASSERT_EQ(crs_mat_vec_mult(&A, X.data() + c * N, y.data()), 0);
+                for (size_t i = 0; i < N; ++i) {
+                    EXPECT_NEAR(Y[c * N + i], y[i], 1e-12) << "k = " << k << ", column " << c;
+                }
+            }
+        }
+        EXPECT_EQ(crs_mat_vec_mult_block(&A, nullptr, nullptr, 1), -1);
+        free_crs_matrix(&A);
+    }
+}
+
 TEST(MatrixDotProductTest, SmallVector) {
 
 }
@@ -139,4 +559,81 @@ TEST(MatrixSubtractionTest, SmallVector) {
 
 TEST(MatrixSubtractionTest, LargeVector) {
 
-}
\ No newline at end of file
+}
+
+// Temporary files of autotune_save ("<path>.<pid>.tmp") left in the working directory
+static int autotune_leftovers(const std::string& path) {
+    int count = 0;
+    for (const auto& entry : std::filesystem::directory_iterator(".")) {
+        const std::string name = entry.path().filename().string();
+        count += (name.rfind(path + ".", 0) == 0 && name.size() > 4 && name.substr(name.size() - 4) == ".tmp");
+    }
+    return count;
+}
+
+// The profile is plausible, survives a save / load round trip next to the entry of another
+// machine, and the tuned block size / thresholds leave the dense product unchanged
+TEST(AutotuneTest, ProfileRoundTrip) {
+    TuningProfile P;
+    ASSERT_EQ(autotune_run(&P), 0);
+    EXPECT_GT(P.block_size, 0);
+    EXPECT_GE(P.parallel_threshold, 0);
+    EXPECT_GE(P.sparse_threshold, 0);
+    EXPECT_GE(P.dense_threshold, 0);
+    EXPECT_GE(P.num_threads, 0);
+    EXPECT_EQ(PARALLEL_THRESHOLD, 1000);   // Defaults restored after the benchmark
+    EXPECT_EQ(SPARSE_PARALLEL_THRESHOLD, 5000);
+    EXPECT_EQ(DENSE_PARALLEL_THRESHOLD, 1000000);
+    EXPECT_EQ(MAT_VEC_BLOCK_SIZE, 32);
+
+    // An entry of another machine, and an entry in the old format (without the sparse and
+    // dense thresholds) that is dropped
+    const char* path = "autotune_test_profile.txt";
+    {
+        std::ofstream other(path);
+        other << "# profile\n4096 20000 65536 64 12 | Other CPU x12\n4096 64 12 | Old CPU x4\n";
+    }
+    ASSERT_EQ(autotune_save(path, &P), 0);
+    ASSERT_EQ(autotune_save(path, &P), 0);   // Replaces the entry of this machine
+    EXPECT_EQ(autotune_leftovers(path), 0);
+    TuningProfile Q;
+    ASSERT_EQ(autotune_load(path, &Q), 0);
+    EXPECT_EQ(Q.parallel_threshold, P.parallel_threshold);
+    EXPECT_EQ(Q.sparse_threshold, P.sparse_threshold);
+    EXPECT_EQ(Q.dense_threshold, P.dense_threshold);
+    EXPECT_EQ(Q.block_size, P.block_size);
+    EXPECT_EQ(Q.num_threads, P.num_threads);
+    EXPECT_STREQ(Q.host, P.host);
+    std::ifstream in(path);
+    std::string line;
+    int entries = 0, others = 0;
+    while (std::getline(in, line)) {
+        entries += (!line.empty() && line[0] != '#');
+        others += (line == "4096 20000 65536 64 12 | Other CPU x12");
+    }
+    EXPECT_EQ(entries, 2);
+    EXPECT_EQ(others, 1);
+    in.close();
+    std::remove(path);
+    EXPECT_EQ(autotune_load(path, &Q), -1);
+
+    // A profile that cannot be replaced (here: a directory) fails without leaving a temporary file
+    const char* dir = "autotune_test_profile_dir";
+    std::filesystem::create_directory(dir);
+    EXPECT_EQ(autotune_save(dir, &P), -1);
+    EXPECT_EQ(autotune_leftovers(dir), 0);
+    EXPECT_TRUE(std::filesystem::is_directory(dir));
+    std::filesystem::remove(dir);
+
+    const int n = 300;
+    std::vector<double> A(n * n), x(n), y_ref(n), y(n);
+    for (int i = 0; i < n * n; ++i) A[i] = std::sin(0.01 * i);
+    for (int i = 0; i < n; ++i) x[i] = std::cos(0.1 * i);
+    ASSERT_EQ(mat_vec_mult(A.data(), x.data(), y_ref.data(), n), 0);
+    const TuningProfile T = {0, 0, 0, 48, 0, "test"};
+    ASSERT_EQ(autotune_apply(&T), 0);
+    ASSERT_EQ(mat_vec_mult(A.data(), x.data(), y.data(), n), 0);
+    for (int i = 0; i < n; ++i) EXPECT_NEAR(y[i], y_ref[i], 1e-12);
+    const TuningProfile defaults = {1000, 5000, 1000000, 32, 0, "defaults"};
+    ASSERT_EQ(autotune_apply(&defaults), 0);
+}
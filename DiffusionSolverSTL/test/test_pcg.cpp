@@ -8,6 +8,18 @@
 // Declare C function with 'extern "C"' to prevent name mangling
 extern "C" {
     #include "utils/PCG_solver.h"
+    #include "matrix_operations/stencil_operator.h"
+    #include "matrix_operations/linear_algebra.h"
+    #include "utils/linear_solver.h"
+    #include "utils/preconditioner.h"
+    #include "matrix_operations/triangular_solve.h"
+    #include "utils/nonsymmetric_solvers.h"
+    #include "utils/multigrid.h"
+    #include "utils/block_PCG_solver.h"
+    #include "utils/SOR_solver.h"
+    #include "utils/amg.h"
+    #include "utils/chebyshev.h"
+    #include "matrix_operations/reordering.h"
 }
 
 using namespace std;
@@ -56,8 +68,9 @@ TEST(PCG_Test, smallSystem) {
     const size_t col = 10;
     const size_t row = 10;
 
-    // Flatten 2D vector to a 1D C-style array using helper function 'Vector2Flatten'
-    double* A = Vector2Flatten(CentralDiff(col, row));
+    // Flatten 2D vector to a 1D C-style array using helper function 'Vector2CArray'
+    auto A_flat = Vector2CArray(CentralDiff(col, row));
+    double* A = A_flat.get();
     auto *x = new double[row]();
     auto *b = new double[row];
     auto *x_expect = new double[row];
@@ -67,6 +80,14 @@ TEST(PCG_Test, smallSystem) {
         x_expect[i] = 1.0;
     }
 
+    // Right-hand side b = A * x_expect
+    for (size_t i = 0; i < row; ++i) {
+        b[i] = 0.0;
+        for (size_t j = 0; j < col; ++j) {
+            b[i] += A[i * col + j] * x_expect[j];
+        }
+    }
+
     CRSMatrix smallMatrix;
     // Call the C function with the raw array
     if (dense_to_crs(A, row, col, &smallMatrix) != 0) {
@@ -74,7 +95,7 @@ TEST(PCG_Test, smallSystem) {
     }
 
     // Call PCG to solve the Ax = b
-    if (pcg_solver(A, x, b, col, 1000, 0.01, "Jacobi") != 1) {
+    if (pcg_solver(A, b, x, col, 1000, 1e-10, "Jacobi") != 0) {
         cerr << "Error solving Ax = b.\n";
     } else {
         cout << "Finish the linear equations solving successful!" << endl;
@@ -82,19 +103,896 @@ TEST(PCG_Test, smallSystem) {
 
     // Verify that each element matches the expected result
     for (size_t i = 0; i < row; ++i) {
-        EXPECT_DOUBLE_EQ(x[i], x_expect[i]);
+        EXPECT_NEAR(x[i], x_expect[i], 1e-8);
     }
 
     // Free the dynamically allocated array after use
-    delete[] A;
+    free_crs_matrix(&smallMatrix);
     delete[] x;
     delete[] b;
     delete[] x_expect;
 
 }
 
+// Helper describing a uniform N x N (x nz) diffusion stencil with storage coefficient 'co'.
+// Faces are unit coefficients, boundary faces (half a cell away) have coefficient 2.
+struct UniformStencil {
+    vector<double> c_low, c_high, co;
+    StencilOperator S{};
+
+    UniformStencil(int N, int nz, double co_value, double theta)
+        : c_low(max(N, nz), 1.0), c_high(max(N, nz), 1.0), co(static_cast<size_t>(N) * N * nz, co_value) {
+        c_low[0] = 2.0;             // West / South / Back face of the first cell
+        c_high[N - 1] = 2.0;        // East / North / Front face of the last cell
+        if (nz > 1) {
+            c_high[nz - 1] = 2.0;
+        }
+        S = {N, N, nz, c_high.data(), c_low.data(), c_high.data(), c_low.data(),
+             nz > 1 ? c_high.data() : nullptr, nz > 1 ? c_low.data() : nullptr, co.data(), theta};
+    }
+};
+
+// The matrix-free operator must match the explicit (dense) 5-point matrix and be symmetric
+TEST(PCG_Test, StencilOperatorMatchesDense) {
+    const int N = 6;
+    UniformStencil U(N, 1, 0.5, 1.0);
+    const size_t n = static_cast<size_t>(N) * N;
+
+    // Build the dense matrix column by column from the operator
+    vector<double> A(n * n), e(n, 0.0), col(n);
+    for (size_t j = 0; j < n; ++j) {
+        e[j] = 1.0;
+        ASSERT_EQ(stencil_apply(&U.S, e.data(), col.data()), 0);
+        for (size_t i = 0; i < n; ++i) {
+            A[i * n + j] = col[i];
+        }
+        e[j] = 0.0;
+    }
+
+    vector<double> diag(n);
+    ASSERT_EQ(stencil_diagonal(&U.S, diag.data()), 0);
+
+    for (size_t i = 0; i < n; ++i) {
+        EXPECT_DOUBLE_EQ(A[i * n + i], diag[i]);
+        for (size_t j = 0; j < n; ++j) {
+            EXPECT_DOUBLE_EQ(A[i * n + j], A[j * n + i]);
+        }
+    }
+
+    // Interior cell (2, 2): co + 4, neighbours -1
+    size_t p = 2 * N + 2;
+    EXPECT_DOUBLE_EQ(A[p * n + p], 4.5);
+    EXPECT_DOUBLE_EQ(A[p * n + p + 1], -1.0);
+    EXPECT_DOUBLE_EQ(A[p * n + p + N], -1.0);
+}
+
+// Solve a 3D implicit system with PCG without ever storing the matrix
 TEST(PCG_Test, MediumSystem) {
+    const int N = 24;
+    UniformStencil U(N, N, 0.1, 1.0);
+    LinearOperator A;
+    ASSERT_EQ(linear_operator_stencil(&A, &U.S), 0);
+
+    const size_t n = A.n;
+    vector<double> x_expect(n), b(n), x(n, 0.0);
+    for (size_t i = 0; i < n; ++i) {
+        x_expect[i] = 1.0 + 0.01 * static_cast<double>(i % 17);
+    }
+    ASSERT_EQ(A.apply(&A, x_expect.data(), b.data()), 0);
+
+    ASSERT_EQ(pcg_solver_op(&A, b.data(), x.data(), 1000, 1e-10, "Jacobi"), 0);
+    for (size_t i = 0; i < n; ++i) {
+        EXPECT_NEAR(x[i], x_expect[i], 1e-8);
+    }
+}
+
+// Helper assembling the CRS matrix of the 2D stencil described by 'UniformStencil'
+static CRSMatrix make_stencil_crs(const UniformStencil& U) {
+    const int N = U.S.nx;
+    const size_t n = static_cast<size_t>(N) * N;
+    CRSMatrix A{};
+    A.rows = n;
+    A.cols = n;
+    A.row_ptr = static_cast<size_t*>(malloc((n + 1) * sizeof(size_t)));
+    A.col_idx = static_cast<size_t*>(malloc(5 * n * sizeof(size_t)));
+    A.values = static_cast<double*>(malloc(5 * n * sizeof(double)));
+
+    vector<double> diag(n);
+    stencil_diagonal(&U.S, diag.data());
+
+    size_t k = 0;
+    for (int j = 0; j < N; ++j) {
+        for (int i = 0; i < N; ++i) {
+            size_t p = static_cast<size_t>(j) * N + i;
+            A.row_ptr[p] = k;
+            if (j > 0)     { A.col_idx[k] = p - N; A.values[k++] = -U.S.theta * U.S.cs[j]; }
+            if (i > 0)     { A.col_idx[k] = p - 1; A.values[k++] = -U.S.theta * U.S.cw[i]; }
+            A.col_idx[k] = p; A.values[k++] = diag[p];
+            if (i + 1 < N) { A.col_idx[k] = p + 1; A.values[k++] = -U.S.theta * U.S.ce[i]; }
+            if (j + 1 < N) { A.col_idx[k] = p + N; A.values[k++] = -U.S.theta * U.S.cn[j]; }
+        }
+    }
+    A.row_ptr[n] = k;
+    A.nnz = k;
+    return A;
+}
+
+// Direct assembly must reproduce the reference 2D matrix entry by entry (sorted columns, exact nnz)
+TEST(PCG_Test, StencilToCRSMatchesReference2D) {
+    const int N = 7;
+    UniformStencil U(N, 1, 0.3, 0.5);
+    CRSMatrix ref = make_stencil_crs(U);
+    CRSMatrix A{};
+    ASSERT_EQ(stencil_to_crs(&U.S, &A), 0);
+    EXPECT_TRUE(A.validated);
+
+    ASSERT_EQ(A.rows, ref.rows);
+    ASSERT_EQ(A.nnz, ref.nnz);
+    EXPECT_EQ(A.nnz, 5 * A.rows - 4 * static_cast<size_t>(N));
+    for (size_t i = 0; i <= A.rows; ++i) {
+        EXPECT_EQ(A.row_ptr[i], ref.row_ptr[i]);
+    }
+    for (size_t k = 0; k < A.nnz; ++k) {
+        EXPECT_EQ(crs_col(&A, k), ref.col_idx[k]);
+        EXPECT_DOUBLE_EQ(A.values[k], ref.values[k]);
+    }
+
+    free_crs_matrix(&A);
+    free_crs_matrix(&ref);
+}
+
+// 3D assembly (7-point) must agree with the matrix-free operator
+TEST(PCG_Test, StencilToCRSMatchesStencil3D) {
+    const int N = 12;
+    UniformStencil U(N, N, 0.2, 1.0);
+    CRSMatrix A{};
+    ASSERT_EQ(stencil_to_crs(&U.S, &A), 0);
+
+    const size_t n = A.rows;
+    ASSERT_EQ(n, static_cast<size_t>(N) * N * N);
+    EXPECT_EQ(A.nnz, 7 * n - 6 * static_cast<size_t>(N) * N);
+
+    vector<double> x(n), y_crs(n), y_stencil(n);
+    for (size_t i = 0; i < n; ++i) {
+        x[i] = cos(0.37 * static_cast<double>(i));
+    }
+    ASSERT_EQ(crs_mat_vec_mult(&A, x.data(), y_crs.data()), 0);
+    ASSERT_EQ(stencil_apply(&U.S, x.data(), y_stencil.data()), 0);
+    for (size_t i = 0; i < n; ++i) {
+        EXPECT_NEAR(y_crs[i], y_stencil[i], 1e-12);
+    }
+
+    free_crs_matrix(&A);
+}
+
+// Solve the same sparse system with every preconditioner of the CRS path
+TEST(PCG_Test, CRSSystemAllPreconditioners) {
+    const int N = 30;
+    UniformStencil U(N, 1, 0.01, 1.0);
+    CRSMatrix A = make_stencil_crs(U);
+    ASSERT_EQ(crs_validate(&A), 0);
+
+    const size_t n = A.rows;
+    vector<double> x_expect(n), b(n), b_stencil(n);
+    for (size_t i = 0; i < n; ++i) {
+        x_expect[i] = sin(0.1 * static_cast<double>(i));
+    }
+    ASSERT_EQ(crs_mat_vec_mult(&A, x_expect.data(), b.data()), 0);
+
+    // The assembled matrix and the matrix-free stencil are the same operator
+    ASSERT_EQ(stencil_apply(&U.S, x_expect.data(), b_stencil.data()), 0);
+    for (size_t i = 0; i < n; ++i) {
+        EXPECT_NEAR(b[i], b_stencil[i], 1e-12);
+    }
+
+    for (const char* preconditioner : {"None", "Jacobi", "IncompleteCholesky", "ModifiedIncompleteCholesky"}) {
+        vector<double> x(n, 0.0);
+        ASSERT_EQ(pcg_solver_crs(&A, b.data(), x.data(), 2000, 1e-10, preconditioner), 0) << preconditioner;
+        for (size_t i = 0; i < n; ++i) {
+            EXPECT_NEAR(x[i], x_expect[i], 1e-8) << preconditioner;
+        }
+
+        // A warm start from the solution returns it unchanged instead of dividing 0 by 0
+        ASSERT_EQ(pcg_solver_crs(&A, b.data(), x.data(), 2000, 1e-8, preconditioner), 0) << preconditioner;
+        for (size_t i = 0; i < n; ++i) {
+            ASSERT_TRUE(std::isfinite(x[i])) << preconditioner;
+            EXPECT_NEAR(x[i], x_expect[i], 1e-8) << preconditioner;
+        }
+    }
+
+    free_crs_matrix(&A);
+}
+
+// The dense entry point builds a sparse IC(0) factor; for a tridiagonal matrix it is exact
+TEST(PCG_Test, DenseIncompleteCholesky) {
+    const size_t n = 200;
+    auto A_flat = Vector2CArray(CentralDiff(n, n));
+    double* A = A_flat.get();
+
+    vector<double> x_expect(n), b(n, 0.0), x(n, 0.0);
+    for (size_t i = 0; i < n; ++i) {
+        x_expect[i] = cos(0.05 * static_cast<double>(i));
+    }
+    for (size_t i = 0; i < n; ++i) {
+        for (size_t j = 0; j < n; ++j) {
+            b[i] += A[i * n + j] * x_expect[j];
+        }
+    }
+
+    ASSERT_EQ(pcg_solver(A, b.data(), x.data(), static_cast<int>(n), 10, 1e-10, "IncompleteCholesky"), 0);
+    for (size_t i = 0; i < n; ++i) {
+        EXPECT_NEAR(x[i], x_expect[i], 1e-8);
+    }
+}
+
+// Pipelined PCG (selected through the Linear_solver_type name) must reach the same solution
+TEST(PCG_Test, PipelinedPCGAllPreconditioners) {
+    const int N = 48;
+    UniformStencil U(N, 1, 0.01, 1.0);
+    CRSMatrix A{};
+    ASSERT_EQ(stencil_to_crs(&U.S, &A), 0);
+
+    const size_t n = A.rows;
+    vector<double> x_expect(n), b(n);
+    for (size_t i = 0; i < n; ++i) {
+        x_expect[i] = sin(0.1 * static_cast<double>(i));
+    }
+    ASSERT_EQ(crs_mat_vec_mult(&A, x_expect.data(), b.data()), 0);
+
+    for (const char* preconditioner : {"None", "Jacobi", "IncompleteCholesky", "ModifiedIncompleteCholesky"}) {
+        vector<double> x(n, 0.0);
+        ASSERT_EQ(linear_solver_crs(&A, b.data(), x.data(), 2000, 1e-10, "PipelinedPCG", preconditioner), 0)
+            << preconditioner;
+        for (size_t i = 0; i < n; ++i) {
+            EXPECT_NEAR(x[i], x_expect[i], 1e-8) << preconditioner;
+        }
+    }
+
+    vector<double> x(n, 0.0);
+    EXPECT_EQ(linear_solver_crs(&A, b.data(), x.data(), 2000, 1e-10, "Unknown", "None"), -1);
+
+    free_crs_matrix(&A);
+}
+
+// Both parallel triangular-solve schedules (directly and through the handle) must reproduce
+// the serial IC(0) application
+TEST(PCG_Test, TriangularSolveMatchesSerialIC) {
+    const int N = 10;
+    UniformStencil U(N, N, 0.05, 1.0);
+    CRSMatrix A{}, L{};
+    ASSERT_EQ(stencil_to_crs(&U.S, &A), 0);
+    ASSERT_EQ(incomplete_cholesky_crs(&A, &L), 0);
+
+    const size_t n = A.rows;
+    vector<double> r(n), z_ref(n);
+    for (size_t i = 0; i < n; ++i) {
+        r[i] = sin(0.3 * static_cast<double>(i));
+    }
+    ic_precondition_crs(&L, r.data(), z_ref.data());
+
+    for (TriangularSolveMethod method : {TRISOLVE_LEVEL_SCHEDULE, TRISOLVE_SYNC_FREE}) {
+        TriangularSolve T;
+        ASSERT_EQ(trisolve_analyze(&L, method, &T), 0);
+
+        // Applied twice with the same analysis, once in place
+        vector<double> y(n), z(n), z_inplace(r);
+        ASSERT_EQ(trisolve_lower(&T, r.data(), y.data()), 0);
+        ASSERT_EQ(trisolve_upper(&T, y.data(), z.data()), 0);
+        ASSERT_EQ(trisolve_llt(&T, z_inplace.data(), z_inplace.data()), 0);
+        for (size_t i = 0; i < n; ++i) {
+            EXPECT_NEAR(z[i], z_ref[i], 1e-12) << method;
+            EXPECT_NEAR(z_inplace[i], z_ref[i], 1e-12) << method;
+        }
+        trisolve_free(&T);
+
+        // Same schedule selected on a preconditioner handle
+        Preconditioner M;
+        ASSERT_EQ(preconditioner_crs(&M, &A, "IncompleteCholesky"), 0);
+        ASSERT_EQ(preconditioner_set_trisolve(&M, method), 0);
+        EXPECT_EQ(M.trisolve, method);
+        EXPECT_EQ(M.builds, 1);   // The factor of the first setup is kept
+        M.apply(&M, r.data(), z.data());
+        for (size_t i = 0; i < n; ++i) {
+            EXPECT_NEAR(z[i], z_ref[i], 1e-12) << method;
+        }
+
+        // Switching the schedule of a single-precision handle keeps its float factor
+        vector<double> z32(n), z32_switched(n);
+        ASSERT_EQ(preconditioner_set_precision(&M, PRECONDITIONER_SINGLE), 0);
+        M.apply(&M, r.data(), z32.data());
+        const TriangularSolveMethod other = (method == TRISOLVE_SYNC_FREE) ? TRISOLVE_LEVEL_SCHEDULE : TRISOLVE_SYNC_FREE;
+        ASSERT_EQ(preconditioner_set_trisolve(&M, other), 0);
+        EXPECT_EQ(M.precision, PRECONDITIONER_SINGLE);
+        EXPECT_EQ(M.builds, 1);
+        M.apply(&M, r.data(), z32_switched.data());
+        for (size_t i = 0; i < n; ++i) {
+            EXPECT_NEAR(z32_switched[i], z32[i], 1e-12 * fabs(z32[i])) << method;
+        }
+        preconditioner_free(&M);
+    }
+
+    free_crs_matrix(&L);
+    free_crs_matrix(&A);
+}
+
+// Multigrid (preconditioner and standalone) needs the same few cycles on a coarse and a fine grid
+TEST(PCG_Test, MultigridIterationsStayFlat) {
+    for (int N : {31, 128}) {
+        UniformStencil U(N, 1, 0.0, 1.0);
+        const size_t n = static_cast<size_t>(N) * N;
+        vector<double> x_expect(n), b(n);
+        for (size_t i = 0; i < n; ++i) {
+            x_expect[i] = 1.0 + sin(0.01 * static_cast<double>(i));
+        }
+        ASSERT_EQ(stencil_apply(&U.S, x_expect.data(), b.data()), 0);
+
+        for (const char* solver : {"PCG", "Multigrid", "MultigridW"}) {
+            vector<double> x(n, 0.0);
+            ASSERT_EQ(linear_solver_stencil(&U.S, b.data(), x.data(), 12, 1e-8, solver, "Multigrid"), 0)
+                << solver << " N = " << N;
+            for (size_t i = 0; i < n; ++i) {
+                EXPECT_NEAR(x[i], x_expect[i], 1e-6) << solver << " N = " << N;
+            }
+        }
+    }
+
+    // 3D (7-point) grid with an odd size, W-cycle preconditioner
+    UniformStencil U(21, 21, 0.1, 1.0);
+    const size_t n = static_cast<size_t>(21) * 21 * 21;
+    vector<double> x_expect(n), b(n), x(n, 0.0);
+    for (size_t i = 0; i < n; ++i) {
+        x_expect[i] = cos(0.02 * static_cast<double>(i));
+    }
+    ASSERT_EQ(stencil_apply(&U.S, x_expect.data(), b.data()), 0);
+    ASSERT_EQ(pcg_solver_stencil(&U.S, b.data(), x.data(), 12, 1e-8, "MultigridW"), 0);
+    for (size_t i = 0; i < n; ++i) {
+        EXPECT_NEAR(x[i], x_expect[i], 1e-6);
+    }
+}
+
+// Smoothed-aggregation AMG on the assembled matrix: few PCG iterations and V-cycles, also
+// with coefficient jumps (layers of 1000x larger face coefficients)
+TEST(PCG_Test, AMGPreconditionerAndSolver) {
+    for (bool jumps : {false, true}) {
+        const int N = 96;
+        UniformStencil U(N, 1, 0.0, 1.0);
+        if (jumps) {
+            for (int i = 1; i < N; ++i) {
+                const double c = (i % 7 < 3) ? 1000.0 : 1.0;
+                U.c_low[i] = c;
+                U.c_high[i - 1] = c;
+            }
+        }
+        CRSMatrix A = make_stencil_crs(U);
+        ASSERT_EQ(crs_validate(&A), 0);
+
+        const size_t n = A.rows;
+        vector<double> x_expect(n), b(n);
+        for (size_t i = 0; i < n; ++i) {
+            x_expect[i] = 1.0 + sin(0.01 * static_cast<double>(i));
+        }
+        ASSERT_EQ(crs_mat_vec_mult(&A, x_expect.data(), b.data()), 0);
+        const double tol = 1e-10 * sqrt(dot_product(b.data(), b.data(), static_cast<int>(n)));
+
+        vector<double> x(n, 0.0);
+        ASSERT_EQ(pcg_solver_crs(&A, b.data(), x.data(), jumps ? 60 : 15, tol, "AMG"), 0) << jumps;
+        for (size_t i = 0; i < n; ++i) {
+            EXPECT_NEAR(x[i], x_expect[i], 1e-6) << jumps;
+        }
+
+        if (!jumps) {
+            vector<double> y(n, 0.0);
+            ASSERT_EQ(linear_solver_crs(&A, b.data(), y.data(), 40, tol, "AMG", "None"), 0);
+            for (size_t i = 0; i < n; ++i) {
+                EXPECT_NEAR(y[i], x_expect[i], 1e-6);
+            }
+        }
+
+        free_crs_matrix(&A);
+    }
+}
+
+// Helper assembling the nonsymmetric 2D advection-diffusion matrix (first-order upwind,
+// velocity 'c' along +x and +y, zero Dirichlet boundaries)
+static CRSMatrix make_upwind_crs(int N, double c) {
+    const size_t n = static_cast<size_t>(N) * N;
+    CRSMatrix A{};
+    A.rows = n;
+    A.cols = n;
+    A.row_ptr = static_cast<size_t*>(malloc((n + 1) * sizeof(size_t)));
+    A.col_idx = static_cast<size_t*>(malloc(5 * n * sizeof(size_t)));
+    A.values = static_cast<double*>(malloc(5 * n * sizeof(double)));
+
+    size_t k = 0;
+    for (int j = 0; j < N; ++j) {
+        for (int i = 0; i < N; ++i) {
+            size_t p = static_cast<size_t>(j) * N + i;
+            A.row_ptr[p] = k;
+            if (j > 0)     { A.col_idx[k] = p - N; A.values[k++] = -1.0 - c; }
+            if (i > 0)     { A.col_idx[k] = p - 1; A.values[k++] = -1.0 - c; }
+            A.col_idx[k] = p; A.values[k++] = 4.0 + 2.0 * c;
+            if (i + 1 < N) { A.col_idx[k] = p + 1; A.values[k++] = -1.0; }
+            if (j + 1 < N) { A.col_idx[k] = p + N; A.values[k++] = -1.0; }
+        }
+    }
+    A.row_ptr[n] = k;
+    A.nnz = k;
+    return A;
+}
+
+// BiCGSTAB and GMRES(m) on nonsymmetric upwinded systems. The symmetric preconditioners
+// (incomplete Cholesky, AMG) only exist for weak advection.
+TEST(PCG_Test, NonsymmetricSolvers) {
+    for (double c : {0.2, 5.0}) {
+        CRSMatrix A = make_upwind_crs(40, c);
+        ASSERT_EQ(crs_validate(&A), 0);
+
+        const size_t n = A.rows;
+        vector<double> x_expect(n), b(n);
+        for (size_t i = 0; i < n; ++i) {
+            x_expect[i] = 1.0 + sin(0.05 * static_cast<double>(i));
+        }
+        ASSERT_EQ(crs_mat_vec_mult(&A, x_expect.data(), b.data()), 0);
+
+        for (const char* solver : {"BiCGSTAB", "GMRES", "GMRES(10)"}) {
+            for (const char* preconditioner : {"None", "Jacobi", "IncompleteCholesky", "AMG"}) {
+                if (c > 1.0 && preconditioner[0] != 'N' && preconditioner[0] != 'J') {
+                    continue;
+                }
+                vector<double> x(n, 0.0);
+                ASSERT_EQ(linear_solver_crs(&A, b.data(), x.data(), 1000, 1e-10, solver, preconditioner), 0)
+                    << solver << " / " << preconditioner << " c = " << c;
+                for (size_t i = 0; i < n; ++i) {
+                    EXPECT_NEAR(x[i], x_expect[i], 1e-8) << solver << " / " << preconditioner << " c = " << c;
+                }
+
+                // Convergence is reported on the true residual
+                vector<double> Ax(n);
+                ASSERT_EQ(crs_mat_vec_mult(&A, x.data(), Ax.data()), 0);
+                double res = 0.0;
+                for (size_t i = 0; i < n; ++i) {
+                    res += (b[i] - Ax[i]) * (b[i] - Ax[i]);
+                }
+                EXPECT_LT(sqrt(res), 1e-10) << solver << " / " << preconditioner << " c = " << c;
+            }
+        }
+        free_crs_matrix(&A);
+    }
+
+    CRSMatrix A = make_upwind_crs(40, 5.0);
+    ASSERT_EQ(crs_validate(&A), 0);
+    const size_t n = A.rows;
+    vector<double> b(n, 1.0);
+
+    // Unknown restart syntax and non-convergence within the iteration limit
+    vector<double> x(n, 0.0);
+    EXPECT_EQ(linear_solver_crs(&A, b.data(), x.data(), 100, 1e-10, "GMRES(x)", "None"), -1);
+    EXPECT_EQ(linear_solver_crs(&A, b.data(), x.data(), 100, 1e-10, "GMRES(10)x", "None"), -1);
+    EXPECT_EQ(gmres_solver_crs(&A, b.data(), x.data(), 3, 1e-10, 2, "None"), 1);
+
+    free_crs_matrix(&A);
+}
+
+// A preconditioner handle and a workspace are set up once and reused by several solves and
+// solvers (repeated solves do not allocate); after the matrix values change, 'setup' rebuilds
+// the handle in place
+TEST(PCG_Test, PreconditionerHandleReuse) {
+    const int N = 32;
+    UniformStencil U(N, 1, 0.01, 1.0);
+    CRSMatrix A{};
+    ASSERT_EQ(stencil_to_crs(&U.S, &A), 0);
+    const size_t n = A.rows;
+    SolverWorkspace ws = SOLVER_WORKSPACE_INIT;
+
+    for (const char* type : {"Jacobi", "IncompleteCholesky"}) {
+        Preconditioner M;
+        ASSERT_EQ(preconditioner_crs(&M, &A, type), 0) << type;
+        EXPECT_EQ(M.n, n);
+
+        for (double scale : {1.0, 4.0}) {
+            if (scale != 1.0) {
+                for (size_t k = 0; k < A.nnz; ++k) {
+                    A.values[k] *= scale;
+                }
+                ASSERT_EQ(M.setup(&M), 0) << type;
+            }
+            for (const char* solver : {"PCG", "PipelinedPCG", "BiCGSTAB", "GMRES"}) {
+                size_t allocations = ws.allocations;
+                for (int rhs = 0; rhs < 2; ++rhs) {
+                    vector<double> x_expect(n), b(n), x(n, 0.0);
+                    for (size_t i = 0; i < n; ++i) {
+                        x_expect[i] = 1.0 + sin(0.1 * static_cast<double>(i + rhs * 7));
+                    }
+                    ASSERT_EQ(crs_mat_vec_mult(&A, x_expect.data(), b.data()), 0);
+                    ASSERT_EQ(linear_solver_crs_precond(&A, b.data(), x.data(), 2000, 1e-10, solver, &M, &ws), 0)
+                        << type << " / " << solver;
+                    for (size_t i = 0; i < n; ++i) {
+                        EXPECT_NEAR(x[i], x_expect[i], 1e-8) << type << " / " << solver;
+                    }
+                    if (rhs == 0) {
+                        allocations = ws.allocations;
+                    }
+                }
+                EXPECT_EQ(ws.allocations, allocations) << type << " / " << solver;
+            }
+        }
+        for (size_t k = 0; k < A.nnz; ++k) {
+            A.values[k] /= 4.0;
+        }
+        preconditioner_free(&M);
+    }
+
+    // Matrix-free stencil with a multigrid handle through the abstract operator
+    {
+        Preconditioner M;
+        ASSERT_EQ(preconditioner_stencil(&M, &U.S, "Multigrid"), 0);
+        LinearOperator op;
+        ASSERT_EQ(linear_operator_stencil(&op, &U.S), 0);
+        vector<double> x_expect(n, 1.0), b(n), x(n, 0.0);
+        ASSERT_EQ(stencil_apply(&U.S, x_expect.data(), b.data()), 0);
+        ASSERT_EQ(pcg_solver_precond(&op, b.data(), x.data(), 20, 1e-10, &M, &ws), 0);
+        for (size_t i = 0; i < n; ++i) {
+            EXPECT_NEAR(x[i], 1.0, 1e-8);
+        }
+        preconditioner_free(&M);
+    }
+
+    // Unknown or unsupported types fail and leave a handle that is safe to free; a handle
+    // without a team apply is rejected by pipelined PCG
+    Preconditioner M;
+    EXPECT_EQ(preconditioner_crs(&M, &A, "Unknown"), -1);
+    preconditioner_free(&M);
+    EXPECT_EQ(preconditioner_crs(&M, &A, "Multigrid"), -1);
+    preconditioner_free(&M);
+    ASSERT_EQ(preconditioner_crs(&M, &A, "AMG"), 0);
+    vector<double> b(n, 1.0), x(n, 0.0);
+    EXPECT_EQ(linear_solver_crs_precond(&A, b.data(), x.data(), 100, 1e-10, "PipelinedPCG", &M, nullptr), -1);
+    preconditioner_free(&M);
+    preconditioner_free(&M);
+
+    // The block only grew for a solver needing more vectors (PCG, pipelined PCG, GMRES)
+    EXPECT_LE(ws.allocations, 3u);
+    workspace_free(&ws);
+
+    // Vectors are cache-line aligned and never exceed the reservation
+    SolverWorkspace small = SOLVER_WORKSPACE_INIT;
+    ASSERT_EQ(workspace_reserve(&small, 3 * workspace_size(5)), 0);
+    for (int k = 0; k < 3; ++k) {
+        double* v = workspace_take(&small, 5);
+        ASSERT_NE(v, nullptr);
+        EXPECT_EQ(reinterpret_cast<uintptr_t>(v) % WORKSPACE_ALIGNMENT, 0u);
+    }
+    EXPECT_EQ(workspace_take(&small, 1), nullptr);
+    workspace_free(&small);
+
+    free_crs_matrix(&A);
+}
+
+// Single-precision IC factor / multigrid hierarchy: iterative refinement keeps the true residual
+// in double and reaches a tolerance far below the float precision of the preconditioner
+TEST(PCG_Test, MixedPrecisionRefinement) {
+    const int N = 48;
+    UniformStencil U(N, 1, 0.01, 1.0);
+    const size_t n = static_cast<size_t>(N) * N;
+    LinearOperator op;
+    ASSERT_EQ(linear_operator_stencil(&op, &U.S), 0);
+    vector<double> x_expect(n), b(n), r(n);
+    for (size_t i = 0; i < n; ++i) {
+        x_expect[i] = 1.0 + sin(0.05 * static_cast<double>(i));
+    }
+    ASSERT_EQ(stencil_apply(&U.S, x_expect.data(), b.data()), 0);
+    const double tol = 1e-11;
+    SolverWorkspace ws = SOLVER_WORKSPACE_INIT;
+
+    for (const char* type : {"IncompleteCholesky", "Multigrid"}) {
+        Preconditioner M;
+        ASSERT_EQ(preconditioner_stencil(&M, &U.S, type), 0) << type;
+        ASSERT_EQ(preconditioner_set_precision(&M, PRECONDITIONER_SINGLE), 0) << type;
+        EXPECT_EQ(M.precision, PRECONDITIONER_SINGLE);
+
+        for (int solve = 0; solve < 2; ++solve) {
+            vector<double> x(n, 0.0);
+            ASSERT_EQ(pcg_solver_refinement(&op, b.data(), x.data(), 500, tol, &M, &ws), 0) << type;
+            ASSERT_EQ(stencil_apply(&U.S, x.data(), r.data()), 0);
+            vec_subtract(b.data(), r.data(), r.data(), static_cast<int>(n));
+            EXPECT_LT(sqrt(dot_product(r.data(), r.data(), static_cast<int>(n))), tol) << type;
+        }
+
+        // Back to double precision (setup runs again)
+        ASSERT_EQ(preconditioner_set_precision(&M, PRECONDITIONER_DOUBLE), 0) << type;
+        vector<double> x(n, 0.0);
+        ASSERT_EQ(pcg_solver_precond(&op, b.data(), x.data(), 500, tol, &M, &ws), 0) << type;
+        for (size_t i = 0; i < n; ++i) {
+            EXPECT_NEAR(x[i], x_expect[i], 1e-8) << type;
+        }
+        preconditioner_free(&M);
+    }
+    workspace_free(&ws);
+
+    // Standalone multigrid with single-precision cycles corrects a double residual
+    Multigrid mg{};
+    ASSERT_EQ(multigrid_setup(&U.S, MULTIGRID_V_CYCLE, &mg), 0);
+    ASSERT_EQ(multigrid_use_single(&mg), 0);
+    vector<double> x(n, 0.0);
+    ASSERT_EQ(multigrid_solve(&mg, b.data(), x.data(), 100, tol), 0);
+    for (size_t i = 0; i < n; ++i) {
+        EXPECT_NEAR(x[i], x_expect[i], 1e-8);
+    }
+    multigrid_free(&mg);
+}
+
+// Block PCG: k right-hand sides solved together match the single solves, columns that
+// converge at different iterations (zero, smooth, rough right-hand sides) included
+TEST(PCG_Test, BlockPCGMatchesSingleSolves) {
+    const int N = 40;
+    UniformStencil U(N, 1, 0.01, 1.0);
+    CRSMatrix A{};
+    ASSERT_EQ(stencil_to_crs(&U.S, &A), 0);
+    const size_t n = A.rows;
+    const int k = 5;
+    vector<double> X_expect(n * k), B(n * k);
+    for (int c = 0; c < k; ++c) {
+        for (size_t i = 0; i < n; ++i) {
+            X_expect[c * n + i] = (c == 0) ? 0.0 : 1.0 + sin(0.02 * c * c * static_cast<double>(i));
+        }
+        ASSERT_EQ(crs_mat_vec_mult(&A, X_expect.data() + c * n, B.data() + c * n), 0);
+    }
+
+    SolverWorkspace ws = SOLVER_WORKSPACE_INIT;
+    for (const char* type : {"None", "Jacobi", "IncompleteCholesky"}) {
+        Preconditioner M;
+        ASSERT_EQ(preconditioner_crs(&M, &A, type), 0) << type;
+        vector<double> X(n * k, 0.0);
+        ASSERT_EQ(block_pcg_solver_precond(&A, B.data(), X.data(), k, 2000, 1e-10, &M, &ws), 0) << type;
+
+        LinearOperator op;
+        ASSERT_EQ(linear_operator_crs(&op, &A), 0);
+        for (size_t i = 0; i < n; ++i) {
+            EXPECT_EQ(X[i], 0.0) << type;   // Zero right-hand side: retired before the first iteration
+        }
+        for (int c = 1; c < k; ++c) {
+            vector<double> x(n, 0.0);
+            ASSERT_EQ(pcg_solver_precond(&op, B.data() + c * n, x.data(), 2000, 1e-10, &M, nullptr), 0) << type;
+            for (size_t i = 0; i < n; ++i) {
+                EXPECT_NEAR(X[c * n + i], x[i], 1e-10) << type << ", column " << c;
+                EXPECT_NEAR(X[c * n + i], X_expect[c * n + i], 1e-8) << type << ", column " << c;
+            }
+        }
+        preconditioner_free(&M);
+    }
+    workspace_free(&ws);
+
+    // Name-based entry point and a too small iteration budget
+    vector<double> X(n * k, 0.0);
+    EXPECT_EQ(block_pcg_solver_crs(&A, B.data(), X.data(), k, 2, 1e-10, "Jacobi"), 1);
+    EXPECT_EQ(block_pcg_solver_crs(&A, B.data(), X.data(), 0, 100, 1e-10, "Jacobi"), -1);
+    free_crs_matrix(&A);
+}
+
+// Red-black / multicolour SOR: the CRS sweep in colour order equals the red-black stencil
+// sweep, the solvers converge (standalone, 27-point pattern with 8 colours) and both
+// multigrid methods accept the SOR smoother
+TEST(PCG_Test, MulticolorSOR) {
+    const int N = 24;
+    UniformStencil U(N, 1, 0.5, 1.0);
+    const size_t n = static_cast<size_t>(N) * N;
+    CRSMatrix A{};
+    ASSERT_EQ(stencil_to_crs(&U.S, &A), 0);
+    vector<double> x_expect(n), b(n), inv_diag(n);
+    for (size_t i = 0; i < n; ++i) {
+        x_expect[i] = 1.0 + sin(0.05 * static_cast<double>(i));
+    }
+    ASSERT_EQ(stencil_apply(&U.S, x_expect.data(), b.data()), 0);
+
+    MulticolorSOR C;
+    ASSERT_EQ(multicolor_setup(&A, &C), 0);
+    EXPECT_EQ(C.num_colors, 2);
+    ASSERT_EQ(stencil_diagonal(&U.S, inv_diag.data()), 0);
+    for (double& d : inv_diag) d = 1.0 / d;
+    vector<double> x1(n, 0.0), x2(n, 0.0);
+    for (int s = 0; s < 3; ++s) {
+        multicolor_sor_sweep(&C, &A, b.data(), x1.data(), 1.3, 0);
+        ASSERT_EQ(stencil_sor_sweep(&U.S, b.data(), x2.data(), inv_diag.data(), 1.3, 0), 0);
+        ASSERT_EQ(stencil_sor_sweep(&U.S, b.data(), x2.data(), inv_diag.data(), 1.3, 1), 0);
+    }
+    for (size_t i = 0; i < n; ++i) {
+        ASSERT_NEAR(x1[i], x2[i], 1e-12);
+    }
+    multicolor_free(&C);
+
+    for (const char* solver : {"Gauss-Seidel", "SOR(1.6)"}) {
+        vector<double> x(n, 0.0), y(n, 0.0);
+        ASSERT_EQ(linear_solver_stencil(&U.S, b.data(), x.data(), 2000, 1e-10, solver, "None"), 0) << solver;
+        ASSERT_EQ(linear_solver_crs(&A, b.data(), y.data(), 2000, 1e-10, solver, "None"), 0) << solver;
+        for (size_t i = 0; i < n; ++i) {
+            EXPECT_NEAR(x[i], x_expect[i], 1e-8) << solver;
+            EXPECT_NEAR(y[i], x_expect[i], 1e-8) << solver;
+        }
+    }
+    vector<double> x(n, 0.0);
+    EXPECT_EQ(linear_solver_stencil(&U.S, b.data(), x.data(), 2000, 1e-10, "SOR(2.5)", "None"), -1);
+    EXPECT_EQ(linear_solver_stencil(&U.S, b.data(), x.data(), 2000, 1e-10, "SOR(1.5))", "None"), -1);
+
+    // Multigrid with red-black SOR smoothing, AMG with the multicolour smoother
+    Multigrid mg;
+    ASSERT_EQ(multigrid_setup(&U.S, MULTIGRID_V_CYCLE, &mg), 0);
+    ASSERT_EQ(multigrid_set_relaxation(&mg, 1.15), 0);
+    fill(x.begin(), x.end(), 0.0);
+    ASSERT_EQ(multigrid_solve(&mg, b.data(), x.data(), 20, 1e-10), 0);
+    multigrid_free(&mg);
+    AMG amg;
+    ASSERT_EQ(amg_setup(&A, &amg), 0);
+    ASSERT_EQ(amg_set_smoother(&amg, AMG_SMOOTHER_MULTICOLOR_SOR, 1.0), 0);
+    vector<double> y(n, 0.0);
+    ASSERT_EQ(amg_solve(&amg, b.data(), y.data(), 40, 1e-10), 0);
+    amg_free(&amg);
+    for (size_t i = 0; i < n; ++i) {
+        EXPECT_NEAR(x[i], x_expect[i], 1e-8);
+        EXPECT_NEAR(y[i], x_expect[i], 1e-8);
+    }
+    free_crs_matrix(&A);
+
+    // 27-point pattern of a 3D grid: 8 colours
+    const int M = 10;
+    vector<size_t> row, col;
+    vector<double> val;
+    for (int k = 0; k < M; ++k)
+        for (int j = 0; j < M; ++j)
+            for (int i = 0; i < M; ++i)
+                for (int d = 0; d < 27; ++d) {
+                    const int a = i + d % 3 - 1, c = j + d / 3 % 3 - 1, e = k + d / 9 - 1;
+                    if (a < 0 || a >= M || c < 0 || c >= M || e < 0 || e >= M) continue;
+                    row.push_back((static_cast<size_t>(k) * M + j) * M + i);
+                    col.push_back((static_cast<size_t>(e) * M + c) * M + a);
+                    val.push_back(d == 13 ? 28.0 : -1.0);
+                }
+    ASSERT_EQ(coo_to_crs(row.data(), col.data(), val.data(), row.size(), M * M * M, M * M * M, &A), 0);
+    ASSERT_EQ(multicolor_setup(&A, &C), 0);
+    EXPECT_EQ(C.num_colors, 8);
+    multicolor_free(&C);
+    const size_t m = A.rows;
+    vector<double> z_expect(m, 1.0), c(m), z(m, 0.0);
+    ASSERT_EQ(crs_mat_vec_mult(&A, z_expect.data(), c.data()), 0);
+    ASSERT_EQ(sor_solver_crs(&A, c.data(), z.data(), 500, 1e-10, 1.0), 0);
+    for (size_t i = 0; i < m; ++i) {
+        EXPECT_NEAR(z[i], 1.0, 1e-9);
+    }
+    free_crs_matrix(&A);
+}
+
+// Chebyshev polynomial: the Lanczos bounds agree with those from the coefficients of a
+// Jacobi-PCG solve, the preconditioner cuts the PCG iterations and works with either bounds,
+// and AMG converges with the Chebyshev smoother
+TEST(PCG_Test, ChebyshevPreconditionerAndSmoother) {
+    const int N = 32;
+    UniformStencil U(N, 1, 0.01, 1.0);
+    const size_t n = static_cast<size_t>(N) * N;
+    LinearOperator op;
+    ASSERT_EQ(linear_operator_stencil(&op, &U.S), 0);
+    vector<double> x_expect(n), b(n), inv_diag(n);
+    for (size_t i = 0; i < n; ++i) {
+        x_expect[i] = 1.0 + sin(0.05 * static_cast<double>(i));
+    }
+    ASSERT_EQ(stencil_apply(&U.S, x_expect.data(), b.data()), 0);
+    ASSERT_EQ(stencil_diagonal(&U.S, inv_diag.data()), 0);
+    for (double& d : inv_diag) d = 1.0 / d;
+
+    // Jacobi-PCG, recording its coefficients: the Lanczos tridiagonal of D^(-1) * A
+    vector<double> alpha(500), beta(500);
+    CGCoefficients coeffs{alpha.data(), beta.data(), 500, 0};
+    Preconditioner J;
+    ASSERT_EQ(preconditioner_stencil(&J, &U.S, "Jacobi"), 0);
+    vector<double> x(n, 0.0);
+    ASSERT_EQ(pcg_solver_record(&op, b.data(), x.data(), 500, 1e-10, &J, nullptr, &coeffs), 0);
+    preconditioner_free(&J);
+    const int jacobi_iterations = coeffs.count;
+    double cg_min, cg_max, lz_min, lz_max;
+    ASSERT_EQ(chebyshev_cg_bounds(alpha.data(), beta.data(), coeffs.count, &cg_min, &cg_max), 0);
+    ASSERT_EQ(chebyshev_lanczos_bounds(&op, inv_diag.data(), CHEBYSHEV_LANCZOS_STEPS, &lz_min, &lz_max), 0);
+    EXPECT_GT(cg_min, 0.0);
+    EXPECT_LT(cg_max, 2.0);                      // Gershgorin bound of D^(-1) * A
+    EXPECT_LE(lz_max, cg_max * (1.0 + 1e-8));    // Ritz values lie inside the spectrum
+    EXPECT_GT(lz_max, 0.95 * cg_max);
+    EXPECT_GE(lz_min, cg_min * (1.0 - 1e-8));
+
+    // Chebyshev-PCG (Lanczos bounds, then the CG bounds); the same handle serves both solves
+    Preconditioner M;
+    ASSERT_EQ(preconditioner_stencil(&M, &U.S, "Chebyshev(6)"), 0);
+    EXPECT_EQ(M.type, PRECONDITIONER_CHEBYSHEV);
+    EXPECT_EQ(M.variant, 6);
+    for (int pass = 0; pass < 2; ++pass) {
+        if (pass == 1) {
+            ASSERT_EQ(preconditioner_set_spectrum(&M, cg_min, cg_max), 0);
+        }
+        fill(x.begin(), x.end(), 0.0);
+        coeffs.count = 0;
+        ASSERT_EQ(pcg_solver_record(&op, b.data(), x.data(), 500, 1e-10, &M, nullptr, &coeffs), 0);
+        EXPECT_LT(2 * coeffs.count, jacobi_iterations) << "pass " << pass;
+        for (size_t i = 0; i < n; ++i) {
+            EXPECT_NEAR(x[i], x_expect[i], 1e-8);
+        }
+    }
+    EXPECT_EQ(preconditioner_set_spectrum(&M, 1.0, 0.5), -1);
+    preconditioner_free(&M);
+
+    // CRS matrix and the other PCG entry points
+    CRSMatrix A{};
+    ASSERT_EQ(stencil_to_crs(&U.S, &A), 0);
+    fill(x.begin(), x.end(), 0.0);
+    ASSERT_EQ(pcg_solver_crs(&A, b.data(), x.data(), 500, 1e-10, "Chebyshev"), 0);
+    vector<double> y(n, 0.0);
+    ASSERT_EQ(pcg_solver_stencil(&U.S, b.data(), y.data(), 500, 1e-10, "Chebyshev(3)"), 0);
+    for (size_t i = 0; i < n; ++i) {
+        EXPECT_NEAR(x[i], x_expect[i], 1e-8);
+        EXPECT_NEAR(y[i], x_expect[i], 1e-8);
+    }
+    EXPECT_EQ(preconditioner_crs(&M, &A, "Chebyshev(0)"), -1);
+    EXPECT_EQ(preconditioner_crs(&M, &A, "Chebyshev(4"), -1);
+    EXPECT_EQ(preconditioner_crs(&M, &A, "Chebyshev(4)junk"), -1);
+    vector<double> dense(4, 1.0);
+    EXPECT_EQ(preconditioner_dense(&M, dense.data(), 2, "Chebyshev"), -1);
+
+    // AMG with the Chebyshev smoother, standalone and as a preconditioner
+    AMG amg;
+    ASSERT_EQ(amg_setup(&A, &amg), 0);
+    ASSERT_EQ(amg_set_smoother(&amg, AMG_SMOOTHER_CHEBYSHEV, 1.0), 0);
+    fill(x.begin(), x.end(), 0.0);
+    ASSERT_EQ(amg_solve(&amg, b.data(), x.data(), 30, 1e-10), 0);
+    for (size_t i = 0; i < n; ++i) {
+        EXPECT_NEAR(x[i], x_expect[i], 1e-8);
+    }
+    amg_free(&amg);
+    free_crs_matrix(&A);
+}
+
+// A reordered system (Matrix_ordering) solved with IC on B = P * A * P^T gives the solution of A
+TEST(PCG_Test, ReorderedCRSSystem) {
+    const int N = 24;
+    UniformStencil U(N, 1, 0.01, 1.0);
+    CRSMatrix A = make_stencil_crs(U);
+    ASSERT_EQ(crs_validate(&A), 0);
+
+    const size_t n = A.rows;
+    vector<double> x_expect(n), b(n);
+    for (size_t i = 0; i < n; ++i) {
+        x_expect[i] = sin(0.1 * static_cast<double>(i));
+    }
+    ASSERT_EQ(crs_mat_vec_mult(&A, x_expect.data(), b.data()), 0);
+
+    CRSOrdering ordering;
+    ASSERT_EQ(crs_ordering_parse("Natural", &ordering), 0);
+    CRSReordering natural{};
+    ASSERT_EQ(crs_reordering_setup(&A, ordering, N, N, 1, &natural), 0);
+    EXPECT_EQ(natural.perm, nullptr);
+    crs_reordering_free(&natural);
+    EXPECT_EQ(crs_ordering_parse("Random", &ordering), -1);
+
+    for (const char* name : {"RCM", "Morton", "Hilbert"}) {
+        ASSERT_EQ(crs_ordering_parse(name, &ordering), 0) << name;
+        CRSReordering R{};
+        ASSERT_EQ(crs_reordering_setup(&A, ordering, N, N, 1, &R), 0) << name;
+        ASSERT_NE(R.perm, nullptr) << name;
+        EXPECT_EQ(R.B.nnz, A.nnz) << name;
+
+        // Two solves reuse the permutation; the second starts from the solution
+        vector<double> x(n, 0.0);
+        for (int solve = 0; solve < 2; ++solve) {
+            crs_reordering_permute(&R, b.data(), x.data());
+            ASSERT_EQ(pcg_solver_crs(&R.B, R.b, R.x, 2000, 1e-10, "IncompleteCholesky"), 0) << name;
+            crs_reordering_unpermute(&R, x.data());
+            for (size_t i = 0; i < n; ++i) {
+                EXPECT_NEAR(x[i], x_expect[i], 1e-8) << name;
+            }
+        }
+        crs_reordering_free(&R);
+        EXPECT_EQ(R.perm, nullptr) << name;
+    }
 
+    // The curves need the grid of the matrix
+    CRSReordering R{};
+    EXPECT_EQ(crs_reordering_setup(&A, CRS_ORDERING_MORTON, N, N + 1, 1, &R), -1);
+    crs_reordering_free(&R);
+    free_crs_matrix(&A);
 }
 
 TEST(PCG_Test, LargeSystem) {
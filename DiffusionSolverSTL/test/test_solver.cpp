@@ -0,0 +1,254 @@
+#include <gtest/gtest.h>
+#include <vector>
+#include <cmath>
+#include "solver/ImplicitScheme.hpp"
+#include "solver/CrankNicolsonScheme.hpp"
+#include "solver/ImplicitSystem.hpp"
+#include "simulation_parameters/Grid.hpp"
+#include "field/Field.hpp"
+
+using namespace std;
+
+// Solves the dense row-major system A * x = b by Gaussian elimination with partial pivoting
+static vector<double> dense_solve(vector<double> A, vector<double> b) {
+    const size_t n = b.size();
+    for (size_t k = 0; k < n; ++k) {
+        size_t pivot = k;
+        for (size_t i = k + 1; i < n; ++i) {
+            if (fabs(A[i * n + k]) > fabs(A[pivot * n + k])) {
+                pivot = i;
+            }
+        }
+        for (size_t j = 0; j < n; ++j) {
+            swap(A[k * n + j], A[pivot * n + j]);
+        }
+        swap(b[k], b[pivot]);
+        for (size_t i = k + 1; i < n; ++i) {
+            const double f = A[i * n + k] / A[k * n + k];
+            for (size_t j = k; j < n; ++j) {
+                A[i * n + j] -= f * A[k * n + j];
+            }
+            b[i] -= f * b[k];
+        }
+    }
+    vector<double> x(n);
+    for (size_t i = n; i-- > 0;) {
+        double sum = b[i];
+        for (size_t j = i + 1; j < n; ++j) {
+            sum -= A[i * n + j] * x[j];
+        }
+        x[i] = sum / A[i * n + i];
+    }
+    return x;
+}
+
+/*
+ * Dense reference of one theta step: assembles (co + theta * K) * T^(n+1) = co * T^n
+ * - (1 - theta) * K * T^n + boundary terms cell by cell from the Grid coefficients (nz = 1 in
+ * 2D) and solves it with dense_solve. 'To(i, j, k)' returns T^n, halo (boundary) cells included.
+ */
+template <typename Value>
+static vector<double> dense_theta_step(const Grid& grid, int dimension, double theta, Value To) {
+    const int N = grid.N;
+    const int nz = (dimension == 3) ? N : 1;
+    const size_t n = static_cast<size_t>(N) * N * nz;
+    vector<double> A(n * n, 0.0), b(n, 0.0);
+
+    for (int k = 0; k < nz; ++k) {
+        for (int j = 0; j < N; ++j) {
+            for (int i = 0; i < N; ++i) {
+                const size_t p = (static_cast<size_t>(k) * N + j) * N + i;
+                const double co = (dimension == 3) ? grid.co3D(i, j, k) : grid.co2D(i, j);
+                A[p * n + p] += co;
+                b[p] += co * To(i, j, k);
+
+                // Faces: (di, dj, dk, coefficient), the grid arrays are shifted by one
+                struct Face { int di, dj, dk; double c; };
+                vector<Face> faces = {{1, 0, 0, grid.ce[i + 1]}, {-1, 0, 0, grid.cw[i + 1]},
+                                      {0, 1, 0, grid.cn[j + 1]}, {0, -1, 0, grid.cs[j + 1]}};
+                if (dimension == 3) {
+                    faces.push_back({0, 0, 1, grid.cf[k + 1]});
+                    faces.push_back({0, 0, -1, grid.cb[k + 1]});
+                }
+                for (const Face& f : faces) {
+                    const int ni = i + f.di, nj = j + f.dj, nk = k + f.dk;
+                    A[p * n + p] += theta * f.c;
+                    b[p] += (1.0 - theta) * f.c * (To(ni, nj, nk) - To(i, j, k));
+                    if (ni < 0 || ni >= N || nj < 0 || nj >= N || nk < 0 || nk >= nz) {
+                        b[p] += theta * f.c * To(ni, nj, nk);   // Fixed boundary value
+                    } else {
+                        A[p * n + (static_cast<size_t>(nk) * N + nj) * N + ni] -= theta * f.c;
+                    }
+                }
+            }
+        }
+    }
+    return dense_solve(A, b);
+}
+
+// Initial field with a hot top boundary and a non-uniform interior (halo = boundary values)
+static Field2D initial_field_2D(int N) {
+    Field2D T(N, N, 300.0, 1);
+    for (int i = -1; i < N + 1; ++i) {
+        T(i, N) = 500.0;
+    }
+    for (int j = 0; j < N; ++j) {
+        for (int i = 0; i < N; ++i) {
+            T(i, j) = 300.0 + 10.0 * sin(0.7 * i + 1.3 * j);
+        }
+    }
+    return T;
+}
+
+static Field3D initial_field_3D(int N) {
+    Field3D T(N, N, N, 300.0, 1);
+    for (int j = -1; j < N + 1; ++j) {
+        for (int i = -1; i < N + 1; ++i) {
+            T(i, j, N) = 500.0;
+        }
+    }
+    for (int k = 0; k < N; ++k) {
+        for (int j = 0; j < N; ++j) {
+            for (int i = 0; i < N; ++i) {
+                T(i, j, k) = 300.0 + 10.0 * sin(0.7 * i + 1.3 * j + 0.4 * k);
+            }
+        }
+    }
+    return T;
+}
+
+// One implicit Euler step (theta = 1) and one Crank-Nicolson step (theta = 0.5) in 2D match the
+// dense solve of the same system, for a matrix-free and an assembled (CRS) solver
+TEST(SolverTest, ThetaStepsMatchDenseSolve2D) {
+    const int N = 7;
+    Grid grid(N, 1.0, 1.0, 1.0, 0.01);
+    grid.initialize_coefficients();
+
+    for (const char* solver : {"PCG", "BiCGSTAB"}) {
+        LinearSolverSettings settings{solver, "IncompleteCholesky", 1000, 1e-12};
+        for (double theta : {1.0, 0.5}) {
+            ImplicitScheme implicit(settings);
+            CrankNicolsonScheme crank_nicolson(settings);
+            TimeStepping& scheme = (theta == 1.0) ? static_cast<TimeStepping&>(implicit) : crank_nicolson;
+
+            TimeLevels2D T(initial_field_2D(N));
+            const Field2D To = T.old();
+            vector<Field2D> Ts;
+            scheme.step(T, grid, 1, 100, Ts);
+
+            const vector<double> ref = dense_theta_step(grid, 2, theta, [&](int i, int j, int) { return To(i, j); });
+            for (int j = 0; j < N; ++j) {
+                for (int i = 0; i < N; ++i) {
+                    EXPECT_NEAR(T.current()(i, j), ref[static_cast<size_t>(j) * N + i], 1e-8)
+                        << solver << " theta = " << theta << " cell (" << i << ", " << j << ")";
+                }
+            }
+            // The boundary (halo) values are not written
+            EXPECT_DOUBLE_EQ(T.current()(2, N), 500.0);
+            EXPECT_DOUBLE_EQ(T.current()(-1, 3), 300.0);
+        }
+    }
+}
+
+TEST(SolverTest, ThetaStepsMatchDenseSolve3D) {
+    const int N = 4;
+    Grid grid(N, 1.0, 1.0, 1.0, 0.01);
+    grid.initialize_coefficients();
+    LinearSolverSettings settings{"PCG", "Jacobi", 1000, 1e-12};
+
+    for (double theta : {1.0, 0.5}) {
+        ImplicitScheme implicit(settings);
+        CrankNicolsonScheme crank_nicolson(settings);
+        TimeStepping& scheme = (theta == 1.0) ? static_cast<TimeStepping&>(implicit) : crank_nicolson;
+
+        TimeLevels3D T(initial_field_3D(N));
+        const Field3D To = T.old();
+        vector<Field3D> Ts;
+        scheme.step(T, grid, 1, 100, Ts);
+
+        const vector<double> ref = dense_theta_step(grid, 3, theta, [&](int i, int j, int k) { return To(i, j, k); });
+        for (int k = 0; k < N; ++k) {
+            for (int j = 0; j < N; ++j) {
+                for (int i = 0; i < N; ++i) {
+                    EXPECT_NEAR(T.current()(i, j, k), ref[(static_cast<size_t>(k) * N + j) * N + i], 1e-8)
+                        << "theta = " << theta;
+                }
+            }
+        }
+    }
+}
+
+// The linear system and its preconditioner are built on the first step only and reused by all
+// following steps of the same grid; a new grid gets a new system
+TEST(SolverTest, PreconditionerBuiltOnce) {
+    const int N = 8;
+    Grid grid(N, 1.0, 1.0, 1.0, 0.01);
+    grid.initialize_coefficients();
+
+    for (const char* solver : {"PCG", "BiCGSTAB"}) {
+        LinearSolverSettings settings{solver, "IncompleteCholesky", 1000, 1e-10};
+        ImplicitScheme implicit(settings);
+        CrankNicolsonScheme crank_nicolson(settings);
+        EXPECT_EQ(implicit.linear_system(), nullptr);
+
+        TimeLevels2D T_implicit(initial_field_2D(N));
+        TimeLevels2D T_cn(initial_field_2D(N));
+        vector<Field2D> Ts;
+        implicit.step(T_implicit, grid, 0, 100, Ts);
+        crank_nicolson.step(T_cn, grid, 0, 100, Ts);
+        const ImplicitSystem* system_implicit = implicit.linear_system();
+        const ImplicitSystem* system_cn = crank_nicolson.linear_system();
+        ASSERT_NE(system_implicit, nullptr);
+        ASSERT_NE(system_cn, nullptr);
+
+        for (int n = 1; n < 5; ++n) {
+            T_implicit.rotate();
+            T_cn.rotate();
+            implicit.step(T_implicit, grid, n, 100, Ts);
+            crank_nicolson.step(T_cn, grid, n, 100, Ts);
+            EXPECT_EQ(implicit.linear_system(), system_implicit) << solver;
+            EXPECT_EQ(crank_nicolson.linear_system(), system_cn) << solver;
+        }
+        EXPECT_EQ(system_implicit->preconditioner().type, PRECONDITIONER_IC);
+        EXPECT_EQ(system_implicit->preconditioner().builds, 1) << solver;
+        EXPECT_EQ(system_cn->preconditioner().builds, 1) << solver;
+
+        // The sync-free schedule only re-analyses the factor built by the first setup
+        LinearSolverSettings sync_free = settings;
+        sync_free.sync_free_trisolve = true;
+        ImplicitSystem system(grid, 2, 1.0, sync_free);
+        EXPECT_EQ(system.preconditioner().trisolve, TRISOLVE_SYNC_FREE);
+        EXPECT_EQ(system.preconditioner().builds, 1) << solver;
+    }
+
+    // Another grid: the scheme builds a new system for it
+    Grid other(N, 1.0, 1.0, 1.0, 0.02);
+    other.initialize_coefficients();
+    ImplicitScheme implicit;
+    TimeLevels2D T(initial_field_2D(N));
+    vector<Field2D> Ts;
+    implicit.step(T, grid, 0, 100, Ts);
+    EXPECT_TRUE(implicit.linear_system()->matches(grid, 2));
+    T.rotate();
+    implicit.step(T, other, 1, 100, Ts);
+    EXPECT_TRUE(implicit.linear_system()->matches(other, 2));
+}
+
+// The AMG hierarchy has no single-precision version: the combination is rejected, not ignored
+TEST(SolverTest, RejectsSinglePrecisionAMG) {
+    const int N = 8;
+    Grid grid(N, 1.0, 1.0, 1.0, 0.01);
+    grid.initialize_coefficients();
+
+    LinearSolverSettings amg_solver{"AMG", "None", 100, 1e-8, true};
+    LinearSolverSettings amg_preconditioner{"PCG", "AMG", 100, 1e-8, true};
+    EXPECT_THROW(ImplicitSystem(grid, 2, 1.0, amg_solver), invalid_argument);
+    EXPECT_THROW(ImplicitSystem(grid, 2, 1.0, amg_preconditioner), invalid_argument);
+
+    // Double precision AMG and single-precision IC are accepted
+    amg_solver.mixed_precision = false;
+    EXPECT_NO_THROW(ImplicitSystem(grid, 2, 1.0, amg_solver));
+    LinearSolverSettings ic_single{"PCG", "IncompleteCholesky", 100, 1e-8, true};
+    ImplicitSystem system(grid, 2, 1.0, ic_single);
+    EXPECT_EQ(system.preconditioner().precision, PRECONDITIONER_SINGLE);
+}